@@ -0,0 +1,212 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+
+// MRMLLogic includes
+#include <vtkMRMLAbstractLogic.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkSimpleFastMutexLock.h>
+
+// ITKSYS includes
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+//---------------------------------------------------------------------------
+/// vtkSchedulerTestLogic records the order the tasks are run in and the
+/// number of cores they are assigned.
+class vtkSchedulerTestLogic: public vtkMRMLAbstractLogic
+{
+public:
+  vtkTypeMacro(vtkSchedulerTestLogic, vtkMRMLAbstractLogic);
+  static vtkSchedulerTestLogic *New(){return new vtkSchedulerTestLogic;}
+
+  void Run(void* clientdata);
+
+  vtkSlicerApplicationLogic* ApplicationLogic;
+  itk::SimpleFastMutexLock Lock;
+  /// Priorities of the tasks in the order they were run.
+  std::vector<int> Priorities;
+  /// Number of cores assigned to the tasks in the order they were run.
+  std::vector<int> NumberOfThreads;
+  int MaximumCoresInUse;
+  volatile bool Blocked;
+protected:
+  vtkSchedulerTestLogic()
+    : ApplicationLogic(0), MaximumCoresInUse(0), Blocked(true) {}
+  virtual ~vtkSchedulerTestLogic(){}
+};
+
+//---------------------------------------------------------------------------
+void vtkSchedulerTestLogic::Run(void* clientdata)
+{
+  vtkSlicerTask* task = this->ApplicationLogic->GetCurrentProcessingTask();
+  int priority = *reinterpret_cast<int*>(clientdata);
+  this->Lock.Lock();
+  this->Priorities.push_back(priority);
+  this->NumberOfThreads.push_back(task ? task->GetNumberOfThreads() : -1);
+  this->MaximumCoresInUse = std::max(this->MaximumCoresInUse,
+    this->ApplicationLogic->GetNumberOfProcessingCoresInUse());
+  this->Lock.Unlock();
+  // The first task waits for all the tasks to be scheduled.
+  while (priority == 0 && this->Blocked)
+    {
+    itksys::SystemTools::Delay(10);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicSchedulerTest(int , char * [])
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetProcessingCoreBudget(2);
+  appLogic->CreateProcessingThread();
+
+  vtkNew<vtkSchedulerTestLogic> logic;
+  logic->ApplicationLogic = appLogic.GetPointer();
+
+  int priorities[5] = {0, 1, 5, 3, 5};
+  for (int i = 0; i < 5; ++i)
+    {
+    vtkNew<vtkSlicerTask> task;
+    task->SetTypeToProcessing();
+    task->SetPriority(priorities[i]);
+    // Each task uses the whole budget: the tasks are run one at a time.
+    task->SetRequestedNumberOfThreads(i == 0 ? 2 : 3);
+    task->SetTaskFunction(logic.GetPointer(), (vtkSlicerTask::TaskFunctionPointer)
+                          &vtkSchedulerTestLogic::Run, &priorities[i]);
+    if (!appLogic->ScheduleTask(task.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to schedule task" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (i == 0)
+      {
+      // Wait for the first task to start before scheduling the others.
+      for (int wait = 0; wait < 500 && logic->Priorities.size() == 0; ++wait)
+        {
+        itksys::SystemTools::Delay(10);
+        }
+      }
+    }
+  logic->Blocked = false;
+
+  for (int wait = 0; wait < 1000 && logic->Priorities.size() < 5; ++wait)
+    {
+    itksys::SystemTools::Delay(10);
+    }
+  appLogic->TerminateProcessingThread();
+
+  int expectedPriorities[5] = {0, 5, 5, 3, 1};
+  if (logic->Priorities.size() != 5)
+    {
+    std::cerr << "Line " << __LINE__ << ": only " << logic->Priorities.size()
+              << " tasks were run" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 5; ++i)
+    {
+    if (logic->Priorities[i] != expectedPriorities[i] ||
+        logic->NumberOfThreads[i] != 2)
+      {
+      std::cerr << "Line " << __LINE__ << ": task " << i << " has priority "
+                << logic->Priorities[i] << " (expected " << expectedPriorities[i]
+                << ") and " << logic->NumberOfThreads[i] << " cores (expected 2)"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (logic->MaximumCoresInUse != 2 ||
+      appLogic->GetNumberOfProcessingCoresInUse() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": core budget not respected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Serialized tasks are run one at a time, the one running gets the whole
+  // budget and the queued ones don't reserve cores.
+  vtkNew<vtkSlicerApplicationLogic> serializedAppLogic;
+  serializedAppLogic->SetProcessingCoreBudget(2);
+  serializedAppLogic->CreateProcessingThread();
+
+  vtkNew<vtkSchedulerTestLogic> serializedLogic;
+  serializedLogic->ApplicationLogic = serializedAppLogic.GetPointer();
+
+  int serializedPriorities[3] = {0, 1, 1};
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkNew<vtkSlicerTask> task;
+    task->SetTypeToProcessing();
+    task->SetPriority(serializedPriorities[i]);
+    task->SerializedOn();
+    task->SetTaskFunction(serializedLogic.GetPointer(),
+                          (vtkSlicerTask::TaskFunctionPointer)
+                          &vtkSchedulerTestLogic::Run, &serializedPriorities[i]);
+    if (!serializedAppLogic->ScheduleTask(task.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to schedule task" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (i == 0)
+      {
+      for (int wait = 0; wait < 500 && serializedLogic->Priorities.size() == 0; ++wait)
+        {
+        itksys::SystemTools::Delay(10);
+        }
+      }
+    }
+  // Give the scheduler a chance to start the queued tasks
+  itksys::SystemTools::Delay(300);
+  if (serializedLogic->Priorities.size() != 1 ||
+      serializedAppLogic->GetNumberOfProcessingCoresInUse() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": serialized tasks were run at the same time"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  serializedLogic->Blocked = false;
+
+  for (int wait = 0; wait < 1000 && serializedLogic->Priorities.size() < 3; ++wait)
+    {
+    itksys::SystemTools::Delay(10);
+    }
+  serializedAppLogic->TerminateProcessingThread();
+
+  if (serializedLogic->Priorities.size() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": only " << serializedLogic->Priorities.size()
+              << " serialized tasks were run" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    if (serializedLogic->NumberOfThreads[i] != 2)
+      {
+      std::cerr << "Line " << __LINE__ << ": serialized task " << i << " has "
+                << serializedLogic->NumberOfThreads[i] << " cores (expected 2)"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include "vtkSlicerTask.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
@@ -51,13 +52,18 @@
 
 // STD includes
 #include <algorithm>
+#include <deque>
 #ifdef linux
 # include <unistd.h>
 #endif
 #include <queue>
+#include <utility>
+#include <vector>
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
+class ProcessingTaskQueue : public std::deque<vtkSmartPointer<vtkSlicerTask> > {};
+class RunningTaskList
+  : public std::vector<std::pair<vtkMultiThreaderIDType, vtkSlicerTask*> > {};
 class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
 
 //----------------------------------------------------------------------------
@@ -208,7 +214,6 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::MultiThreader::New();
-  this->ProcessingThreadId = -1;
   this->ProcessingThreadActive = false;
   this->ProcessingThreadActiveLock = itk::MutexLock::New();
   this->ProcessingTaskQueueLock = itk::MutexLock::New();
@@ -226,6 +231,10 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
   this->WriteDataQueueLock = itk::MutexLock::New();
 
   this->InternalTaskQueue = new ProcessingTaskQueue;
+  this->InternalRunningTasks = new RunningTaskList;
+  this->ProcessingCoreBudget =
+    std::max(1, itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
+  this->ProcessingCoresInUse = 0;
   this->InternalModifiedQueue = new ModifiedQueue;
 
   this->InternalReadDataQueue = new ReadDataQueue;
@@ -238,20 +247,25 @@ vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
   // Note that TerminateThread does not kill a thread, it only waits
   // for the thread to finish.  We need to signal the thread that we
   // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
+  if (!this->ProcessingThreadIDs.empty() && this->ProcessingThreader)
     {
     // Signal the processingThread that we are terminating.
     this->ProcessingThreadActiveLock->Lock();
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock->Unlock();
 
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
+    // Wait for the threads to finish and clean up the state of the threader
+    std::vector<int>::const_iterator idIterator;
+    for (idIterator = this->ProcessingThreadIDs.begin();
+         idIterator != this->ProcessingThreadIDs.end(); ++idIterator)
+      {
+      this->ProcessingThreader->TerminateThread( *idIterator );
+      }
+    this->ProcessingThreadIDs.clear();
     }
 
   delete this->InternalTaskQueue;
+  delete this->InternalRunningTasks;
 
   this->ModifiedQueueLock->Lock();
   while (!(*this->InternalModifiedQueue).empty())
@@ -291,21 +305,29 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   this->vtkObject::PrintSelf(os, indent);
 
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
+  os << indent << "ProcessingCoreBudget: " << this->ProcessingCoreBudget << "\n";
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
     this->ProcessingThreadActiveLock->Lock();
     this->ProcessingThreadActive = true;
     this->ProcessingThreadActiveLock->Unlock();
 
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
+    // Each processing task uses at least one core: there is no need for more
+    // processing threads than cores in the budget. Leave room in the threader
+    // for the networking threads.
+    int processingThreadCount =
+      std::min(this->GetProcessingCoreBudget(), ITK_MAX_THREADS - 4);
+    for (int i = 0; i < processingThreadCount; ++i)
+      {
+      this->ProcessingThreadIDs.push_back( this->ProcessingThreader
+        ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
+                      this) );
+      }
 
     // Start four network threads (TODO: make the number of threads a setting)
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
@@ -348,7 +370,7 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
     std::cout << "vtkSlicerApplicationLogic::TerminateProcessingThread()" << std::endl;
     this->ModifiedQueueActiveLock->Lock();
@@ -367,10 +389,14 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock->Unlock();
 
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
-
     std::vector<int>::const_iterator idIterator;
+    for (idIterator = this->ProcessingThreadIDs.begin();
+         idIterator != this->ProcessingThreadIDs.end(); ++idIterator)
+      {
+      this->ProcessingThreader->TerminateThread( *idIterator );
+      }
+    this->ProcessingThreadIDs.clear();
+
     idIterator = this->NetworkingThreadIDs.begin();
     while (idIterator != this->NetworkingThreadIDs.end())
       {
@@ -428,29 +454,15 @@ void vtkSlicerApplicationLogic::ProcessProcessingTasks()
     if (active)
       {
       // pull a task off the queue
-      this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = NULL;
-          }
-        }
-      this->ProcessingTaskQueueLock->Unlock();
+      task = this->StartNextProcessingTask();
 
       // process the task (should this be in a separate thread?)
       if (task)
         {
         task->Execute();
+        this->FinishProcessingTask(task);
         task = 0;
+        continue;
         }
       }
 
@@ -505,17 +517,16 @@ void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
       {
       // pull a task off the queue
       this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
+      ProcessingTaskQueue::iterator it;
+      for (it = this->InternalTaskQueue->begin();
+           it != this->InternalTaskQueue->end(); ++it)
         {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
+        // only handle networking tasks in this thread
+        if ( (*it)->GetType() == vtkSlicerTask::Networking )
           {
-          task = NULL;
+          task = *it;
+          this->InternalTaskQueue->erase(it);
+          break;
           }
         }
       this->ProcessingTaskQueueLock->Unlock();
@@ -548,7 +559,7 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
   if (active)
     {
     this->ProcessingTaskQueueLock->Lock();
-    (*this->InternalTaskQueue).push( task );
+    (*this->InternalTaskQueue).push_back( task );
     //std::cout << (*this->InternalTaskQueue).size() << std::endl;
     this->ProcessingTaskQueueLock->Unlock();
 
@@ -559,6 +570,159 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
   return false;
 }
 
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerTask> vtkSlicerApplicationLogic::StartNextProcessingTask()
+{
+  vtkSmartPointer<vtkSlicerTask> task;
+  this->ProcessingTaskQueueLock->Lock();
+
+  // Serialized tasks wait in the queue while one of them runs.
+  bool serializedTaskRunning = false;
+  RunningTaskList::iterator runningIt;
+  for (runningIt = this->InternalRunningTasks->begin();
+       runningIt != this->InternalRunningTasks->end(); ++runningIt)
+    {
+    serializedTaskRunning = serializedTaskRunning ||
+      runningIt->second->GetSerialized();
+    }
+
+  // The queued processing task with the highest priority is next, the
+  // earliest scheduled one if there are several.
+  ProcessingTaskQueue::iterator next = this->InternalTaskQueue->end();
+  int queuedProcessingTasks = 0;
+  bool serializedTaskQueued = false;
+  ProcessingTaskQueue::iterator it;
+  for (it = this->InternalTaskQueue->begin();
+       it != this->InternalTaskQueue->end(); ++it)
+    {
+    if ((*it)->GetType() != vtkSlicerTask::Processing ||
+        ((*it)->GetSerialized() && serializedTaskRunning))
+      {
+      continue;
+      }
+    // Only one of the queued serialized tasks can run at a time.
+    if ((*it)->GetSerialized())
+      {
+      if (!serializedTaskQueued)
+        {
+        ++queuedProcessingTasks;
+        }
+      serializedTaskQueued = true;
+      }
+    else
+      {
+      ++queuedProcessingTasks;
+      }
+    if (next == this->InternalTaskQueue->end() ||
+        (*it)->GetPriority() > (*next)->GetPriority())
+      {
+      next = it;
+      }
+    }
+
+  int freeCores = this->ProcessingCoreBudget - this->ProcessingCoresInUse;
+  if (next != this->InternalTaskQueue->end() && freeCores > 0)
+    {
+    int cores = (*next)->GetRequestedNumberOfThreads();
+    if (cores == 0)
+      {
+      // Share the budget between the running tasks and the queued tasks
+      // that could run at the same time.
+      int tasks = queuedProcessingTasks
+        + static_cast<int>(this->InternalRunningTasks->size());
+      cores = std::min(std::max(1, this->ProcessingCoreBudget / tasks),
+                       freeCores);
+      }
+    // A task can't use more than the whole budget.
+    cores = std::min(cores, this->ProcessingCoreBudget);
+    // Lower priority tasks are not started before the next task, otherwise
+    // the next task could wait for free cores forever.
+    if (cores <= freeCores)
+      {
+      task = *next;
+      this->InternalTaskQueue->erase(next);
+      task->SetNumberOfThreads(cores);
+      this->ProcessingCoresInUse += cores;
+      this->InternalRunningTasks->push_back(
+        std::make_pair(vtkMultiThreader::GetCurrentThreadID(),
+                       task.GetPointer()));
+      }
+    }
+
+  this->ProcessingTaskQueueLock->Unlock();
+  return task;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::FinishProcessingTask(vtkSlicerTask* task)
+{
+  this->ProcessingTaskQueueLock->Lock();
+  RunningTaskList::iterator it;
+  for (it = this->InternalRunningTasks->begin();
+       it != this->InternalRunningTasks->end(); ++it)
+    {
+    if (it->second == task)
+      {
+      this->ProcessingCoresInUse -= task->GetNumberOfThreads();
+      this->InternalRunningTasks->erase(it);
+      break;
+      }
+    }
+  this->ProcessingTaskQueueLock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTask* vtkSlicerApplicationLogic::GetCurrentProcessingTask()
+{
+  vtkSlicerTask* task = 0;
+  vtkMultiThreaderIDType threadID = vtkMultiThreader::GetCurrentThreadID();
+  this->ProcessingTaskQueueLock->Lock();
+  RunningTaskList::const_iterator it;
+  for (it = this->InternalRunningTasks->begin();
+       it != this->InternalRunningTasks->end(); ++it)
+    {
+    if (vtkMultiThreader::ThreadsEqual(it->first, threadID))
+      {
+      task = it->second;
+      break;
+      }
+    }
+  this->ProcessingTaskQueueLock->Unlock();
+  return task;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::SetProcessingCoreBudget(int cores)
+{
+  cores = std::max(1, cores);
+  this->ProcessingTaskQueueLock->Lock();
+  bool modified = (this->ProcessingCoreBudget != cores);
+  this->ProcessingCoreBudget = cores;
+  this->ProcessingTaskQueueLock->Unlock();
+  if (modified)
+    {
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetProcessingCoreBudget()
+{
+  this->ProcessingTaskQueueLock->Lock();
+  int cores = this->ProcessingCoreBudget;
+  this->ProcessingTaskQueueLock->Unlock();
+  return cores;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfProcessingCoresInUse()
+{
+  this->ProcessingTaskQueueLock->Lock();
+  int cores = this->ProcessingCoresInUse;
+  this->ProcessingTaskQueueLock->Unlock();
+  return cores;
+}
+
 //----------------------------------------------------------------------------
 int vtkSlicerApplicationLogic::RequestModified( vtkObject *obj )
 {
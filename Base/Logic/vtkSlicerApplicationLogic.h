@@ -37,6 +37,7 @@ class vtkMRMLInteractionNode;
 class vtkSlicerTask;
 class ModifiedQueue;
 class ProcessingTaskQueue;
+class RunningTaskList;
 class ReadDataQueue;
 class ReadDataRequest;
 class WriteDataQueue;
@@ -56,7 +57,10 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the threads for processing.
+  /// One processing thread is created per core of the processing core
+  /// budget, the budget must be set before to change the number of threads.
+  /// \sa SetProcessingCoreBudget()
   void CreateProcessingThread();
 
   /// Shutdown the processing thread
@@ -77,8 +81,30 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// Schedule a task to run in the processing thread. Returns true if
   /// task was successfully scheduled. ScheduleTask() is called from the
   /// main thread to run something in the processing thread.
+  /// Processing tasks are started by decreasing priority when enough cores
+  /// of the processing core budget are available. Serialized tasks are
+  /// started one at a time.
+  /// \sa vtkSlicerTask::SetPriority(), vtkSlicerTask::SetSerialized(),
+  /// SetProcessingCoreBudget()
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Number of cores the running processing tasks can use altogether.
+  /// Each processing task is assigned a number of cores when it is started
+  /// (see vtkSlicerTask::GetNumberOfThreads()), the task is delayed until
+  /// enough cores are free. By default, the number of cores of the machine
+  /// (ITK global default number of threads).
+  void SetProcessingCoreBudget(int cores);
+  int GetProcessingCoreBudget();
+
+  /// Number of cores of the budget used by the running processing tasks.
+  int GetNumberOfProcessingCoresInUse();
+
+  /// Return the processing task run by the calling thread, 0 if the calling
+  /// thread is not running a processing task.
+  /// This allows a task function to know the number of cores it has been
+  /// assigned.
+  vtkSlicerTask* GetCurrentProcessingTask();
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
@@ -191,6 +217,14 @@ protected:
   /// Task processing loop that is run in the processing thread
   void ProcessProcessingTasks();
 
+  /// Remove from the queue the processing task to start next and assign it
+  /// cores of the budget. Return 0 if there is no task to start or not
+  /// enough free cores.
+  vtkSmartPointer<vtkSlicerTask> StartNextProcessingTask();
+
+  /// Give the cores of a finished processing task back to the budget.
+  void FinishProcessingTask(vtkSlicerTask* task);
+
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
@@ -222,7 +256,7 @@ private:
   itk::MutexLock::Pointer WriteDataQueueActiveLock;
   itk::MutexLock::Pointer WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
   int ProcessingThreadActive;
   int ModifiedQueueActive;
@@ -230,6 +264,9 @@ private:
   int WriteDataQueueActive;
 
   ProcessingTaskQueue* InternalTaskQueue;
+  RunningTaskList*     InternalRunningTasks;
+  int ProcessingCoreBudget;
+  int ProcessingCoresInUse;
   ModifiedQueue*       InternalModifiedQueue;
   ReadDataQueue*       InternalReadDataQueue;
   WriteDataQueue*      InternalWriteDataQueue;
@@ -9,7 +9,12 @@ vtkSlicerTask::vtkSlicerTask()
 {
   this->TaskObject = 0;
   this->TaskFunction = 0;
+  this->TaskClientData = 0;
   this->Type = vtkSlicerTask::Undefined;
+  this->Priority = 0;
+  this->RequestedNumberOfThreads = 0;
+  this->NumberOfThreads = 0;
+  this->Serialized = false;
 }
 //----------------------------------------------------------------------------
 vtkSlicerTask::~vtkSlicerTask()
@@ -39,4 +44,11 @@ void vtkSlicerTask::Execute()
 void vtkSlicerTask::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "Type: " << this->GetTypeAsString() << "\n";
+  os << indent << "Priority: " << this->Priority << "\n";
+  os << indent << "RequestedNumberOfThreads: "
+     << this->RequestedNumberOfThreads << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "Serialized: " << this->Serialized << "\n";
 }
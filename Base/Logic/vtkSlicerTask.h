@@ -38,6 +38,35 @@ public:
   void SetTypeToProcessing() {this->SetType(vtkSlicerTask::Processing);};
   void SetTypeToNetworking() {this->SetType(vtkSlicerTask::Networking);};
 
+  ///
+  /// Priority of the task. Among the queued processing tasks, the one with
+  /// the highest priority is executed first. Tasks with the same priority
+  /// are executed in the order they were scheduled. 0 by default.
+  vtkSetMacro (Priority, int);
+  vtkGetMacro (Priority, int);
+
+  ///
+  /// Number of cores the task wants to use. 0 (default) lets the
+  /// application logic share the processing core budget between the
+  /// queued tasks.
+  /// \sa vtkSlicerApplicationLogic::SetProcessingCoreBudget()
+  vtkSetClampMacro (RequestedNumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro (RequestedNumberOfThreads, int);
+
+  ///
+  /// Number of cores assigned to the task by the application logic when
+  /// the task is started. Set by the application logic only.
+  vtkSetMacro (NumberOfThreads, int);
+  vtkGetMacro (NumberOfThreads, int);
+
+  ///
+  /// Serialized tasks share a process-wide resource and can't run at the
+  /// same time. While a serialized task runs, the queued serialized tasks
+  /// don't take a share of the processing core budget. Off by default.
+  vtkSetMacro (Serialized, bool);
+  vtkGetMacro (Serialized, bool);
+  vtkBooleanMacro (Serialized, bool);
+
   const char* GetTypeAsString( ) {
     switch (this->Type)
       {
@@ -60,7 +89,11 @@ private:
   void *TaskClientData;
   
   int Type;
-  
+  int Priority;
+  int RequestedNumberOfThreads;
+  int NumberOfThreads;
+  bool Serialized;
+
 };
 #endif
 
@@ -27,14 +27,21 @@
 #include <vtkMRMLROIListNode.h>
 #include <vtkMRMLStorageNode.h>
 #include <vtkMRMLTransformNode.h>
+#include <vtkMRMLVolumeNode.h>
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkStringArray.h>
 
+// ITK includes
+#include <itkMultiThreader.h>
+#include <itkMutexLockHolder.h>
+#include <itkSimpleFastMutexLock.h>
+
 // ITKSYS includes
 #include <itksys/Process.h>
 #include <itksys/SystemTools.hxx>
@@ -55,6 +62,7 @@
 
 #ifdef _WIN32
 #else
+#include <sys/statvfs.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
@@ -245,6 +253,52 @@ protected:
   std::string NodeID;
 };
 
+//----------------------------------------------------------------------------
+// The environment is shared by all the threads: executable modules are
+// launched one at a time while the environment is modified for them.
+static itk::SimpleFastMutexLock CLIEnvironmentLock;
+
+//----------------------------------------------------------------------------
+// Shared object modules run in the Slicer process: they share std::cout and
+// std::cerr (redirected while they run) and ITK's global default number of
+// threads. They are run one at a time; executable modules and other
+// processing tasks can still run concurrently. Their tasks are serialized
+// so that the application logic does not start (and assign cores to)
+// the ones that would wait for the lock.
+static itk::SimpleFastMutexLock CLISharedObjectLock;
+
+//----------------------------------------------------------------------------
+// Identify the runs so that concurrent runs don't share temporary files.
+static itk::SimpleFastMutexLock CLIRunCountLock;
+static int CLIRunCount = 0;
+
+//----------------------------------------------------------------------------
+// Set ITK's global default number of threads while a shared object module
+// runs (CLISharedObjectLock must be held) and restore it afterwards.
+class vtkSlicerCLIGlobalDefaultNumberOfThreads
+{
+public:
+  vtkSlicerCLIGlobalDefaultNumberOfThreads(int numberOfThreads)
+    : Set(numberOfThreads > 0)
+    , SavedNumberOfThreads(itk::MultiThreader::GetGlobalDefaultNumberOfThreads())
+  {
+    if (this->Set)
+      {
+      itk::MultiThreader::SetGlobalDefaultNumberOfThreads(numberOfThreads);
+      }
+  }
+  ~vtkSlicerCLIGlobalDefaultNumberOfThreads()
+  {
+    if (this->Set)
+      {
+      itk::MultiThreader::SetGlobalDefaultNumberOfThreads(this->SavedNumberOfThreads);
+      }
+  }
+private:
+  bool Set;
+  int SavedNumberOfThreads;
+};
+
 //----------------------------------------------------------------------------
 class vtkSlicerCLIModuleLogic::vtkInternal
 {
@@ -256,6 +310,32 @@ public:
 
   std::string TemporaryDirectory;
 
+  int SharedMemoryDataExchange;
+
+  /// Directory where the data files exchanged with the modules are written.
+  /// The memory backed file system is only used if it has room for
+  /// expectedKilobytes (with a margin), it is often small (e.g. 64MB in
+  /// containers).
+  std::string GetDataExchangeDirectory(double expectedKilobytes)const
+  {
+#ifndef _WIN32
+    struct statvfs fileSystem;
+    if (this->SharedMemoryDataExchange &&
+        itksys::SystemTools::FileIsDirectory("/dev/shm") &&
+        access("/dev/shm", W_OK) == 0 &&
+        statvfs("/dev/shm", &fileSystem) == 0)
+      {
+      double freeKilobytes = static_cast<double>(fileSystem.f_bavail) *
+        fileSystem.f_frsize / 1024.;
+      if (freeKilobytes >= 1.25 * expectedKilobytes)
+        {
+        return "/dev/shm";
+        }
+      }
+#endif
+    return this->TemporaryDirectory;
+  }
+
   typedef std::vector<std::pair<int, vtkMRMLCommandLineModuleNode*> > RequestType;
   struct FindRequest
   {
@@ -352,6 +432,7 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
 
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->RedirectModuleStreams = 1;
+  this->Internal->SharedMemoryDataExchange = 0;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
   this->Internal->RescheduleCallback->SetCLIModuleLogic(this);
@@ -465,6 +546,35 @@ int vtkSlicerCLIModuleLogic::GetRedirectModuleStreams() const
   return this->Internal->RedirectModuleStreams;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryDataExchangeOn()
+{
+  this->SetSharedMemoryDataExchange(static_cast<int>(1));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryDataExchangeOff()
+{
+  this->SetSharedMemoryDataExchange(static_cast<int>(0));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetSharedMemoryDataExchange(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting SharedMemoryDataExchange to " << value);
+  if (this->Internal->SharedMemoryDataExchange != value)
+    {
+    this->Internal->SharedMemoryDataExchange = value;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetSharedMemoryDataExchange() const
+{
+  return this->Internal->SharedMemoryDataExchange;
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
@@ -512,7 +622,9 @@ vtkSlicerCLIModuleLogic
                              const std::string& type,
                              const std::string& name,
                              const std::vector<std::string>& extensions,
-                             CommandLineModuleType commandType)
+                             CommandLineModuleType commandType,
+                             const std::string& dataExchangeDirectory,
+                             int runID)
 {
   std::string fname = name;
   std::string pid;
@@ -533,15 +645,9 @@ vtkSlicerCLIModuleLogic
   // the MRML scene, then a real temporary filename is constructed.
   // The filename will point to the Temporary directory defined for
   // Slicer. The filename will be unique to the process (multiple
-  // running instances of slicer will not collide).  The filename
-  // will be unique to the node in the process (the same node will be
-  // encoded to the same filename every time within that running
-  // instance of Slicer).  This last point is an optimization to
-  // minimize the number of times a file is written when running a
-  // module.  However, if we change the execution model such that more
-  // than one module can run at the same time within the same Slicer
-  // process, then this encoding will need to be changed to be unique
-  // per module execution.
+  // running instances of slicer will not collide), to the module
+  // execution (modules running at the same time will not collide) and
+  // to the node within the execution.
   //
 
 
@@ -552,6 +658,7 @@ vtkSlicerCLIModuleLogic
 #else
   pidString << getpid();
 #endif
+  pidString << "_" << runID;
   pid = pidString.str();
   std::transform(pid.begin(), pid.end(), pid.begin(), DigitsToCharacters());
 
@@ -567,9 +674,10 @@ vtkSlicerCLIModuleLogic
   std::transform(fname.begin(), fname.end(),
                  fname.begin(), DigitsToCharacters());
 
-  // By default, the filename is based on the temporary directory and
-  // the pid
-  fname = this->Internal->TemporaryDirectory + "/" + pid + "_" + fname;
+  // By default, the filename is based on the data exchange directory
+  // (the temporary directory or a memory backed file system), the pid
+  // and the run
+  fname = dataExchangeDirectory + "/" + pid + "_" + fname;
 
   if (tag == "image")
     {
@@ -702,6 +810,11 @@ void vtkSlicerCLIModuleLogic::Apply ( vtkMRMLCommandLineModuleNode* node, bool u
 
   vtkSlicerTask* task = vtkSlicerTask::New();
   task->SetTypeToProcessing();
+  task->SetPriority(node->GetPriority());
+  task->SetRequestedNumberOfThreads(node->GetNumberOfThreads());
+  // Shared object modules are run one at a time (see CLISharedObjectLock)
+  task->SetSerialized(
+    node->GetModuleDescription().GetType() == "SharedObjectModule");
 
   // Pass the current node as client data to the task.  This allows
   // the user to switch to another parameter set after the task is
@@ -873,6 +986,11 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   qDebug() << "ModuleType:" << node0->GetModuleDescription().GetType().c_str();
 
 
+  // identifier of this run, used to make the temporary files unique
+  CLIRunCountLock.Lock();
+  int runID = ++CLIRunCount;
+  CLIRunCountLock.Unlock();
+
   // map to keep track of MRML Ids and filenames
   typedef std::map<std::string, std::string> MRMLIDToFileNameMap;
   MRMLIDToFileNameMap nodesToReload;
@@ -904,6 +1022,10 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // Make a pass over the parameters and establish which parameters
   // have images or geometry or transforms or tables that need to be written
   // before execution or loaded upon completion.
+  std::vector<ModuleParameter*> dataParameters;
+  double inputKilobytes = 0.;
+  double largestInputKilobytes = 0.;
+  int numberOfOutputVolumes = 0;
   for (pgit = pgbeginit; pgit != pgendit; ++pgit)
     {
     // iterate over each parameter in this group
@@ -931,42 +1053,67 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
           }
 
         // only keep track of objects associated with real nodes
-        if (!this->GetMRMLScene()->GetNodeByID(id.c_str()) || id == "None")
+        vtkMRMLNode* dataNode = this->GetMRMLScene()->GetNodeByID(id.c_str());
+        if (!dataNode || id == "None")
           {
           continue;
           }
+        dataParameters.push_back(&(*pit));
 
-        std::string fname
-          = this->ConstructTemporaryFileName((*pit).GetTag(),
-                                             (*pit).GetType(),
-                                             id,
-                                             (*pit).GetFileExtensions(),
-                                             commandType);
-
-        filesToDelete.insert(fname);
-
-        if ((*pit).GetChannel() == "input")
+        // Estimate the size of the exchanged volumes, an output is assumed
+        // to be as large as the largest input.
+        vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+        if ((*pit).GetChannel() == "input" &&
+            volumeNode && volumeNode->GetImageData())
           {
-          nodesToWrite[id] = fname;
+          double volumeKilobytes =
+            volumeNode->GetImageData()->GetActualMemorySize();
+          inputKilobytes += volumeKilobytes;
+          largestInputKilobytes =
+            std::max(largestInputKilobytes, volumeKilobytes);
           }
-        else if ((*pit).GetChannel() == "output")
+        else if ((*pit).GetChannel() == "output" && volumeNode)
           {
-          nodesToReload[id] = fname;
+          ++numberOfOutputVolumes;
           }
         }
       }
     }
 
+  std::string dataExchangeDirectory =
+    this->Internal->GetDataExchangeDirectory(
+      inputKilobytes + numberOfOutputVolumes * largestInputKilobytes);
+
+  std::vector<ModuleParameter*>::const_iterator dpit;
+  for (dpit = dataParameters.begin(); dpit != dataParameters.end(); ++dpit)
+    {
+    ModuleParameter* parameter = *dpit;
+    std::string id = parameter->GetDefault();
+    std::string fname
+      = this->ConstructTemporaryFileName(parameter->GetTag(),
+                                         parameter->GetType(),
+                                         id,
+                                         parameter->GetFileExtensions(),
+                                         commandType,
+                                         dataExchangeDirectory,
+                                         runID);
+
+    filesToDelete.insert(fname);
+
+    if (parameter->GetChannel() == "input")
+      {
+      nodesToWrite[id] = fname;
+      }
+    else if (parameter->GetChannel() == "output")
+      {
+      nodesToReload[id] = fname;
+      }
+    }
+
 
   // write out the input datasets
   //
   //
-  std::set<std::string> MemoryTransferPossible;
-  MemoryTransferPossible.insert("vtkMRMLScalarVolumeNode");
-  MemoryTransferPossible.insert("vtkMRMLVectorVolumeNode");
-  MemoryTransferPossible.insert("vtkMRMLDiffusionWeightedVolumeNode");
-  MemoryTransferPossible.insert("vtkMRMLDiffusionTensorVolumeNode");
-
   MRMLIDToFileNameMap::const_iterator id2fn0;
 
   for (id2fn0 = nodesToWrite.begin();
@@ -1008,9 +1155,11 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       //std::cerr << nd->GetName() << " is " << nd->GetClassName() << std::endl;
 
-      // Check if we can transfer the datatype using a direct memory transfer
-      if (std::find(MemoryTransferPossible.begin(), MemoryTransferPossible.end(),
-                    nd->GetClassName()) == MemoryTransferPossible.end())
+      // Check if we can transfer the datatype using a direct memory
+      // transfer: any volume referenced as slicer:%p#%s is read by the
+      // module from the scene (itkMRMLIDImageIO)
+      if (!nd->IsA("vtkMRMLVolumeNode") ||
+          (*id2fn0).second.find("slicer:") != 0)
         {
         // Cannot use a memory transfer, use a StorageNode
         out = defaultOut;
@@ -1199,6 +1348,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
 #else
     pidString << getpid();
 #endif
+    pidString << "_" << runID;
 
     static const char alphanum[] =
         "0123456789"
@@ -1717,6 +1867,19 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   qDebug() << information0.str().c_str();
 
 
+  // Number of threads assigned to the module by the scheduler of the
+  // application logic. When not run by the processing threads (i.e.
+  // ApplyAndWait()), the number of threads set on the node is used; 0 keeps
+  // the ITK default.
+  int numberOfThreads = node0->GetNumberOfThreads();
+  vtkSlicerTask* task = this->GetApplicationLogic()->GetCurrentProcessingTask();
+  if (task)
+    {
+    numberOfThreads = task->GetNumberOfThreads();
+    }
+  node0->SetAssignedNumberOfThreads(numberOfThreads > 0 ?
+    numberOfThreads : itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
+
   // run the filter
   //
   //
@@ -1736,6 +1899,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     // statically linked to the executable.
     // Historically, there was an nvidia driver bug that causes the module
     // to fail on exit with undefined symbol.
+     CLIEnvironmentLock.Lock();
      std::string saveITKAutoLoadPath;
      itksys::SystemTools::GetEnv("ITK_AUTOLOAD_PATH", saveITKAutoLoadPath);
      std::string emptyString("ITK_AUTOLOAD_PATH=");
@@ -1758,9 +1922,43 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                             itksysProcess_Option_HideWindow, 1);
     // itksysProcess_SetTimeout(process, 5.0); // 5 seconds
 
+    // ITK filters of the module use the number of threads assigned by the
+    // scheduler.
+    std::string saveITKNumberOfThreads;
+    bool hadITKNumberOfThreads = itksys::SystemTools::GetEnv(
+      "ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS", saveITKNumberOfThreads);
+    if (numberOfThreads > 0)
+      {
+      std::stringstream numberOfThreadsEnv;
+      numberOfThreadsEnv << "ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS="
+                         << numberOfThreads;
+      putSuccess = itksys::SystemTools::PutEnv(
+        const_cast <char *> (numberOfThreadsEnv.str().c_str()));
+      if (!putSuccess)
+        {
+        vtkErrorMacro( "Unable to set ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS.");
+        }
+      }
+
     // execute the command
     itksysProcess_Execute(process);
 
+    // restore the number of threads
+    if (numberOfThreads > 0)
+      {
+      if (hadITKNumberOfThreads)
+        {
+        std::string numberOfThreadsEnv = "ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS=";
+        numberOfThreadsEnv += saveITKNumberOfThreads;
+        itksys::SystemTools::PutEnv(
+          const_cast <char *> (numberOfThreadsEnv.c_str()));
+        }
+      else
+        {
+        itksys::SystemTools::UnPutEnv("ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS");
+        }
+      }
+
     // restore the load path
     std::string putEnvString = ("ITK_AUTOLOAD_PATH=");
     putEnvString = putEnvString + saveITKAutoLoadPath;
@@ -1770,6 +1968,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       vtkErrorMacro( "Unable to restore ITK_AUTOLOAD_PATH. ");
       }
+    CLIEnvironmentLock.Unlock();
 
     // Wait for the command to finish
     char *tbuffer;
@@ -2046,11 +2245,16 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     //
 
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> sharedObjectHolder(
+      CLISharedObjectLock);
     std::ostringstream coutstringstream;
     std::ostringstream cerrstringstream;
     std::streambuf* origcoutrdbuf = std::cout.rdbuf();
     std::streambuf* origcerrrdbuf = std::cerr.rdbuf();
     int returnValue = 0;
+    // ITK filters of the module use the number of threads assigned by the
+    // scheduler until the module returns.
+    vtkSlicerCLIGlobalDefaultNumberOfThreads globalNumberOfThreads(numberOfThreads);
     try
       {
       if (this->Internal->RedirectModuleStreams)
@@ -80,6 +80,19 @@ public:
   void SetRedirectModuleStreams(int value);
   int GetRedirectModuleStreams() const;
 
+  /// Exchange the data with the modules through files in a memory backed
+  /// file system (/dev/shm) when one is available instead of the temporary
+  /// directory, so that the data is not written to disk. The data of shared
+  /// object modules is exchanged in memory when possible (see
+  /// itkMRMLIDImageIO) regardless of this setting. The memory backed file
+  /// system is not used if its free space is smaller than the size of the
+  /// volumes exchanged with the module. Off by default: the exchanged data
+  /// then takes RAM in addition to the scene.
+  virtual void SharedMemoryDataExchangeOn();
+  virtual void SharedMemoryDataExchangeOff();
+  void SetSharedMemoryDataExchange(int value);
+  int GetSharedMemoryDataExchange() const;
+
   /// Schedules the command line module to run.
   /// The CLI is scheduled to be run in a separate thread. This methods
   /// is non blocking and returns immediately.
@@ -119,7 +132,9 @@ protected:
                                          const std::string& type,
                                          const std::string& name,
                                      const std::vector<std::string>& extensions,
-                                     CommandLineModuleType commandType);
+                                     CommandLineModuleType commandType,
+                                     const std::string& dataExchangeDirectory,
+                                     int runID);
   std::string ConstructTemporarySceneFileName(vtkMRMLScene *scene);
   std::string FindHiddenNodeID(const ModuleDescription& d,
                                const ModuleParameter& p);
@@ -29,6 +29,7 @@
 #include <QTimer>
 #include <QNetworkProxyFactory>
 #include <QSettings>
+#include <QThread>
 #include <QTranslator>
 
 // CTK includes
@@ -992,6 +993,11 @@ void qSlicerCoreApplication::setMRMLScene(vtkMRMLScene* newMRMLScene)
   QString workingDirectory = QDir::currentPath();
   newMRMLScene->SetRootDirectory(workingDirectory.toLatin1());
 
+  // Threads used to write the scene data, see the "General" settings panel
+  newMRMLScene->SetNumberOfWriteDataThreads(
+    this->userSettings()->value("IO/NumberOfWriteDataThreads",
+                                QThread::idealThreadCount()).toInt());
+
 #ifdef Slicer_BUILD_CLI_SUPPORT
   // Register the node type for the command line modules
   // TODO: should probably done in the command line logic
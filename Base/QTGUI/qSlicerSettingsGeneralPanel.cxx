@@ -23,6 +23,7 @@
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QSettings>
+#include <QThread>
 
 // CTK includes
 #include <ctkBooleanMapper.h>
@@ -34,6 +35,9 @@
 
 #include "vtkSlicerConfigure.h" // For Slicer_QM_OUTPUT_DIRS, Slicer_BUILD_I18N_SUPPORT
 
+// MRML includes
+#include <vtkMRMLScene.h>
+
 // --------------------------------------------------------------------------
 // qSlicerSettingsGeneralPanelPrivate
 
@@ -88,6 +92,7 @@ void qSlicerSettingsGeneralPanelPrivate::init()
 
   // Default values
   this->SlicerWikiURLLineEdit->setText("http://www.slicer.org/slicerWiki/index.php");
+  this->NumberOfWriteDataThreadsSpinBox->setValue(QThread::idealThreadCount());
 
   q->registerProperty("no-splash", this->ShowSplashScreenCheckBox, "checked",
                       SIGNAL(toggled(bool)));
@@ -111,6 +116,11 @@ void qSlicerSettingsGeneralPanelPrivate::init()
                       SIGNAL(valueChanged(int)),
                       "Max. number of 'Recently Loaded' menu items",
                       ctkSettingsPanel::OptionRequireRestart);
+  q->registerProperty("IO/NumberOfWriteDataThreads", this->NumberOfWriteDataThreadsSpinBox,
+                      "value", SIGNAL(valueChanged(int)),
+                      "Number of threads to save data");
+  QObject::connect(this->NumberOfWriteDataThreadsSpinBox, SIGNAL(valueChanged(int)),
+                   q, SLOT(setNumberOfWriteDataThreads(int)));
 }
 
 // --------------------------------------------------------------------------
@@ -129,3 +139,13 @@ qSlicerSettingsGeneralPanel::qSlicerSettingsGeneralPanel(QWidget* _parent)
 qSlicerSettingsGeneralPanel::~qSlicerSettingsGeneralPanel()
 {
 }
+
+// --------------------------------------------------------------------------
+void qSlicerSettingsGeneralPanel::setNumberOfWriteDataThreads(int threads)
+{
+  vtkMRMLScene* scene = qSlicerApplication::application()->mrmlScene();
+  if (scene)
+    {
+    scene->SetNumberOfWriteDataThreads(threads);
+    }
+}
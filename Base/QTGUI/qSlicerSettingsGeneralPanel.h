@@ -47,6 +47,11 @@ public:
   /// Destructor
   virtual ~qSlicerSettingsGeneralPanel();
 
+public slots:
+  /// Set the number of threads the application scene writes its data with.
+  /// \sa vtkMRMLScene::SetNumberOfWriteDataThreads()
+  void setNumberOfWriteDataThreads(int threads);
+
 protected:
   QScopedPointer<qSlicerSettingsGeneralPanelPrivate> d_ptr;
 
@@ -26,6 +26,7 @@ Version:   $Revision: 1.2 $
 #include <vtkIntArray.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
 
 // STD includes
 #include <sstream>
@@ -53,6 +54,16 @@ public:
   /// Delay in msecs to wait before the module is auto run.
   unsigned int AutoRunDelay;
 
+  /// Scheduling priority.
+  int Priority;
+  /// Requested and assigned number of threads.
+  int NumberOfThreads;
+  int AssignedNumberOfThreads;
+  /// Wall clock times of the last run.
+  double QueuedTime;
+  double StartTime;
+  double FinishTime;
+
   /// Last time the module was started.
   vtkTimeStamp LastRunTime;
   /// Last time a parameter was modified.
@@ -86,6 +97,12 @@ vtkMRMLCommandLineModuleNode::vtkMRMLCommandLineModuleNode()
     vtkMRMLCommandLineModuleNode::AutoRunOnChangedParameter
     | vtkMRMLCommandLineModuleNode::AutoRunCancelsRunningProcess;
   this->Internal->AutoRunDelay = 1000;
+  this->Internal->Priority = 0;
+  this->Internal->NumberOfThreads = 0;
+  this->Internal->AssignedNumberOfThreads = 0;
+  this->Internal->QueuedTime = 0.;
+  this->Internal->StartTime = 0.;
+  this->Internal->FinishTime = 0.;
 }
 
 //----------------------------------------------------------------------------
@@ -124,6 +141,8 @@ void vtkMRMLCommandLineModuleNode::WriteXML(ostream& of, int nIndent)
   of << " version=\"" << this->URLEncodeString ( module.GetVersion().c_str() ) << "\"";
   of << " autorunmode=\"" << this->Internal->AutoRunMode << "\"";
   of << " autorun=\"" << this->Internal->AutoRun << "\"";
+  of << " priority=\"" << this->Internal->Priority << "\"";
+  of << " numberofthreads=\"" << this->Internal->NumberOfThreads << "\"";
   
   // Loop over the parameter groups, writing each parameter.  Note
   // that the parameter names are unique.
@@ -207,6 +226,22 @@ void vtkMRMLCommandLineModuleNode::ReadXMLAttributes(const char** atts)
       ss >> autoRun;
       this->SetAutoRun(autoRun);
       }
+    else if (!strcmp(attName, "priority"))
+      {
+      int priority = 0;
+      std::stringstream ss;
+      ss << attValue;
+      ss >> priority;
+      this->SetPriority(priority);
+      }
+    else if (!strcmp(attName, "numberofthreads"))
+      {
+      int numberOfThreads = 0;
+      std::stringstream ss;
+      ss << attValue;
+      ss >> numberOfThreads;
+      this->SetNumberOfThreads(numberOfThreads);
+      }
     }
 
   // Set an attribute on the node based on the module title so that
@@ -263,6 +298,8 @@ void vtkMRMLCommandLineModuleNode::Copy(vtkMRMLNode *anode)
 
   this->SetModuleDescription(node->GetModuleDescription());
   this->SetStatus(static_cast<StatusType>(node->GetStatus()));
+  this->SetPriority(node->GetPriority());
+  this->SetNumberOfThreads(node->GetNumberOfThreads());
 }
 
 //----------------------------------------------------------------------------
@@ -276,6 +313,12 @@ void vtkMRMLCommandLineModuleNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Status: " << this->GetStatusString() << "\n";
   os << indent << "AutoRun:" << this->GetAutoRun() << "\n";
   os << indent << "AutoRunMode:" << this->GetAutoRunMode() << "\n";
+  os << indent << "Priority:" << this->GetPriority() << "\n";
+  os << indent << "NumberOfThreads:" << this->GetNumberOfThreads() << "\n";
+  os << indent << "AssignedNumberOfThreads:"
+     << this->GetAssignedNumberOfThreads() << "\n";
+  os << indent << "QueuedDuration:" << this->GetQueuedDuration() << "\n";
+  os << indent << "RunningDuration:" << this->GetRunningDuration() << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -510,12 +553,24 @@ void vtkMRMLCommandLineModuleNode::SetStatus(int status, bool modify)
     this->Internal->Status = status;
     switch (this->Internal->Status)
       {
+      case vtkMRMLCommandLineModuleNode::Scheduled:
+        this->Internal->QueuedTime = vtkTimerLog::GetUniversalTime();
+        this->Internal->StartTime = 0.;
+        this->Internal->FinishTime = 0.;
+        break;
       case vtkMRMLCommandLineModuleNode::Running:
         this->Internal->LastRunTime.Modified();
+        this->Internal->StartTime = vtkTimerLog::GetUniversalTime();
+        this->Internal->FinishTime = 0.;
         break;
       case vtkMRMLCommandLineModuleNode::Cancelling:
         this->AbortProcess();
         break;
+      case vtkMRMLCommandLineModuleNode::Completed:
+      case vtkMRMLCommandLineModuleNode::CompletedWithErrors:
+      case vtkMRMLCommandLineModuleNode::Cancelled:
+        this->Internal->FinishTime = vtkTimerLog::GetUniversalTime();
+        break;
       default:
         break;
       }
@@ -592,6 +647,100 @@ unsigned int vtkMRMLCommandLineModuleNode::GetAutoRunDelay() const
   return this->Internal->AutoRunDelay;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLCommandLineModuleNode::SetPriority(int priority)
+{
+  if (this->Internal->Priority == priority)
+    {
+    return;
+    }
+  this->Internal->Priority = priority;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLCommandLineModuleNode::GetPriority() const
+{
+  return this->Internal->Priority;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLCommandLineModuleNode::SetNumberOfThreads(int numberOfThreads)
+{
+  numberOfThreads = numberOfThreads < 0 ? 0 : numberOfThreads;
+  if (this->Internal->NumberOfThreads == numberOfThreads)
+    {
+    return;
+    }
+  this->Internal->NumberOfThreads = numberOfThreads;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLCommandLineModuleNode::GetNumberOfThreads() const
+{
+  return this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLCommandLineModuleNode::SetAssignedNumberOfThreads(int numberOfThreads)
+{
+  // Set from the processing thread, no Modified() here.
+  this->Internal->AssignedNumberOfThreads = numberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLCommandLineModuleNode::GetAssignedNumberOfThreads() const
+{
+  return this->Internal->AssignedNumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetQueuedTime() const
+{
+  return this->Internal->QueuedTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetStartTime() const
+{
+  return this->Internal->StartTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetFinishTime() const
+{
+  return this->Internal->FinishTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetQueuedDuration() const
+{
+  if (this->Internal->QueuedTime == 0.)
+    {
+    return 0.;
+    }
+  double end = this->Internal->StartTime;
+  if (end == 0.)
+    {
+    end = this->Internal->FinishTime != 0. ?
+      this->Internal->FinishTime : vtkTimerLog::GetUniversalTime();
+    }
+  return end - this->Internal->QueuedTime;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLCommandLineModuleNode::GetRunningDuration() const
+{
+  if (this->Internal->StartTime == 0.)
+    {
+    return 0.;
+    }
+  double end = this->Internal->FinishTime != 0. ?
+    this->Internal->FinishTime : vtkTimerLog::GetUniversalTime();
+  return end - this->Internal->StartTime;
+}
+
 //----------------------------------------------------------------------------
 unsigned long vtkMRMLCommandLineModuleNode::GetLastRunTime() const
 {
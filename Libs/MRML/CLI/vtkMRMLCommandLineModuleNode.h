@@ -186,6 +186,48 @@ public:
   /// \sa SetAutoRunDelay(), GetAutoRun(), GetAutoRunMode()
   unsigned int GetAutoRunDelay()const;
 
+  /// Set the priority of the CLI execution. When several CLIs are scheduled,
+  /// the one with the highest priority is started first. 0 by default.
+  /// \sa GetPriority(), SetNumberOfThreads()
+  void SetPriority(int priority);
+  /// \sa SetPriority()
+  int GetPriority()const;
+
+  /// Set the number of threads (cores) the CLI should be run with.
+  /// 0 (default) lets the scheduler share the processing core budget between
+  /// the scheduled CLIs.
+  /// \sa GetNumberOfThreads(), GetAssignedNumberOfThreads(),
+  /// vtkSlicerApplicationLogic::SetProcessingCoreBudget()
+  void SetNumberOfThreads(int numberOfThreads);
+  /// \sa SetNumberOfThreads()
+  int GetNumberOfThreads()const;
+
+  /// Set the number of threads the CLI has been assigned by the scheduler
+  /// for the current run. Do not call manually, only the logic should set it.
+  /// \sa GetAssignedNumberOfThreads(), SetNumberOfThreads()
+  void SetAssignedNumberOfThreads(int numberOfThreads);
+  /// Return the number of threads the CLI is run with, 0 if it has not
+  /// been run yet.
+  /// \sa SetNumberOfThreads()
+  int GetAssignedNumberOfThreads()const;
+
+  /// Return the wall clock time (in seconds, vtkTimerLog::GetUniversalTime())
+  /// when the CLI was last Scheduled, started Running and finished
+  /// (Completed, CompletedWithErrors or Cancelled).
+  /// Times are 0 when the state has not been reached during the last run.
+  /// \sa GetQueuedDuration(), GetRunningDuration(), SetStatus()
+  double GetQueuedTime()const;
+  double GetStartTime()const;
+  double GetFinishTime()const;
+
+  /// Return the time (in seconds) the CLI waited in the queue before
+  /// starting to run and the time it ran during the last run.
+  /// If the CLI is still queued (resp. running), the duration up to now is
+  /// returned.
+  /// \sa GetQueuedTime(), GetStartTime(), GetFinishTime()
+  double GetQueuedDuration()const;
+  double GetRunningDuration()const;
+
   /// Return the last time the module was ran.
   /// \sa GetParameterMTime(), GetInputMTime(), GetMTime()
   unsigned long GetLastRunTime()const;
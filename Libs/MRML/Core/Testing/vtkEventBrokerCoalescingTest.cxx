@@ -0,0 +1,264 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct CallRecorder
+{
+  std::vector<unsigned long> Events;
+  std::vector<vtkEventBroker::CoalescedCallList> CoalescedCalls;
+  /// Class names of the nodes of the coalesced node events, read when the
+  /// calls are delivered
+  std::vector<std::string> NodeClassNames;
+
+  /// Coalesced calls of \a event, NULL if none
+  const vtkEventBroker::CoalescedCallList* GetCoalescedCalls(unsigned long event)
+    {
+    for (size_t i = 0; i < this->CoalescedCalls.size(); ++i)
+      {
+      if (this->CoalescedCalls[i].size() > 0 &&
+          this->CoalescedCalls[i][0].EventID == event)
+        {
+        return &this->CoalescedCalls[i];
+        }
+      }
+    return 0;
+    }
+
+  void Clear()
+    {
+    this->Events.clear();
+    this->CoalescedCalls.clear();
+    this->NodeClassNames.clear();
+    }
+};
+
+//----------------------------------------------------------------------------
+void RecordCall(vtkObject* vtkNotUsed(caller), unsigned long eid,
+                void* clientData, void* callData)
+{
+  CallRecorder* recorder = reinterpret_cast<CallRecorder*>(clientData);
+  recorder->Events.push_back(eid);
+  if (eid == vtkEventBroker::CoalescedEvent)
+    {
+    vtkEventBroker::CoalescedCallList* calls =
+      reinterpret_cast<vtkEventBroker::CoalescedCallList*>(callData);
+    recorder->CoalescedCalls.push_back(*calls);
+    for (size_t i = 0; i < calls->size(); ++i)
+      {
+      if ((*calls)[i].EventID != vtkCommand::ModifiedEvent)
+        {
+        recorder->NodeClassNames.push_back(
+          reinterpret_cast<vtkMRMLNode*>((*calls)[i].CallData)->GetClassName());
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* AddModel(vtkMRMLScene* scene)
+{
+  vtkNew<vtkMRMLModelNode> model;
+  return scene->AddNode(model.GetPointer());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerCoalescingTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[] )
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkObject> observer;
+
+  CallRecorder coalescedRecorder;
+  vtkNew<vtkCallbackCommand> coalescedCallback;
+  coalescedCallback->SetCallback(RecordCall);
+  coalescedCallback->SetClientData(&coalescedRecorder);
+  vtkObservation* addedObservation = broker->AddObservation(
+    scene.GetPointer(), vtkMRMLScene::NodeAddedEvent, observer.GetPointer(),
+    coalescedCallback.GetPointer());
+  addedObservation->CoalesceEventsOn();
+  vtkObservation* modifiedObservation = broker->AddObservation(
+    scene.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(),
+    coalescedCallback.GetPointer());
+  modifiedObservation->CoalesceEventsOn();
+
+  CallRecorder recorder;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(RecordCall);
+  callback->SetClientData(&recorder);
+  broker->AddObservation(
+    scene.GetPointer(), vtkMRMLScene::NodeAddedEvent, observer.GetPointer(),
+    callback.GetPointer());
+
+  // Outside of a batch process, the events are not coalesced
+  AddModel(scene.GetPointer());
+  if (coalescedRecorder.Events.size() != 2 ||
+      coalescedRecorder.Events[0] != vtkMRMLScene::NodeAddedEvent ||
+      coalescedRecorder.Events[1] != vtkCommand::ModifiedEvent ||
+      recorder.Events.size() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": events coalesced outside of a batch"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  coalescedRecorder.Clear();
+  recorder.Clear();
+
+  // In a nested batch process, the coalesced events are delivered once at
+  // the end of the outermost batch
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  vtkMRMLNode* model1 = AddModel(scene.GetPointer());
+  scene->StartState(vtkMRMLScene::ImportState);
+  vtkMRMLNode* model2 = AddModel(scene.GetPointer());
+  scene->EndState(vtkMRMLScene::ImportState);
+  vtkMRMLNode* model3 = AddModel(scene.GetPointer());
+  scene->Modified();
+  scene->Modified();
+  if (coalescedRecorder.Events.size() != 0 ||
+      broker->GetNumberOfCoalescedObservations() != 2 ||
+      recorder.Events.size() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": events not coalesced in a batch"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (broker->GetCoalescing(scene.GetPointer()) != 0 ||
+      coalescedRecorder.Events.size() != 2 ||
+      coalescedRecorder.Events[0] != vtkEventBroker::CoalescedEvent ||
+      coalescedRecorder.Events[1] != vtkEventBroker::CoalescedEvent ||
+      broker->GetNumberOfCoalescedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": coalesced events not delivered"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  // The modified events are collapsed into one call
+  const vtkEventBroker::CoalescedCallList* modifiedCalls =
+    coalescedRecorder.GetCoalescedCalls(vtkCommand::ModifiedEvent);
+  if (!modifiedCalls || modifiedCalls->size() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": modified events not collapsed"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The added nodes are delivered in order
+  const vtkEventBroker::CoalescedCallList* addedCalls =
+    coalescedRecorder.GetCoalescedCalls(vtkMRMLScene::NodeAddedEvent);
+  if (!addedCalls ||
+      addedCalls->size() != 3 ||
+      (*addedCalls)[0].CallData != model1 ||
+      (*addedCalls)[1].CallData != model2 ||
+      (*addedCalls)[2].CallData != model3)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong coalesced added nodes"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removed observations are not invoked
+  coalescedRecorder.Clear();
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  AddModel(scene.GetPointer());
+  broker->RemoveObservation(addedObservation);
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (coalescedRecorder.Events.size() != 1 ||
+      coalescedRecorder.GetCoalescedCalls(vtkMRMLScene::NodeAddedEvent))
+    {
+    std::cerr << "Line " << __LINE__ << ": removed observation invoked"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A node removed in the batch is still valid when its removal is delivered,
+  // and released afterwards
+  vtkObservation* removedObservation = broker->AddObservation(
+    scene.GetPointer(), vtkMRMLScene::NodeRemovedEvent, observer.GetPointer(),
+    coalescedCallback.GetPointer());
+  removedObservation->CoalesceEventsOn();
+  coalescedRecorder.Clear();
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  vtkWeakPointer<vtkMRMLNode> removedModel = AddModel(scene.GetPointer());
+  scene->RemoveNode(removedModel);
+  if (removedModel.GetPointer() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": removed node not referenced"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (coalescedRecorder.NodeClassNames.size() != 1 ||
+      coalescedRecorder.NodeClassNames[0] != "vtkMRMLModelNode" ||
+      removedModel.GetPointer() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": removed node not delivered or not released"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The batch of another scene does not coalesce the events of this scene
+  vtkNew<vtkMRMLScene> otherScene;
+  coalescedRecorder.Clear();
+  otherScene->StartState(vtkMRMLScene::BatchProcessState);
+  AddModel(scene.GetPointer());
+  if (broker->GetCoalescing(otherScene.GetPointer()) != 1 ||
+      broker->GetCoalescing(scene.GetPointer()) != 0 ||
+      coalescedRecorder.Events.size() != 1 ||
+      coalescedRecorder.Events[0] != vtkCommand::ModifiedEvent)
+    {
+    std::cerr << "Line " << __LINE__ << ": events coalesced by another scene"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  otherScene->EndState(vtkMRMLScene::BatchProcessState);
+
+  // A scene deleted in a batch process stops coalescing
+  vtkMRMLScene* deletedScene = vtkMRMLScene::New();
+  vtkObservation* deletedSceneObservation = broker->AddObservation(
+    deletedScene, vtkCommand::ModifiedEvent, observer.GetPointer(),
+    coalescedCallback.GetPointer());
+  deletedSceneObservation->CoalesceEventsOn();
+  deletedScene->StartState(vtkMRMLScene::BatchProcessState);
+  AddModel(deletedScene);
+  deletedScene->Delete();
+  if (broker->GetCoalescing(deletedScene) != 0 ||
+      broker->GetNumberOfCoalescedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": deleted scene still coalescing"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void FastCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                  void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+}
+
+//----------------------------------------------------------------------------
+void SlowCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                  void* vtkNotUsed(clientData), void* vtkNotUsed(callData))
+{
+  double start = vtkTimerLog::GetUniversalTime();
+  while (vtkTimerLog::GetUniversalTime() - start < 0.002)
+    {
+    }
+}
+
+//----------------------------------------------------------------------------
+void CountStorm(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerStatisticsTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[] )
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  vtkNew<vtkObject> subject;
+  vtkNew<vtkObject> observer;
+
+  vtkNew<vtkCallbackCommand> fastCallback;
+  fastCallback->SetCallback(FastCallback);
+  vtkObservation* fastObservation = broker->AddObservation(
+    subject.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(),
+    fastCallback.GetPointer());
+  vtkNew<vtkCallbackCommand> slowCallback;
+  slowCallback->SetCallback(SlowCallback);
+  vtkObservation* slowObservation = broker->AddObservation(
+    subject.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(),
+    slowCallback.GetPointer());
+
+  // Invocations are counted and timed
+  broker->ResetObservationStatistics();
+  for (int i = 0; i < 5; ++i)
+    {
+    subject->Modified();
+    }
+  if (fastObservation->GetInvocationCount() != 5 ||
+      slowObservation->GetInvocationCount() != 5 ||
+      slowObservation->GetTotalElapsedTime() < 5 * 0.002)
+    {
+    std::cerr << "Line " << __LINE__ << ": invocations not counted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkCollection* slowest = broker->GetSlowestObservations(1);
+  if (slowest->GetNumberOfItems() != 1 ||
+      slowest->GetItemAsObject(0) != slowObservation)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong slowest observation" << std::endl;
+    slowest->Delete();
+    return EXIT_FAILURE;
+    }
+  slowest->Delete();
+  broker->PrintObservationStatistics(std::cout, vtkIndent(), 2);
+
+  broker->ResetObservationStatistics();
+  if (slowObservation->GetInvocationCount() != 0 ||
+      slowObservation->GetTotalElapsedTime() != 0.)
+    {
+    std::cerr << "Line " << __LINE__ << ": statistics not reset" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A storm is reported once per subject, event and second, whatever the
+  // number of observations of the event
+  int storms = 0;
+  vtkNew<vtkCallbackCommand> stormCallback;
+  stormCallback->SetCallback(CountStorm);
+  stormCallback->SetClientData(&storms);
+  broker->AddObserver(vtkEventBroker::EventStormEvent, stormCallback.GetPointer());
+  int numberOfEventStorms = broker->GetNumberOfEventStorms();
+  broker->SetEventStormThreshold(3);
+  for (int i = 0; i < 10; ++i)
+    {
+    subject->Modified();
+    }
+  broker->SetEventStormThreshold(0);
+  broker->RemoveObserver(stormCallback.GetPointer());
+  if (storms != 1 ||
+      broker->GetNumberOfEventStorms() != numberOfEventStorms + 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": event storm reported " << storms
+              << " times" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  return EXIT_SUCCESS;
+}
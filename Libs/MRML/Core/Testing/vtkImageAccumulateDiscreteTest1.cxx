@@ -0,0 +1,111 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageAccumulateDiscrete.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckHistogram(vtkImageData* image, int numberOfThreads,
+                    const std::vector<int>& expected, int line)
+{
+  vtkNew<vtkImageAccumulateDiscrete> accumulate;
+  accumulate->SetInput(image);
+  accumulate->SetNumberOfThreads(numberOfThreads);
+  accumulate->Update();
+  int* histogram = static_cast<int*>(accumulate->GetOutput()->GetScalarPointer());
+  for (int bin = 0; bin < static_cast<int>(expected.size()); ++bin)
+    {
+    if (histogram[bin] != expected[bin])
+      {
+      std::cerr << "Line " << line << ": " << numberOfThreads << " threads: bin "
+                << bin << " has " << histogram[bin] << " voxels, expected "
+                << expected[bin] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageAccumulateDiscreteTest1(int , char * [] )
+{
+  vtkNew<vtkImageAccumulateDiscrete> node1;
+  EXERCISE_BASIC_OBJECT_METHODS(node1.GetPointer());
+
+  // Image with an extent that does not start at 0
+  vtkNew<vtkImageData> image;
+  image->SetExtent(2, 51, -3, 36, 5, 34);
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  std::vector<int> expected(65536, 0);
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+    {
+    voxels[i] = static_cast<short>((i * 7919) % 3000 - 1000);
+    ++expected[voxels[i] + 32768];
+    }
+
+  // The histogram does not depend on the number of threads
+  if (!CheckHistogram(image.GetPointer(), 1, expected, __LINE__) ||
+      !CheckHistogram(image.GetPointer(), 3, expected, __LINE__) ||
+      !CheckHistogram(image.GetPointer(), 8, expected, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Sampled histogram
+  int extent[6] = {0, 99, 0, 99, 0, 99};
+  if (vtkImageAccumulateDiscrete::ComputeSampleStride(extent, 0) != 1 ||
+      vtkImageAccumulateDiscrete::ComputeSampleStride(extent, 1000000) != 1 ||
+      vtkImageAccumulateDiscrete::ComputeSampleStride(extent, 999999) != 2 ||
+      vtkImageAccumulateDiscrete::ComputeSampleStride(extent, 1000) != 10 ||
+      vtkImageAccumulateDiscrete::ComputeSampleStride(extent, 1) != 100)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong sample stride" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkImageAccumulateDiscrete> accumulate;
+  accumulate->SetInput(image.GetPointer());
+  accumulate->SetMaximumNumberOfSamples(image->GetNumberOfPoints() / 8);
+  accumulate->Update();
+  int* histogram = static_cast<int*>(accumulate->GetOutput()->GetScalarPointer());
+  vtkIdType numberOfSamples = 0;
+  for (int bin = 0; bin < 65536; ++bin)
+    {
+    numberOfSamples += histogram[bin];
+    }
+  if (accumulate->GetSampleStride() != 2 ||
+      numberOfSamples != 25 * 20 * 15)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfSamples
+              << " voxels sampled with a stride of "
+              << accumulate->GetSampleStride() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
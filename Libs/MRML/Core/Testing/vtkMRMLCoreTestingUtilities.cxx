@@ -0,0 +1,80 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScalarVolumeNode.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace vtkMRMLCoreTestingUtilities
+{
+
+//----------------------------------------------------------------------------
+bool CompareVolumes(vtkMRMLScalarVolumeNode* volume1,
+                    vtkMRMLScalarVolumeNode* volume2)
+{
+  if (!volume1 || !volume2 ||
+      !volume1->GetImageData() || !volume2->GetImageData())
+    {
+    std::cerr << "CompareVolumes: missing volume or image data" << std::endl;
+    return false;
+    }
+  vtkImageData* image1 = volume1->GetImageData();
+  vtkImageData* image2 = volume2->GetImageData();
+  int extent1[6];
+  int extent2[6];
+  image1->GetExtent(extent1);
+  image2->GetExtent(extent2);
+  vtkNew<vtkMatrix4x4> rasToIJK1;
+  vtkNew<vtkMatrix4x4> rasToIJK2;
+  volume1->GetRASToIJKMatrix(rasToIJK1.GetPointer());
+  volume2->GetRASToIJKMatrix(rasToIJK2.GetPointer());
+  for (int i = 0; i < 16; ++i)
+    {
+    if (rasToIJK1->GetElement(i / 4, i % 4) != rasToIJK2->GetElement(i / 4, i % 4))
+      {
+      std::cerr << "CompareVolumes: RAS to IJK matrices differ" << std::endl;
+      return false;
+      }
+    }
+  if (memcmp(extent1, extent2, sizeof(extent1)) != 0 ||
+      image1->GetScalarType() != image2->GetScalarType() ||
+      image1->GetNumberOfScalarComponents() != image2->GetNumberOfScalarComponents() ||
+      volume1->GetLabelMap() != volume2->GetLabelMap())
+    {
+    std::cerr << "CompareVolumes: image geometries differ" << std::endl;
+    return false;
+    }
+  vtkDataArray* scalars1 = image1->GetPointData()->GetScalars();
+  vtkDataArray* scalars2 = image2->GetPointData()->GetScalars();
+  if (scalars1->GetNumberOfTuples() != scalars2->GetNumberOfTuples() ||
+      memcmp(scalars1->GetVoidPointer(0), scalars2->GetVoidPointer(0),
+             scalars1->GetNumberOfTuples() * scalars1->GetNumberOfComponents() *
+             scalars1->GetDataTypeSize()) != 0)
+    {
+    std::cerr << "CompareVolumes: image scalars differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of vtkMRMLCoreTestingUtilities namespace
@@ -0,0 +1,32 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLCoreTestingUtilities_h
+#define __vtkMRMLCoreTestingUtilities_h
+
+class vtkMRMLScalarVolumeNode;
+
+//---------------------------------------------------------------------------
+// Utility functions shared by the MRML Core tests
+namespace vtkMRMLCoreTestingUtilities
+{
+
+//---------------------------------------------------------------------------
+// Return true if the two volumes have the same geometry (RAS to IJK matrix,
+// extent), the same label map flag and the same scalars. The first
+// difference is printed on std::cerr.
+bool CompareVolumes(vtkMRMLScalarVolumeNode* volume1,
+                    vtkMRMLScalarVolumeNode* volume2);
+
+} // end of vtkMRMLCoreTestingUtilities namespace
+
+#endif
@@ -0,0 +1,109 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckTranslationToWorld(vtkMRMLLinearTransformNode* node, double expected, int line)
+{
+  vtkNew<vtkMatrix4x4> transformToWorld;
+  if (!node->GetMatrixTransformToWorld(transformToWorld.GetPointer()) ||
+      transformToWorld->GetElement(0, 3) != expected)
+    {
+    std::cerr << "Line " << line << ": wrong translation to world "
+              << transformToWorld->GetElement(0, 3) << ", expected "
+              << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLLinearTransformNodeTransformToWorldTest(int vtkNotUsed(argc),
+                                                   char * vtkNotUsed(argv)[] )
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // A chain of 5 transforms translating by 1, 2, 4, 8 and 16 mm
+  const int depth = 5;
+  vtkNew<vtkMRMLLinearTransformNode> nodes[depth];
+  for (int i = 0; i < depth; ++i)
+    {
+    scene->AddNode(nodes[i].GetPointer());
+    nodes[i]->GetMatrixTransformToParent()->SetElement(0, 3, 1 << i);
+    if (i > 0)
+      {
+      nodes[i]->SetAndObserveTransformNodeID(nodes[i - 1]->GetID());
+      }
+    }
+  vtkMRMLLinearTransformNode* leaf = nodes[depth - 1].GetPointer();
+  if (!CheckTranslationToWorld(leaf, 31., __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Nothing changed, the cached matrix is used
+  unsigned long generation = leaf->GetTransformToWorldGeneration();
+  if (!CheckTranslationToWorld(leaf, 31., __LINE__) ||
+      leaf->GetTransformToWorldGeneration() != generation)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Modifying the root invalidates the whole chain
+  nodes[0]->GetMatrixTransformToParent()->SetElement(0, 3, 101.);
+  if (leaf->GetTransformToWorldGeneration() == generation ||
+      !CheckTranslationToWorld(leaf, 131., __LINE__) ||
+      !CheckTranslationToWorld(nodes[2].GetPointer(), 107., __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Reparenting a node in the middle of the chain
+  nodes[3]->SetAndObserveTransformNodeID(nodes[1]->GetID());
+  if (!CheckTranslationToWorld(leaf, 127., __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Removing a parent from the scene
+  scene->RemoveNode(nodes[1].GetPointer());
+  if (!CheckTranslationToWorld(leaf, 24., __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A matrix set after the cache was computed
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(0, 3, 32.);
+  leaf->SetAndObserveMatrixTransformToParent(matrix.GetPointer());
+  if (!CheckTranslationToWorld(leaf, 40., __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -15,6 +15,9 @@
 
 #include "vtkMRMLCoreTestingMacros.h"
 
+// STD includes
+#include <sstream>
+
 int vtkMRMLScalarVolumeDisplayNodeTest1(int , char * [] )
 {
   vtkNew<vtkMRMLScalarVolumeDisplayNode> node1;
@@ -22,6 +25,30 @@ int vtkMRMLScalarVolumeDisplayNodeTest1(int , char * [] )
   EXERCISE_BASIC_OBJECT_METHODS(node1.GetPointer());
 
   EXERCISE_BASIC_DISPLAY_MRML_METHODS(vtkMRMLScalarVolumeDisplayNode, node1.GetPointer());
-  
+
+  // The auto levels sampling is saved, restored and copied
+  node1->SetAutoLevelsMaximumNumberOfSamples(5000);
+  std::stringstream xml;
+  node1->WriteXML(xml, 0);
+  if (xml.str().find("autoLevelsMaximumNumberOfSamples=\"5000\"") == std::string::npos)
+    {
+    std::cerr << "WriteXML failed to write autoLevelsMaximumNumberOfSamples: "
+              << xml.str() << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* atts[] = {"autoLevelsMaximumNumberOfSamples", "5000", NULL};
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> node2;
+  node2->ReadXMLAttributes(atts);
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> node3;
+  node3->Copy(node1.GetPointer());
+  if (node2->GetAutoLevelsMaximumNumberOfSamples() != 5000 ||
+      node3->GetAutoLevelsMaximumNumberOfSamples() != 5000)
+    {
+    std::cerr << "AutoLevelsMaximumNumberOfSamples not restored: "
+              << node2->GetAutoLevelsMaximumNumberOfSamples() << " "
+              << node3->GetAutoLevelsMaximumNumberOfSamples() << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,122 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+bool CheckPhaseTimes(vtkMRMLScene* scene, int numberOfPhasesRun)
+{
+  double phasesTime = 0.;
+  for (int phase = 0; phase < vtkMRMLScene::NumberOfImportPhases; ++phase)
+    {
+    double phaseTime = scene->GetImportPhaseTime(phase);
+    if (phase < numberOfPhasesRun && phaseTime < 0.)
+      {
+      std::cerr << "Import phase " << phase << " was not timed" << std::endl;
+      return false;
+      }
+    if (phase >= numberOfPhasesRun && phaseTime != -1.)
+      {
+      std::cerr << "Import phase " << phase << " did not run but took "
+                << phaseTime << "s" << std::endl;
+      return false;
+      }
+    if (phaseTime > 0.)
+      {
+      phasesTime += phaseTime;
+      }
+    }
+  // Tolerance for the rounding errors of the sum
+  if (fabs(phasesTime - scene->GetImportTime()) > 1e-6)
+    {
+    std::cerr << "Import phases took " << phasesTime << "s, import took "
+              << scene->GetImportTime() << "s" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneImportPhaseTimesTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  vtkNew<vtkMRMLScene> scene;
+  if (scene->GetImportTime() != -1. ||
+      !CheckPhaseTimes(scene.GetPointer(), 0))
+    {
+    std::cerr << "A scene that never imported has import times" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Add nodes that conflict with the imported ones so that all the phases
+  // have something to do
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  vtkNew<vtkMRMLModelDisplayNode> modelDisplayNode;
+  scene->AddNode(modelDisplayNode.GetPointer());
+  modelNode->SetAndObserveDisplayNodeID(modelDisplayNode->GetID());
+
+  const char sceneXML[] =
+    "<MRML  version=\"18916\" userTags=\"\">"
+    "  <Model id=\"vtkMRMLModelNode1\" name=\"New Model1\" displayNodeRef=\"vtkMRMLModelDisplayNode1\" ></Model>"
+    "  <ModelDisplay id=\"vtkMRMLModelDisplayNode1\" name=\"New Display 1\" ></ModelDisplay>"
+    "</MRML>"
+    ;
+  scene->SetSceneXMLString(sceneXML);
+  scene->SetLoadFromXMLString(1);
+  if (!scene->Import() || scene->GetNumberOfNodes() != 4)
+    {
+    std::cerr << "Failed to import scene" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckPhaseTimes(scene.GetPointer(), vtkMRMLScene::NumberOfImportPhases))
+    {
+    std::cerr << "Import failed to time its phases" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->PrintImportSummary(std::cout, vtkIndent());
+
+  // Only the parsing runs when the scene fails to parse, the times of the
+  // previous import are not kept
+  scene->SetSceneXMLString("");
+  if (scene->Import())
+    {
+    std::cerr << "Import of an empty scene string succeeded" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckPhaseTimes(scene.GetPointer(), 1))
+    {
+    std::cerr << "Failed import failed to time its phases" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+bool CheckNodesByClass(vtkMRMLScene* scene, const char* className, int line)
+{
+  // Compute the expected result the slow way.
+  std::vector<vtkMRMLNode*> expectedNodes;
+  for (int i = 0; i < scene->GetNumberOfNodes(); ++i)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(i);
+    if (node->IsA(className))
+      {
+      expectedNodes.push_back(node);
+      }
+    }
+
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass(className, nodes);
+  vtkCollection* nodeCollection = scene->GetNodesByClass(className);
+  int numberOfNodes = scene->GetNumberOfNodesByClass(className);
+  bool success = (nodes == expectedNodes) &&
+    nodeCollection->GetNumberOfItems() == static_cast<int>(expectedNodes.size()) &&
+    numberOfNodes == static_cast<int>(expectedNodes.size());
+  for (int i = 0; success && i < numberOfNodes; ++i)
+    {
+    success = (nodeCollection->GetItemAsObject(i) == expectedNodes[i]) &&
+      (scene->GetNthNodeByClass(i, className) == expectedNodes[i]);
+    }
+  nodeCollection->Delete();
+  if (scene->GetNthNodeByClass(numberOfNodes, className) != 0)
+    {
+    success = false;
+    }
+  if (!success)
+    {
+    std::cerr << "Line " << line << ": GetNodesByClass(" << className << ")"
+              << " failed: " << numberOfNodes << " nodes found, "
+              << expectedNodes.size() << " expected." << std::endl;
+    }
+  return success;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByClassTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // Populate the class cache before adding nodes.
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLTransformNode", __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLModelNode> model1;
+  scene->AddNode(model1.GetPointer());
+  vtkNew<vtkMRMLLinearTransformNode> transform1;
+  scene->AddNode(transform1.GetPointer());
+  vtkNew<vtkMRMLModelNode> model2;
+  scene->AddNode(model2.GetPointer());
+
+  // Superclasses must list the nodes as well.
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLTransformNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLNode", __LINE__) ||
+      scene->GetNumberOfNodesByClass("vtkMRMLModelNode") != 2)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Insertion in the middle of the scene must keep the collection order.
+  vtkNew<vtkMRMLModelNode> model3;
+  scene->InsertBeforeNode(model1.GetPointer(), model3.GetPointer());
+  vtkNew<vtkMRMLModelNode> model4;
+  scene->InsertAfterNode(transform1.GetPointer(), model4.GetPointer());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLNode", __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  scene->RemoveNode(model1.GetPointer());
+  scene->RemoveNode(transform1.GetPointer());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLTransformNode", __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLNode", __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  scene->Clear(1);
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", __LINE__) ||
+      scene->GetNumberOfNodesByClass("vtkMRMLNode") != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
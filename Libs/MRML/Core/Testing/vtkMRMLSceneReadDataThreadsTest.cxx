@@ -0,0 +1,129 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLStorageNode.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+const char* VolumeIDs[3] = {"vtkMRMLScalarVolumeNode1",
+                            "vtkMRMLScalarVolumeNode2",
+                            "vtkMRMLScalarVolumeNode3"};
+
+const char SceneXML[] =
+  "<MRML  version=\"Slicer4\" userTags=\"\">"
+  "  <Volume id=\"vtkMRMLScalarVolumeNode1\" name=\"fixed\""
+  "    storageNodeRef=\"vtkMRMLVolumeArchetypeStorageNode1\" ></Volume>"
+  "  <VolumeArchetypeStorage id=\"vtkMRMLVolumeArchetypeStorageNode1\""
+  "    fileName=\"fixed.nrrd\" ></VolumeArchetypeStorage>"
+  "  <Volume id=\"vtkMRMLScalarVolumeNode2\" name=\"moving\""
+  "    storageNodeRef=\"vtkMRMLVolumeArchetypeStorageNode2\" ></Volume>"
+  "  <VolumeArchetypeStorage id=\"vtkMRMLVolumeArchetypeStorageNode2\""
+  "    fileName=\"moving.nrrd\" ></VolumeArchetypeStorage>"
+  "  <Volume id=\"vtkMRMLScalarVolumeNode3\" name=\"helixMask\" labelMap=\"1\""
+  "    storageNodeRef=\"vtkMRMLVolumeArchetypeStorageNode3\" ></Volume>"
+  "  <VolumeArchetypeStorage id=\"vtkMRMLVolumeArchetypeStorageNode3\""
+  "    fileName=\"helixMask.nrrd\" ></VolumeArchetypeStorage>"
+  "  <Volume id=\"vtkMRMLScalarVolumeNode4\" name=\"missing\""
+  "    storageNodeRef=\"vtkMRMLVolumeArchetypeStorageNode4\" ></Volume>"
+  "  <VolumeArchetypeStorage id=\"vtkMRMLVolumeArchetypeStorageNode4\""
+  "    fileName=\"missing.nrrd\" ></VolumeArchetypeStorage>"
+  "</MRML>";
+
+//----------------------------------------------------------------------------
+bool ImportScene(vtkMRMLScene* scene, const char* dataDirectory, int numberOfThreads)
+{
+  scene->SetRootDirectory(dataDirectory);
+  scene->SetLoadFromXMLString(1);
+  scene->SetSceneXMLString(SceneXML);
+  scene->SetNumberOfReadDataThreads(numberOfThreads);
+  scene->Import();
+
+  // The missing file is reported
+  if (scene->GetErrorCode() != 1)
+    {
+    std::cerr << "Missing file not reported with " << numberOfThreads
+              << " threads" << std::endl;
+    return false;
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+      scene->GetNodeByID(VolumeIDs[i]));
+    if (!volumeNode || !volumeNode->GetImageData() ||
+        !volumeNode->GetStorageNode() ||
+        scene->GetReadDataTime(volumeNode->GetStorageNode()->GetID()) < 0.)
+      {
+      std::cerr << "Failed to read " << VolumeIDs[i] << " with "
+                << numberOfThreads << " threads" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkMRMLSceneReadDataThreadsTest <test data directory>
+int vtkMRMLSceneReadDataThreadsTest(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkMRMLSceneReadDataThreadsTest <test data directory>"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* dataDirectory = argv[1];
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScene> threadedScene;
+  if (!ImportScene(scene.GetPointer(), dataDirectory, 1) ||
+      !ImportScene(threadedScene.GetPointer(), dataDirectory, 3))
+    {
+    return EXIT_FAILURE;
+    }
+
+  for (int i = 0; i < 3; ++i)
+    {
+    if (!vtkMRMLCoreTestingUtilities::CompareVolumes(
+          vtkMRMLScalarVolumeNode::SafeDownCast(scene->GetNodeByID(VolumeIDs[i])),
+          vtkMRMLScalarVolumeNode::SafeDownCast(threadedScene->GetNodeByID(VolumeIDs[i]))))
+      {
+      std::cerr << VolumeIDs[i] << " differs when read with 3 threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The volumes read in parallel are not considered modified
+  if (scene->GetStorableNodesModifiedSinceRead() !=
+      threadedScene->GetStorableNodesModifiedSinceRead())
+    {
+    std::cerr << "Line " << __LINE__ << ": modified since read differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  threadedScene->PrintReadDataSummary(std::cout, vtkIndent());
+
+  return EXIT_SUCCESS;
+}
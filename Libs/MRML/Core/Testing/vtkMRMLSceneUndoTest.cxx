@@ -0,0 +1,173 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <string>
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [])
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLModelNode> model1;
+  model1->SetName("Model1");
+  scene->AddNode(model1.GetPointer());
+  vtkNew<vtkMRMLModelNode> model2;
+  model2->SetName("Model2");
+  scene->AddNode(model2.GetPointer());
+
+  // Save the scene a few times, only model1 is modified in between.
+  scene->SaveStateForUndo();
+  model1->SetName("Model1 modified");
+  scene->SaveStateForUndo();
+  model1->SetName("Model1 modified twice");
+  scene->SaveStateForUndo();
+  model1->SetName("Model1 modified three times");
+  if (scene->GetNumberOfUndoLevels() != 3)
+    {
+    std::cerr << "SaveStateForUndo failed: " << scene->GetNumberOfUndoLevels()
+              << " undo levels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Remove model2 and restore it
+  scene->SaveStateForUndo();
+  scene->RemoveNode(model2.GetPointer());
+  scene->Undo();
+  vtkMRMLNode* restoredModel2 = scene->GetFirstNodeByName("Model2");
+  if (!restoredModel2 || scene->GetNumberOfNodes() != 2)
+    {
+    std::cerr << "Undo failed to restore removed node" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Undo the modifications of model1
+  scene->Undo();
+  if (strcmp(model1->GetName(), "Model1 modified twice") != 0)
+    {
+    std::cerr << "Undo failed: " << model1->GetName() << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  scene->Undo();
+  if (strcmp(model1->GetName(), "Model1") != 0 ||
+      strcmp(restoredModel2->GetName(), "Model2") != 0 ||
+      scene->GetNumberOfUndoLevels() != 0)
+    {
+    std::cerr << "Undo failed: " << model1->GetName() << " "
+              << restoredModel2->GetName() << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Redo();
+  if (strcmp(model1->GetName(), "Model1 modified") != 0)
+    {
+    std::cerr << "Redo failed: " << model1->GetName() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Stack size
+  scene->ClearUndoStack();
+  scene->ClearRedoStack();
+  scene->SetUndoStackSize(2);
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo(model1.GetPointer());
+    model1->SetName("Model1 modified in loop");
+    }
+  if (scene->GetNumberOfUndoLevels() != 2)
+    {
+    std::cerr << "UndoStackSize failed: " << scene->GetNumberOfUndoLevels()
+              << " undo levels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory budget: the most recent step is always kept.
+  scene->ClearUndoStack();
+  scene->SetUndoStackSize(100);
+  scene->SetUndoStackMemoryBudget(1);
+  for (int i = 0; i < 50; ++i)
+    {
+    model1->SetAttribute("UndoTest", "a value to make the snapshot bigger");
+    scene->SaveStateForUndo();
+    model1->Modified();
+    }
+  if (scene->GetNumberOfUndoLevels() < 1 ||
+      scene->GetNumberOfUndoLevels() >= 50 ||
+      (scene->GetNumberOfUndoLevels() > 1 &&
+       scene->GetUndoStackMemorySize() > scene->GetUndoStackMemoryBudget()))
+    {
+    std::cerr << "UndoStackMemoryBudget failed: "
+              << scene->GetNumberOfUndoLevels() << " undo levels, "
+              << scene->GetUndoStackMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A snapshot shared with a more recent step stays in the budget when the
+  // step that created it is discarded.
+  scene->ClearUndoStack();
+  scene->SetUndoStackSize(2);
+  scene->SetUndoStackMemoryBudget(1000);
+  restoredModel2->SetAttribute("UndoTest", std::string(20 * 1024, 'x').c_str());
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo();
+    model1->Modified();
+    }
+  if (scene->GetNumberOfUndoLevels() != 2 ||
+      scene->GetUndoStackMemorySize() < 20)
+    {
+    std::cerr << "UndoStackMemoryBudget failed to count shared snapshots: "
+              << scene->GetNumberOfUndoLevels() << " undo levels, "
+              << scene->GetUndoStackMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  scene->Undo();
+  if (scene->GetNumberOfUndoLevels() != 0 ||
+      scene->GetUndoStackMemorySize() != 0)
+    {
+    std::cerr << "UndoStackMemoryBudget failed to release snapshots: "
+              << scene->GetUndoStackMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A snapshot reused after the last step using it was discarded is counted
+  // again.
+  scene->SetUndoStackSize(1);
+  scene->SaveStateForUndo(restoredModel2);
+  scene->SaveStateForUndo(model1.GetPointer());
+  scene->SaveStateForUndo(restoredModel2);
+  if (scene->GetNumberOfUndoLevels() != 1 ||
+      scene->GetUndoStackMemorySize() < 20)
+    {
+    std::cerr << "UndoStackMemoryBudget failed to count reused snapshots: "
+              << scene->GetNumberOfUndoLevels() << " undo levels, "
+              << scene->GetUndoStackMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLNRRDStorageNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+const char* FileNames[3] = {"fixed.nrrd", "moving.nrrd", "helixMask.nrrd"};
+
+//----------------------------------------------------------------------------
+void ProgressCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                      void* clientData, void* callData)
+{
+  *reinterpret_cast<double*>(clientData) = *reinterpret_cast<double*>(callData);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkMRMLSceneWriteDataThreadsTest <test data directory>
+//          <temporary directory>
+int vtkMRMLSceneWriteDataThreadsTest(int argc, char * argv[] )
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: vtkMRMLSceneWriteDataThreadsTest <test data directory>"
+              << " <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string dataDirectory = argv[1];
+  std::string temporaryDirectory = argv[2];
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkCollection> nodesToWrite;
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    vtkNew<vtkMRMLVolumeArchetypeStorageNode> readStorageNode;
+    readStorageNode->SetFileName((dataDirectory + "/" + FileNames[i]).c_str());
+    if (!readStorageNode->ReadData(volumeNode.GetPointer()))
+      {
+      std::cerr << "Failed to read " << FileNames[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkNew<vtkMRMLNRRDStorageNode> storageNode;
+    storageNode->SetFileName(
+      (temporaryDirectory + "/vtkMRMLSceneWriteDataThreadsTest_" + FileNames[i]).c_str());
+    scene->AddNode(storageNode.GetPointer());
+    scene->AddNode(volumeNode.GetPointer());
+    volumeNode->SetAndObserveStorageNodeID(storageNode->GetID());
+    nodesToWrite->AddItem(volumeNode.GetPointer());
+    }
+
+  double progress = 0.;
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetCallback(ProgressCallback);
+  progressCallback->SetClientData(&progress);
+  scene->AddObserver(vtkCommand::ProgressEvent, progressCallback.GetPointer());
+
+  scene->SetNumberOfWriteDataThreads(3);
+  if (!scene->WriteDataInParallel(nodesToWrite.GetPointer()))
+    {
+    std::cerr << "WriteDataInParallel failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (progress != 1.)
+    {
+    std::cerr << "WriteDataInParallel reported a progress of " << progress
+              << " instead of 1" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The files written concurrently contain the volumes
+  for (int i = 0; i < nodesToWrite->GetNumberOfItems(); ++i)
+    {
+    vtkMRMLScalarVolumeNode* volumeNode =
+      vtkMRMLScalarVolumeNode::SafeDownCast(nodesToWrite->GetItemAsObject(i));
+    vtkMRMLStorageNode* storageNode = volumeNode->GetStorageNode();
+    if (scene->GetWriteDataTime(storageNode->GetID()) < 0.)
+      {
+      std::cerr << "No write time recorded for " << storageNode->GetFileName()
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    // The compression threads given for the write are taken back
+    if (vtkMRMLNRRDStorageNode::SafeDownCast(storageNode)
+          ->GetNumberOfCompressionThreads() != 1)
+      {
+      std::cerr << "Compression threads not restored for "
+                << storageNode->GetFileName() << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkNew<vtkMRMLScalarVolumeNode> writtenVolumeNode;
+    vtkNew<vtkMRMLNRRDStorageNode> readStorageNode;
+    readStorageNode->SetFileName(storageNode->GetFileName());
+    if (!readStorageNode->ReadData(writtenVolumeNode.GetPointer()))
+      {
+      std::cerr << "Failed to read " << storageNode->GetFileName() << std::endl;
+      return EXIT_FAILURE;
+      }
+    writtenVolumeNode->SetLabelMap(volumeNode->GetLabelMap());
+    if (!vtkMRMLCoreTestingUtilities::CompareVolumes(
+          volumeNode, writtenVolumeNode.GetPointer()))
+      {
+      std::cerr << storageNode->GetFileName() << " differs from "
+                << FileNames[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  scene->PrintWriteDataSummary(std::cout, vtkIndent());
+
+  return EXIT_SUCCESS;
+}
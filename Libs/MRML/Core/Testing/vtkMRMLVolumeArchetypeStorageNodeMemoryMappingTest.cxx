@@ -0,0 +1,148 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// VTKsys includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool ReadVolume(const char* fileName, bool useMemoryMapping,
+                vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  storageNode->SetFileName(fileName);
+  storageNode->SetUseMemoryMapping(useMemoryMapping);
+  if (!storageNode->ReadData(volumeNode) || volumeNode->GetImageData() == 0)
+    {
+    std::cerr << "Failed to read " << fileName << " with memory mapping "
+              << useMemoryMapping << std::endl;
+    return false;
+    }
+  // The test file can be mapped: make sure the mapping is used
+  if (vtkMRMLVolumeArchetypeStorageNode::IsMemoryMapped(
+        volumeNode->GetImageData()) != useMemoryMapping)
+    {
+    std::cerr << "Memory mapping of " << fileName << " is "
+              << !useMemoryMapping << ", expected " << useMemoryMapping
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkMRMLVolumeArchetypeStorageNodeMemoryMappingTest <raw nrrd file>
+//          <temporary directory>
+int vtkMRMLVolumeArchetypeStorageNodeMemoryMappingTest(int argc, char * argv[] )
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: vtkMRMLVolumeArchetypeStorageNodeMemoryMappingTest <raw nrrd file>"
+              << " <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* fileName = argv[1];
+  const char* temporaryDirectory = argv[2];
+
+  vtkNew<vtkMRMLScalarVolumeNode> readVolume;
+  vtkNew<vtkMRMLScalarVolumeNode> mappedVolume;
+  if (!ReadVolume(fileName, false, readVolume.GetPointer()) ||
+      !ReadVolume(fileName, true, mappedVolume.GetPointer()) ||
+      !vtkMRMLCoreTestingUtilities::CompareVolumes(
+        readVolume.GetPointer(), mappedVolume.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Modifying the mapped image does not modify the file
+  vtkDataArray* mappedScalars = mappedVolume->GetImageData()->GetPointData()->GetScalars();
+  double value = mappedScalars->GetComponent(0, 0);
+  mappedScalars->SetComponent(0, 0, value + 1);
+  if (mappedScalars->GetComponent(0, 0) != value + 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": mapped image can not be modified" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> mappedVolume2;
+  if (!ReadVolume(fileName, true, mappedVolume2.GetPointer()) ||
+      !vtkMRMLCoreTestingUtilities::CompareVolumes(
+        readVolume.GetPointer(), mappedVolume2.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Writing a mapped volume over its own file first releases the mapping
+  std::string copyFileName = std::string(temporaryDirectory) +
+    "/vtkMRMLVolumeArchetypeStorageNodeMemoryMappingTest.nrrd";
+  if (!vtksys::SystemTools::CopyFileAlways(fileName, copyFileName.c_str()))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to copy " << fileName
+              << " into " << copyFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> copyVolume;
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> copyStorageNode;
+  copyStorageNode->SetFileName(copyFileName.c_str());
+  copyStorageNode->SetUseMemoryMapping(1);
+  copyStorageNode->SetUseCompression(0);
+  if (!copyStorageNode->ReadData(copyVolume.GetPointer()) ||
+      !vtkMRMLVolumeArchetypeStorageNode::IsMemoryMapped(copyVolume->GetImageData()))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to map " << copyFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!copyStorageNode->WriteData(copyVolume.GetPointer()) ||
+      vtkMRMLVolumeArchetypeStorageNode::IsMemoryMapped(copyVolume->GetImageData()))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write the mapped volume over "
+              << copyFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> writtenVolume;
+  if (!vtkMRMLCoreTestingUtilities::CompareVolumes(
+        readVolume.GetPointer(), copyVolume.GetPointer()) ||
+      !ReadVolume(copyFileName.c_str(), false, writtenVolume.GetPointer()) ||
+      !vtkMRMLCoreTestingUtilities::CompareVolumes(
+        readVolume.GetPointer(), writtenVolume.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": the volume written over its mapped file"
+              << " differs" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtksys::SystemTools::RemoveFile(copyFileName.c_str());
+
+  // Releasing the image releases the mapping
+  mappedVolume->SetAndObserveImageData(0);
+  mappedVolume2->SetAndObserveImageData(0);
+
+  return EXIT_SUCCESS;
+}
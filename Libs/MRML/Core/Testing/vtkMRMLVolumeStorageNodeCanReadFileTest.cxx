@@ -0,0 +1,116 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLDiffusionTensorVolumeNode.h"
+#include "vtkMRMLDiffusionWeightedVolumeNode.h"
+#include "vtkMRMLNRRDStorageNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLVectorVolumeNode.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckCanReadFile(vtkMRMLStorageNode* storageNode, const std::string& fileName,
+                      vtkMRMLNode* refNode, bool expected, int line)
+{
+  storageNode->SetFileName(fileName.c_str());
+  bool canRead = storageNode->CanReadFile(refNode);
+  if (canRead != expected)
+    {
+    std::cerr << "Line " << line << ": " << storageNode->GetClassName()
+              << "::CanReadFile(" << refNode->GetClassName() << ") returned "
+              << canRead << " for " << fileName << std::endl;
+    return false;
+    }
+  // The data is not read
+  if (refNode->IsA("vtkMRMLVolumeNode") &&
+      vtkMRMLVolumeNode::SafeDownCast(refNode)->GetImageData() != 0)
+    {
+    std::cerr << "Line " << line << ": image data was read" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkMRMLVolumeStorageNodeCanReadFileTest <test data directory>
+int vtkMRMLVolumeStorageNodeCanReadFileTest(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkMRMLVolumeStorageNodeCanReadFileTest <test data directory>"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = argv[1];
+  std::string scalarFile = directory + "/fixed.nrrd";
+  std::string dtiFile = directory + "/helix-DTI.nhdr";
+  std::string dwiFile = directory + "/helix-DWI.nhdr";
+  std::string missingFile = directory + "/missing.nrrd";
+
+  vtkNew<vtkMRMLScalarVolumeNode> scalarNode;
+  vtkNew<vtkMRMLVectorVolumeNode> vectorNode;
+  vtkNew<vtkMRMLDiffusionWeightedVolumeNode> dwiNode;
+  vtkNew<vtkMRMLDiffusionTensorVolumeNode> dtiNode;
+
+  vtkNew<vtkMRMLNRRDStorageNode> nrrdStorageNode;
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> archetypeStorageNode;
+  vtkMRMLStorageNode* nrrd = nrrdStorageNode.GetPointer();
+  vtkMRMLStorageNode* archetype = archetypeStorageNode.GetPointer();
+
+  if (// The NRRD header kind selects the node type
+      !CheckCanReadFile(nrrd, scalarFile, scalarNode.GetPointer(), true, __LINE__) ||
+      !CheckCanReadFile(nrrd, scalarFile, vectorNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, scalarFile, dwiNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, scalarFile, dtiNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, dtiFile, dtiNode.GetPointer(), true, __LINE__) ||
+      !CheckCanReadFile(nrrd, dtiFile, dwiNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, dtiFile, scalarNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, dwiFile, dwiNode.GetPointer(), true, __LINE__) ||
+      !CheckCanReadFile(nrrd, dwiFile, dtiNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(nrrd, dwiFile, vectorNode.GetPointer(), false, __LINE__) ||
+      // The number of components selects the node type
+      !CheckCanReadFile(archetype, scalarFile, scalarNode.GetPointer(), true, __LINE__) ||
+      !CheckCanReadFile(archetype, scalarFile, vectorNode.GetPointer(), false, __LINE__) ||
+      !CheckCanReadFile(archetype, scalarFile, dtiNode.GetPointer(), false, __LINE__) ||
+      // Files that are not available are left to ReadData
+      !CheckCanReadFile(nrrd, missingFile, scalarNode.GetPointer(), true, __LINE__) ||
+      !CheckCanReadFile(archetype, missingFile, scalarNode.GetPointer(), true, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Reading the data still succeeds after the header has been probed
+  archetype->SetFileName(scalarFile.c_str());
+  if (!archetype->CanReadFile(scalarNode.GetPointer()) ||
+      !archetype->ReadData(scalarNode.GetPointer()) ||
+      scalarNode->GetImageData() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to read " << scalarFile << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
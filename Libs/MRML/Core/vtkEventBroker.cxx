@@ -19,11 +19,128 @@
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkCriticalSection.h>
+#include <vtkIntArray.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+//----------------------------------------------------------------------------
+// Recursive lock of the broker: the broker methods call each other and the
+// observer callbacks may add or remove observations.
+// Owner and Count are read by threads that do not own the lock, they are
+// protected by their own short lived StateMutex.
+class vtkEventBrokerLock
+{
+public:
+  vtkEventBrokerLock() : Count(0) {}
+
+  void Lock()
+    {
+    vtkMultiThreaderIDType threadID = vtkMultiThreader::GetCurrentThreadID();
+    this->StateMutex.Lock();
+    if (this->Count > 0 && vtkMultiThreader::ThreadsEqual(this->Owner, threadID))
+      {
+      ++this->Count;
+      this->StateMutex.Unlock();
+      return;
+      }
+    this->StateMutex.Unlock();
+    this->Mutex.Lock();
+    this->SetState(threadID, 1);
+    }
+
+  void Unlock()
+    {
+    this->StateMutex.Lock();
+    bool release = (--this->Count == 0);
+    this->StateMutex.Unlock();
+    if (release)
+      {
+      this->Mutex.Unlock();
+      }
+    }
+
+  /// Fully release the lock owned by the current thread, returns the
+  /// recursion count to give to Reacquire().
+  int Release()
+    {
+    this->StateMutex.Lock();
+    int count = this->Count;
+    this->Count = 0;
+    this->StateMutex.Unlock();
+    this->Mutex.Unlock();
+    return count;
+    }
+
+  void Reacquire(int count)
+    {
+    this->Mutex.Lock();
+    this->SetState(vtkMultiThreader::GetCurrentThreadID(), count);
+    }
+
+private:
+  void SetState(vtkMultiThreaderIDType owner, int count)
+    {
+    this->StateMutex.Lock();
+    this->Owner = owner;
+    this->Count = count;
+    this->StateMutex.Unlock();
+    }
+
+  vtkSimpleCriticalSection Mutex;
+  vtkSimpleCriticalSection StateMutex;
+  vtkMultiThreaderIDType Owner;
+  int Count;
+};
+
+//----------------------------------------------------------------------------
+// Hold the broker lock in a scope.
+class vtkEventBrokerLocker
+{
+public:
+  vtkEventBrokerLocker(vtkEventBrokerLock* lock) : Lock(lock)
+    {
+    this->Lock->Lock();
+    }
+  ~vtkEventBrokerLocker()
+    {
+    this->Lock->Unlock();
+    }
+private:
+  vtkEventBrokerLock* Lock;
+};
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Name of the event, its id if it has no name.
+std::string GetEventString(unsigned long event)
+{
+  const char *eventString = vtkCommand::GetStringFromEventId( event );
+  if ( !strcmp( eventString, "NoEvent" ) )
+    {
+    std::stringstream ss;
+    ss << event;
+    return ss.str();
+    }
+  return eventString;
+}
+
+// Sort the observations by decreasing elapsed time.
+bool IsSlowerObservation(vtkObservation *observation1, vtkObservation *observation2)
+{
+  return observation1->GetTotalElapsedTime() > observation2->GetTotalElapsedTime();
+}
+}
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -100,6 +217,9 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->EventStormThreshold = 0;
+  this->NumberOfEventStorms = 0;
+  this->Lock = new vtkEventBrokerLock;
 }
 
 //----------------------------------------------------------------------------
@@ -107,6 +227,12 @@ vtkEventBroker::~vtkEventBroker()
 {
   /// fast and dangerous but ok because we are in the destructor.
   this->DetachObservations();
+  std::map< vtkObservation *, CoalescedCalls >::iterator callsIter;
+  for ( callsIter = this->CoalescedCallsMap.begin();
+        callsIter != this->CoalescedCallsMap.end(); ++callsIter )
+    {
+    this->ReleaseCoalescedObjects( callsIter->second.Objects );
+    }
   
   // close the event log if needed
   if ( this->LogFile.is_open() )
@@ -119,6 +245,7 @@ vtkEventBroker::~vtkEventBroker()
     {
     this->TimerLog->Delete();
     }
+  delete this->Lock;
   //cout << "vtkEventBroker singleton Deleted" << endl;
 }
 
@@ -148,6 +275,7 @@ void vtkEventBroker::DetachObservations()
 vtkObservation *vtkEventBroker::AddObservation (
   vtkObject *subject, unsigned long event, vtkObject *observer, vtkCallbackCommand *notify, float priority)
 {
+  vtkEventBrokerLocker locker(this->Lock);
   std::vector<vtkObject *>::iterator siter;
 
   vtkObservation *observation = vtkObservation::New();
@@ -181,6 +309,7 @@ vtkObservation *vtkEventBroker::AddObservation (
 vtkObservation *vtkEventBroker::AddObservation (
   vtkObject *subject, const char *event, const char *script)
 {       
+  vtkEventBrokerLocker locker(this->Lock);
   vtkObservation *observation = vtkObservation::New();
   observation->SetEventBroker( this );
   this->SubjectMap[subject].insert( observation );
@@ -289,6 +418,7 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
   // - detach from subject (and observer)
   // - delete the observation
 
+  vtkEventBrokerLocker locker(this->Lock);
   ObservationVector::iterator inObsIter;
 
   for(inObsIter=observations.begin(); inObsIter != observations.end(); inObsIter++)
@@ -321,6 +451,26 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
       }
     }
 
+  // remove from coalesced observations
+  // (the objects of the calls are released once the queue is updated)
+  std::vector< vtkObject* > coalescedObjects;
+  for(queueIter=this->CoalescedQueue.begin(); queueIter != this->CoalescedQueue.end();)
+    {
+    if (observations.find(*queueIter)!=observations.end())
+      {
+      std::map< vtkObservation *, CoalescedCalls >::iterator callsIter =
+        this->CoalescedCallsMap.find(*queueIter);
+      coalescedObjects.insert(coalescedObjects.end(),
+        callsIter->second.Objects.begin(), callsIter->second.Objects.end());
+      this->CoalescedCallsMap.erase(callsIter);
+      queueIter=this->CoalescedQueue.erase(queueIter);
+      }
+    else
+      {
+      ++queueIter;
+      }
+    }
+
   // detach and delete each of the observations
   for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
@@ -328,6 +478,7 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
     this->DetachObservation( *removeIter );
     (*removeIter)->Delete();
     }
+  this->ReleaseCoalescedObjects( coalescedObjects );
 }
 
 //----------------------------------------------------------------------------
@@ -364,6 +515,7 @@ void vtkEventBroker::RemoveObservationsForSubjectByTag (vtkObject *subject, unsi
 vtkEventBroker::ObservationVector vtkEventBroker
 ::GetSubjectObservations (vtkObject *observer)
 {
+  vtkEventBrokerLocker locker(this->Lock);
   // find matching observations to remove
   ObservationVector observationList = this->ObserverMap[observer];
 
@@ -375,6 +527,7 @@ vtkEventBroker::ObservationVector vtkEventBroker::GetObservations (
   vtkObject *subject, unsigned long event,
   vtkObject *observer, vtkCallbackCommand *notify, unsigned int maxReturnedObservations/*=0*/)
 {
+  vtkEventBrokerLocker locker(this->Lock);
   ObservationVector observationList;
   // Special case for fast return
   if (event == 0 && observer == 0 && notify == 0)
@@ -418,6 +571,7 @@ bool vtkEventBroker::GetObservationExist (
 //----------------------------------------------------------------------------
 vtkEventBroker::ObservationVector vtkEventBroker::GetObservationsForSubjectByTag (vtkObject *subject, unsigned long tag)
 {
+  vtkEventBrokerLocker locker(this->Lock);
   // find matching observations to remove
   // - all tags match 0
   ObservationVector& subjectList = this->SubjectMap[subject];
@@ -438,6 +592,7 @@ vtkEventBroker::ObservationVector vtkEventBroker::GetObservationsForSubjectByTag
 //----------------------------------------------------------------------------
 vtkCollection *vtkEventBroker::GetObservationsForSubject ( vtkObject *subject )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   vtkCollection *collection = vtkCollection::New();
   ObservationVector& subjectList = this->SubjectMap[subject];
   for(ObservationVector::iterator iter=subjectList.begin();
@@ -454,6 +609,7 @@ vtkCollection *vtkEventBroker::GetObservationsForSubject ( vtkObject *subject )
 //----------------------------------------------------------------------------
 vtkCollection *vtkEventBroker::GetObservationsForObserver ( vtkObject *observer )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   vtkCollection *collection = vtkCollection::New();
   ObservationVector& observerList = this->ObserverMap[observer];
   for (ObservationVector::iterator iter = observerList.begin();
@@ -470,6 +626,7 @@ vtkCollection *vtkEventBroker::GetObservationsForObserver ( vtkObject *observer
 //----------------------------------------------------------------------------
 vtkCollection *vtkEventBroker::GetObservationsForCallback ( vtkCallbackCommand *callback )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   vtkCollection *collection = vtkCollection::New();
   ObjectToObservationVectorMap::iterator it;
   for (it = this->ObserverMap.begin(); it != this->ObserverMap.end(); ++it)
@@ -489,6 +646,7 @@ vtkCollection *vtkEventBroker::GetObservationsForCallback ( vtkCallbackCommand *
 //----------------------------------------------------------------------------
 int vtkEventBroker::GetNumberOfObservations ( )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   size_t count = 0;
   ObjectToObservationVectorMap::iterator iter; 
   for(iter=this->SubjectMap.begin(); iter != this->SubjectMap.end(); iter++)  
@@ -501,6 +659,7 @@ int vtkEventBroker::GetNumberOfObservations ( )
 //----------------------------------------------------------------------------
 vtkObservation *vtkEventBroker::GetNthObservation ( int n )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   if ( n < 0 )
     {
     return NULL;
@@ -594,6 +753,7 @@ void vtkEventBroker::CloseLogFile ()
 //----------------------------------------------------------------------------
 void vtkEventBroker::LogEvent ( vtkObservation *observation )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   if ( this->LogFileName == NULL )
     {
     // if we don't have a log file, we can't do anything
@@ -681,9 +841,22 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   // - if the observer did ask to observe delete events, pass them through
   //   right away even in async mode - this way things can clean up
   //
+  vtkEventBrokerLocker locker(this->Lock);
   if ( eid == observation->GetEvent() || observation->GetEvent() == vtkCommand::AnyEvent )
     {
-    if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
+    if ( this->EventStormThreshold > 0 && eid != vtkCommand::DeleteEvent )
+      {
+      this->DetectEventStorm( observation, eid );
+      }
+    std::map< vtkObject *, CoalescingSubject >::const_iterator coalescingIter =
+      this->CoalescingSubjects.find( observation->GetSubject() );
+    if ( coalescingIter != this->CoalescingSubjects.end() &&
+         observation->GetCoalesceEvents() && eid != vtkCommand::DeleteEvent &&
+         ( callData == NULL || coalescingIter->second.ObjectEvents.count( eid ) ) )
+      {
+      this->CoalesceObservation( observation, eid, callData );
+      }
+    else if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
       {
       this->InvokeObservation( observation, eid, callData );
       }
@@ -708,8 +881,9 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   if ( eid == vtkCommand::DeleteEvent )
     {
     // iterate list of observations for the deleted object (caller) as subject
+    // (on a copy as the lock is released while the observations are invoked)
     ObservationVector::iterator obsIter;
-    ObservationVector& subjectList = this->SubjectMap[caller];
+    ObservationVector subjectList = this->SubjectMap[caller];
     for(obsIter=subjectList.begin(); obsIter != subjectList.end(); ++obsIter)
       {
       if ( (*obsIter)->GetEvent() == vtkCommand::DeleteEvent )
@@ -719,6 +893,12 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
       }
     if ( caller == observation->GetSubject() )
       {
+      // A new object at the same address must not be coalescing
+      this->ClearCoalescing (caller);
+      // nor inherit the event rates
+      this->EventRates.erase (
+        this->EventRates.lower_bound( std::make_pair( caller, 0UL ) ),
+        this->EventRates.upper_bound( std::make_pair( caller, ~0UL ) ) );
       // Remove all observations for this subject (0 matches all tags)
       this->RemoveObservationsForSubjectByTag (observation->GetSubject(), 0);
       }
@@ -752,6 +932,7 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
   // can be invoked.
   // If the event is not currently in the queue, add it and keep a flag.
   //
+  vtkEventBrokerLocker locker(this->Lock);
   vtkObservation::CallType call(eid, callData);
   if ( this->GetCompressCallData() &&
        observation->GetEvent() != vtkCommand::AnyEvent)
@@ -786,12 +967,14 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
 //----------------------------------------------------------------------------
 int vtkEventBroker::GetNumberOfQueuedObservations ()
 {
+  vtkEventBrokerLocker locker(this->Lock);
   return static_cast<int>( this->EventQueue.size() );
 }
 
 //----------------------------------------------------------------------------
 vtkObservation *vtkEventBroker::GetNthQueuedObservation ( int n )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   if ( n < 0 || n >= this->GetNumberOfQueuedObservations() )
     {
     return NULL;
@@ -802,6 +985,7 @@ vtkObservation *vtkEventBroker::GetNthQueuedObservation ( int n )
 //----------------------------------------------------------------------------
 vtkObservation *vtkEventBroker::DequeueObservation ()
 {
+  vtkEventBrokerLocker locker(this->Lock);
   vtkObservation *observation = this->EventQueue.front();
   this->EventQueue.pop_front();
   observation->SetInEventQueue(0);
@@ -812,6 +996,7 @@ vtkObservation *vtkEventBroker::DequeueObservation ()
 void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
                                          unsigned long eid, void *callData )
 {
+  vtkEventBrokerLocker locker(this->Lock);
   this->EventNestingLevel++;
 
   double startTime = this->TimerLog->GetUniversalTime();
@@ -823,6 +1008,9 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   // - run script is available, otherwise run callback command
   //  -- pass back the client data to the script handler (for
   //     example it could be the interpreter to use)
+  // - the lock is released during the call so that observers running on
+  //   other threads are not blocked
+  int lockCount = this->Lock->Release();
   if ( observation->GetScript() != NULL )
     {
     if ( this->ScriptHandler )
@@ -838,11 +1026,13 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
                                       eid,
                                       callData );
     }
+  this->Lock->Reacquire(lockCount);
 
   // Record timing and write the to the log file if enabled
   double elapsedTime = this->TimerLog->GetUniversalTime() - startTime;
   observation->SetTotalElapsedTime (observation->GetTotalElapsedTime() + elapsedTime);
   observation->SetLastElapsedTime (elapsedTime);
+  observation->SetInvocationCount (observation->GetInvocationCount() + 1);
   this->LogEvent (observation);
 
   // clear reference to observation (may cause delete)
@@ -861,6 +1051,7 @@ void vtkEventBroker::ProcessEventQueue ()
   // - if the observation is no longer in the queue, stop processing events
   // - unregister before after dequeing in case the observation should go away
   //
+  vtkEventBrokerLocker locker(this->Lock);
   while ( this->GetNumberOfQueuedObservations() > 0 )
     {
     vtkObservation *observation = this->EventQueue.front();
@@ -884,6 +1075,289 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+vtkCollection *vtkEventBroker::GetSlowestObservations ( int n )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  std::vector< vtkObservation * > observations;
+  ObjectToObservationVectorMap::iterator mapIter;
+  for (mapIter = this->SubjectMap.begin(); mapIter != this->SubjectMap.end(); ++mapIter)
+    {
+    observations.insert( observations.end(), mapIter->second.begin(), mapIter->second.end() );
+    }
+  size_t count = std::min( observations.size(), static_cast<size_t>( std::max( n, 0 ) ) );
+  std::partial_sort( observations.begin(), observations.begin() + count,
+                     observations.end(), IsSlowerObservation );
+
+  vtkCollection *collection = vtkCollection::New();
+  for (size_t i = 0; i < count; ++i)
+    {
+    collection->AddItem( observations[i] );
+    }
+  return collection;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintObservationStatistics ( ostream& os, vtkIndent indent, int n )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  vtkCollection *observations = this->GetSlowestObservations( n );
+  for (int i = 0; i < observations->GetNumberOfItems(); ++i)
+    {
+    vtkObservation *observation =
+      vtkObservation::SafeDownCast( observations->GetItemAsObject( i ) );
+    unsigned long invocationCount = observation->GetInvocationCount();
+    os << indent << observation->GetTotalElapsedTime() << "s in "
+       << invocationCount << " call(s)";
+    if ( invocationCount > 0 )
+      {
+      os << " (" << observation->GetTotalElapsedTime() / invocationCount << "s each)";
+      }
+    os << ": " << observation->GetSubject()->GetClassName()
+       << " " << GetEventString( observation->GetEvent() ) << " -> ";
+    if ( observation->GetScript() != NULL )
+      {
+      os << "\"" << observation->GetScript() << "\"";
+      }
+    else
+      {
+      os << ( observation->GetObserver() ?
+              observation->GetObserver()->GetClassName() : "No observer class" );
+      }
+    os << "\n";
+    }
+  observations->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetObservationStatistics ()
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  ObjectToObservationVectorMap::iterator mapIter;
+  for (mapIter = this->SubjectMap.begin(); mapIter != this->SubjectMap.end(); ++mapIter)
+    {
+    ObservationVector::iterator obsIter;
+    for (obsIter = mapIter->second.begin(); obsIter != mapIter->second.end(); ++obsIter)
+      {
+      (*obsIter)->SetInvocationCount( 0 );
+      (*obsIter)->SetLastElapsedTime( 0.0 );
+      (*obsIter)->SetTotalElapsedTime( 0.0 );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::DetectEventStorm ( vtkObservation *observation, unsigned long eid )
+{
+  //
+  // count the events in windows of one second and report the storm
+  // once, when the count goes above the threshold
+  //
+  vtkEventBrokerLocker locker(this->Lock);
+  // the event is processed once per observation: it is only counted for
+  // the first observation of the subject that matches it
+  vtkObject *subject = observation->GetSubject();
+  ObjectToObservationVectorMap::const_iterator subjectIter =
+    this->SubjectMap.find( subject );
+  if ( subjectIter == this->SubjectMap.end() )
+    {
+    return;
+    }
+  ObservationVector::const_iterator obsIter;
+  for ( obsIter = subjectIter->second.begin(); obsIter != subjectIter->second.end(); ++obsIter )
+    {
+    if ( (*obsIter)->GetEvent() == eid || (*obsIter)->GetEvent() == vtkCommand::AnyEvent )
+      {
+      break;
+      }
+    }
+  if ( obsIter == subjectIter->second.end() || *obsIter != observation )
+    {
+    return;
+    }
+
+  double now = this->TimerLog->GetUniversalTime();
+  EventRate& rate = this->EventRates[ std::make_pair( subject, eid ) ];
+  if ( rate.EventCount == 0 || now - rate.WindowStartTime >= 1.0 )
+    {
+    rate.WindowStartTime = now;
+    rate.EventCount = 0;
+    }
+  if ( ++rate.EventCount != static_cast<unsigned long>( this->EventStormThreshold ) + 1 )
+    {
+    return;
+    }
+
+  ++this->NumberOfEventStorms;
+  vtkWarningMacro( "Event storm: " << observation->GetSubject()->GetClassName()
+                   << " (" << observation->GetSubject() << ") fired "
+                   << GetEventString( eid ) << " more than "
+                   << this->EventStormThreshold << " times in a second" );
+  // observers of the broker are not called with the lock held
+  int lockCount = this->Lock->Release();
+  this->InvokeEvent( vtkEventBroker::EventStormEvent, observation );
+  this->Lock->Reacquire( lockCount );
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::StartCoalescing ( vtkObject *subject, vtkIntArray *objectEvents )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  std::map< vtkObject *, CoalescingSubject >::iterator it =
+    this->CoalescingSubjects.find( subject );
+  if ( it == this->CoalescingSubjects.end() )
+    {
+    it = this->CoalescingSubjects.insert(
+      std::make_pair( subject, CoalescingSubject() ) ).first;
+    it->second.Level = 0;
+    for ( int i = 0; objectEvents && i < objectEvents->GetNumberOfTuples(); ++i )
+      {
+      it->second.ObjectEvents.insert(
+        static_cast<unsigned long>( objectEvents->GetValue(i) ) );
+      }
+    }
+  ++it->second.Level;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::EndCoalescing ( vtkObject *subject )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  std::map< vtkObject *, CoalescingSubject >::iterator it =
+    this->CoalescingSubjects.find( subject );
+  if ( it == this->CoalescingSubjects.end() )
+    {
+    vtkErrorMacro ( "EndCoalescing called without StartCoalescing" );
+    return;
+    }
+  if ( --it->second.Level == 0 )
+    {
+    this->CoalescingSubjects.erase( it );
+    this->InvokeCoalescedObservations( subject );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ClearCoalescing ( vtkObject *subject )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  this->CoalescingSubjects.erase( subject );
+  // (the objects of the calls are released once the queue is updated)
+  std::vector< vtkObject* > coalescedObjects;
+  std::deque< vtkObservation *>::iterator queueIter;
+  for ( queueIter = this->CoalescedQueue.begin(); queueIter != this->CoalescedQueue.end(); )
+    {
+    if ( (*queueIter)->GetSubject() == subject )
+      {
+      std::map< vtkObservation *, CoalescedCalls >::iterator callsIter =
+        this->CoalescedCallsMap.find( *queueIter );
+      coalescedObjects.insert( coalescedObjects.end(),
+        callsIter->second.Objects.begin(), callsIter->second.Objects.end() );
+      this->CoalescedCallsMap.erase( callsIter );
+      queueIter = this->CoalescedQueue.erase( queueIter );
+      }
+    else
+      {
+      ++queueIter;
+      }
+    }
+  this->ReleaseCoalescedObjects( coalescedObjects );
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetCoalescing ( vtkObject *subject )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  std::map< vtkObject *, CoalescingSubject >::const_iterator it =
+    this->CoalescingSubjects.find( subject );
+  return it != this->CoalescingSubjects.end() ? it->second.Level : 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfCoalescedObservations ()
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  return static_cast<int>( this->CoalescedQueue.size() );
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::CoalesceObservation ( vtkObservation *observation,
+                                           unsigned long eid,
+                                           void *callData )
+{
+  vtkEventBrokerLocker locker(this->Lock);
+  std::map< vtkObservation *, CoalescedCalls >::iterator it =
+    this->CoalescedCallsMap.find( observation );
+  if ( it == this->CoalescedCallsMap.end() )
+    {
+    it = this->CoalescedCallsMap.insert(
+      std::make_pair( observation, CoalescedCalls() ) ).first;
+    this->CoalescedQueue.push_back( observation );
+    }
+  // only the first of the duplicated calls is kept
+  if ( it->second.UniqueCalls.insert( std::make_pair( eid, callData ) ).second )
+    {
+    it->second.Calls.push_back( vtkObservation::CallType( eid, callData ) );
+    // the call data of the object events is a vtkObject that must still
+    // exist when the call is delivered
+    if ( callData )
+      {
+      vtkObject *object = reinterpret_cast<vtkObject*>( callData );
+      object->Register( this );
+      it->second.Objects.push_back( object );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ReleaseCoalescedObjects ( std::vector< vtkObject* >& objects )
+{
+  // the objects may be deleted: work on a copy
+  std::vector< vtkObject* > releasedObjects;
+  releasedObjects.swap( objects );
+  std::vector< vtkObject* >::iterator it;
+  for ( it = releasedObjects.begin(); it != releasedObjects.end(); ++it )
+    {
+    (*it)->UnRegister( this );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::InvokeCoalescedObservations ( vtkObject *subject )
+{
+  //
+  // invoke each observation of the subject once with the list of its calls
+  // - the observation is removed from the coalesced queue before it is
+  //   invoked: the callbacks can add or remove observations
+  //
+  vtkEventBrokerLocker locker(this->Lock);
+  std::deque< vtkObservation *>::iterator queueIter = this->CoalescedQueue.begin();
+  while ( queueIter != this->CoalescedQueue.end() &&
+          this->CoalescingSubjects.count( subject ) == 0 )
+    {
+    if ( (*queueIter)->GetSubject() != subject )
+      {
+      ++queueIter;
+      continue;
+      }
+    vtkObservation *observation = *queueIter;
+    this->CoalescedQueue.erase( queueIter );
+    std::map< vtkObservation *, CoalescedCalls >::iterator it =
+      this->CoalescedCallsMap.find( observation );
+    CoalescedCalls calls;
+    calls.Calls.swap( it->second.Calls );
+    calls.Objects.swap( it->second.Objects );
+    this->CoalescedCallsMap.erase( it );
+
+    observation->Register( this );
+    this->InvokeObservation( observation, vtkEventBroker::CoalescedEvent, &calls.Calls );
+    observation->Delete();
+    this->ReleaseCoalescedObjects( calls.Objects );
+    // the callbacks may have modified the queue
+    queueIter = this->CoalescedQueue.begin();
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -892,10 +1366,16 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << "\n";
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
+  os << indent << "EventStormThreshold: " << this->EventStormThreshold << "\n";
+  os << indent << "NumberOfEventStorms: " << this->NumberOfEventStorms << "\n";
+  os << indent << "NumberOfCoalescingSubjects: " << this->CoalescingSubjects.size() << "\n";
+  os << indent << "NumberOfCoalescedObservations: " << this->CoalescedQueue.size() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
+  os << indent << "SlowestObservations:\n";
+  this->PrintObservationStatistics(os, indent.GetNextIndent());
 }
 
 //----------------------------------------------------------------------------
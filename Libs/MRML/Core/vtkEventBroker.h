@@ -17,6 +17,7 @@
 
 // MRML includes
 #include "vtkMRML.h"
+#include "vtkObservation.h"
 
 // VTK includes
 #include <vtkObject.h>
@@ -31,7 +32,8 @@ class vtkTimerLog;
 
 class vtkCollection;
 class vtkCallbackCommand;
-class vtkObservation;
+class vtkIntArray;
+class vtkEventBrokerLock;
 
 /// \brief Class that manages adding and deleting of observers with events.
 ///
@@ -41,6 +43,11 @@ class vtkObservation;
 /// See also:
 /// http://wiki.na-mic.org/Wiki/index.php/Slicer3:EventBroker
 /// http://en.wikipedia.org/wiki/Observer_pattern
+///
+/// Observations can be added, removed and invoked from any thread: the
+/// internal maps and the event queue are protected by a recursive lock that
+/// is released while the observer callbacks are running. Observers are
+/// called on the thread that invoked the event.
 //
 /// Other interesting observer implementations:
 /// http://xlobject.sourceforge
@@ -158,6 +165,39 @@ public:
   virtual void SetTimerLog(vtkTimerLog* timerLog);
   vtkGetObjectMacro (TimerLog, vtkTimerLog);
 
+  /// Observation statistics
+  ///
+  /// Each observation accumulates the number of times it was invoked and the
+  /// time spent in its callback (see vtkObservation::GetInvocationCount() and
+  /// vtkObservation::GetTotalElapsedTime()).
+  /// GetSlowestObservations() returns the \a n observations that took the
+  /// most time, slowest first.
+  /// Note: vtkCollection object is allocated internally
+  /// and must be freed by the caller
+  vtkCollection *GetSlowestObservations (int n = 10);
+  /// Print the \a n slowest observations with their number of invocations,
+  /// total and mean time.
+  void PrintObservationStatistics (ostream& os, vtkIndent indent, int n = 10);
+  /// Reset the invocation counts and elapsed times of all the observations.
+  void ResetObservationStatistics ();
+
+  /// Event storm detection
+  ///
+  /// If EventStormThreshold is > 0, a subject firing an observed event more
+  /// than EventStormThreshold times within a second is reported: a warning
+  /// is emitted and the broker invokes EventStormEvent with one of the
+  /// observations of the event as call data. A storm is reported once per
+  /// subject, event and second, however many observations the event has.
+  /// 0 by default (no detection).
+  vtkSetMacro (EventStormThreshold, int);
+  vtkGetMacro (EventStormThreshold, int);
+  /// Number of event storms reported so far.
+  vtkGetMacro (NumberOfEventStorms, int);
+  enum
+    {
+    EventStormEvent = 66201
+    };
+
   /// 
   /// Open and close the log file
   void OpenLogFile ();
@@ -233,6 +273,39 @@ public:
   vtkGetMacro (CompressCallData, int);
   vtkSetMacro (CompressCallData, int);
 
+  /// Event coalescing
+  ///
+  /// While the broker coalesces the events of a subject (between
+  /// StartCoalescing(subject) and the matching EndCoalescing(subject), calls
+  /// can be nested), the events of the subject's observations that opted in
+  /// with vtkObservation::CoalesceEventsOn() are not invoked. Instead each
+  /// distinct (event, call data) pair is recorded once per observation, in
+  /// the order it first happened, and the observation is invoked a single
+  /// time with CoalescedEvent when the outermost EndCoalescing(subject) is
+  /// called. The call data of CoalescedEvent is a pointer to the
+  /// CoalescedCallList of the observation, for example the list of the
+  /// nodes added to a scene during a batch process.
+  /// Only the events without call data and the \a objectEvents, whose call
+  /// data is a vtkObject, are coalesced. The objects are referenced until
+  /// they are delivered. The other events, DeleteEvent, the events of other
+  /// subjects and the observations that did not opt in are not affected.
+  /// vtkMRMLScene coalesces its events while it is in BatchProcessState.
+  enum
+    {
+    CoalescedEvent = 66200
+    };
+  typedef std::vector< vtkObservation::CallType > CoalescedCallList;
+  void StartCoalescing (vtkObject *subject, vtkIntArray *objectEvents = 0);
+  void EndCoalescing (vtkObject *subject);
+  /// Stop coalescing the events of \a subject whatever the nesting level,
+  /// its pending coalesced calls are discarded. Called when the subject is
+  /// deleted.
+  void ClearCoalescing (vtkObject *subject);
+  /// Nesting level of StartCoalescing(subject), 0 if the events of
+  /// \a subject are not coalesced.
+  int GetCoalescing (vtkObject *subject);
+  int GetNumberOfCoalescedObservations ();
+
   /// 
   /// Sets the method pointer to be used for processing script observations
   void SetScriptHandler ( void (*scriptHandler) (const char* script, void *clientData), void *clientData )
@@ -274,6 +347,46 @@ protected:
 
   /// The event queue of triggered but not-yet-invoked observations
   std::deque< vtkObservation * > EventQueue;
+
+  /// Record a call of an observation while coalescing
+  void CoalesceObservation (vtkObservation *observation, unsigned long eid,
+                            void *callData);
+  /// Invoke the coalesced observations of \a subject
+  void InvokeCoalescedObservations (vtkObject *subject);
+
+  /// Count the events of the subject of the observation and report event
+  /// storms
+  void DetectEventStorm (vtkObservation *observation, unsigned long eid);
+  int EventStormThreshold;
+  int NumberOfEventStorms;
+  /// Start time and number of events of the current one second window of
+  /// each (subject, event)
+  struct EventRate
+    {
+    double WindowStartTime;
+    unsigned long EventCount;
+    };
+  std::map< std::pair< vtkObject *, unsigned long >, EventRate > EventRates;
+
+  /// Observations with coalesced calls, in the order of their first call
+  std::deque< vtkObservation * > CoalescedQueue;
+  struct CoalescedCalls
+    {
+    CoalescedCallList Calls;
+    std::set< std::pair< unsigned long, void* > > UniqueCalls;
+    /// Objects of the calls, referenced until the calls are delivered
+    std::vector< vtkObject* > Objects;
+    };
+  std::map< vtkObservation *, CoalescedCalls > CoalescedCallsMap;
+  /// Release the objects referenced by coalesced calls
+  void ReleaseCoalescedObjects (std::vector< vtkObject* >& objects);
+  /// Subjects whose events are coalesced
+  struct CoalescingSubject
+    {
+    int Level;
+    std::set< unsigned long > ObjectEvents;
+    };
+  std::map< vtkObject *, CoalescingSubject > CoalescingSubjects;
   
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
@@ -287,6 +400,9 @@ protected:
   int CompressCallData;
 
   std::ofstream LogFile;
+
+  /// Protects the maps, the event queue and the log file.
+  vtkEventBrokerLock* Lock;
 private:
   /// DetachObservations is a fast (but dangerous) method to delete all the
   /// observations. It leaves the event broker in an inconsistent state:
@@ -14,6 +14,10 @@
 #include "vtkImageAccumulateDiscrete.h"
 #include "vtkObjectFactory.h"
 #include "vtkImageData.h"
+#include "vtkMultiThreader.h"
+
+// STD includes
+#include <vector>
 
 
 //----------------------------------------------------------------------------
@@ -23,6 +27,8 @@ vtkStandardNewMacro(vtkImageAccumulateDiscrete);
 // Constructor sets default values
 vtkImageAccumulateDiscrete::vtkImageAccumulateDiscrete()
 {
+  this->MaximumNumberOfSamples = 0;
+  this->SampleStride = 1;
 }
 
 #define  MAX_ACCUMULATION_BIN 65535
@@ -60,73 +66,135 @@ void vtkImageAccumulateDiscrete::ComputeInputUpdateExtent(int inExt[6],
 }
 
 //----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
+int vtkImageAccumulateDiscrete::ComputeSampleStride(int extent[6],
+                                                    vtkIdType maximumNumberOfSamples)
+{
+  if (maximumNumberOfSamples <= 0)
+    {
+    return 1;
+    }
+  int stride = 1;
+  for (;;)
+    {
+    double numberOfSamples = 1.;
+    bool singlePixel = true;
+    for (int i = 0; i < 3; ++i)
+      {
+      int samples = (extent[2*i+1] - extent[2*i]) / stride + 1;
+      numberOfSamples *= samples > 0 ? samples : 0;
+      singlePixel = singlePixel && samples <= 1;
+      }
+    if (numberOfSamples <= static_cast<double>(maximumNumberOfSamples) ||
+        singlePixel)
+      {
+      return stride;
+      }
+    ++stride;
+    }
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+struct vtkImageAccumulateDiscreteThreadStruct
+{
+  vtkImageAccumulateDiscrete *Filter;
+  vtkImageData *Input;
+  int *Output;
+  int Offset;
+  int Stride;
+  /// Histograms of the threads other than the first one, which counts
+  /// directly in the output.
+  std::vector<std::vector<int> > Histograms;
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// This templated function counts the rows [firstRow, lastRow[ of the
+// sampled input into outPtr.
 template <class T>
 static void vtkImageAccumulateDiscreteExecute(vtkImageAccumulateDiscrete *self,
-                      vtkImageData *inData, T *inPtr,
-                      vtkImageData *outData, int *outPtr)
+                      vtkImageData *inData, T *inPtr, int offset, int stride,
+                      vtkIdType firstRow, vtkIdType lastRow,
+                      int *outPtr, bool reportProgress)
 {
   int min0, max0, min1, max1, min2, max2;
-  int idx0, idx1, idx2;
+  int idx0;
   vtkIdType inInc0, inInc1, inInc2;
-  T *inPtr0, *inPtr1, *inPtr2;
-  vtkFloatingPointType *origin;
-  int offset;
-  int outExt[6];
+  T *inPtr0;
   unsigned long count = 0;
   unsigned long target;
 
-  // Zero count in every bin
-  outData->GetExtent(min0, max0, min1, max1, min2, max2);
-  memset((void *)outPtr, 0,
-     (max0-min0+1)*(max1-min1+1)*(max2-min2+1)*sizeof(int));
-
   // Get information to march through data
   inData->GetExtent(min0, max0, min1, max1, min2, max2);
   inData->GetIncrements(inInc0, inInc1, inInc2);
-  outData->GetExtent(outExt);
-  origin = outData->GetOrigin();
-  offset = (int)(-origin[0]);
+  vtkIdType rowsPerSlice = (max1 - min1) / stride + 1;
 
   // Ignore all components other than first one.
   // NOTE: GetIncrements takes the number of components into account
 
-  target = (unsigned long)((max2 - min2 + 1)*(max1 - min1 +1)/50.0);
+  target = (unsigned long)((lastRow - firstRow)/50.0);
   target++;
 
-  inPtr2 = inPtr;
-  for (idx2 = min2; idx2 <= max2; ++idx2)
+  for (vtkIdType row = firstRow; !self->AbortExecute && row < lastRow; ++row)
     {
-    inPtr1 = inPtr2;
-    for (idx1 = min1; !self->AbortExecute && idx1 <= max1; ++idx1)
+    if (reportProgress && !(count%target))
       {
-      if (!(count%target))
-        {
-        self->UpdateProgress(count/(50.0*target));
-        }
-      count++;
-      inPtr0  = inPtr1;
-      for (idx0 = min0; idx0 <= max0; ++idx0)
+      self->UpdateProgress(count/(50.0*target));
+      }
+    count++;
+    vtkIdType idx2 = (row / rowsPerSlice) * stride;
+    vtkIdType idx1 = (row % rowsPerSlice) * stride;
+    inPtr0 = inPtr + idx2 * inInc2 + idx1 * inInc1;
+    for (idx0 = min0; idx0 <= max0; idx0 += stride)
+      {
+      int a = (int)(*inPtr0) + offset;
+      if ( a < MAX_ACCUMULATION_BIN && a > 0 )
         {
-        int a = (int)(*inPtr0) + offset;
-        if ( a < MAX_ACCUMULATION_BIN && a > 0 )
-          {
-          outPtr[a]++;
-          }
-        inPtr0 += inInc0;
+        outPtr[a]++;
         }
-      inPtr1 += inInc1;
+      inPtr0 += stride * inInc0;
       }
-    inPtr2 += inInc2;
     }
 }
 
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkImageAccumulateDiscreteThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageAccumulateDiscreteThreadStruct *str =
+    static_cast<vtkImageAccumulateDiscreteThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+  int numberOfThreads = info->NumberOfThreads;
+
+  vtkImageData *inData = str->Input;
+  int *ext = inData->GetExtent();
+  vtkIdType numberOfRows =
+    static_cast<vtkIdType>((ext[3] - ext[2]) / str->Stride + 1) *
+    ((ext[5] - ext[4]) / str->Stride + 1);
+  vtkIdType firstRow = numberOfRows * threadId / numberOfThreads;
+  vtkIdType lastRow = numberOfRows * (threadId + 1) / numberOfThreads;
+  int *outPtr = threadId == 0 ?
+    str->Output : &str->Histograms[threadId - 1][0];
+  void *inPtr = inData->GetScalarPointer();
+
+  switch (inData->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageAccumulateDiscreteExecute(str->Filter,
+      inData, static_cast<VTK_TT *>(inPtr), str->Offset, str->Stride,
+      firstRow, lastRow, outPtr, threadId == 0));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
 
 //----------------------------------------------------------------------------
 // This method is passed a input and output Data, and executes the filter
 // algorithm to fill the output from the input.
-// It just executes a switch statement to call the correct function for
-// the Datas data types.
+// The rows of the input are split between the threads, each thread counts
+// its rows in its own histogram and the histograms are summed at the end.
 void vtkImageAccumulateDiscrete::ExecuteData(vtkDataObject *)
 {
   vtkImageData *inData = this->GetInput();
@@ -134,11 +202,7 @@ void vtkImageAccumulateDiscrete::ExecuteData(vtkDataObject *)
   outData->SetExtent(this->GetOutput()->GetWholeExtent());
   outData->AllocateScalars();
 
-  void *inPtr;
-  int *outPtr;
-
-  inPtr  = inData->GetScalarPointer();
-  outPtr = (int *)outData->GetScalarPointer();
+  int *outPtr = (int *)outData->GetScalarPointer();
 
   // this filter expects that output is type int.
   if (outData->GetScalarType() != VTK_INT)
@@ -147,54 +211,62 @@ void vtkImageAccumulateDiscrete::ExecuteData(vtkDataObject *)
           << " must be int\n");
     return;
   }
-  
-  int type = inData->GetScalarType();
 
-  switch (type)
+  switch (inData->GetScalarType())
   {
     case VTK_CHAR:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (char *)(inPtr), outData, outPtr);
-      break;
+    case VTK_SIGNED_CHAR:
     case VTK_UNSIGNED_CHAR:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (unsigned char *)(inPtr), outData, outPtr);
-      break;
     case VTK_SHORT:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (short *)(inPtr), outData, outPtr);
-      break;
     case VTK_UNSIGNED_SHORT:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (unsigned short *)(inPtr), outData, outPtr);
-      break;
     case VTK_INT:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (int *)(inPtr), outData, outPtr);
-      break;
     case VTK_UNSIGNED_INT:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (unsigned int *)(inPtr), outData, outPtr);
-      break;
     case VTK_LONG:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (long *)(inPtr), outData, outPtr);
-      break;
     case VTK_UNSIGNED_LONG:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (unsigned long *)(inPtr), outData, outPtr);
-      break;
     case VTK_FLOAT:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (float *)(inPtr), outData, outPtr);
-      break;
     case VTK_DOUBLE:
-      vtkImageAccumulateDiscreteExecute(this, 
-              inData, (double *)(inPtr), outData, outPtr);
       break;
     default:
       vtkErrorMacro(<< "Execute: Unsupported ScalarType");
       return;
+  }
+
+  // Zero count in every bin
+  int numberOfBins = outData->GetNumberOfPoints();
+  memset((void *)outPtr, 0, numberOfBins*sizeof(int));
+
+  int *inExt = inData->GetExtent();
+  this->SampleStride = vtkImageAccumulateDiscrete::ComputeSampleStride(inExt, this->MaximumNumberOfSamples);
+
+  vtkImageAccumulateDiscreteThreadStruct str;
+  str.Filter = this;
+  str.Input = inData;
+  str.Output = outPtr;
+  str.Offset = (int)(-outData->GetOrigin()[0]);
+  str.Stride = this->SampleStride;
+
+  // Do not spawn more threads than there are rows to count
+  vtkIdType numberOfRows =
+    static_cast<vtkIdType>((inExt[3] - inExt[2]) / str.Stride + 1) *
+    ((inExt[5] - inExt[4]) / str.Stride + 1);
+  int numberOfThreads = this->NumberOfThreads;
+  if (numberOfRows < numberOfThreads)
+    {
+    numberOfThreads = numberOfRows > 0 ? static_cast<int>(numberOfRows) : 1;
+    }
+  str.Histograms.resize(numberOfThreads - 1, std::vector<int>(numberOfBins, 0));
+
+  this->Threader->SetNumberOfThreads(numberOfThreads);
+  this->Threader->SetSingleMethod(vtkImageAccumulateDiscreteThreadedExecute, &str);
+  this->Threader->SingleMethodExecute();
+
+  for (int thread = 0; thread < numberOfThreads - 1; ++thread)
+    {
+    const int *histogram = &str.Histograms[thread][0];
+    for (int bin = 0; bin < numberOfBins; ++bin)
+      {
+      outPtr[bin] += histogram[bin];
+      }
     }
 }
 
@@ -203,5 +275,6 @@ void vtkImageAccumulateDiscrete::ExecuteData(vtkDataObject *)
 void vtkImageAccumulateDiscrete::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
+  os << indent << "MaximumNumberOfSamples: " << this->MaximumNumberOfSamples << "\n";
+  os << indent << "SampleStride: " << this->SampleStride << "\n";
 }
-
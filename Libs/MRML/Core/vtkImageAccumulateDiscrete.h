@@ -27,6 +27,8 @@
 /// discrete bins.  It then counts the number of pixels associated
 /// with each bin.  The output is this "scatter plot".
 /// The input can be any type, but the output is always int.
+/// The input is split in slabs of rows that are counted in parallel into
+/// per-thread histograms, which are summed at the end.
 class VTK_MRML_EXPORT vtkImageAccumulateDiscrete : public vtkImageToImageFilter
 {
 public:
@@ -34,6 +36,25 @@ public:
   vtkTypeMacro(vtkImageAccumulateDiscrete,vtkImageToImageFilter);
   void PrintSelf(ostream& os, vtkIndent indent);
 
+  ///
+  /// Maximum number of pixels to count. If the input has more pixels, only
+  /// the pixels of a regular sub-grid (every SampleStride pixel along each
+  /// axis) are counted and the output is an estimate of the histogram
+  /// scaled down by about SampleStride^3. 0 (default) counts all the pixels.
+  vtkSetMacro(MaximumNumberOfSamples, vtkIdType);
+  vtkGetMacro(MaximumNumberOfSamples, vtkIdType);
+
+  ///
+  /// Stride between the counted pixels used by the last execution,
+  /// 1 if all the pixels were counted.
+  vtkGetMacro(SampleStride, int);
+
+  ///
+  /// Return the smallest stride such that the regular sub-grid of the
+  /// extent has at most maximumNumberOfSamples pixels, 1 if
+  /// maximumNumberOfSamples is 0.
+  static int ComputeSampleStride(int extent[6], vtkIdType maximumNumberOfSamples);
+
 protected:
   vtkImageAccumulateDiscrete();
   ~vtkImageAccumulateDiscrete() {};
@@ -43,6 +64,9 @@ protected:
   void ComputeInputUpdateExtent(int inExt[6], int outExt[6]);
   void ExecuteData(vtkDataObject *);
 
+  vtkIdType MaximumNumberOfSamples;
+  int SampleStride;
+
 private:
   vtkImageAccumulateDiscrete(const vtkImageAccumulateDiscrete&);
   void operator=(const vtkImageAccumulateDiscrete&);
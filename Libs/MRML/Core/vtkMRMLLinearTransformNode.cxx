@@ -31,6 +31,11 @@ vtkMRMLLinearTransformNode::vtkMRMLLinearTransformNode()
 {
   this->MatrixTransformToParent = NULL;
 
+  this->MatrixTransformToWorldCache = vtkMatrix4x4::New();
+  this->MatrixTransformToWorldCacheLinear = 1;
+  this->MatrixTransformToWorldCacheGeneration = 0;
+  this->MatrixTransformToWorldCacheParent = NULL;
+
   vtkMatrix4x4 *matrix  = vtkMatrix4x4::New();
   matrix->Identity();
   this->SetAndObserveMatrixTransformToParent(matrix);
@@ -44,6 +49,7 @@ vtkMRMLLinearTransformNode::~vtkMRMLLinearTransformNode()
     {
     this->SetAndObserveMatrixTransformToParent(NULL);
     }
+  this->MatrixTransformToWorldCache->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -171,28 +177,53 @@ vtkGeneralTransform* vtkMRMLLinearTransformNode::GetTransformToParent()
 //----------------------------------------------------------------------------
 int  vtkMRMLLinearTransformNode::GetMatrixTransformToWorld(vtkMatrix4x4* transformToWorld)
 {
-  if (this->IsTransformToWorldLinear() != 1) 
+  this->UpdateMatrixTransformToWorldCache();
+  if (this->MatrixTransformToWorldCacheLinear != 1) 
     {
     transformToWorld->Identity();
     return 0;
     }
 
-  vtkMatrix4x4 *xform = vtkMatrix4x4::New();
-  xform->DeepCopy(transformToWorld);
-  vtkMatrix4x4::Multiply4x4(this->MatrixTransformToParent, xform, transformToWorld);
-  xform->Delete();
+  vtkMatrix4x4::Multiply4x4(this->MatrixTransformToWorldCache, transformToWorld,
+                            transformToWorld);
+  // TODO: what does this return code mean?
+  return 1;
+}
 
-  vtkMRMLTransformNode *parent = this->GetParentTransformNode();
-  if (parent != NULL) 
+//----------------------------------------------------------------------------
+void vtkMRMLLinearTransformNode::UpdateMatrixTransformToWorldCache()
+{
+  // Retrieving the parent through the node reference makes sure the parent
+  // is observed, so its TransformModifiedEvent invalidates the cache
+  vtkMRMLTransformNode *parent = vtkMRMLTransformNode::SafeDownCast(
+    this->GetNodeReference(this->GetTransformNodeReferenceRole()));
+  if (this->MatrixTransformToWorldCacheGeneration == this->TransformToWorldGeneration &&
+      this->MatrixTransformToWorldCacheParent == parent)
     {
-    vtkMRMLLinearTransformNode *lparent = dynamic_cast < vtkMRMLLinearTransformNode* > (parent);
-    if (lparent) 
-      {
-      return (lparent->GetMatrixTransformToWorld(transformToWorld));
-      }
+    return;
+    }
+  this->MatrixTransformToWorldCacheGeneration = this->TransformToWorldGeneration;
+  this->MatrixTransformToWorldCacheParent = parent;
+
+  this->MatrixTransformToWorldCacheLinear = this->IsTransformToWorldLinear();
+  if (this->MatrixTransformToWorldCacheLinear != 1) 
+    {
+    this->MatrixTransformToWorldCache->Identity();
+    return;
+    }
+  if (this->MatrixTransformToParent == NULL)
+    {
+    this->MatrixTransformToWorldCache->Identity();
+    }
+  else
+    {
+    this->MatrixTransformToWorldCache->DeepCopy(this->MatrixTransformToParent);
+    }
+  vtkMRMLLinearTransformNode *lparent = vtkMRMLLinearTransformNode::SafeDownCast(parent);
+  if (lparent) 
+    {
+    lparent->GetMatrixTransformToWorld(this->MatrixTransformToWorldCache);
     }
-  // TODO: what does this return code mean?
-  return 1;
 }
 
 //----------------------------------------------------------------------------
@@ -72,6 +72,8 @@ class VTK_MRML_EXPORT vtkMRMLLinearTransformNode : public vtkMRMLTransformNode
 
   /// 
   /// Get concatinated transforms to the top
+  /// The matrix to world is cached until the transform of this node or of
+  /// one of its parents is modified (see GetTransformToWorldGeneration()).
   virtual int  GetMatrixTransformToWorld(vtkMatrix4x4* transformToWorld);
   
   /// 
@@ -102,6 +104,16 @@ protected:
   void operator=(const vtkMRMLLinearTransformNode&);
 
   vtkMatrix4x4* MatrixTransformToParent;
+
+  /// Recompute the cached matrix to world if the generation or the parent
+  /// changed since it was computed.
+  void UpdateMatrixTransformToWorldCache();
+  vtkMatrix4x4* MatrixTransformToWorldCache;
+  int MatrixTransformToWorldCacheLinear;
+  unsigned long MatrixTransformToWorldCacheGeneration;
+  /// Only compared, never dereferenced: the parent can be removed from the
+  /// scene without this node being notified.
+  vtkMRMLTransformNode* MatrixTransformToWorldCacheParent;
 };
 
 #endif
@@ -29,6 +29,7 @@ Version:   $Revision: 1.6 $
 #include <vtkNRRDWriter.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtksys/SystemTools.hxx>
 
 
 //----------------------------------------------------------------------------
@@ -38,6 +39,7 @@ vtkMRMLNodeNewMacro(vtkMRMLNRRDStorageNode);
 vtkMRMLNRRDStorageNode::vtkMRMLNRRDStorageNode()
 {
   this->CenterImage = 0;
+  this->NumberOfCompressionThreads = 1;
 }
 
 //----------------------------------------------------------------------------
@@ -93,6 +95,7 @@ void vtkMRMLNRRDStorageNode::Copy(vtkMRMLNode *anode)
   vtkMRMLNRRDStorageNode *node = (vtkMRMLNRRDStorageNode *) anode;
 
   this->SetCenterImage(node->CenterImage);
+  this->SetNumberOfCompressionThreads(node->NumberOfCompressionThreads);
 
   this->EndModify(disabledModify);
 
@@ -103,6 +106,8 @@ void vtkMRMLNRRDStorageNode::PrintSelf(ostream& os, vtkIndent indent)
 {  
   vtkMRMLStorageNode::PrintSelf(os,indent);
   os << indent << "CenterImage:   " << this->CenterImage << "\n";
+  os << indent << "NumberOfCompressionThreads:   "
+     << this->NumberOfCompressionThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -114,6 +119,81 @@ bool vtkMRMLNRRDStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
          refNode->IsA("vtkMRMLDiffusionTensorVolumeNode");
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLNRRDStorageNode::CanReadFile(vtkMRMLNode *refNode)
+{
+  if (!this->Superclass::CanReadFile(refNode))
+    {
+    return false;
+    }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+    {
+    // The file may be a remote reference fetched by ReadData
+    return true;
+    }
+
+  vtkNew<vtkNRRDReader> reader;
+  reader->SetFileName(fullName.c_str());
+  if (!reader->CanReadFile(fullName.c_str()))
+    {
+    vtkDebugMacro("CanReadFile: This is not a nrrd file");
+    return false;
+    }
+  // Only the header is read
+  reader->UpdateInformation();
+  return this->FileKindMatchesReferenceNode(reader.GetPointer(), refNode);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLNRRDStorageNode::FileKindMatchesReferenceNode(vtkNRRDReader *reader,
+                                                          vtkMRMLNode *refNode)
+{
+  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
+    {
+    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::TENSORS))
+      {
+      vtkDebugMacro("MRMLVolumeNode does not match file kind");
+      return false;
+      }
+    }
+  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
+    {
+    vtkDebugMacro("Checking we have right info in file");
+    const char *value = reader->GetHeaderValue("modality");
+    if (value == NULL)
+      {
+      vtkDebugMacro("MRMLVolumeNode does not match file kind: no modality");
+      return false;
+      }
+    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
+            !strcmp(value,"DWMRI") ) )
+      {
+      vtkDebugMacro("MRMLVolumeNode does not match file kind");
+      return false;
+      }
+    }
+  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
+    {
+    if (! (reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
+           || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS))
+      {
+      vtkDebugMacro("MRMLVolumeNode does not match file kind");
+      return false;
+      }
+    }  
+  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
+    {
+    if (!(reader->GetPointDataType() == vtkDataSetAttributes::SCALARS && 
+        (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents()==3) ))
+      {
+      vtkDebugMacro("MRMLVolumeNode does not match file kind");
+      return false;
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -185,47 +265,11 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   // MRML Node
   reader->UpdateInformation();
 
-  // Check type
-  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
-    {
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::TENSORS))
-      {
-      vtkDebugMacro("MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
+  if (!this->FileKindMatchesReferenceNode(reader.GetPointer(), refNode))
     {
-    vtkDebugMacro("Checking we have right info in file");
-    const char *value = reader->GetHeaderValue("modality");
-    if (value == NULL)
-      {
-      return 0;
-      }
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
-            !strcmp(value,"DWMRI") ) )
-      {
-      vtkErrorMacro("MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
-    {
-    if (! (reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
-           || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS))
-      {
-      vtkDebugMacro("MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }  
-  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
-    {
-    if (!(reader->GetPointDataType() == vtkDataSetAttributes::SCALARS && 
-        (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents()==3) ))
-      {
-      vtkErrorMacro("MRMLVolumeNode does not match file kind");
-      return 0;
-      }
+    vtkErrorMacro("ReadDataInternal: " << fullName
+                  << " does not match the kind of " << refNode->GetClassName());
+    return 0;
     }
 
   reader->Update();
@@ -366,6 +410,7 @@ int vtkMRMLNRRDStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   writer->SetFileName(fullName.c_str());
   writer->SetInput(volNode->GetImageData() );
   writer->SetUseCompression(this->GetUseCompression());
+  writer->SetNumberOfThreads(this->NumberOfCompressionThreads);
 
   // set volume attributes
   writer->SetIJKToRASMatrix(ijkToRas.GetPointer());
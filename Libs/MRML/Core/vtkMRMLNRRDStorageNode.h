@@ -53,6 +53,13 @@ class VTK_MRML_EXPORT vtkMRMLNRRDStorageNode : public vtkMRMLStorageNode
   vtkGetMacro(CenterImage, int);
   vtkSetMacro(CenterImage, int);
 
+  /// 
+  /// Number of threads used to compress the data on write (see
+  /// vtkNRRDWriter::SetNumberOfThreads()). Not saved in the scene.
+  /// 1 by default.
+  vtkGetMacro(NumberOfCompressionThreads, int);
+  vtkSetClampMacro(NumberOfCompressionThreads, int, 1, VTK_INT_MAX);
+
   /// 
   /// Access the nrrd header fields to create a diffusion gradient table
   int ParseDiffusionInformation(vtkNRRDReader *reader,vtkDoubleArray *grad,vtkDoubleArray *bvalues);
@@ -64,6 +71,11 @@ class VTK_MRML_EXPORT vtkMRMLNRRDStorageNode : public vtkMRMLStorageNode
   /// Return true if the node can be read in.
   virtual bool CanReadInReferenceNode(vtkMRMLNode *refNode);
 
+  /// Return true if the NRRD header of the file matches the reference node
+  /// (e.g. tensor kind for diffusion tensor volumes, DWMRI modality for
+  /// diffusion weighted volumes). The data is not read.
+  virtual bool CanReadFile(vtkMRMLNode *refNode);
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -88,7 +100,14 @@ protected:
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
+  /// Return true if the kind of the file read by the reader, whose
+  /// information must be up to date, matches the reference node.
+  /// A mismatch is not an error: it only reports debug messages, the
+  /// callers decide whether to report it.
+  bool FileKindMatchesReferenceNode(vtkNRRDReader *reader, vtkMRMLNode *refNode);
+
   int CenterImage;
+  int NumberOfCompressionThreads;
 
 };
 
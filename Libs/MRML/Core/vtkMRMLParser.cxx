@@ -81,8 +81,7 @@ void vtkMRMLParser::StartElement(const char* tagName, const char** atts)
     return;
     } // MRML
 
-  const char* tmp = this->MRMLScene->GetClassNameByTag(tagName);
-  std::string className = tmp ? tmp : "";
+  std::string className = this->GetRegisteredClassName(tagName);
 
   // CreateNodeByClass should have a chance to instantiate non-registered node
   if (className.empty())
@@ -158,14 +157,12 @@ void vtkMRMLParser::EndElement (const char *name)
     return;
     }
 
-  const char* className = this->MRMLScene->GetClassNameByTag(name);
-  if (className == NULL) 
+  if (this->GetRegisteredClassName(name).empty())
     {
     // check for a renamed node
     if (strcmp(name, "SceneSnapshot") == 0)
       {
-      className = this->MRMLScene->GetClassNameByTag("SceneView");
-      if (className == NULL)
+      if (this->GetRegisteredClassName("SceneView").empty())
         {
         return;
         }
@@ -178,3 +175,17 @@ void vtkMRMLParser::EndElement (const char *name)
 
   this->NodeStack.pop();
 }
+
+//-----------------------------------------------------------------------------
+const std::string& vtkMRMLParser::GetRegisteredClassName(const char* tagName)
+{
+  std::map< std::string, std::string >::iterator it =
+    this->ClassNamesByTag.find(tagName);
+  if (it == this->ClassNamesByTag.end())
+    {
+    const char* className = this->MRMLScene->GetClassNameByTag(tagName);
+    it = this->ClassNamesByTag.insert(std::make_pair(
+      std::string(tagName), std::string(className ? className : ""))).first;
+    }
+  return it->second;
+}
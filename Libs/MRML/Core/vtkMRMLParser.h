@@ -25,7 +25,9 @@ class vtkMRMLScene;
 class vtkCollection;
 
 // STD includes
+#include <map>
 #include <stack>
+#include <string>
 
 /// \brief Parse XML scene file.
 class VTK_MRML_EXPORT vtkMRMLParser : public vtkXMLParser
@@ -49,10 +51,16 @@ protected:
   virtual void StartElement(const char* name, const char** atts);
   virtual void EndElement (const char *name);
 
+  /// Class name registered in the scene for the XML tag, empty if none.
+  /// The lookups are cached for the duration of the parsing as the same
+  /// tags are found many times in a scene file.
+  const std::string& GetRegisteredClassName(const char* tagName);
+
 private:
   vtkMRMLScene* MRMLScene;
   vtkCollection* NodeCollection;
   std::stack< vtkMRMLNode *> NodeStack;
+  std::map< std::string, std::string > ClassNamesByTag;
 };
 
 #endif
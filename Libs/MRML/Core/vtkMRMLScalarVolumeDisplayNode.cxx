@@ -49,6 +49,7 @@ vtkMRMLScalarVolumeDisplayNode::vtkMRMLScalarVolumeDisplayNode()
   this->AutoWindowLevel = 1;
   this->AutoThreshold = 0;
   this->ApplyThreshold = 0;
+  this->AutoLevelsMaximumNumberOfSamples = 0;
   //this->LowerThreshold = VTK_SHORT_MIN;
   //this->UpperThreshold = VTK_SHORT_MAX;
 
@@ -242,6 +243,11 @@ void vtkMRMLScalarVolumeDisplayNode::WriteXML(ostream& of, int nIndent)
   ss << this->AutoThreshold;
   of << indent << " autoThreshold=\"" << ss.str() << "\"";
   }
+  {
+  std::stringstream ss;
+  ss << this->AutoLevelsMaximumNumberOfSamples;
+  of << indent << " autoLevelsMaximumNumberOfSamples=\"" << ss.str() << "\"";
+  }
   if (this->WindowLevelPresets.size() > 0)
     {
     for (int p = 0; p < this->GetNumberOfWindowLevelPresets(); p++)
@@ -324,6 +330,12 @@ void vtkMRMLScalarVolumeDisplayNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->AutoThreshold;
       }
+    else if (!strcmp(attName, "autoLevelsMaximumNumberOfSamples"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->AutoLevelsMaximumNumberOfSamples;
+      }
     else if (!strncmp(attName, "windowLevelPreset", 17)) 
       {
       this->AddWindowLevelPresetFromString(attValue);
@@ -343,6 +355,8 @@ void vtkMRMLScalarVolumeDisplayNode::Copy(vtkMRMLNode *anode)
   Superclass::Copy(anode);
   vtkMRMLScalarVolumeDisplayNode *node = (vtkMRMLScalarVolumeDisplayNode *) anode;
   
+  // before the auto flags, the auto levels use the number of samples
+  this->SetAutoLevelsMaximumNumberOfSamples(node->GetAutoLevelsMaximumNumberOfSamples());
   this->SetAutoWindowLevel( node->GetAutoWindowLevel() );
   this->SetWindowLevel(node->GetWindow(), node->GetLevel());
   this->SetAutoThreshold( node->GetAutoThreshold() ); // don't want to run CalculateAutoLevel
@@ -377,6 +391,8 @@ void vtkMRMLScalarVolumeDisplayNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UpperThreshold:    " << this->GetUpperThreshold() << "\n";
   os << indent << "LowerThreshold:    " << this->GetLowerThreshold() << "\n";
   os << indent << "Interpolate:       " << this->Interpolate << "\n";
+  os << indent << "AutoLevelsMaximumNumberOfSamples: "
+     << this->AutoLevelsMaximumNumberOfSamples << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -731,6 +747,9 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
       this->Accumulate = vtkImageAccumulateDiscrete::New();
       }
 
+    // The histogram is computed in parallel, on a sub-grid of the voxels
+    // for large volumes if requested
+    this->Accumulate->SetMaximumNumberOfSamples(this->AutoLevelsMaximumNumberOfSamples);
     this->Accumulate->SetInput(imageDataScalar);
     this->Bimodal->SetInput(this->Accumulate->GetOutput());
     this->Bimodal->Update();
@@ -72,6 +72,15 @@ class VTK_MRML_EXPORT vtkMRMLScalarVolumeDisplayNode : public vtkMRMLVolumeDispl
   vtkBooleanMacro(AutoWindowLevel, int);
   vtkGetMacro(AutoWindowLevel, int);
   vtkSetMacro(AutoWindowLevel, int);
+
+  ///
+  /// Maximum number of voxels used to compute the histogram of the automatic
+  /// window/level and threshold. Larger volumes are sampled on a regular
+  /// grid, which estimates the histogram in a fraction of the time.
+  /// 0 (default) uses all the voxels.
+  /// \sa vtkImageAccumulateDiscrete::SetMaximumNumberOfSamples
+  vtkGetMacro(AutoLevelsMaximumNumberOfSamples, vtkIdType);
+  vtkSetMacro(AutoLevelsMaximumNumberOfSamples, vtkIdType);
   
   /// 
   /// The window value to use when autoWindowLevel is 'no'
@@ -218,6 +227,7 @@ protected:
   int AutoWindowLevel;
   int ApplyThreshold;
   int AutoThreshold;
+  vtkIdType AutoLevelsMaximumNumberOfSamples;
 
   vtkImageCast *ResliceAlphaCast;
   vtkImageLogic *AlphaLogic;
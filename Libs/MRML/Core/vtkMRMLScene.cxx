@@ -18,6 +18,7 @@ Version:   $Revision: 1.18 $
 
 #include "vtkCacheManager.h"
 #include "vtkDataIOManager.h"
+#include "vtkEventBroker.h"
 #include "vtkTagTable.h"
 
 #include "vtkMRMLBSplineTransformNode.h"
@@ -45,6 +46,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLSliceCompositeNode.h"
 #include "vtkMRMLSliceNode.h"
 #include "vtkMRMLSnapshotClipNode.h"
+#include "vtkMRMLStorageNode.h"
 #include "vtkMRMLTransformStorageNode.h"
 #include "vtkMRMLUnstructuredGridDisplayNode.h"
 #include "vtkMRMLUnstructuredGridNode.h"
@@ -52,6 +54,8 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeDisplayNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
+#include "vtkITKArchetypeImageSeriesScalarReader.h"
+#include "vtkMRMLVolumeNode.h"
 #include "vtkURIHandler.h"
 #include "vtkMRMLLayoutNode.h"
 
@@ -71,10 +75,20 @@ Version:   $Revision: 1.18 $
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkCriticalSection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkOutputWindow.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// ITK includes
+#include <itkConfigure.h>
 
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
@@ -83,6 +97,8 @@ Version:   $Revision: 1.18 $
 #include <algorithm>
 #include <cassert>
 #include <numeric>
+#include <set>
+#include <sstream>
 
 //#define MRMLSCENE_VERBOSE 1
 
@@ -95,6 +111,7 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NodesByClassMTime = 0;
   this->SceneModifiedTime = 0;
 
   this->RegisteredNodeClasses.clear();
@@ -103,6 +120,8 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->Nodes =  vtkCollection::New();
   this->UndoStackSize = 100;
+  this->UndoStackMemorySize = 0;
+  this->UndoStackMemoryBudget = 0;
   this->UndoFlag = false;
   this->InUndo = false;
 
@@ -122,6 +141,15 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->ReadDataOnLoad = 1;
 
+  this->NumberOfReadDataThreads = 1;
+  this->NumberOfWriteDataThreads = 1;
+  this->WriteDataElapsedTime = 0.;
+  this->ImportTime = -1.;
+  for (int phase = 0; phase < vtkMRMLScene::NumberOfImportPhases; ++phase)
+    {
+    this->ImportPhaseTimes[phase] = -1.;
+    }
+
   this->LastLoadedVersion = NULL;
   this->Version = NULL;
 
@@ -200,6 +228,9 @@ vtkMRMLScene::vtkMRMLScene()
 //------------------------------------------------------------------------------
 vtkMRMLScene::~vtkMRMLScene()
 {
+  // Drop the events coalesced by a batch process that was not ended
+  vtkEventBroker::GetInstance()->ClearCoalescing(this);
+
   this->ClearUndoStack ( );
   this->ClearRedoStack ( );
 
@@ -567,6 +598,14 @@ void vtkMRMLScene::StartState(unsigned long state, int anticipatedMaxProgress)
   if (this->IsBatchProcessing() && !wasBatchProcessing)
     {
     this->InvokeEvent( StateEvent | StartEvent | BatchProcessState);
+    // Observations that opted in receive the events of the batch at once.
+    // The call data of the node events is the node.
+    vtkNew<vtkIntArray> nodeEvents;
+    nodeEvents->InsertNextValue(vtkMRMLScene::NodeAboutToBeAddedEvent);
+    nodeEvents->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+    nodeEvents->InsertNextValue(vtkMRMLScene::NodeAboutToBeRemovedEvent);
+    nodeEvents->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+    vtkEventBroker::GetInstance()->StartCoalescing(this, nodeEvents.GetPointer());
     }
   if (state != vtkMRMLScene::BatchProcessState &&
       !wasInState)
@@ -583,6 +622,13 @@ void vtkMRMLScene::EndState(unsigned long state)
   this->States.pop_back();
 
   bool isInState = ((this->GetStates() & state) == state);
+  bool endBatchProcess = ((state & vtkMRMLScene::BatchProcessState) &&
+                          !this->IsBatchProcessing());
+  // The coalesced events are delivered before the state end events
+  if (endBatchProcess)
+    {
+    vtkEventBroker::GetInstance()->EndCoalescing(this);
+    }
   // vtkMRMLScene::BatchProcessState is handled after
   if (state != vtkMRMLScene::BatchProcessState &&
       !isInState)
@@ -590,8 +636,7 @@ void vtkMRMLScene::EndState(unsigned long state)
     this->InvokeEvent( StateEvent | EndEvent | state );
     }
 
-  if ((state & vtkMRMLScene::BatchProcessState) &&
-      !this->IsBatchProcessing())
+  if (endBatchProcess)
     {
     this->InvokeEvent( StateEvent | EndEvent |
                        vtkMRMLScene::BatchProcessState );
@@ -642,8 +687,6 @@ int vtkMRMLScene::Connect()
 int vtkMRMLScene::Import()
 {
 #ifdef MRMLSCENE_VERBOSE
-  vtkTimerLog* addNodesTimer = vtkTimerLog::New();
-  vtkTimerLog* updateSceneTimer = vtkTimerLog::New();
   vtkTimerLog* timer = vtkTimerLog::New();
   timer->StartTimer();
 #endif
@@ -655,11 +698,21 @@ int vtkMRMLScene::Import()
   this->SetUndoOff();
   this->StartState(vtkMRMLScene::ImportState);
   this->ReferencedIDChanges.clear();
+  this->ReadDataTimes.clear();
+  for (int phase = 0; phase < vtkMRMLScene::NumberOfImportPhases; ++phase)
+    {
+    this->ImportPhaseTimes[phase] = -1.;
+    }
 
   // read nodes into a temp scene
   vtkSmartPointer<vtkCollection> loadedNodes = vtkSmartPointer<vtkCollection>::New();
 
+  // A phase starts when the previous one ends so that the phase times add
+  // up to the import time
+  double importStartTime = vtkTimerLog::GetUniversalTime();
+  double phaseStartTime = importStartTime;
   int parsingSuccess = this->LoadIntoScene(loadedNodes);
+  this->EndImportPhase(ImportParsePhase, phaseStartTime);
 
   if (parsingSuccess)
     {
@@ -675,25 +728,26 @@ int vtkMRMLScene::Import()
       {
       this->AddReservedID(node->GetID());
       }
-#ifdef MRMLSCENE_VERBOSE
-    addNodesTimer->StartTimer();
-#endif
     for (loadedNodes->InitTraversal(it);
          (node = (vtkMRMLNode*)loadedNodes->GetNextItemAsObject(it)) ;)
       {
       this->AddNode(node);
       }
-#ifdef MRMLSCENE_VERBOSE
-    addNodesTimer->StopTimer();
-    updateSceneTimer->StartTimer();
-#endif
+    this->EndImportPhase(ImportAddNodesPhase, phaseStartTime);
+
     // Update the node references to the changed node IDs
     // (that conflicted in the current scene and the imported scene)
+    // in one pass once all the nodes are added
     this->UpdateNodeReferences(loadedNodes);
     this->RemoveReservedIDs();
+    this->EndImportPhase(ImportUpdateReferencesPhase, phaseStartTime);
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, NULL);
 
+    // Read the volumes concurrently, the nodes already read are skipped by
+    // vtkMRMLStorableNode::UpdateScene()
+    this->ReadDataInParallel(loadedNodes);
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -720,9 +774,7 @@ int vtkMRMLScene::Import()
 
     this->Modified();
     this->RemoveUnusedNodeReferences();
-#ifdef MRMLSCENE_VERBOSE
-    updateSceneTimer->StopTimer();
-#endif
+    this->EndImportPhase(ImportUpdateScenePhase, phaseStartTime);
     }
   else
     {
@@ -731,6 +783,8 @@ int vtkMRMLScene::Import()
     this->ReferencedIDChanges.clear();
     }
 
+  this->ImportTime = phaseStartTime - importStartTime;
+
   this->SetUndoFlag(undoFlag);
 
 #ifdef MRMLSCENE_VERBOSE
@@ -750,12 +804,10 @@ int vtkMRMLScene::Import()
     }
 #ifdef MRMLSCENE_VERBOSE
   timer->StopTimer();
-  std::cerr<<"vtkMRMLScene::Import()::AddNodes:" << addNodesTimer->GetElapsedTime() << "\n";
-  std::cerr<< "vtkMRMLScene::Import()::UpdateScene" << updateSceneTimer->GetElapsedTime() << "\n";
+  this->PrintImportSummary(std::cerr, vtkIndent());
   std::cerr<<"vtkMRMLScene::Import()::SceneImported:" << importingTimer->GetElapsedTime() << "\n";
   std::cerr<<"vtkMRMLScene::Import():" << timer->GetElapsedTime() << "\n";
-  addNodesTimer->Delete();
-  updateSceneTimer->Delete();
+  this->PrintReadDataSummary(std::cerr, vtkIndent());
   importingTimer->Delete();
   timer->Delete();
 #endif
@@ -763,6 +815,596 @@ int vtkMRMLScene::Import()
   return returnCode;
 }
 
+//------------------------------------------------------------------------------
+namespace
+{
+/// Data of a volume node read by a worker thread of ReadDataInParallel().
+/// The file is read into copies of the volume and storage nodes that are not
+/// in the scene, so that no scene observer is called from the worker thread.
+struct ReadDataJob
+{
+  vtkMRMLStorableNode* Node;
+  vtkMRMLStorageNode* StorageNode;
+  vtkSmartPointer<vtkMRMLStorableNode> TempNode;
+  vtkSmartPointer<vtkMRMLStorageNode> TempStorageNode;
+  /// Number of file names of the storage node before reading.
+  int NumberOfFileNames;
+  int Result;
+  double Time;
+};
+
+struct ReadDataJobQueue
+{
+  std::vector<ReadDataJob> Jobs;
+  size_t NextJob;
+  vtkSimpleCriticalSection Lock;
+  /// The ITK 3 IO factories create the image IOs from a shared list that
+  /// is not thread-safe: the files are then read one at a time.
+  vtkSimpleCriticalSection ReadLock;
+};
+
+//------------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ReadDataThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ReadDataJobQueue* queue = static_cast<ReadDataJobQueue*>(info->UserData);
+  while (true)
+    {
+    queue->Lock.Lock();
+    size_t jobIndex = queue->NextJob++;
+    queue->Lock.Unlock();
+    if (jobIndex >= queue->Jobs.size())
+      {
+      break;
+      }
+    ReadDataJob& job = queue->Jobs[jobIndex];
+#if ITK_VERSION_MAJOR < 4
+    queue->ReadLock.Lock();
+#endif
+    double startTime = vtkTimerLog::GetUniversalTime();
+    job.Result = job.TempStorageNode->ReadData(job.TempNode.GetPointer());
+    job.Time = vtkTimerLog::GetUniversalTime() - startTime;
+#if ITK_VERSION_MAJOR < 4
+    queue->ReadLock.Unlock();
+#endif
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ReadDataInParallel(vtkCollection* nodes)
+{
+  if (this->NumberOfReadDataThreads < 2 || !this->ReadDataOnLoad)
+    {
+    return;
+    }
+
+  ReadDataJobQueue queue;
+  queue.NextJob = 0;
+  vtkMRMLNode *node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)nodes->GetNextItemAsObject(it)) ;)
+    {
+    // Only the volume nodes transfer all their data with Copy()
+    vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+    if (!volumeNode || !volumeNode->GetAddToScene() ||
+        volumeNode->GetNumberOfStorageNodes() != 1)
+      {
+      continue;
+      }
+    vtkMRMLStorageNode* storageNode = vtkMRMLStorageNode::SafeDownCast(
+      this->GetNodeByID(volumeNode->GetNthStorageNodeID(0)));
+    // Remote files are left to UpdateScene() and the cache manager
+    if (!storageNode || !storageNode->GetAddToScene() ||
+        storageNode->GetFileName() == NULL ||
+        (storageNode->GetURI() != NULL && strlen(storageNode->GetURI()) > 0) ||
+        !storageNode->CanReadInReferenceNode(volumeNode))
+      {
+      continue;
+      }
+    ReadDataJob job;
+    job.Node = volumeNode;
+    job.StorageNode = storageNode;
+    job.TempNode.TakeReference(
+      vtkMRMLStorableNode::SafeDownCast(volumeNode->CreateNodeInstance()));
+    job.TempNode->Copy(volumeNode);
+    job.TempStorageNode.TakeReference(
+      vtkMRMLStorageNode::SafeDownCast(storageNode->CreateNodeInstance()));
+    job.TempStorageNode->Copy(storageNode);
+    // Keep the ID so that the temporary node still references the storage
+    // node after ReadData()
+    static_cast<vtkMRMLNode*>(job.TempStorageNode.GetPointer())->SetID(
+      storageNode->GetID());
+    // The temporary storage node has no scene to resolve relative paths with
+    job.TempStorageNode->SetFileName(
+      storageNode->GetFullNameFromFileName().c_str());
+    job.TempStorageNode->ResetFileNameList();
+    for (int n = 0; n < storageNode->GetNumberOfFileNames(); ++n)
+      {
+      job.TempStorageNode->AddFileName(
+        storageNode->GetFullNameFromNthFileName(n).c_str());
+      }
+    job.NumberOfFileNames = job.TempStorageNode->GetNumberOfFileNames();
+    job.Result = 0;
+    job.Time = 0.;
+    queue.Jobs.push_back(job);
+    }
+  if (queue.Jobs.size() == 0)
+    {
+    return;
+    }
+
+  // The first archetype reader registers the extra ITK IO factories and
+  // unregisters the deprecated ones: make sure it happens on this thread
+  // and not concurrently in the worker threads.
+  vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader> factoriesReader =
+    vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+
+  vtkSmartPointer<vtkMultiThreader> threader =
+    vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(
+    std::min(this->NumberOfReadDataThreads, static_cast<int>(queue.Jobs.size())));
+  threader->SetSingleMethod(ReadDataThread, &queue);
+  threader->SingleMethodExecute();
+
+  // Transfer the data to the scene nodes
+  std::vector<ReadDataJob>::iterator jobIt;
+  for (jobIt = queue.Jobs.begin(); jobIt != queue.Jobs.end(); ++jobIt)
+    {
+    vtkMRMLStorageNode* storageNode = jobIt->StorageNode;
+    this->ReadDataTimes[storageNode->GetID()] = jobIt->Time;
+    if (!jobIt->Result)
+      {
+      this->SetErrorCode(1);
+      this->SetErrorMessage(std::string("Error reading file ") +
+                            storageNode->GetFileName());
+      continue;
+      }
+    jobIt->Node->Copy(jobIt->TempNode.GetPointer());
+    // Files of a series found by the reader
+    for (int n = jobIt->NumberOfFileNames;
+         n < jobIt->TempStorageNode->GetNumberOfFileNames(); ++n)
+      {
+      storageNode->AddFileName(jobIt->TempStorageNode->GetNthFileName(n));
+      }
+    storageNode->SetReadStateIdle();
+    storageNode->StoredTime->Modified();
+    }
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLScene::GetReadDataTime(const char* storageNodeID)
+{
+  if (storageNodeID == NULL)
+    {
+    return -1.;
+    }
+  std::map<std::string, double>::const_iterator it =
+    this->ReadDataTimes.find(storageNodeID);
+  return it != this->ReadDataTimes.end() ? it->second : -1.;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::SetReadDataTime(const char* storageNodeID, double time)
+{
+  if (storageNodeID == NULL)
+    {
+    return;
+    }
+  this->ReadDataTimes[storageNodeID] = time;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PrintReadDataSummary(ostream& os, vtkIndent indent)
+{
+  double totalTime = 0.;
+  std::map<std::string, double>::const_iterator it;
+  for (it = this->ReadDataTimes.begin(); it != this->ReadDataTimes.end(); ++it)
+    {
+    vtkMRMLStorageNode* storageNode =
+      vtkMRMLStorageNode::SafeDownCast(this->GetNodeByID(it->first));
+    const char* fileName = storageNode ? storageNode->GetFileName() : NULL;
+    os << indent << it->first << " (" << (fileName ? fileName : "(none)")
+       << "): " << it->second << "s\n";
+    totalTime += it->second;
+    }
+  os << indent << "Files read: " << this->ReadDataTimes.size()
+     << ", total read time: " << totalTime << "s with "
+     << this->NumberOfReadDataThreads << " thread(s)\n";
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLScene::GetImportPhaseTime(int phase)
+{
+  if (phase < 0 || phase >= vtkMRMLScene::NumberOfImportPhases)
+    {
+    vtkErrorMacro("GetImportPhaseTime: invalid phase " << phase);
+    return -1.;
+    }
+  return this->ImportPhaseTimes[phase];
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::EndImportPhase(int phase, double& phaseStartTime)
+{
+  double now = vtkTimerLog::GetUniversalTime();
+  this->ImportPhaseTimes[phase] = now - phaseStartTime;
+  phaseStartTime = now;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PrintImportSummary(ostream& os, vtkIndent indent)
+{
+  os << indent << "Parse: " << this->ImportPhaseTimes[ImportParsePhase] << "s\n";
+  os << indent << "Add nodes: " << this->ImportPhaseTimes[ImportAddNodesPhase] << "s\n";
+  os << indent << "Update references: "
+     << this->ImportPhaseTimes[ImportUpdateReferencesPhase] << "s\n";
+  os << indent << "Update scene: " << this->ImportPhaseTimes[ImportUpdateScenePhase] << "s\n";
+  os << indent << "Import: " << this->ImportTime << "s\n";
+}
+
+//------------------------------------------------------------------------------
+namespace
+{
+/// Volume node written by a worker thread of WriteDataInParallel().
+/// The worker writes a copy of the node taken before the threads start, which
+/// shares the voxels but not the pipeline of the node image data: the main
+/// thread can update and render the node meanwhile. The modified events of
+/// the storage node are disabled while it writes so that no observer is
+/// called from the worker thread.
+struct WriteDataJob
+{
+  vtkSmartPointer<vtkMRMLVolumeNode> Snapshot;
+  vtkMRMLStorageNode* StorageNode;
+  int StorageNodeDisabledModify;
+  int NumberOfCompressionThreads;
+  int Result;
+  double Time;
+};
+
+//------------------------------------------------------------------------------
+/// Set the number of threads a NRRD storage node compresses with, return the
+/// previous one (0 if the storage node can't compress concurrently).
+int SetNumberOfCompressionThreads(vtkMRMLStorageNode* storageNode, int threads)
+{
+  vtkMRMLNRRDStorageNode* nrrdStorageNode =
+    vtkMRMLNRRDStorageNode::SafeDownCast(storageNode);
+  if (!nrrdStorageNode || threads < 1)
+    {
+    return 0;
+    }
+  int previousThreads = nrrdStorageNode->GetNumberOfCompressionThreads();
+  nrrdStorageNode->SetNumberOfCompressionThreads(threads);
+  return previousThreads;
+}
+
+//------------------------------------------------------------------------------
+/// Output window that keeps the messages of the worker threads of
+/// WriteDataInParallel() until the main thread displays them.
+class vtkMRMLSceneMessageCollector : public vtkOutputWindow
+{
+public:
+  static vtkMRMLSceneMessageCollector* New();
+  vtkTypeMacro(vtkMRMLSceneMessageCollector, vtkOutputWindow);
+
+  virtual void DisplayText(const char* text)
+    { this->AddMessage(TextMessage, text); }
+  virtual void DisplayErrorText(const char* text)
+    { this->AddMessage(ErrorMessage, text); }
+  virtual void DisplayWarningText(const char* text)
+    { this->AddMessage(WarningMessage, text); }
+  virtual void DisplayGenericWarningText(const char* text)
+    { this->AddMessage(GenericWarningMessage, text); }
+  virtual void DisplayDebugText(const char* text)
+    { this->AddMessage(DebugMessage, text); }
+
+  /// Display the collected messages in \a outputWindow and forget them.
+  void Flush(vtkOutputWindow* outputWindow)
+    {
+    this->Lock.Lock();
+    std::vector<std::pair<int, std::string> > messages;
+    messages.swap(this->Messages);
+    this->Lock.Unlock();
+    std::vector<std::pair<int, std::string> >::const_iterator it;
+    for (it = messages.begin(); it != messages.end(); ++it)
+      {
+      const char* text = it->second.c_str();
+      switch (it->first)
+        {
+        case ErrorMessage: outputWindow->DisplayErrorText(text); break;
+        case WarningMessage: outputWindow->DisplayWarningText(text); break;
+        case GenericWarningMessage: outputWindow->DisplayGenericWarningText(text); break;
+        case DebugMessage: outputWindow->DisplayDebugText(text); break;
+        default: outputWindow->DisplayText(text); break;
+        }
+      }
+    }
+
+protected:
+  vtkMRMLSceneMessageCollector() {}
+  ~vtkMRMLSceneMessageCollector() {}
+
+  enum MessageType
+  {
+    TextMessage,
+    ErrorMessage,
+    WarningMessage,
+    GenericWarningMessage,
+    DebugMessage
+  };
+
+  void AddMessage(int type, const char* text)
+    {
+    this->Lock.Lock();
+    this->Messages.push_back(std::make_pair(type, std::string(text ? text : "")));
+    this->Lock.Unlock();
+    }
+
+  std::vector<std::pair<int, std::string> > Messages;
+  vtkSimpleCriticalSection Lock;
+
+private:
+  vtkMRMLSceneMessageCollector(const vtkMRMLSceneMessageCollector&);
+  void operator=(const vtkMRMLSceneMessageCollector&);
+};
+
+vtkStandardNewMacro(vtkMRMLSceneMessageCollector);
+
+//------------------------------------------------------------------------------
+struct WriteDataJobQueue
+{
+  std::vector<WriteDataJob> Jobs;
+  size_t NextJob;
+  size_t NumberOfWrittenJobs;
+  vtkSimpleCriticalSection Lock;
+  /// Scene that reports the progress.
+  vtkMRMLScene* Scene;
+  vtkMRMLSceneMessageCollector* Messages;
+  vtkOutputWindow* OutputWindow;
+};
+
+//------------------------------------------------------------------------------
+/// Run by the calling thread while the worker threads write: invoke the
+/// progress events and display the messages of the worker threads.
+void ReportWriteDataProgress(WriteDataJobQueue* queue)
+{
+  size_t reportedJobs = 0;
+  while (reportedJobs < queue->Jobs.size())
+    {
+    vtksys::SystemTools::Delay(50);
+    queue->Lock.Lock();
+    size_t writtenJobs = queue->NumberOfWrittenJobs;
+    queue->Lock.Unlock();
+    queue->Messages->Flush(queue->OutputWindow);
+    if (writtenJobs != reportedJobs)
+      {
+      reportedJobs = writtenJobs;
+      double progress = static_cast<double>(reportedJobs) / queue->Jobs.size();
+      queue->Scene->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE WriteDataThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  WriteDataJobQueue* queue = static_cast<WriteDataJobQueue*>(info->UserData);
+  // vtkMultiThreader::SingleMethodExecute() runs the thread 0 on the calling
+  // thread.
+  if (info->ThreadID == 0)
+    {
+    ReportWriteDataProgress(queue);
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  while (true)
+    {
+    queue->Lock.Lock();
+    size_t jobIndex = queue->NextJob++;
+    queue->Lock.Unlock();
+    if (jobIndex >= queue->Jobs.size())
+      {
+      break;
+      }
+    WriteDataJob& job = queue->Jobs[jobIndex];
+    double startTime = vtkTimerLog::GetUniversalTime();
+    job.Result = job.StorageNode->WriteData(job.Snapshot);
+    job.Time = vtkTimerLog::GetUniversalTime() - startTime;
+    queue->Lock.Lock();
+    ++queue->NumberOfWrittenJobs;
+    queue->Lock.Unlock();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLScene::WriteDataInParallel(vtkCollection* storableNodes)
+{
+  this->WriteDataTimes.clear();
+  this->WriteDataElapsedTime = 0.;
+  if (storableNodes == NULL)
+    {
+    return 1;
+    }
+  double elapsedStartTime = vtkTimerLog::GetUniversalTime();
+
+  int result = 1;
+  WriteDataJobQueue queue;
+  queue.NextJob = 0;
+  queue.NumberOfWrittenJobs = 0;
+  queue.Scene = this;
+  std::vector<vtkMRMLStorableNode*> serialNodes;
+  // Files and images already written by a job
+  std::set<std::string> jobFileNames;
+  std::set<vtkImageData*> jobImages;
+  vtkMRMLStorableNode *node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (storableNodes->InitTraversal(it);
+       (node = vtkMRMLStorableNode::SafeDownCast(storableNodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorageNode* storageNode = node->GetStorageNode();
+    if (!storageNode || !node->GetSaveWithScene())
+      {
+      continue;
+      }
+    vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+    std::string fullName = storageNode->GetFileName() ?
+      storageNode->GetFullNameFromFileName() : std::string();
+    // Archetype storage nodes write in a temporary directory named after the
+    // file name without its extension
+    std::string fileKey = vtksys::SystemTools::GetParentDirectory(fullName.c_str())
+      + "/" + vtksys::SystemTools::GetFilenameWithoutExtension(fullName);
+    if (this->NumberOfWriteDataThreads < 2 ||
+        !volumeNode || !volumeNode->GetImageData() ||
+        fullName.empty() ||
+        (storageNode->GetURI() != NULL && strlen(storageNode->GetURI()) > 0) ||
+        !storageNode->CanWriteFromReferenceNode(volumeNode) ||
+        jobFileNames.count(fileKey) ||
+        jobImages.count(volumeNode->GetImageData()))
+      {
+      serialNodes.push_back(node);
+      continue;
+      }
+    jobFileNames.insert(fileKey);
+    jobImages.insert(volumeNode->GetImageData());
+    WriteDataJob job;
+    job.Snapshot = volumeNode;
+    job.StorageNode = storageNode;
+    job.StorageNodeDisabledModify = 0;
+    job.NumberOfCompressionThreads = 0;
+    job.Result = 0;
+    job.Time = 0.;
+    queue.Jobs.push_back(job);
+    }
+
+  if (queue.Jobs.size() > 0)
+    {
+    // Create on the main thread what the writers would otherwise lazily
+    // create on the worker threads.
+    if (this->GetDataIOManager())
+      {
+      this->GetDataIOManager()->GetFileFormatHelper();
+      }
+    // The threads left when there are fewer jobs than threads compress
+    int compressionThreads = std::max(1,
+      this->NumberOfWriteDataThreads / static_cast<int>(queue.Jobs.size()));
+    std::vector<WriteDataJob>::iterator jobIt;
+    for (jobIt = queue.Jobs.begin(); jobIt != queue.Jobs.end(); ++jobIt)
+      {
+      vtkMRMLVolumeNode* volumeNode = jobIt->Snapshot;
+      jobIt->Snapshot.TakeReference(vtkMRMLVolumeNode::SafeDownCast(
+        volumeNode->CreateNodeInstance()));
+      jobIt->Snapshot->Copy(volumeNode);
+      jobIt->Snapshot->CopyOrientation(volumeNode);
+      vtkNew<vtkImageData> image;
+      image->ShallowCopy(volumeNode->GetImageData());
+      jobIt->Snapshot->SetAndObserveImageData(image.GetPointer());
+      image->GetProducerPort();
+      jobIt->StorageNodeDisabledModify = jobIt->StorageNode->StartModify();
+      jobIt->NumberOfCompressionThreads =
+        SetNumberOfCompressionThreads(jobIt->StorageNode, compressionThreads);
+      }
+
+    // The messages of the worker threads are displayed by this thread
+    vtkSmartPointer<vtkOutputWindow> outputWindow = vtkOutputWindow::GetInstance();
+    vtkSmartPointer<vtkMRMLSceneMessageCollector> messages =
+      vtkSmartPointer<vtkMRMLSceneMessageCollector>::New();
+    queue.Messages = messages;
+    queue.OutputWindow = outputWindow;
+    vtkOutputWindow::SetInstance(messages);
+
+    // One more thread for this thread to report the progress
+    vtkSmartPointer<vtkMultiThreader> threader =
+      vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(
+      std::min(this->NumberOfWriteDataThreads, static_cast<int>(queue.Jobs.size())) + 1);
+    threader->SetSingleMethod(WriteDataThread, &queue);
+    threader->SingleMethodExecute();
+
+    vtkOutputWindow::SetInstance(outputWindow);
+    messages->Flush(outputWindow);
+
+    for (jobIt = queue.Jobs.begin(); jobIt != queue.Jobs.end(); ++jobIt)
+      {
+      SetNumberOfCompressionThreads(jobIt->StorageNode,
+                                    jobIt->NumberOfCompressionThreads);
+      jobIt->StorageNode->EndModify(jobIt->StorageNodeDisabledModify);
+      jobIt->Snapshot = 0;
+      if (jobIt->StorageNode->GetID())
+        {
+        this->WriteDataTimes[jobIt->StorageNode->GetID()] = jobIt->Time;
+        }
+      if (!jobIt->Result)
+        {
+        vtkErrorMacro("WriteDataInParallel: error writing file "
+                      << jobIt->StorageNode->GetFileName());
+        result = 0;
+        }
+      }
+    }
+
+  std::vector<vtkMRMLStorableNode*>::iterator nodeIt;
+  for (nodeIt = serialNodes.begin(); nodeIt != serialNodes.end(); ++nodeIt)
+    {
+    vtkMRMLStorageNode* storageNode = (*nodeIt)->GetStorageNode();
+    // Nodes written one at a time can compress with all the threads
+    int numberOfCompressionThreads = this->NumberOfWriteDataThreads > 1 ?
+      SetNumberOfCompressionThreads(storageNode, this->NumberOfWriteDataThreads) : 0;
+    double startTime = vtkTimerLog::GetUniversalTime();
+    if (!storageNode->WriteData(*nodeIt))
+      {
+      vtkErrorMacro("WriteDataInParallel: error writing file "
+                    << (storageNode->GetFileName() ? storageNode->GetFileName() : "(none)"));
+      result = 0;
+      }
+    SetNumberOfCompressionThreads(storageNode, numberOfCompressionThreads);
+    if (storageNode->GetID())
+      {
+      this->WriteDataTimes[storageNode->GetID()] =
+        vtkTimerLog::GetUniversalTime() - startTime;
+      }
+    }
+  this->WriteDataElapsedTime = vtkTimerLog::GetUniversalTime() - elapsedStartTime;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+double vtkMRMLScene::GetWriteDataTime(const char* storageNodeID)
+{
+  if (storageNodeID == NULL)
+    {
+    return -1.;
+    }
+  std::map<std::string, double>::const_iterator it =
+    this->WriteDataTimes.find(storageNodeID);
+  return it != this->WriteDataTimes.end() ? it->second : -1.;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PrintWriteDataSummary(ostream& os, vtkIndent indent)
+{
+  double totalTime = 0.;
+  std::map<std::string, double>::const_iterator it;
+  for (it = this->WriteDataTimes.begin(); it != this->WriteDataTimes.end(); ++it)
+    {
+    vtkMRMLStorageNode* storageNode =
+      vtkMRMLStorageNode::SafeDownCast(this->GetNodeByID(it->first));
+    const char* fileName = storageNode ? storageNode->GetFileName() : NULL;
+    os << indent << it->first << " (" << (fileName ? fileName : "(none)")
+       << "): " << it->second << "s\n";
+    totalTime += it->second;
+    }
+  os << indent << "Files written: " << this->WriteDataTimes.size()
+     << ", total write time: " << totalTime << "s, elapsed time: "
+     << this->WriteDataElapsedTime << "s with "
+     << this->NumberOfWriteDataThreads << " thread(s)\n";
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
 {
@@ -1074,6 +1716,7 @@ vtkMRMLNode*  vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
 
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->AddNodeClass(n);
 
   //n->OnNodeAddedToScene();
 
@@ -1205,6 +1848,10 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
 
   std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeClass(n);
+  // The snapshot stays in the undo steps that use it, but must not be shared
+  // with a node that would later be allocated at the same address.
+  this->UndoSnapshots.erase(n);
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1381,18 +2028,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetCachedNodesByClass(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1403,16 +2039,9 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
-    }
+  const std::vector<vtkMRMLNode*>& classNodes =
+    this->GetCachedNodesByClass(className);
+  nodes.insert(nodes.end(), classNodes.begin(), classNodes.end());
   return static_cast<int>(nodes.size());
 }
 
@@ -1425,15 +2054,12 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return 0;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes =
+    this->GetCachedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(*it);
     }
   return nodes;
 }
@@ -1528,22 +2154,13 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return NULL;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes =
+    this->GetCachedNodesByClass(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return NULL;
     }
-  return NULL;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1683,11 +2300,13 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  const std::vector<vtkMRMLNode*>& classNodes =
+    this->GetCachedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (!strcmp(node->GetName(), name) && node->IsA(className))
+    vtkMRMLNode* node = *it;
+    if (node->GetName() && !strcmp(node->GetName(), name))
       {
       nodes->AddItem(node);
       }
@@ -1775,6 +2394,7 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->AddNodeClass(n, itemIndex == 0);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -1856,6 +2476,7 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->AddNodeClass(n, itemIndex == 0);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -1876,6 +2497,14 @@ void vtkMRMLScene::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ErrorCode = " << this->ErrorCode << "\n";
   os << indent << "URL = " << this->GetURL() << "\n";
   os << indent << "Root Directory = " << this->GetRootDirectory() << "\n";
+  os << indent << "Import:\n";
+  this->PrintImportSummary(os, indent.GetNextIndent());
+  os << indent << "NumberOfReadDataThreads = " << this->NumberOfReadDataThreads << "\n";
+  os << indent << "Read data:\n";
+  this->PrintReadDataSummary(os, indent.GetNextIndent());
+  os << indent << "NumberOfWriteDataThreads = " << this->NumberOfWriteDataThreads << "\n";
+  os << indent << "Written data:\n";
+  this->PrintWriteDataSummary(os, indent.GetNextIndent());
 
   this->Nodes->vtkCollection::PrintSelf(os,indent);
   std::list<std::string> classes = this->GetNodeClassesList();
@@ -2117,6 +2746,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
     {
     this->CopyNodeInUndoStack(node);
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2148,6 +2778,7 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2187,6 +2818,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2232,7 +2864,6 @@ void vtkMRMLScene::PushIntoUndoStack()
       }
     }
 
-  //TODO check max stack size
   this->UndoStack.push_back(newScene);
 }
 
@@ -2275,10 +2906,34 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     return;
     }
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  // If the node hasn't been modified since its last snapshot, reuse the
+  // snapshot instead of copying the node again.
+  vtkSmartPointer<vtkMRMLNode> snode;
+  UndoSnapshotsType::iterator snapshotIt = this->UndoSnapshots.find(copyNode);
+  if (snapshotIt != this->UndoSnapshots.end() &&
+      snapshotIt->second.second == copyNode->GetMTime() &&
+      !copyNode->GetDisableModifiedEvent() &&
+      copyNode->GetModifiedEventPending() == 0)
     {
+    snode = snapshotIt->second.first;
+    }
+  else
+    {
+    snode.TakeReference(copyNode->CreateNodeInstance());
     snode->CopyWithScene(copyNode);
+    this->UndoSnapshots[copyNode] =
+      std::make_pair(snode, copyNode->GetMTime());
+    }
+  UndoSnapshotMemorySizesType::iterator sizeIt =
+    this->UndoSnapshotMemorySizes.find(snode);
+  // A new snapshot, or a shared one whose size was released with the last
+  // undo step that used it.
+  if (this->UndoStackMemoryBudget > 0 &&
+      sizeIt == this->UndoSnapshotMemorySizes.end())
+    {
+    sizeIt = this->UndoSnapshotMemorySizes.insert(std::make_pair(
+      snode.GetPointer(),
+      std::make_pair(this->EstimateUndoNodeMemorySize(snode), 0))).first;
     }
   vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
   int nnodes = undoScene->GetNumberOfItems();
@@ -2288,10 +2943,76 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     if (node == copyNode)
       {
       undoScene->ReplaceItem (n, snode);
+      // The snapshot memory is counted once, whatever the number of undo
+      // steps using it.
+      if (sizeIt != this->UndoSnapshotMemorySizes.end() &&
+          sizeIt->second.second++ == 0)
+        {
+        this->UndoStackMemorySize += sizeIt->second.first;
+        }
       break;
       }
     }
-  snode->Delete();
+  if (sizeIt != this->UndoSnapshotMemorySizes.end() &&
+      sizeIt->second.second == 0)
+    {
+    // The snapshot is not used by any undo step
+    this->UndoSnapshotMemorySizes.erase(sizeIt);
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::TrimUndoStack()
+{
+  while (!this->UndoStack.empty() &&
+         (static_cast<int>(this->UndoStack.size()) > this->UndoStackSize ||
+          (this->UndoStackMemoryBudget > 0 &&
+           this->UndoStackMemorySize > this->UndoStackMemoryBudget * 1024 &&
+           this->UndoStack.size() > 1)))
+    {
+    this->DeleteUndoStep(this->UndoStack.front());
+    this->UndoStack.pop_front();
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::DeleteUndoStep(vtkCollection* undoStep)
+{
+  int nnodes = undoStep->GetNumberOfItems();
+  for (int n=0; n<nnodes; n++)
+    {
+    UndoSnapshotMemorySizesType::iterator sizeIt =
+      this->UndoSnapshotMemorySizes.find(
+        vtkMRMLNode::SafeDownCast(undoStep->GetItemAsObject(n)));
+    if (sizeIt == this->UndoSnapshotMemorySizes.end())
+      {
+      continue;
+      }
+    if (--sizeIt->second.second <= 0)
+      {
+      // Last undo step using the snapshot
+      this->UndoStackMemorySize -= sizeIt->second.first;
+      this->UndoSnapshotMemorySizes.erase(sizeIt);
+      }
+    }
+  undoStep->RemoveAllItems();
+  undoStep->Delete();
+}
+
+//------------------------------------------------------------------------------
+unsigned long vtkMRMLScene::EstimateUndoNodeMemorySize(vtkMRMLNode* node)
+{
+  // Snapshots share their bulk data with the original node, what is
+  // duplicated are the node attributes, which are all written in the XML.
+  std::stringstream ss;
+  node->WriteXML(ss, 0);
+  return static_cast<unsigned long>(ss.str().size()) + sizeof(*node);
+}
+
+//------------------------------------------------------------------------------
+unsigned long vtkMRMLScene::GetUndoStackMemorySize()
+{
+  return this->UndoStackMemorySize / 1024;
 }
 
 //------------------------------------------------------------------------------
@@ -2423,7 +3144,7 @@ void vtkMRMLScene::Undo()
 
   for (nn=0; nn<addNodes.size(); nn++)
     {
-    this->AddNode(addNodes[nn]);
+    this->AddUndoNode(addNodes[nn]);
     }
   for (nn=0; nn<removeNodes.size(); nn++)
     {
@@ -2438,8 +3159,7 @@ void vtkMRMLScene::Undo()
 
   if (undoScene)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    this->DeleteUndoStep(undoScene);
     }
 
   this->RemoveUnusedNodeReferences();
@@ -2544,7 +3264,7 @@ void vtkMRMLScene::Redo()
 
   for (nn=0; nn<addNodes.size(); nn++)
     {
-    this->AddNode(addNodes[nn]);
+    this->AddUndoNode(addNodes[nn]);
     }
   for (nn=0; nn<removeNodes.size(); nn++)
     {
@@ -2562,6 +3282,24 @@ void vtkMRMLScene::Redo()
   this->Modified();
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLScene::AddUndoNode(vtkMRMLNode* node)
+{
+  if (node->GetScene() == NULL)
+    {
+    // The node was removed from the scene after the undo step was saved, it
+    // can be added back as is.
+    this->AddNode(node);
+    return;
+    }
+  // The node is a snapshot that may be shared with other undo steps, it must
+  // stay untouched, add a copy instead.
+  vtkSmartPointer<vtkMRMLNode> nodeCopy;
+  nodeCopy.TakeReference(node->CreateNodeInstance());
+  nodeCopy->CopyWithScene(node);
+  this->AddNode(nodeCopy);
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearUndoStack()
 {
@@ -2572,6 +3310,9 @@ void vtkMRMLScene::ClearUndoStack()
     (*iter)->Delete();
     }
   this->UndoStack.clear();
+  this->UndoSnapshotMemorySizes.clear();
+  this->UndoStackMemorySize = 0;
+  this->UndoSnapshots.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2676,6 +3417,23 @@ const char* vtkMRMLScene::GetChangedID(const char* id)
 //------------------------------------------------------------------------------
 void vtkMRMLScene::UpdateNodeReferences(vtkCollection* checkNodes/*=NULL*/)
 {
+  if (this->ReferencedIDChanges.empty())
+    {
+    return;
+    }
+  // Index the nodes to check, searching the collection for each referencing
+  // node is too slow for large scenes
+  std::set<vtkMRMLNode*> checkNodesSet;
+  if (checkNodes != NULL)
+    {
+    vtkMRMLNode* checkNode;
+    vtkCollectionSimpleIterator it;
+    for (checkNodes->InitTraversal(it);
+         (checkNode = vtkMRMLNode::SafeDownCast(checkNodes->GetNextItemAsObject(it))) ;)
+      {
+      checkNodesSet.insert(checkNode);
+      }
+    }
   for (std::map< std::string, std::string>::const_iterator iterChanged = this->ReferencedIDChanges.begin();
     iterChanged != this->ReferencedIDChanges.end(); iterChanged++)
     {
@@ -2696,7 +3454,7 @@ void vtkMRMLScene::UpdateNodeReferences(vtkCollection* checkNodes/*=NULL*/)
         {
         continue;
         }
-      if (checkNodes!=NULL && !checkNodes->IsItemPresent(node))
+      if (checkNodes!=NULL && checkNodesSet.find(node)==checkNodesSet.end())
         {
         continue;
         }
@@ -2894,6 +3652,102 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetCachedNodesByClass(const char* className)
+{
+  assert(className);
+  if (this->Nodes->GetMTime() > this->NodesByClassMTime)
+    {
+    // The Nodes collection has been modified without going through
+    // AddNodeClass()/RemoveNodeClass() (e.g. GetNodes()->RemoveItem()), the
+    // cached lists can't be trusted anymore.
+    this->ClearNodesByClass();
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator classIt =
+    this->NodesByClass.find(className);
+  if (classIt != this->NodesByClass.end())
+    {
+    return classIt->second;
+    }
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Compute node class cache for " << className << std::endl;
+#endif
+  std::vector<vtkMRMLNode*>& classNodes = this->NodesByClass[className];
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (node->IsA(className))
+      {
+      classNodes.push_back(node);
+      }
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeClass(vtkMRMLNode *node, bool appended)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  if (!appended)
+    {
+    // The node has been inserted in the middle of the collection, rebuild
+    // the lists lazily to keep the same order as the Nodes collection.
+    this->ClearNodesByClass();
+    return;
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator classIt;
+  for (classIt = this->NodesByClass.begin();
+       classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second.push_back(node);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeClass(vtkMRMLNode *node)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator classIt;
+  for (classIt = this->NodesByClass.begin();
+       classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (!node->IsA(classIt->first.c_str()))
+      {
+      continue;
+      }
+    std::vector<vtkMRMLNode*>& classNodes = classIt->second;
+    std::vector<vtkMRMLNode*>::iterator nodeIt =
+      std::find(classNodes.begin(), classNodes.end(), node);
+    if (nodeIt != classNodes.end())
+      {
+      classNodes.erase(nodeIt);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodesByClass()
+{
+  if (this->Nodes)
+    {
+    this->NodesByClass.clear();
+    this->NodesByClassMTime = this->Nodes->GetMTime();
+    }
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
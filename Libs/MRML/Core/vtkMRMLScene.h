@@ -260,6 +260,24 @@ public:
   /// returns number of redo steps in the history buffer
   int GetNumberOfRedoLevels() { return (int)this->RedoStack.size();};
 
+  /// Maximum number of steps in the undo stack (100 by default).
+  /// When exceeded, the oldest steps are discarded.
+  vtkGetMacro(UndoStackSize, int);
+  vtkSetMacro(UndoStackSize, int);
+
+  /// Approximate amount of memory (in kilobytes) the node snapshots of the
+  /// undo stack are allowed to use. When exceeded, the oldest steps are
+  /// discarded (the most recent step is always kept).
+  /// 0 (default) disables the budget, only UndoStackSize is then used.
+  /// Bulk data (image data, polydata...) is shared by reference between a
+  /// node and its snapshots and is not accounted for.
+  vtkGetMacro(UndoStackMemoryBudget, unsigned long);
+  vtkSetMacro(UndoStackMemoryBudget, unsigned long);
+
+  /// Approximate amount of memory (in kilobytes) used by the node snapshots
+  /// of the undo stack. Only computed when UndoStackMemoryBudget is set.
+  unsigned long GetUndoStackMemorySize();
+
   /// Save current state in the undo buffer
   void SaveStateForUndo();
   /// Save current state of the node in the undo buffer
@@ -366,6 +384,84 @@ public:
   vtkSetMacro(ReadDataOnLoad,int);
   vtkGetMacro(ReadDataOnLoad,int);
 
+  /// Number of threads used by Import() to read the data of the volume
+  /// nodes. With more than one thread, the local files of the imported
+  /// volumes are read concurrently into temporary nodes once the node
+  /// references are resolved, then transferred to the scene nodes on the
+  /// main thread before UpdateScene() is called on the imported nodes.
+  /// The other storable nodes are read by UpdateScene() as before.
+  /// With ITK 3, whose IO factories are not thread-safe, the files are
+  /// still read one at a time.
+  /// 1 by default: all the data is read by UpdateScene(), one node at a time.
+  /// \sa Import(), GetReadDataTime()
+  vtkSetClampMacro(NumberOfReadDataThreads, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfReadDataThreads, int);
+
+  /// Time in seconds the storage node \a storageNodeID took to read its data
+  /// during the last Import(), -1 if it didn't read any data.
+  /// \sa SetReadDataTime(), PrintReadDataSummary()
+  double GetReadDataTime(const char* storageNodeID);
+  /// Record the time a storage node took to read its data. Only meant to be
+  /// called during Import() (see vtkMRMLStorableNode::UpdateScene()).
+  void SetReadDataTime(const char* storageNodeID, double time);
+  /// Print the files read by the last Import() with their read times.
+  void PrintReadDataSummary(ostream& os, vtkIndent indent);
+
+  /// Phases of Import() timed by GetImportPhaseTime().
+  enum ImportPhase
+    {
+    /// Parse the scene file and instantiate the nodes
+    ImportParsePhase = 0,
+    /// Add the nodes to the scene, resolving the ID conflicts
+    ImportAddNodesPhase,
+    /// Update the references to the changed node IDs
+    ImportUpdateReferencesPhase,
+    /// Read the data and call UpdateScene() on the imported nodes
+    ImportUpdateScenePhase,
+    NumberOfImportPhases
+    };
+  /// Time in seconds spent in \a phase by the last Import(), -1 if the
+  /// phase didn't run (e.g. the scene file failed to parse).
+  /// \sa GetImportTime(), PrintImportSummary()
+  double GetImportPhaseTime(int phase);
+  /// Time in seconds spent by the last Import() in its phases, -1 if the
+  /// scene never imported. It is the sum of the times of the phases.
+  /// \sa GetImportPhaseTime()
+  vtkGetMacro(ImportTime, double);
+  /// Print the time spent in each phase of the last Import().
+  void PrintImportSummary(ostream& os, vtkIndent indent);
+
+  /// Number of threads used by WriteDataInParallel() to write the data of
+  /// the volume nodes.
+  /// 1 by default: the nodes are written one at a time. The application
+  /// sets it from the "IO/NumberOfWriteDataThreads" setting.
+  /// \sa WriteDataInParallel(), GetWriteDataTime()
+  vtkSetClampMacro(NumberOfWriteDataThreads, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfWriteDataThreads, int);
+
+  /// Write the data of the storable nodes in \a storableNodes with their
+  /// storage node. The volume nodes with a local file are written
+  /// concurrently using NumberOfWriteDataThreads threads, the modified
+  /// events of their storage nodes being invoked on the calling thread once
+  /// all the files are written. The threads write copies of the volume nodes
+  /// that share their voxels, so the pipelines of the nodes are not updated
+  /// by the worker threads. The threads left when there are fewer volumes
+  /// than threads compress NRRD files. While they are written, the calling thread
+  /// invokes vtkCommand::ProgressEvent with the fraction of these volumes
+  /// written (double*) and displays the messages of the worker threads.
+  /// The other nodes are then written one at a time. Nodes without storage
+  /// node or not saved with the scene are skipped.
+  /// Return 1 if all the data was written, 0 otherwise.
+  /// \sa GetWriteDataTime(), PrintWriteDataSummary()
+  int WriteDataInParallel(vtkCollection* storableNodes);
+  /// Time in seconds the storage node \a storageNodeID took to write its
+  /// data during the last WriteDataInParallel(), -1 if it didn't write any
+  /// data.
+  double GetWriteDataTime(const char* storageNodeID);
+  /// Print the files written by the last WriteDataInParallel() with their
+  /// write times.
+  void PrintWriteDataSummary(ostream& os, vtkIndent indent);
+
   void SetErrorMessage(const std::string &error);
   std::string GetErrorMessage();
 
@@ -575,12 +671,33 @@ protected:
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// Add back into the scene a node removed after an undo/redo step was
+  /// saved. Snapshots are never added directly but copied first.
+  void AddUndoNode(vtkMRMLNode* node);
+
+  /// Discard the oldest undo steps until the undo stack fits into
+  /// UndoStackSize and UndoStackMemoryBudget.
+  void TrimUndoStack();
+
+  /// Empty and delete an undo step. The memory of its snapshots is released
+  /// from the budget only if no other undo step uses them.
+  void DeleteUndoStep(vtkCollection* undoStep);
+
+  /// Return an estimate (in bytes) of the memory used by the attributes of a
+  /// node snapshot.
+  unsigned long EstimateUndoNodeMemorySize(vtkMRMLNode* node);
+
   /// Add a node to the scene without invoking a NodeAddedEvent event
   /// Use with extreme caution as it might unsynchronize observer.
   vtkMRMLNode* AddNodeNoNotify(vtkMRMLNode *n);
 
   void AddReferencedNodes(vtkMRMLNode *node, vtkCollection *refNodes);
 
+  /// Read concurrently the local files of the volume nodes in \a nodes
+  /// using NumberOfReadDataThreads threads. Called by Import().
+  /// \sa NumberOfReadDataThreads
+  void ReadDataInParallel(vtkCollection* nodes);
+
   /// Handle vtkMRMLScene::DeleteEvent: clear the scene
   static void SceneCallback( vtkObject *caller, unsigned long eid,
                              void *clientData, void *callData );
@@ -613,6 +730,25 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method
   void ClearNodeIDs();
 
+  /// Return the list of nodes that are of class \a className (IsA()), in
+  /// the same order as in the Nodes collection. The list is computed on the
+  /// first request for a class and then kept up to date by AddNodeClass()
+  /// and RemoveNodeClass(), so that later calls cost proportionally to the
+  /// number of returned nodes instead of the number of nodes in the scene.
+  /// \sa GetNodesByClass(), GetNthNodeByClass(), GetNumberOfNodesByClass()
+  const std::vector<vtkMRMLNode*>& GetCachedNodesByClass(const char* className);
+
+  /// Add node to the NodesByClass map used to speedup GetNodesByClass()
+  /// \a appended is true if the node has been added at the end of the Nodes
+  /// collection, otherwise the map is cleared as the order is not known.
+  void AddNodeClass(vtkMRMLNode *node, bool appended = true);
+
+  /// Remove node from NodesByClass map used to speedup GetNodesByClass()
+  void RemoveNodeClass(vtkMRMLNode *node);
+
+  /// Clear NodesByClass map used to speedup GetNodesByClass()
+  void ClearNodesByClass();
+
   /// Get a NodeReferences iterator for a node reference
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
@@ -634,6 +770,23 @@ protected:
   std::list< vtkCollection* >  UndoStack;
   std::list< vtkCollection* >  RedoStack;
 
+  /// Estimated memory (in bytes) of each snapshot of the UndoStack with the
+  /// number of undo steps that use it. Snapshots are shared between steps,
+  /// their memory is only released when the last step using them is deleted.
+  typedef std::map< vtkMRMLNode*, std::pair<unsigned long, int> >
+    UndoSnapshotMemorySizesType;
+  UndoSnapshotMemorySizesType  UndoSnapshotMemorySizes;
+  unsigned long                UndoStackMemorySize;
+  unsigned long                UndoStackMemoryBudget;
+
+  /// Last snapshot saved in the undo stack for a node with the node MTime at
+  /// that time. Snapshots are never modified once created, so they are shared
+  /// by all the undo steps saved while the node is left unmodified.
+  typedef std::map< vtkMRMLNode*,
+                    std::pair< vtkSmartPointer<vtkMRMLNode>, unsigned long> >
+    UndoSnapshotsType;
+  UndoSnapshotsType UndoSnapshots;
+
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -648,6 +801,9 @@ protected:
   NodeReferencesType NodeReferences; // ReferencedIDs (string), ReferencingNodes (node pointer)
   std::map< std::string, std::string > ReferencedIDChanges;
   std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
+  /// Nodes of the scene indexed by the class names they have been queried
+  /// with (a node is listed under all the queried classes it IsA()).
+  std::map< std::string, std::vector<vtkMRMLNode*> > NodesByClass;
 
   std::string ErrorMessage;
 
@@ -659,7 +815,28 @@ protected:
 
   int ReadDataOnLoad;
 
+  /// Record the time spent in \a phase since \a phaseStartTime and start
+  /// the next phase.
+  void EndImportPhase(int phase, double& phaseStartTime);
+
+  /// Time spent in each phase of the last Import().
+  double ImportPhaseTimes[NumberOfImportPhases];
+  double ImportTime;
+
+  int NumberOfReadDataThreads;
+  /// Time spent reading the data of each storage node during the last
+  /// Import(), indexed by storage node ID.
+  std::map< std::string, double > ReadDataTimes;
+
+  int NumberOfWriteDataThreads;
+  /// Time spent writing the data of each storage node during the last
+  /// WriteDataInParallel(), indexed by storage node ID.
+  std::map< std::string, double > WriteDataTimes;
+  /// Duration of the last WriteDataInParallel().
+  double WriteDataElapsedTime;
+
   unsigned long NodeIDsMTime;
+  unsigned long NodesByClassMTime;
 
   void RemoveAllNodes(bool removeSingletons);
 
@@ -20,6 +20,7 @@ Version:   $Revision: 1.3 $
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkTimerLog.h>
 
 // STD includes
 #include <sstream>
@@ -262,8 +263,21 @@ void vtkMRMLStorableNode::UpdateScene(vtkMRMLScene *scene)
         {
         fname = std::string(pnode->GetURI());
         }
+      bool importing = scene->IsImporting() && scene->GetReadDataOnLoad();
+      if (importing && scene->GetReadDataTime(pnode->GetID()) >= 0.)
+        {
+        // already read by the scene, see vtkMRMLScene::NumberOfReadDataThreads
+        continue;
+        }
       vtkDebugMacro("UpdateScene: calling ReadData, fname = " << fname.c_str());
-      if (pnode->ReadData(this) == 0)
+      double startTime = vtkTimerLog::GetUniversalTime();
+      int res = pnode->ReadData(this);
+      if (importing)
+        {
+        scene->SetReadDataTime(pnode->GetID(),
+                               vtkTimerLog::GetUniversalTime() - startTime);
+        }
+      if (res == 0)
         {
         scene->SetErrorCode(1);      
         std::string msg = std::string("Error reading file ") + fname;
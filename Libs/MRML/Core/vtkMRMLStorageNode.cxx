@@ -1045,6 +1045,12 @@ bool vtkMRMLStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *refNode)
   return this->CanReadInReferenceNode(refNode);
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanReadFile(vtkMRMLNode *refNode)
+{
+  return refNode != NULL && this->CanReadInReferenceNode(refNode);
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 {
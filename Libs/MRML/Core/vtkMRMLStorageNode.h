@@ -30,6 +30,10 @@ class vtkStringArray;
 /// A superclass for other storage nodes like volume and model.
 class VTK_MRML_EXPORT vtkMRMLStorageNode : public vtkMRMLNode
 {
+  /// The scene reads the data of its storage nodes concurrently on import
+  /// and updates StoredTime once the data is transferred to the scene.
+  friend class vtkMRMLScene;
+
 public:
   vtkTypeMacro(vtkMRMLStorageNode,vtkMRMLNode);
   void PrintSelf(ostream& os, vtkIndent indent);
@@ -265,6 +269,17 @@ public:
   /// \sa CanReadInReferenceNode, WriteData
   virtual bool CanWriteFromReferenceNode(vtkMRMLNode* refNode);
 
+  /// Return true if the file of the storage node can be read into the
+  /// reference node. Unlike ReadData, only the file header is inspected:
+  /// it is a cheap test to find the node type a file should be read in
+  /// before decoding its data.
+  /// By default it returns the same than CanReadInReferenceNode.
+  /// Subclasses can reimplement the method to inspect the file header.
+  /// Files that are not yet available locally (e.g. remote URIs) are
+  /// expected to be accepted, ReadData being the final check.
+  /// \sa CanReadInReferenceNode, ReadData
+  virtual bool CanReadFile(vtkMRMLNode* refNode);
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -17,6 +17,7 @@ Version:   $Revision: 1.14 $
 #include "vtkMRMLTransformStorageNode.h"
 
 // VTK includes
+#include <vtkCallbackCommand.h>
 #include <vtkGeneralTransform.h>
 
 //----------------------------------------------------------------------------
@@ -24,6 +25,15 @@ vtkMRMLTransformNode::vtkMRMLTransformNode()
 {
   this->TransformToParent = vtkGeneralTransform::New();
   this->TransformToParent->Identity();
+
+  // The generation must be up-to-date before any other observer is notified
+  this->TransformToWorldGeneration = 1;
+  this->TransformModifiedCommand = vtkCallbackCommand::New();
+  this->TransformModifiedCommand->SetClientData(this);
+  this->TransformModifiedCommand->SetCallback(
+    &vtkMRMLTransformNode::TransformModifiedCallback);
+  this->AddObserver(vtkMRMLTransformableNode::TransformModifiedEvent,
+                    this->TransformModifiedCommand, 1000.0);
 }
 
 //----------------------------------------------------------------------------
@@ -33,6 +43,8 @@ vtkMRMLTransformNode::~vtkMRMLTransformNode()
     {
     this->TransformToParent->Delete();
     }
+  this->RemoveObserver(this->TransformModifiedCommand);
+  this->TransformModifiedCommand->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -59,6 +71,18 @@ void vtkMRMLTransformNode::Copy(vtkMRMLNode *anode)
 void vtkMRMLTransformNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
+  os << indent << "TransformToWorldGeneration: "
+     << this->TransformToWorldGeneration << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::TransformModifiedCallback(vtkObject *vtkNotUsed(caller),
+                                                     unsigned long vtkNotUsed(eid),
+                                                     void *clientData,
+                                                     void *vtkNotUsed(callData))
+{
+  vtkMRMLTransformNode* self = reinterpret_cast<vtkMRMLTransformNode*>(clientData);
+  ++self->TransformToWorldGeneration;
 }
 
 //----------------------------------------------------------------------------
@@ -17,6 +17,7 @@
 
 #include "vtkMRMLStorableNode.h"
 
+class vtkCallbackCommand;
 class vtkGeneralTransform;
 class vtkMatrix4x4;
 
@@ -106,6 +107,14 @@ public:
   virtual vtkMRMLStorageNode* CreateDefaultStorageNode();
 
   virtual bool GetModifiedSinceRead();
+
+  ///
+  /// Incremented each time the transform of this node to world may have
+  /// changed, i.e. each time TransformModifiedEvent is invoked on the node.
+  /// The event is propagated down the hierarchy by the child nodes, the
+  /// generation of a node changes when any of its parents changes.
+  vtkGetMacro(TransformToWorldGeneration, unsigned long);
+
 protected:
   vtkMRMLTransformNode();
   ~vtkMRMLTransformNode();
@@ -114,6 +123,11 @@ protected:
 
   vtkGeneralTransform* TransformToParent;
 
+  /// Increment the generation when TransformModifiedEvent is invoked.
+  static void TransformModifiedCallback(vtkObject *caller, unsigned long eid,
+                                        void *clientData, void *callData);
+  vtkCallbackCommand* TransformModifiedCommand;
+  unsigned long TransformToWorldGeneration;
 };
 
 #endif
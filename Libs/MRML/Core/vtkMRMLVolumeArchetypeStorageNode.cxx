@@ -28,12 +28,14 @@ Version:   $Revision: 1.6 $
 #include "vtkITKArchetypeImageSeriesVectorReaderFile.h"
 #include "vtkITKArchetypeImageSeriesVectorReaderSeries.h"
 #include "vtkITKImageWriter.h"
+#include "itkTimeSeriesDatabaseHelper.h"
 
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkCriticalSection.h>
 #include <vtkDataArray.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkNew.h>
@@ -44,7 +46,9 @@ Version:   $Revision: 1.6 $
 
 // STD includes
 #include <algorithm>
+#include <fstream>
 #include <iterator>
+#include <map>
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLVolumeArchetypeStorageNode);
@@ -55,6 +59,7 @@ vtkMRMLVolumeArchetypeStorageNode::vtkMRMLVolumeArchetypeStorageNode()
   this->CenterImage = 0;
   this->SingleFile  = 0;
   this->UseOrientationFromFile = 1;
+  this->UseMemoryMapping = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -82,6 +87,11 @@ void vtkMRMLVolumeArchetypeStorageNode::WriteXML(ostream& of, int nIndent)
   ss << this->UseOrientationFromFile;
   of << indent << " UseOrientationFromFile=\"" << ss.str() << "\"";
   }
+  {
+  std::stringstream ss;
+  ss << this->UseMemoryMapping;
+  of << indent << " useMemoryMapping=\"" << ss.str() << "\"";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -115,6 +125,12 @@ void vtkMRMLVolumeArchetypeStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->UseOrientationFromFile;
       }
+    if (!strcmp(attName, "useMemoryMapping"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->UseMemoryMapping;
+      }
     }
 
   this->EndModify(disabledModify);
@@ -133,6 +149,7 @@ void vtkMRMLVolumeArchetypeStorageNode::Copy(vtkMRMLNode *anode)
   this->SetCenterImage(node->CenterImage);
   this->SetSingleFile(node->SingleFile);
   this->SetUseOrientationFromFile(node->UseOrientationFromFile);
+  this->SetUseMemoryMapping(node->UseMemoryMapping);
 
   this->EndModify(disabledModify);
 }
@@ -144,6 +161,7 @@ void vtkMRMLVolumeArchetypeStorageNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "CenterImage:   " << this->CenterImage << "\n";
   os << indent << "SingleFile:   " << this->SingleFile << "\n";
   os << indent << "UseOrientationFromFile:   " << this->UseOrientationFromFile << "\n";
+  os << indent << "UseMemoryMapping:   " << this->UseMemoryMapping << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -256,8 +274,425 @@ void ApplyImageSeriesReaderWorkaround(vtkMRMLVolumeArchetypeStorageNode * storag
       }
     }
 }
+
+//----------------------------------------------------------------------------
+/// Location of the pixel data of an uncompressed image file
+struct RawDataLocation
+{
+  RawDataLocation() : Offset(0), BigEndian(false) {}
+  std::string FileName;
+  size_t Offset;
+  bool BigEndian;
+};
+
+//----------------------------------------------------------------------------
+std::string TrimHeaderValue(const std::string& value)
+{
+  size_t start = value.find_first_not_of(" \t\r");
+  if (start == std::string::npos)
+    {
+    return std::string();
+    }
+  size_t end = value.find_last_not_of(" \t\r");
+  return value.substr(start, end - start + 1);
+}
+
+//----------------------------------------------------------------------------
+/// Return the full path of a data file referenced by a header file
+std::string DataFilePath(const std::string& headerFileName, const std::string& dataFileName)
+{
+  if (vtksys::SystemTools::FileIsFullPath(dataFileName.c_str()))
+    {
+    return dataFileName;
+    }
+  std::string headerDirectory = vtksys::SystemTools::GetFilenamePath(headerFileName);
+  return vtksys::SystemTools::CollapseFullPath(dataFileName.c_str(), headerDirectory.c_str());
+}
+
+//----------------------------------------------------------------------------
+/// Parse the header of a .nrrd or .nhdr file.
+/// Return false if the pixel data is not stored raw in a single file.
+bool FindNrrdRawData(const std::string& fileName, RawDataLocation& location)
+{
+  std::ifstream header(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string line;
+  if (!std::getline(header, line) || line.compare(0, 7, "NRRD000") != 0)
+    {
+    return false;
+    }
+  location.FileName = fileName;
+  bool raw = false;
+  bool detached = false;
+  while (std::getline(header, line))
+    {
+    line = TrimHeaderValue(line);
+    if (line.empty())
+      {
+      // end of the header, the attached data follows
+      break;
+      }
+    size_t colon = line.find(": ");
+    if (line[0] == '#' || colon == std::string::npos)
+      {
+      // comments and key/value pairs
+      continue;
+      }
+    std::string field = vtksys::SystemTools::LowerCase(line.substr(0, colon));
+    std::string value = TrimHeaderValue(line.substr(colon + 2));
+    if (field == "encoding")
+      {
+      raw = (value == "raw");
+      }
+    else if (field == "endian")
+      {
+      location.BigEndian = (value == "big");
+      }
+    else if ((field == "byte skip" || field == "line skip") && value != "0")
+      {
+      return false;
+      }
+    else if (field == "data file" || field == "datafile")
+      {
+      // lists and formatted file names span several files
+      if (value.compare(0, 4, "LIST") == 0 || value.find(' ') != std::string::npos)
+        {
+        return false;
+        }
+      location.FileName = DataFilePath(fileName, value);
+      detached = true;
+      }
+    }
+  if (!raw)
+    {
+    return false;
+    }
+  location.Offset = 0;
+  if (!detached)
+    {
+    std::streamoff offset = header.tellg();
+    if (offset <= 0)
+      {
+      return false;
+      }
+    location.Offset = static_cast<size_t>(offset);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Parse the header of a .mha or .mhd file.
+/// Return false if the pixel data is not stored raw in a single file.
+bool FindMetaImageRawData(const std::string& fileName, RawDataLocation& location)
+{
+  std::ifstream header(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string line;
+  while (std::getline(header, line))
+    {
+    size_t equal = line.find('=');
+    if (equal == std::string::npos)
+      {
+      continue;
+      }
+    std::string field = TrimHeaderValue(line.substr(0, equal));
+    std::string value = vtksys::SystemTools::LowerCase(TrimHeaderValue(line.substr(equal + 1)));
+    if ((field == "CompressedData" && value != "false") ||
+        (field == "BinaryData" && value != "true") ||
+        (field == "HeaderSize" && value != "0"))
+      {
+      return false;
+      }
+    else if (field == "BinaryDataByteOrderMSB" || field == "ElementByteOrderMSB")
+      {
+      location.BigEndian = (value == "true");
+      }
+    else if (field == "ElementDataFile")
+      {
+      // ElementDataFile is the last field of the header
+      if (value == "local")
+        {
+        std::streamoff offset = header.tellg();
+        if (offset <= 0)
+          {
+          return false;
+          }
+        location.FileName = fileName;
+        location.Offset = static_cast<size_t>(offset);
+        return true;
+        }
+      value = TrimHeaderValue(line.substr(equal + 1));
+      if (value == "LIST" || value.find_first_of(" %") != std::string::npos)
+        {
+        return false;
+        }
+      location.FileName = DataFilePath(fileName, value);
+      location.Offset = 0;
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+/// Scalar arrays whose memory is a mapping of a file. Volumes can be read
+/// from several threads (see vtkMRMLScene::SetNumberOfReadDataThreads()).
+struct MappedScalars
+{
+  itk::TimeSeriesDatabaseHelper::MappedFile* File;
+  std::string FileName;
+  unsigned long ReleaseObserverTag;
+};
+typedef std::map<vtkObject*, MappedScalars> MappedScalarsMapType;
+vtkSimpleCriticalSection MappedScalarsLock;
+
+//----------------------------------------------------------------------------
+MappedScalarsMapType& GetMappedScalars()
+{
+  static MappedScalarsMapType mappedScalars;
+  return mappedScalars;
+}
+
+//----------------------------------------------------------------------------
+void ReleaseMappedFile(vtkObject* caller, unsigned long vtkNotUsed(eid),
+                       void* clientData, void* vtkNotUsed(callData))
+{
+  MappedScalarsLock.Lock();
+  GetMappedScalars().erase(caller);
+  MappedScalarsLock.Unlock();
+  delete reinterpret_cast<itk::TimeSeriesDatabaseHelper::MappedFile*>(clientData);
+}
+
+//----------------------------------------------------------------------------
+void ReleaseDetachedScalars(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                            void* clientData, void* vtkNotUsed(callData))
+{
+  reinterpret_cast<vtkDataArray*>(clientData)->Delete();
+}
+
+//----------------------------------------------------------------------------
+/// Return the name of the file the scalars are mapped from, an empty string
+/// if the scalars are not mapped.
+std::string GetMappedFileName(vtkDataArray* scalars)
+{
+  std::string fileName;
+  MappedScalarsLock.Lock();
+  MappedScalarsMapType::const_iterator it = GetMappedScalars().find(scalars);
+  if (it != GetMappedScalars().end())
+    {
+    fileName = it->second.FileName;
+    }
+  MappedScalarsLock.Unlock();
+  return fileName;
+}
+
+//----------------------------------------------------------------------------
+/// Copy the mapped memory of the scalars into a memory buffer and release
+/// the mapping. The array object is kept, so the images that share it
+/// (shallow copies) use the copy too.
+void DetachMappedScalars(vtkDataArray* scalars)
+{
+  MappedScalarsLock.Lock();
+  MappedScalarsMapType::iterator it = GetMappedScalars().find(scalars);
+  if (it == GetMappedScalars().end())
+    {
+    MappedScalarsLock.Unlock();
+    return;
+    }
+  MappedScalars mapped = it->second;
+  GetMappedScalars().erase(it);
+  MappedScalarsLock.Unlock();
+
+  vtkDataArray* copy = vtkDataArray::CreateDataArray(scalars->GetDataType());
+  copy->DeepCopy(scalars);
+  // The array does not own the memory of the copy, the copy is released
+  // with the array
+  scalars->RemoveObserver(mapped.ReleaseObserverTag);
+  scalars->SetVoidArray(copy->GetVoidPointer(0),
+                        copy->GetNumberOfTuples() * copy->GetNumberOfComponents(), 1);
+  delete mapped.File;
+  vtkNew<vtkCallbackCommand> releaseCopy;
+  releaseCopy->SetCallback(ReleaseDetachedScalars);
+  releaseCopy->SetClientData(copy);
+  scalars->AddObserver(vtkCommand::DeleteEvent, releaseCopy.GetPointer());
+  scalars->Modified();
+}
+
+//----------------------------------------------------------------------------
+/// Return true if writing fileName can overwrite the mapped file: same file
+/// or same name with another extension (header and detached data files).
+bool CanOverwriteMappedFile(const std::string& fileName,
+                            const std::string& mappedFileName)
+{
+  std::string fullName = vtksys::SystemTools::CollapseFullPath(fileName.c_str());
+  std::string mappedName = vtksys::SystemTools::CollapseFullPath(mappedFileName.c_str());
+  return vtksys::SystemTools::ComparePath(
+           vtksys::SystemTools::GetFilenamePath(fullName).c_str(),
+           vtksys::SystemTools::GetFilenamePath(mappedName).c_str()) &&
+         vtksys::SystemTools::GetFilenameWithoutLastExtension(fullName) ==
+           vtksys::SystemTools::GetFilenameWithoutLastExtension(mappedName);
+}
+
+//----------------------------------------------------------------------------
+/// Create an image whose scalars are the copy-on-write memory mapping of
+/// the pixel data of the file read by the reader.
+/// Return 0 if the file can not be mapped (compressed, multi-file,
+/// multi-component, foreign byte order...).
+vtkImageData* MapImageData(vtkMRMLVolumeArchetypeStorageNode* storageNode,
+                           vtkITKArchetypeImageSeriesReader* reader)
+{
+  try
+    {
+    reader->UpdateInformation();
+    }
+  catch (...)
+    {
+    return 0;
+    }
+  if (reader->GetNumberOfFileNames() != 1 || reader->GetNumberOfComponents() != 1)
+    {
+    return 0;
+    }
+  std::string fileName = reader->GetFileName(0);
+  std::string extension = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameLastExtension(fileName));
+  RawDataLocation location;
+  bool found = false;
+  if (extension == ".nrrd" || extension == ".nhdr")
+    {
+    found = FindNrrdRawData(fileName, location);
+    }
+  else if (extension == ".mha" || extension == ".mhd")
+    {
+    found = FindMetaImageRawData(fileName, location);
+    }
+  if (!found)
+    {
+    return 0;
+    }
+
+  vtkImageData* output = reader->GetOutput();
+  int extent[6];
+  output->GetWholeExtent(extent);
+  int scalarType = output->GetScalarType();
+  int scalarSize = vtkDataArray::GetDataTypeSize(scalarType);
+#ifdef VTK_WORDS_BIGENDIAN
+  bool bigEndian = true;
+#else
+  bool bigEndian = false;
+#endif
+  vtkIdType numberOfValues = static_cast<vtkIdType>(extent[1] - extent[0] + 1) *
+    (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+  if (numberOfValues <= 0 || scalarSize == 0 ||
+      (scalarSize > 1 && location.BigEndian != bigEndian) ||
+      location.Offset % scalarSize != 0)
+    {
+    return 0;
+    }
+  size_t dataSize = static_cast<size_t>(numberOfValues) * scalarSize;
+
+  itk::TimeSeriesDatabaseHelper::MappedFile* mappedFile =
+    new itk::TimeSeriesDatabaseHelper::MappedFile;
+  if (!mappedFile->Open(location.FileName.c_str(), true) ||
+      location.Offset + dataSize > mappedFile->GetSize())
+    {
+    delete mappedFile;
+    return 0;
+    }
+  vtkDebugWithObjectMacro(storageNode, "ReadData: memory mapped " << location.FileName
+                          << " at offset " << location.Offset);
+
+  vtkDataArray* scalars = vtkDataArray::CreateDataArray(scalarType);
+  // The array does not own the memory, the mapping is released with the array
+  scalars->SetVoidArray(mappedFile->GetCopyOnWriteData() + location.Offset, numberOfValues, 1);
+  vtkNew<vtkCallbackCommand> releaseMappedFile;
+  releaseMappedFile->SetCallback(ReleaseMappedFile);
+  releaseMappedFile->SetClientData(mappedFile);
+  MappedScalars mapped;
+  mapped.File = mappedFile;
+  mapped.FileName = location.FileName;
+  mapped.ReleaseObserverTag =
+    scalars->AddObserver(vtkCommand::DeleteEvent, releaseMappedFile.GetPointer());
+  MappedScalarsLock.Lock();
+  GetMappedScalars()[scalars] = mapped;
+  MappedScalarsLock.Unlock();
+
+  vtkImageData* imageData = vtkImageData::New();
+  imageData->SetWholeExtent(extent);
+  imageData->SetExtent(extent);
+  imageData->SetSpacing(output->GetSpacing());
+  imageData->SetOrigin(output->GetOrigin());
+  imageData->SetScalarType(scalarType);
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->GetPointData()->SetScalars(scalars);
+  scalars->Delete();
+  return imageData;
+}
+
 } // end of anonymous namespace
 
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::IsMemoryMapped(vtkImageData* imageData)
+{
+  if (!imageData || !imageData->GetPointData() ||
+      !imageData->GetPointData()->GetScalars())
+    {
+    return false;
+    }
+  return !GetMappedFileName(imageData->GetPointData()->GetScalars()).empty();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::CanReadFile(vtkMRMLNode *refNode)
+{
+  if (!this->Superclass::CanReadFile(refNode))
+    {
+    return false;
+    }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+    {
+    // The file may be a remote reference fetched by ReadData
+    return true;
+    }
+
+  bool isVector = refNode->IsA("vtkMRMLVectorVolumeNode");
+  bool isTensor = refNode->IsA("vtkMRMLDiffusionTensorVolumeNode");
+  if (!isVector && !isTensor)
+    {
+    // Any number of components can be read in a scalar volume: there is no
+    // need to read the header (a directory scan for DICOM series) twice.
+    return true;
+    }
+
+  // The number of components selects the node type: the header is read once
+  // with the scalar reader, it reports the number of components of the file.
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  reader->SetSingleFile( this->GetSingleFile() );
+  reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+  reader->SetArchetype(fullName.c_str());
+  ApplyImageSeriesReaderWorkaround(this, reader.GetPointer(), fullName);
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  try
+    {
+    reader->UpdateInformation();
+    }
+  catch (...)
+    {
+    vtkDebugMacro("CanReadFile: Cannot read image information from " << fullName);
+    return false;
+    }
+
+  unsigned int numberOfComponents = reader->GetNumberOfComponents();
+  if (isTensor)
+    {
+    // Same conservative test as vtkITKArchetypeDiffusionTensorImageReaderFile
+    return reader->GetNumberOfFileNames() == 1 &&
+      (numberOfComponents == 6 || numberOfComponents == 9);
+    }
+  // Same test as InstantiateVectorVolumeReader()
+  return numberOfComponents >= 3;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -344,10 +779,22 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     reader->SetUseNativeOriginOn();
     }
 
+  // Uncompressed scalar volumes can be mapped instead of read
+  vtkSmartPointer<vtkImageData> mappedImageData;
+  if (this->UseMemoryMapping &&
+      !refNode->IsA("vtkMRMLVectorVolumeNode") &&
+      !refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    mappedImageData.TakeReference(MapImageData(this, reader));
+    }
+
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
-    reader->Update();
+    if (mappedImageData.GetPointer() == NULL)
+      {
+      reader->Update();
+      }
     }
   catch (...)
     {
@@ -368,12 +815,14 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  if (reader->GetOutput() == NULL || reader->GetOutput()->GetPointData() == NULL)
+  vtkImageData* imageData = mappedImageData.GetPointer() ?
+    mappedImageData.GetPointer() : reader->GetOutput();
+  if (imageData == NULL || imageData->GetPointData() == NULL)
     {
     vtkErrorMacro("ReadData: Unable to read data from file: " << fullName);
     }
 
-  vtkPointData * pointData = reader->GetOutput()->GetPointData();
+  vtkPointData * pointData = imageData->GetPointData();
   if (volNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
     {
     if (pointData->GetTensors() == NULL || pointData->GetTensors()->GetNumberOfTuples() == 0)
@@ -420,7 +869,7 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     }
 
   vtkNew<vtkImageChangeInformation> ici;
-  ici->SetInput(reader->GetOutput());
+  ici->SetInput(imageData);
   ici->SetOutputSpacing( 1, 1, 1 );
   ici->SetOutputOrigin( 0, 0, 0 );
   ici->Update();
@@ -464,6 +913,19 @@ int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
   
+  // The file the scalars are mapped from can not be overwritten: it would
+  // change or truncate the mapped memory (or fail with a sharing violation
+  // on Windows).
+  vtkDataArray* scalars = volNode->GetImageData()->GetPointData() ?
+    volNode->GetImageData()->GetPointData()->GetScalars() : 0;
+  std::string mappedFileName = scalars ? GetMappedFileName(scalars) : std::string();
+  if (!mappedFileName.empty() &&
+      CanOverwriteMappedFile(this->GetFullNameFromFileName(), mappedFileName))
+    {
+    vtkDebugMacro("WriteData: releasing the memory mapping of " << mappedFileName);
+    DetachMappedScalars(scalars);
+    }
+
   // update the file list
   std::string moveFromDir = this->UpdateFileList(refNode, 1);
 
@@ -72,6 +72,22 @@ public:
   vtkSetMacro(UseOrientationFromFile, int);
   vtkGetMacro(UseOrientationFromFile, int);
 
+  ///
+  /// Whether to memory map the pixel data of uncompressed single file
+  /// scalar volumes (NRRD, MetaImage) instead of reading it. The mapping
+  /// is copy-on-write: the file is never modified and only the pages that
+  /// are accessed are loaded into memory. Files that can not be mapped are
+  /// read as usual. Off by default.
+  vtkSetMacro(UseMemoryMapping, int);
+  vtkGetMacro(UseMemoryMapping, int);
+  vtkBooleanMacro(UseMemoryMapping, int);
+
+  ///
+  /// Return true if the scalars of the image are a memory mapping of a file
+  /// (see UseMemoryMapping). Writing over the mapped file first copies the
+  /// scalars in memory and releases the mapping.
+  static bool IsMemoryMapped(vtkImageData* imageData);
+
   /// 
   /// Return a defualt file extension for writting
   virtual const char* GetDefaultWriteFileExtension();
@@ -80,6 +96,12 @@ public:
   virtual bool CanReadInReferenceNode(vtkMRMLNode* refNode);
   virtual bool CanWriteFromReferenceNode(vtkMRMLNode* refNode);
 
+  /// Return true if the image header of the file matches the reference
+  /// node: at least 3 components for vector volumes, 6 or 9 components
+  /// for diffusion tensor volumes. Only the image information is read, and
+  /// only for those node types: other volume nodes are always accepted.
+  virtual bool CanReadFile(vtkMRMLNode* refNode);
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -106,6 +128,7 @@ protected:
   int CenterImage;
   int SingleFile;
   int UseOrientationFromFile;
+  int UseMemoryMapping;
 
 };
 
@@ -179,6 +179,8 @@ void vtkMRMLVolumeNode::Copy(vtkMRMLNode *anode)
     // of restoring from SceneViews, where the nodes will not 
     // have bulk data.
     this->SetAndObserveImageData(node->ImageData);
+    // The dictionary comes with the file the image data was read from
+    this->Dictionary = node->Dictionary;
     }
 
   anode->SetDisableModifiedEvent(amode);
@@ -37,6 +37,7 @@ vtkObservation::vtkObservation()
   this->Script = NULL;
   this->Comment = NULL;
   this->Priority = 0.0f;
+  this->CoalesceEvents = 0;
   this->EventTag = 0;
   this->SubjectDeleteEventTag = 0;
   this->ObserverDeleteEventTag = 0;
@@ -47,6 +48,7 @@ vtkObservation::vtkObservation()
 
   this->LastElapsedTime = 0.0;
   this->TotalElapsedTime = 0.0;
+  this->InvocationCount = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -95,10 +97,13 @@ void vtkObservation::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Comment: " <<
     (this->Comment ? this->Comment : "(none)") << "\n";
+  os << indent << "Priority: " << this->Priority << "\n";
+  os << indent << "CoalesceEvents: " << this->CoalesceEvents << "\n";
   os << indent << "EventTag: " << this->EventTag << "\n";
   os << indent << "SubjectDeleteEventTag: " << this->SubjectDeleteEventTag << "\n";
   os << indent << "ObserverDeleteEventTag: " << this->ObserverDeleteEventTag << "\n";
 
   os << indent << "LastElapsedTime: " << this->LastElapsedTime << "\n";
   os << indent << "TotalElapsedTime: " << this->TotalElapsedTime << "\n";
+  os << indent << "InvocationCount: " << this->InvocationCount << "\n";
 }
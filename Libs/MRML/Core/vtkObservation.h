@@ -75,6 +75,15 @@ class VTK_MRML_EXPORT vtkObservation : public vtkObject
   vtkSetMacro(Priority, float);
   vtkGetMacro(Priority, float);
 
+  /// Opt in to the coalesced delivery of the events: while the event broker
+  /// coalesces events, the calls of this observation are collected and
+  /// delivered at once with vtkEventBroker::CoalescedEvent.
+  /// Off by default.
+  /// \sa vtkEventBroker::StartCoalescing()
+  vtkGetMacro (CoalesceEvents, int);
+  vtkSetMacro (CoalesceEvents, int);
+  vtkBooleanMacro (CoalesceEvents, int);
+
   vtkGetMacro (EventTag, unsigned long);
   vtkSetMacro (EventTag, unsigned long);
   vtkGetMacro (SubjectDeleteEventTag, unsigned long);
@@ -89,6 +98,10 @@ class VTK_MRML_EXPORT vtkObservation : public vtkObject
   vtkSetMacro (LastElapsedTime, double);
   vtkGetMacro (TotalElapsedTime, double);
   vtkSetMacro (TotalElapsedTime, double);
+  /// Number of invocations since the observation was created or its
+  /// statistics reset (see vtkEventBroker::ResetObservationStatistics())
+  vtkGetMacro (InvocationCount, unsigned long);
+  vtkSetMacro (InvocationCount, unsigned long);
 
   struct CallType
   {
@@ -150,6 +163,9 @@ protected:
   /// Priority of the observer
   float Priority;
 
+  /// Flag that tells the broker to coalesce the events of this observation
+  int CoalesceEvents;
+
   /// 
   /// keep track of the tags returned by vtkObject::AddObserver so this
   /// observation will be easy to remove when the time comes
@@ -159,6 +175,7 @@ protected:
 
   double LastElapsedTime;
   double TotalElapsedTime;
+  unsigned long InvocationCount;
 
 };
 
@@ -239,3 +239,17 @@ int vtkObserverManager::GetObservationsCount(vtkObject *nodePtr, unsigned long e
     broker->GetObservations(nodePtr, event, observer, this->CallbackCommand);
   return static_cast<int>(observations.size());
 }
+
+//----------------------------------------------------------------------------
+void vtkObserverManager::SetObjectEventsCoalesced(vtkObject *nodePtr, bool coalesce, unsigned long event)
+{
+  vtkEventBroker *broker = vtkEventBroker::GetInstance();
+  vtkObject *observer = this->GetObserver();
+  vtkEventBroker::ObservationVector observations =
+    broker->GetObservations(nodePtr, event, observer, this->CallbackCommand);
+  vtkEventBroker::ObservationVector::iterator it;
+  for (it = observations.begin(); it != observations.end(); ++it)
+    {
+    (*it)->SetCoalesceEvents(coalesce ? 1 : 0);
+    }
+}
@@ -80,6 +80,13 @@ class VTK_MRML_EXPORT vtkObserverManager : public vtkObject
   /// Return the number of observations by the manager on the node.
   /// If event is != 0 , only observations matching the events are counted
   int GetObservationsCount(vtkObject* nodePtr, unsigned long event = 0);
+
+  /// Opt in (or out) to the coalesced delivery of the observed events of
+  /// the node: while the event broker coalesces events, the callback is
+  /// called once with vtkEventBroker::CoalescedEvent instead of once per
+  /// event. If event is != 0, only the observations of that event are set.
+  /// \sa vtkEventBroker::StartCoalescing(), vtkObservation::SetCoalesceEvents()
+  void SetObjectEventsCoalesced(vtkObject* nodePtr, bool coalesce, unsigned long event = 0);
 protected:
   vtkObserverManager();
   virtual ~vtkObserverManager();
@@ -32,12 +32,17 @@
 #include <vtkMRMLSliceNode.h>
 
 // VTK includes
+#include <vtkActor2D.h>
+#include <vtkActor2DCollection.h>
 #include <vtkCamera.h>
+#include <vtkCutter.h>
 #include <vtkErrorCode.h>
 #include <vtkImageData.h>
 #include <vtkInteractorEventRecorder.h>
 #include <vtkNew.h>
+#include <vtkPlane.h>
 #include <vtkPNGWriter.h>
+#include <vtkPolyDataMapper2D.h>
 #include <vtkRegressionTestImage.h>
 #include <vtkRenderer.h>
 #include <vtkRendererCollection.h>
@@ -49,6 +54,7 @@
 
 // STD includes
 bool TestBatchRemoveDisplayNode();
+bool TestSliceScrolling();
 
 //----------------------------------------------------------------------------
 int vtkMRMLModelSliceDisplayableManagerTest(int vtkNotUsed(argc),
@@ -56,6 +62,7 @@ int vtkMRMLModelSliceDisplayableManagerTest(int vtkNotUsed(argc),
 {
   bool res = true;
   res = TestBatchRemoveDisplayNode() && res;
+  res = TestSliceScrolling() && res;
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -136,3 +143,77 @@ bool TestBatchRemoveDisplayNode()
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool TestSliceScrolling()
+{
+  vtkSmartPointer<vtkRenderWindow> renderWindow = CreateRenderWindow();
+  vtkRenderer* renderer = renderWindow->GetRenderers()->GetFirstRenderer();
+  vtkNew<vtkMRMLScene> scene;
+  vtkSmartPointer<vtkMRMLDisplayableManagerGroup> displayableManagerGroup =
+    CreateDisplayableManager(scene.GetPointer(), renderer);
+
+  // A model large enough to be indexed
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(10.);
+  sphereSource->SetThetaResolution(120);
+  sphereSource->SetPhiResolution(120);
+  sphereSource->Update();
+
+  vtkNew<vtkMRMLModelDisplayNode> modelDisplayNode;
+  modelDisplayNode->SetSliceIntersectionVisibility(1);
+  scene->AddNode(modelDisplayNode.GetPointer());
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetAndObservePolyData(sphereSource->GetOutput());
+  modelNode->AddAndObserveDisplayNodeID(modelDisplayNode->GetID());
+  scene->AddNode(modelNode.GetPointer());
+
+  vtkActor2D* actor = vtkActor2D::SafeDownCast(
+    renderer->GetActors2D()->GetLastActor2D());
+  vtkPolyDataMapper2D* mapper = actor ?
+    vtkPolyDataMapper2D::SafeDownCast(actor->GetMapper()) : 0;
+  if (!mapper)
+    {
+    std::cerr << "Line " << __LINE__ << ": no slice intersection actor" << std::endl;
+    return false;
+    }
+
+  vtkMRMLSliceNode* sliceNode = vtkMRMLSliceNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLSliceNodeRed"));
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0., 0., 1.);
+  vtkNew<vtkCutter> cutter;
+  cutter->SetInput(sphereSource->GetOutput());
+  cutter->SetCutFunction(plane.GetPointer());
+  // Repeated offsets along the same direction use the cell index
+  const double offsets[7] = {-20., 0.5, 3.3, 3.3, 5.7, 9.5, 0.5};
+  for (int i = 0; i < 7; ++i)
+    {
+    sliceNode->SetSliceOffset(offsets[i]);
+    if (offsets[i] < -10.)
+      {
+      // The plane misses the model
+      if (actor->GetVisibility())
+        {
+        std::cerr << "Line " << __LINE__ << ": model not culled at offset "
+                  << offsets[i] << std::endl;
+        return false;
+        }
+      continue;
+      }
+    plane->SetOrigin(0., 0., offsets[i]);
+    cutter->Update();
+    mapper->Update();
+    vtkPolyData* intersection = mapper->GetInput();
+    if (!actor->GetVisibility() || !intersection ||
+        intersection->GetNumberOfLines() != cutter->GetOutput()->GetNumberOfLines())
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong intersection at offset "
+                << offsets[i] << ": "
+                << (intersection ? intersection->GetNumberOfLines() : -1)
+                << " lines instead of " << cutter->GetOutput()->GetNumberOfLines()
+                << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
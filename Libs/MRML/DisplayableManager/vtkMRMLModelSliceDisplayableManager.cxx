@@ -32,10 +32,16 @@
 // VTK includes
 #include <vtkActor2D.h>
 #include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
 #include <vtkEventBroker.h>
+#include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPlane.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataMapper2D.h>
 #include <vtkProperty2D.h>
 #include <vtkRenderer.h>
@@ -54,11 +60,287 @@
 #include <cassert>
 #include <set>
 #include <map>
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLModelSliceDisplayableManager );
 vtkCxxRevisionMacro(vtkMRMLModelSliceDisplayableManager, "$Revision: 13525 $");
 
+//---------------------------------------------------------------------------
+namespace
+{
+
+/// Index of the polygons of a polydata by their extent along a direction.
+/// The polygons are binned by the interval of the signed distances of their
+/// points along the direction, so that the polygons cut by a plane normal to
+/// the direction are found without visiting the whole mesh. Scrolling a
+/// slice moves the plane along a constant direction: the index is reused
+/// until the slice is rotated or the polydata modified.
+class SliceCellIndex
+{
+public:
+  SliceCellIndex();
+
+  /// Return true if the index is built for the current state of the
+  /// polydata and the direction.
+  bool IsValid(vtkPolyData* polyData, const double direction[3])const;
+  /// Return true if the polydata and the direction are the same as the
+  /// previous call. Used to only build the index for repeated cuts.
+  bool IsRepeatedRequest(vtkPolyData* polyData, const double direction[3]);
+  /// Index the polygons of the polydata along the normalized direction.
+  void Build(vtkPolyData* polyData, const double direction[3]);
+  /// Copy into \a output the polygons crossing the plane at \a distance
+  /// along the direction, with their points, point data and cell data.
+  void ExtractCells(double distance, vtkPolyData* output);
+  void Reset();
+
+protected:
+  struct State
+    {
+    State() : PolyData(0), PointsMTime(0), PolysMTime(0)
+      {
+      this->Direction[0] = this->Direction[1] = this->Direction[2] = 0.;
+      }
+    void Set(vtkPolyData* polyData, const double direction[3]);
+    bool operator==(const State& other)const;
+
+    vtkPolyData* PolyData;
+    unsigned long PointsMTime;
+    unsigned long PolysMTime;
+    double Direction[3];
+    };
+  int GetBin(double distance)const;
+
+  State Indexed;
+  State LastRequest;
+  double Minimum;
+  double Maximum;
+  double BinSize;
+  /// Location of the polygons in the cell array
+  std::vector<vtkIdType> CellLocations;
+  std::vector<double> CellMinimums;
+  std::vector<double> CellMaximums;
+  /// Polygons of bin i are BinCells[BinOffsets[i]] to BinCells[BinOffsets[i+1]-1]
+  std::vector<vtkIdType> BinOffsets;
+  std::vector<vtkIdType> BinCells;
+  /// Ids of the extracted points, -1 if not extracted
+  std::vector<vtkIdType> PointMap;
+};
+
+//---------------------------------------------------------------------------
+void SliceCellIndex::State::Set(vtkPolyData* polyData, const double direction[3])
+{
+  this->PolyData = polyData;
+  this->PointsMTime = polyData->GetPoints() ? polyData->GetPoints()->GetMTime() : 0;
+  this->PolysMTime = polyData->GetPolys() ? polyData->GetPolys()->GetMTime() : 0;
+  for (int i = 0; i < 3; ++i)
+    {
+    this->Direction[i] = direction[i];
+    }
+}
+
+//---------------------------------------------------------------------------
+bool SliceCellIndex::State::operator==(const State& other)const
+{
+  // directions are normalized
+  return this->PolyData == other.PolyData &&
+    this->PointsMTime == other.PointsMTime &&
+    this->PolysMTime == other.PolysMTime &&
+    vtkMath::Dot(this->Direction, other.Direction) > 1. - 1e-12;
+}
+
+//---------------------------------------------------------------------------
+SliceCellIndex::SliceCellIndex()
+{
+  this->Minimum = 0.;
+  this->Maximum = 0.;
+  this->BinSize = 1.;
+}
+
+//---------------------------------------------------------------------------
+bool SliceCellIndex::IsValid(vtkPolyData* polyData, const double direction[3])const
+{
+  if (this->Indexed.PolyData == 0)
+    {
+    return false;
+    }
+  State state;
+  state.Set(polyData, direction);
+  return state == this->Indexed;
+}
+
+//---------------------------------------------------------------------------
+bool SliceCellIndex::IsRepeatedRequest(vtkPolyData* polyData, const double direction[3])
+{
+  State request;
+  request.Set(polyData, direction);
+  bool repeated = (request == this->LastRequest);
+  this->LastRequest = request;
+  return repeated;
+}
+
+//---------------------------------------------------------------------------
+int SliceCellIndex::GetBin(double distance)const
+{
+  int numberOfBins = static_cast<int>(this->BinOffsets.size()) - 1;
+  int bin = static_cast<int>((distance - this->Minimum) / this->BinSize);
+  return std::max(0, std::min(bin, numberOfBins - 1));
+}
+
+//---------------------------------------------------------------------------
+void SliceCellIndex::Build(vtkPolyData* polyData, const double direction[3])
+{
+  this->Reset();
+  vtkPoints* points = polyData->GetPoints();
+  vtkCellArray* polys = polyData->GetPolys();
+  vtkIdType numberOfCells = polys->GetNumberOfCells();
+  if (!points || numberOfCells == 0)
+    {
+    return;
+    }
+  this->CellLocations.resize(numberOfCells);
+  this->CellMinimums.resize(numberOfCells);
+  this->CellMaximums.resize(numberOfCells);
+  this->Minimum = VTK_DOUBLE_MAX;
+  this->Maximum = -VTK_DOUBLE_MAX;
+  vtkIdType npts = 0;
+  vtkIdType* pts = 0;
+  vtkIdType cellId = 0;
+  polys->InitTraversal();
+  for (vtkIdType location = polys->GetTraversalLocation();
+       polys->GetNextCell(npts, pts);
+       location = polys->GetTraversalLocation(), ++cellId)
+    {
+    double cellMinimum = VTK_DOUBLE_MAX;
+    double cellMaximum = -VTK_DOUBLE_MAX;
+    for (vtkIdType i = 0; i < npts; ++i)
+      {
+      double distance = vtkMath::Dot(direction, points->GetPoint(pts[i]));
+      cellMinimum = std::min(cellMinimum, distance);
+      cellMaximum = std::max(cellMaximum, distance);
+      }
+    this->CellLocations[cellId] = location;
+    this->CellMinimums[cellId] = cellMinimum;
+    this->CellMaximums[cellId] = cellMaximum;
+    this->Minimum = std::min(this->Minimum, cellMinimum);
+    this->Maximum = std::max(this->Maximum, cellMaximum);
+    }
+
+  // A few polygons per bin, each polygon spans a couple of bins
+  int numberOfBins = static_cast<int>(
+    std::max(static_cast<vtkIdType>(1),
+             std::min(numberOfCells / 16, static_cast<vtkIdType>(65536))));
+  this->BinSize = (this->Maximum - this->Minimum) / numberOfBins;
+  if (this->BinSize <= 0.)
+    {
+    this->BinSize = 1.;
+    }
+  this->BinOffsets.assign(numberOfBins + 1, 0);
+  for (cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    int lastBin = this->GetBin(this->CellMaximums[cellId]);
+    for (int bin = this->GetBin(this->CellMinimums[cellId]); bin <= lastBin; ++bin)
+      {
+      ++this->BinOffsets[bin + 1];
+      }
+    }
+  for (int bin = 0; bin < numberOfBins; ++bin)
+    {
+    this->BinOffsets[bin + 1] += this->BinOffsets[bin];
+    }
+  this->BinCells.resize(this->BinOffsets[numberOfBins]);
+  std::vector<vtkIdType> binEnds(this->BinOffsets.begin(), this->BinOffsets.end() - 1);
+  for (cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    int lastBin = this->GetBin(this->CellMaximums[cellId]);
+    for (int bin = this->GetBin(this->CellMinimums[cellId]); bin <= lastBin; ++bin)
+      {
+      this->BinCells[binEnds[bin]++] = cellId;
+      }
+    }
+  this->PointMap.assign(polyData->GetNumberOfPoints(), -1);
+  this->Indexed.Set(polyData, direction);
+}
+
+//---------------------------------------------------------------------------
+void SliceCellIndex::ExtractCells(double distance, vtkPolyData* output)
+{
+  output->Initialize();
+  vtkPolyData* input = this->Indexed.PolyData;
+  if (!input || distance < this->Minimum || distance > this->Maximum)
+    {
+    output->Modified();
+    return;
+    }
+  vtkPoints* inputPoints = input->GetPoints();
+  vtkCellArray* inputPolys = input->GetPolys();
+  vtkPointData* inputPointData = input->GetPointData();
+  vtkCellData* inputCellData = input->GetCellData();
+
+  int bin = this->GetBin(distance);
+  vtkIdType binSize = this->BinOffsets[bin + 1] - this->BinOffsets[bin];
+  vtkNew<vtkPoints> points;
+  points->SetDataType(inputPoints->GetDataType());
+  points->Allocate(binSize);
+  vtkNew<vtkCellArray> polys;
+  output->GetPointData()->CopyAllocate(inputPointData, binSize);
+  output->GetCellData()->CopyAllocate(inputCellData, binSize);
+
+  std::vector<vtkIdType> extractedPoints;
+  std::vector<vtkIdType> cellPoints;
+  for (vtkIdType i = this->BinOffsets[bin]; i < this->BinOffsets[bin + 1]; ++i)
+    {
+    vtkIdType cellId = this->BinCells[i];
+    if (this->CellMinimums[cellId] > distance ||
+        this->CellMaximums[cellId] < distance)
+      {
+      continue;
+      }
+    vtkIdType npts = 0;
+    vtkIdType* pts = 0;
+    inputPolys->GetCell(this->CellLocations[cellId], npts, pts);
+    if (npts == 0)
+      {
+      continue;
+      }
+    cellPoints.resize(npts);
+    for (vtkIdType j = 0; j < npts; ++j)
+      {
+      vtkIdType& pointId = this->PointMap[pts[j]];
+      if (pointId < 0)
+        {
+        pointId = points->InsertNextPoint(inputPoints->GetPoint(pts[j]));
+        output->GetPointData()->CopyData(inputPointData, pts[j], pointId);
+        extractedPoints.push_back(pts[j]);
+        }
+      cellPoints[j] = pointId;
+      }
+    vtkIdType newCellId = polys->InsertNextCell(npts, &cellPoints[0]);
+    output->GetCellData()->CopyData(inputCellData, cellId, newCellId);
+    }
+  for (size_t i = 0; i < extractedPoints.size(); ++i)
+    {
+    this->PointMap[extractedPoints[i]] = -1;
+    }
+  output->SetPoints(points.GetPointer());
+  output->SetPolys(polys.GetPointer());
+  output->Squeeze();
+}
+
+//---------------------------------------------------------------------------
+void SliceCellIndex::Reset()
+{
+  this->Indexed = State();
+  this->CellLocations.clear();
+  this->CellMinimums.clear();
+  this->CellMaximums.clear();
+  this->BinOffsets.clear();
+  this->BinCells.clear();
+  this->PointMap.clear();
+}
+
+} // end of anonymous namespace
+
 //---------------------------------------------------------------------------
 class vtkMRMLModelSliceDisplayableManager::vtkInternal
 {
@@ -71,6 +353,10 @@ public:
     vtkSmartPointer<vtkPlane> Plane;
     vtkSmartPointer<vtkCutter> Cutter;
     vtkSmartPointer<vtkProp> Actor;
+    /// Polygons of the model crossing the slice plane, cut instead of the
+    /// whole model when the index is used.
+    vtkSmartPointer<vtkPolyData> SlabPolyData;
+    mutable SliceCellIndex CellIndex;
     };
 
   typedef std::map < vtkMRMLDisplayNode*, const Pipeline* > PipelinesCacheType;
@@ -87,6 +373,8 @@ public:
   void SetSliceNode(vtkMRMLSliceNode* sliceNode);
   void UpdateSliceNode();
   void SetSlicePlaneFromMatrix(vtkMatrix4x4* matrix, vtkPlane* plane);
+  bool IsPlaneCuttingBounds(vtkPlane* plane, double bounds[6]);
+  vtkPolyData* GetCutterInput(const Pipeline* pipeline, vtkPolyData* polyData);
 
   // Display Nodes
   void AddDisplayNode(vtkMRMLDisplayableNode*, vtkMRMLDisplayNode*);
@@ -196,6 +484,60 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   plane->SetOrigin(origin);
 }
 
+//---------------------------------------------------------------------------
+bool vtkMRMLModelSliceDisplayableManager::vtkInternal
+::IsPlaneCuttingBounds(vtkPlane* plane, double bounds[6])
+{
+  if (bounds[0] > bounds[1])
+    {
+    // empty polydata
+    return false;
+    }
+  bool above = false;
+  bool below = false;
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double point[3] = {bounds[corner & 1], bounds[2 + ((corner >> 1) & 1)],
+                       bounds[4 + ((corner >> 2) & 1)]};
+    double value = plane->EvaluateFunction(point);
+    above = above || value >= 0.;
+    below = below || value <= 0.;
+    }
+  return above && below;
+}
+
+//---------------------------------------------------------------------------
+vtkPolyData* vtkMRMLModelSliceDisplayableManager::vtkInternal
+::GetCutterInput(const Pipeline* pipeline, vtkPolyData* polyData)
+{
+  // Small or non polygonal meshes are cut directly
+  const vtkIdType minimumNumberOfIndexedCells = 1000;
+  double direction[3];
+  pipeline->Plane->GetNormal(direction);
+  if (polyData->GetNumberOfPolys() < minimumNumberOfIndexedCells ||
+      polyData->GetNumberOfPolys() != polyData->GetNumberOfCells() ||
+      vtkMath::Normalize(direction) == 0.)
+    {
+    pipeline->CellIndex.Reset();
+    return polyData;
+    }
+  // The index is only built when the same mesh is cut twice in a row along
+  // the same direction (e.g. scrolling through slices), not for each step of
+  // a slice rotation or a mesh edit
+  bool repeated = pipeline->CellIndex.IsRepeatedRequest(polyData, direction);
+  if (!pipeline->CellIndex.IsValid(polyData, direction))
+    {
+    if (!repeated)
+      {
+      return polyData;
+      }
+    pipeline->CellIndex.Build(polyData, direction);
+    }
+  pipeline->CellIndex.ExtractCells(
+    vtkMath::Dot(direction, pipeline->Plane->GetOrigin()), pipeline->SlabPolyData);
+  return pipeline->SlabPolyData;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLModelSliceDisplayableManager::vtkInternal
 ::GetNodeMatrixToWorld(vtkMRMLTransformableNode* node, vtkMatrix4x4* outMat)
@@ -286,6 +628,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   pipeline->NodeToWorld = vtkSmartPointer<vtkMatrix4x4>::New();
   pipeline->Transformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
   pipeline->Plane = vtkSmartPointer<vtkPlane>::New();
+  pipeline->SlabPolyData = vtkSmartPointer<vtkPolyData>::New();
 
   // Set up pipeline
   pipeline->Transformer->SetTransform(pipeline->TransformToSlice);
@@ -350,10 +693,6 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
       {
       return;
       }
-    pipeline->Cutter->SetInput(polyData);
-
-    // need this to update bounds of the locator, to avoid crash in the cutter 
-    polyData->Modified();
 
     // Update transform matrices
 
@@ -377,6 +716,23 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
     pipeline->TransformToSlice->SetMatrix(tempMat2.GetPointer());
 
     pipeline->Plane->Modified(); 
+
+    // Skip the models that the slice plane doesn't cross
+    polyData->Update();
+    if (!this->IsPlaneCuttingBounds(pipeline->Plane, polyData->GetBounds()))
+      {
+      pipeline->Actor->SetVisibility(0);
+      return;
+      }
+
+    // Only cut the polygons crossing the plane if the model is indexed
+    vtkPolyData* cutterInput = this->GetCutterInput(pipeline, polyData);
+    pipeline->Cutter->SetInput(cutterInput);
+    if (cutterInput == polyData)
+      {
+      // need this to update bounds of the locator, to avoid crash in the cutter 
+      polyData->Modified();
+      }
     
     // optimization for slice to slice intersections which are 1 quad polydatas
     // no need for 50^3 default locator divisons
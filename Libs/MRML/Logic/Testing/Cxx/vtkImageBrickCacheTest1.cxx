@@ -0,0 +1,167 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageBrickCache.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageEllipsoidSource.h>
+#include <vtkNew.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <iostream>
+
+#include "vtkMRMLCoreTestingMacros.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CompareExtent(vtkImageBrickCache* cache, vtkImageEllipsoidSource* source,
+                   int extent[6], int line)
+{
+  cache->GetOutput()->SetUpdateExtent(extent);
+  cache->Update();
+  vtkImageData* output = cache->GetOutput();
+
+  vtkNew<vtkImageData> expected;
+  source->GetOutput()->SetUpdateExtent(extent);
+  source->Update();
+  expected->DeepCopy(source->GetOutput());
+
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        if (output->GetScalarComponentAsDouble(i, j, k, 0) !=
+            expected->GetScalarComponentAsDouble(i, j, k, 0))
+          {
+          std::cerr << "Line " << line << ": wrong value at " << i << ","
+                    << j << "," << k << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageBrickCacheTest1(int , char * [] )
+{
+  vtkNew<vtkImageBrickCache> cache;
+  EXERCISE_BASIC_OBJECT_METHODS( cache.GetPointer() );
+
+  vtkNew<vtkImageEllipsoidSource> source;
+  source->SetWholeExtent(0, 99, 0, 79, 0, 59);
+  source->SetCenter(50, 40, 30);
+  source->SetRadius(30, 20, 10);
+  source->SetOutputScalarTypeToShort();
+  source->SetInValue(200);
+  source->SetOutValue(-10);
+
+  cache->SetBrickSize(16, 16, 16);
+  cache->SetInputConnection(source->GetOutputPort());
+
+  // A slice
+  int sliceExtent[6] = {0, 99, 0, 79, 30, 30};
+  if (!CompareExtent(cache.GetPointer(), source.GetPointer(), sliceExtent, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+  // The bricks of a single slice are loaded (100x80x16 voxels)
+  unsigned long sliceBricksSize = vtkImageBrickCache::GetMemorySize();
+  if (sliceBricksSize == 0 || sliceBricksSize > 2 * 100 * 80 * 16 * 2 / 1024)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong memory size "
+              << sliceBricksSize << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Another slice in the same bricks must not request more bricks
+  int sliceExtent2[6] = {10, 50, 0, 79, 33, 33};
+  if (!CompareExtent(cache.GetPointer(), source.GetPointer(), sliceExtent2, __LINE__) ||
+      vtkImageBrickCache::GetMemorySize() != sliceBricksSize)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Modifying the source invalidates the bricks
+  source->SetInValue(100);
+  if (!CompareExtent(cache.GetPointer(), source.GetPointer(), sliceExtent2, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Memory budget
+  vtkImageBrickCache::SetMemoryBudget(sliceBricksSize);
+  int wholeExtent[6] = {0, 99, 0, 79, 0, 59};
+  if (!CompareExtent(cache.GetPointer(), source.GetPointer(), wholeExtent, __LINE__) ||
+      vtkImageBrickCache::GetMemorySize() > sliceBricksSize)
+    {
+    std::cerr << "Line " << __LINE__ << ": memory budget not respected: "
+              << vtkImageBrickCache::GetMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Oblique slice: only the bricks intersected by the slice are fetched
+  // although the whole extent is requested.
+  vtkImageBrickCache::ClearCache();
+  vtkImageBrickCache::SetMemoryBudget(256 * 1024);
+  vtkNew<vtkTransform> sliceToIJK;
+  sliceToIJK->Translate(50, 40, 30);
+  sliceToIJK->RotateX(45);
+  cache->SetSliceTransform(sliceToIJK.GetPointer());
+  cache->GetOutput()->SetUpdateExtent(wholeExtent);
+  cache->Update();
+  unsigned long wholeSize = 100 * 80 * 60 * sizeof(short) / 1024;
+  if (vtkImageBrickCache::GetMemorySize() == 0 ||
+      vtkImageBrickCache::GetMemorySize() > wholeSize / 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": too many bricks for an oblique slice: "
+              << vtkImageBrickCache::GetMemorySize() << "kB" << std::endl;
+    return EXIT_FAILURE;
+    }
+  source->GetOutput()->SetUpdateExtent(wholeExtent);
+  source->Update();
+  for (int k = 0; k <= 59; ++k)
+    {
+    int j = k + 10;
+    for (int i = 0; i <= 99 && j <= 79; ++i)
+      {
+      if (cache->GetOutput()->GetScalarComponentAsDouble(i, j, k, 0) !=
+          source->GetOutput()->GetScalarComponentAsDouble(i, j, k, 0))
+        {
+        std::cerr << "Line " << __LINE__ << ": wrong value on the oblique slice at "
+                  << i << "," << j << "," << k << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  cache->SetSliceTransform(0);
+
+  vtkImageBrickCache::ClearCache();
+  if (vtkImageBrickCache::GetMemorySize() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": ClearCache failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
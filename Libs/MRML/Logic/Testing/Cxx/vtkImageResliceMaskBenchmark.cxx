@@ -0,0 +1,176 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageResliceMask.h"
+
+// VTK includes
+#include <vtkImageCast.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Reslice sliceCount slices of volume and print the time per slice.
+void TimeReslice(vtkImageData* volume, vtkMatrix4x4* axes,
+                 int interpolationMode, int sliceCount, const char* name)
+{
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+
+  vtkNew<vtkImageResliceMask> reslice;
+  reslice->SetInput(volume);
+  reslice->SetInterpolationMode(interpolationMode);
+  reslice->SetOutputDimensionality(2);
+  reslice->SetOutputOrigin(0, 0, 0);
+  reslice->SetOutputSpacing(1, 1, 1);
+  reslice->SetOutputExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, 0);
+  reslice->SetResliceAxes(axes);
+
+  double origin = axes->GetElement(2, 3);
+  vtkNew<vtkTimerLog> timerLog;
+  timerLog->StartTimer();
+  for (int i = 0; i < sliceCount; ++i)
+    {
+    axes->SetElement(2, 3, origin + i);
+    reslice->Update();
+    }
+  timerLog->StopTimer();
+  axes->SetElement(2, 3, origin);
+
+  std::cout << volume->GetScalarTypeAsString() << " "
+            << reslice->GetInterpolationModeAsString() << " " << name << ": "
+            << 1000. * timerLog->GetElapsedTime() / sliceCount << " ms/slice"
+            << std::endl;
+}
+
+//----------------------------------------------------------------------------
+// The optimized (permutation) path must give the same slice as the
+// unoptimized one for axis aligned slices.
+bool CompareWithUnoptimized(vtkImageData* volume, vtkMatrix4x4* axes,
+                            int interpolationMode)
+{
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+
+  vtkNew<vtkImageResliceMask> reslice[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    reslice[i]->SetInput(volume);
+    reslice[i]->SetInterpolationMode(interpolationMode);
+    reslice[i]->SetOptimization(i);
+    reslice[i]->SetOutputDimensionality(2);
+    reslice[i]->SetOutputOrigin(0, 0, 0);
+    reslice[i]->SetOutputSpacing(1, 1, 1);
+    reslice[i]->SetOutputExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, 0);
+    reslice[i]->SetResliceAxes(axes);
+    reslice[i]->Update();
+    }
+  vtkImageData* unoptimized = reslice[0]->GetOutput();
+  vtkImageData* optimized = reslice[1]->GetOutput();
+  size_t size = dimensions[0] * dimensions[1] * optimized->GetScalarSize();
+  if (memcmp(optimized->GetScalarPointer(), unoptimized->GetScalarPointer(), size) != 0)
+    {
+    std::cerr << volume->GetScalarTypeAsString() << " "
+              << reslice[1]->GetInterpolationModeAsString()
+              << ": optimized reslice differs from unoptimized reslice"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkImageResliceMaskBenchmark [volume size] [number of slices]
+int vtkImageResliceMaskBenchmark(int argc, char * argv[])
+{
+  int size = argc > 1 ? atoi(argv[1]) : 128;
+  int sliceCount = argc > 2 ? atoi(argv[2]) : 10;
+  if (size < 2 || sliceCount < 1 || sliceCount > size)
+    {
+    std::cerr << "Usage: vtkImageResliceMaskBenchmark [volume size] [number of slices]"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkImageData> shortVolume;
+  shortVolume->SetDimensions(size, size, size);
+  shortVolume->SetScalarTypeToShort();
+  shortVolume->SetNumberOfScalarComponents(1);
+  shortVolume->AllocateScalars();
+  short* ptr = static_cast<short*>(shortVolume->GetScalarPointer());
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        *ptr++ = static_cast<short>((i * 7 + j * 13 + k * 29) % 2048 - 1024);
+        }
+      }
+    }
+
+  vtkNew<vtkImageCast> ucharCast;
+  ucharCast->SetInput(shortVolume.GetPointer());
+  ucharCast->SetOutputScalarTypeToUnsignedChar();
+  ucharCast->ClampOverflowOn();
+  ucharCast->Update();
+  vtkNew<vtkImageCast> floatCast;
+  floatCast->SetInput(shortVolume.GetPointer());
+  floatCast->SetOutputScalarTypeToFloat();
+  floatCast->Update();
+
+  vtkImageData* volumes[3] =
+    {ucharCast->GetOutput(), shortVolume.GetPointer(), floatCast->GetOutput()};
+  int interpolationModes[2] = {VTK_RESLICE_NEAREST, VTK_RESLICE_LINEAR};
+
+  // axial slices on the voxels and in between voxels
+  vtkNew<vtkMatrix4x4> axial;
+  vtkNew<vtkMatrix4x4> axialBetween;
+  axialBetween->SetElement(2, 3, 0.5);
+  // oblique slices, rotated by 30 degrees around the x axis
+  vtkNew<vtkMatrix4x4> oblique;
+  oblique->SetElement(1, 1, 0.866025);
+  oblique->SetElement(1, 2, -0.5);
+  oblique->SetElement(2, 1, 0.5);
+  oblique->SetElement(2, 2, 0.866025);
+  oblique->SetElement(1, 3, size / 4.);
+
+  bool success = true;
+  for (int v = 0; v < 3; ++v)
+    {
+    for (int m = 0; m < 2; ++m)
+      {
+      success = CompareWithUnoptimized(volumes[v], axial.GetPointer(),
+                                       interpolationModes[m]) && success;
+      TimeReslice(volumes[v], axial.GetPointer(), interpolationModes[m],
+                  sliceCount, "axial");
+      TimeReslice(volumes[v], axialBetween.GetPointer(), interpolationModes[m],
+                  sliceCount, "axial between slices");
+      TimeReslice(volumes[v], oblique.GetPointer(), interpolationModes[m],
+                  sliceCount, "oblique");
+      }
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageResliceMask.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkImageEllipsoidSource.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void SetupReslice(vtkImageResliceMask* reslice, vtkImageData* input,
+                  vtkTransform* transform)
+{
+  reslice->SetInput(input);
+  reslice->SetResliceTransform(transform);
+  reslice->SetInterpolationModeToLinear();
+  reslice->SetOutputOrigin(0, 0, 0);
+  reslice->SetOutputSpacing(1, 1, 1);
+  reslice->SetOutputExtent(0, 63, 0, 63, 0, 0);
+}
+
+//----------------------------------------------------------------------------
+bool CompareOutputs(vtkImageResliceMask* reslice1,
+                    vtkImageResliceMask* reslice2, int line)
+{
+  vtkImageData* output1 = reslice1->GetOutput();
+  vtkImageData* output2 = reslice2->GetOutput();
+  if (memcmp(output1->GetScalarPointer(), output2->GetScalarPointer(),
+             64 * 64 * output1->GetScalarSize()) != 0)
+    {
+    std::cerr << "Line " << line << ": outputs differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageResliceMaskShareResultsTest(int , char * [] )
+{
+  vtkNew<vtkImageEllipsoidSource> source;
+  source->SetWholeExtent(0, 63, 0, 63, 0, 63);
+  source->SetCenter(32, 32, 32);
+  source->SetRadius(20, 10, 15);
+  source->SetOutputScalarTypeToShort();
+  source->Update();
+  vtkNew<vtkImageData> volume;
+  volume->DeepCopy(source->GetOutput());
+
+  vtkNew<vtkTransform> transform;
+  transform->Translate(0, 0, 31.5);
+  transform->RotateX(20);
+
+  vtkNew<vtkImageResliceMask> reference;
+  SetupReslice(reference.GetPointer(), volume.GetPointer(), transform.GetPointer());
+  reference->Update();
+
+  vtkImageResliceMask::ClearResultCache();
+  vtkNew<vtkImageResliceMask> reslice1;
+  SetupReslice(reslice1.GetPointer(), volume.GetPointer(), transform.GetPointer());
+  reslice1->ShareResultsOn();
+  reslice1->Update();
+  vtkNew<vtkImageResliceMask> reslice2;
+  SetupReslice(reslice2.GetPointer(), volume.GetPointer(), transform.GetPointer());
+  reslice2->ShareResultsOn();
+  reslice2->Update();
+
+  // The second filter reuses the result of the first one
+  if (reslice1->GetOutput()->GetPointData()->GetScalars() !=
+      reslice2->GetOutput()->GetPointData()->GetScalars() ||
+      reslice1->GetBackgroundMask()->GetPointData()->GetScalars() !=
+      reslice2->GetBackgroundMask()->GetPointData()->GetScalars() ||
+      vtkImageResliceMask::GetResultCacheMemorySize() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": result not shared" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CompareOutputs(reference.GetPointer(), reslice2.GetPointer(), __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A different geometry is resliced again
+  transform->Translate(0, 0, 2);
+  reslice2->Update();
+  reference->Update();
+  if (reslice1->GetOutput()->GetPointData()->GetScalars() ==
+      reslice2->GetOutput()->GetPointData()->GetScalars() ||
+      !CompareOutputs(reference.GetPointer(), reslice2.GetPointer(), __LINE__))
+    {
+    std::cerr << "Line " << __LINE__ << ": result wrongly shared" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modifying the input invalidates the results
+  volume->GetPointData()->GetScalars()->SetComponent(32 * 64 * 64 + 32 * 64 + 32, 0, 1000);
+  volume->Modified();
+  reslice1->Update();
+  reference->Update();
+  if (!CompareOutputs(reference.GetPointer(), reslice1.GetPointer(), __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkImageResliceMask::SetResultCacheMemoryBudget(0);
+  if (vtkImageResliceMask::GetResultCacheMemorySize() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": memory budget not respected"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkImageResliceMask::SetResultCacheMemoryBudget(64 * 1024);
+
+  return EXIT_SUCCESS;
+}
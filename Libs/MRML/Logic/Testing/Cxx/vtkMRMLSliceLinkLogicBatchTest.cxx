@@ -0,0 +1,133 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkMRMLSliceLinkLogic.h"
+
+// MRML includes
+#include <vtkEventBroker.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+//---------------------------------------------------------------------------
+/// vtkMRMLTestSliceLinkLogic counts the slice nodes the link logic starts
+/// and stops observing.
+class vtkMRMLTestSliceLinkLogic: public vtkMRMLSliceLinkLogic
+{
+public:
+  vtkTypeMacro(vtkMRMLTestSliceLinkLogic, vtkMRMLSliceLinkLogic);
+  static vtkMRMLTestSliceLinkLogic *New(){return new vtkMRMLTestSliceLinkLogic;}
+
+  bool IsObserved(vtkMRMLNode* node)
+    {
+    return vtkEventBroker::GetInstance()->GetObservationExist(
+      node, vtkCommand::ModifiedEvent, this, this->GetMRMLNodesCallbackCommand());
+    }
+
+  int AddedNodes;
+  int RemovedNodes;
+protected:
+  vtkMRMLTestSliceLinkLogic() : AddedNodes(0), RemovedNodes(0){}
+  virtual ~vtkMRMLTestSliceLinkLogic(){}
+
+  virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+    {
+    this->AddedNodes += node->IsA("vtkMRMLSliceNode") || node->IsA("vtkMRMLSliceCompositeNode");
+    this->Superclass::OnMRMLSceneNodeAdded(node);
+    }
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+    {
+    this->RemovedNodes += node->IsA("vtkMRMLSliceNode") || node->IsA("vtkMRMLSliceCompositeNode");
+    this->Superclass::OnMRMLSceneNodeRemoved(node);
+    }
+};
+
+//---------------------------------------------------------------------------
+bool CheckLink(vtkMRMLTestSliceLinkLogic* logic, int addedNodes, int removedNodes,
+               const char* step)
+{
+  if (logic->AddedNodes != addedNodes || logic->RemovedNodes != removedNodes)
+    {
+    std::cerr << step << ": " << logic->AddedNodes << " slice nodes added and "
+              << logic->RemovedNodes << " removed instead of " << addedNodes
+              << " and " << removedNodes << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+// Check that the slice link logic handles the slice nodes of a batch process
+// once, from their state at the end of the batch.
+int vtkMRMLSliceLinkLogicBatchTest(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLTestSliceLinkLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLSliceNode> redSliceNode;
+  redSliceNode->SetLayoutName("Red");
+  vtkNew<vtkMRMLSliceCompositeNode> redCompositeNode;
+  redCompositeNode->SetLayoutName("Red");
+  vtkNew<vtkMRMLSliceNode> yellowSliceNode;
+  yellowSliceNode->SetLayoutName("Yellow");
+
+  // The yellow slice node is added and removed again by the batch
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  scene->AddNode(redSliceNode.GetPointer());
+  scene->AddNode(yellowSliceNode.GetPointer());
+  scene->AddNode(redCompositeNode.GetPointer());
+  scene->RemoveNode(yellowSliceNode.GetPointer());
+  if (logic->AddedNodes != 0)
+    {
+    std::cerr << "Slice nodes handled during the batch process" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (!CheckLink(logic.GetPointer(), 2, 0, "Batch adding nodes") ||
+      !logic->IsObserved(redSliceNode.GetPointer()) ||
+      !logic->IsObserved(redCompositeNode.GetPointer()) ||
+      logic->IsObserved(yellowSliceNode.GetPointer()))
+    {
+    std::cerr << "Wrong slice node observations after the batch" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The red slice node is removed and added back: it keeps its observation
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  scene->RemoveNode(redSliceNode.GetPointer());
+  scene->AddNode(redSliceNode.GetPointer());
+  scene->RemoveNode(redCompositeNode.GetPointer());
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+  if (!CheckLink(logic.GetPointer(), 2, 1, "Batch removing nodes") ||
+      !logic->IsObserved(redSliceNode.GetPointer()) ||
+      logic->IsObserved(redCompositeNode.GetPointer()))
+    {
+    std::cerr << "Wrong slice node observations after the batch" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Outside a batch process the nodes are handled right away
+  scene->AddNode(yellowSliceNode.GetPointer());
+  if (!CheckLink(logic.GetPointer(), 3, 1, "Adding a node") ||
+      !logic->IsObserved(yellowSliceNode.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  logic->SetMRMLScene(0);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,570 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+#include "vtkImageBrickCache.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkLinearTransform.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+vtkCxxRevisionMacro(vtkImageBrickCache, "$Revision$");
+vtkStandardNewMacro(vtkImageBrickCache);
+vtkCxxSetObjectMacro(vtkImageBrickCache, SliceTransform, vtkLinearTransform);
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Identify a brick: the pipeline it comes from, the modified time of that
+// pipeline when the brick was read and the brick index.
+struct BrickKey
+{
+  const void* Source;
+  unsigned long SourceMTime;
+  int Index[3];
+
+  bool operator<(const BrickKey& other)const
+    {
+    if (this->Source != other.Source)
+      {
+      return this->Source < other.Source;
+      }
+    if (this->SourceMTime != other.SourceMTime)
+      {
+      return this->SourceMTime < other.SourceMTime;
+      }
+    return std::lexicographical_compare(this->Index, this->Index + 3,
+                                        other.Index, other.Index + 3);
+    }
+};
+
+//------------------------------------------------------------------------------
+// LRU cache of bricks shared by all the vtkImageBrickCache filters.
+// The most recently used bricks are at the front of the list.
+class BrickStorage
+{
+public:
+  BrickStorage()
+    : MemoryBudget(256 * 1024)
+    , MemorySize(0)
+    {
+    }
+
+  vtkImageData* Find(const BrickKey& key)
+    {
+    BrickMapType::iterator it = this->Bricks.find(key);
+    if (it == this->Bricks.end())
+      {
+      return 0;
+      }
+    // Move the brick to the front of the list
+    this->LRU.splice(this->LRU.begin(), this->LRU, it->second);
+    return it->second->second;
+    }
+
+  void Insert(const BrickKey& key, vtkImageData* brick)
+    {
+    BrickMapType::iterator it = this->Bricks.find(key);
+    if (it != this->Bricks.end())
+      {
+      this->MemorySize -= it->second->second->GetActualMemorySize();
+      this->LRU.erase(it->second);
+      this->Bricks.erase(it);
+      }
+    this->LRU.push_front(BrickType(key, brick));
+    this->Bricks[key] = this->LRU.begin();
+    this->MemorySize += brick->GetActualMemorySize();
+    this->Trim();
+    }
+
+  void Trim()
+    {
+    while (this->MemorySize > this->MemoryBudget && !this->LRU.empty())
+      {
+      BrickType& brick = this->LRU.back();
+      this->MemorySize -= brick.second->GetActualMemorySize();
+      this->Bricks.erase(brick.first);
+      this->LRU.pop_back();
+      }
+    }
+
+  void Clear()
+    {
+    this->Bricks.clear();
+    this->LRU.clear();
+    this->MemorySize = 0;
+    }
+
+  unsigned long MemoryBudget;
+  unsigned long MemorySize;
+
+protected:
+  typedef std::pair<BrickKey, vtkSmartPointer<vtkImageData> > BrickType;
+  typedef std::list<BrickType> BrickListType;
+  typedef std::map<BrickKey, BrickListType::iterator> BrickMapType;
+  BrickListType LRU;
+  BrickMapType Bricks;
+};
+
+//------------------------------------------------------------------------------
+BrickStorage& GetBrickStorage()
+{
+  static BrickStorage storage;
+  return storage;
+}
+
+//------------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4];
+}
+
+//------------------------------------------------------------------------------
+bool IsExtentInside(const int extent[6], const int container[6])
+{
+  return extent[0] >= container[0] && extent[1] <= container[1] &&
+         extent[2] >= container[2] && extent[3] <= container[3] &&
+         extent[4] >= container[4] && extent[5] <= container[5];
+}
+
+//------------------------------------------------------------------------------
+BrickKey GetBrickKey(vtkAlgorithm* filter, vtkInformation* inInfo)
+{
+  BrickKey key;
+  vtkAlgorithmOutput* inputConnection = filter->GetInputConnection(0, 0);
+  vtkAlgorithm* source = inputConnection ? inputConnection->GetProducer() : 0;
+  key.Source = source;
+  key.SourceMTime = 0;
+  if (inInfo->Has(vtkDemandDrivenPipeline::PIPELINE_MODIFIED_TIME()))
+    {
+    key.SourceMTime = inInfo->Get(vtkDemandDrivenPipeline::PIPELINE_MODIFIED_TIME());
+    }
+  else if (source)
+    {
+    key.SourceMTime = source->GetMTime();
+    }
+  key.Index[0] = key.Index[1] = key.Index[2] = 0;
+  return key;
+}
+
+//------------------------------------------------------------------------------
+// Set to 0 the voxels of extent.
+void ClearExtent(vtkImageData* image, const int extent[6])
+{
+  size_t rowSize = static_cast<size_t>(extent[1] - extent[0] + 1) *
+    image->GetNumberOfScalarComponents() * image->GetScalarSize();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      memset(image->GetScalarPointer(extent[0], j, k), 0, rowSize);
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageBrickCache::vtkInternal
+{
+public:
+  vtkInternal()
+    : CurrentFetch(0)
+    , UseSlab(false)
+    {
+    }
+
+  /// Key of the bricks of the request being executed.
+  BrickKey Key;
+  /// Bricks of the request being executed. They are referenced until the
+  /// output is generated so the cache can't discard them in the meantime.
+  std::map<BrickKey, vtkSmartPointer<vtkImageData> > PinnedBricks;
+  /// Extents (6 values each) to request from the input, one per pass.
+  std::vector<int> Fetches;
+  /// Index of the extent being requested from the input.
+  size_t CurrentFetch;
+
+  /// Slab in input index coordinates: points p such that
+  /// SlabMin <= SlabNormal.(p - SlabOrigin) <= SlabMax.
+  bool UseSlab;
+  double SlabOrigin[3];
+  double SlabNormal[3];
+  double SlabMin;
+  double SlabMax;
+};
+
+//----------------------------------------------------------------------------
+vtkImageBrickCache::vtkImageBrickCache()
+{
+  this->BrickSize[0] = 64;
+  this->BrickSize[1] = 64;
+  this->BrickSize[2] = 64;
+  this->SliceTransform = 0;
+  this->NumberOfSlices = 1;
+  this->FetchedExtent[0] = this->FetchedExtent[2] = this->FetchedExtent[4] = 0;
+  this->FetchedExtent[1] = this->FetchedExtent[3] = this->FetchedExtent[5] = -1;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickCache::~vtkImageBrickCache()
+{
+  this->SetSliceTransform(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageBrickCache::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  if (this->SliceTransform)
+    {
+    unsigned long transformMTime = this->SliceTransform->GetMTime();
+    mTime = std::max(mTime, transformMTime);
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickCache::SetMemoryBudget(unsigned long kilobytes)
+{
+  GetBrickStorage().MemoryBudget = kilobytes;
+  GetBrickStorage().Trim();
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageBrickCache::GetMemoryBudget()
+{
+  return GetBrickStorage().MemoryBudget;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageBrickCache::GetMemorySize()
+{
+  return GetBrickStorage().MemorySize;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickCache::ClearCache()
+{
+  GetBrickStorage().Clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickCache::GetBrickRange(const int extent[6],
+                                       const int wholeExtent[6],
+                                       int brickRange[6])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    int brickSize = std::max(this->BrickSize[i], 1);
+    int minIndex = std::max(extent[2*i], wholeExtent[2*i]);
+    int maxIndex = std::min(extent[2*i+1], wholeExtent[2*i+1]);
+    brickRange[2*i] = (minIndex - wholeExtent[2*i]) / brickSize;
+    brickRange[2*i+1] = (maxIndex - wholeExtent[2*i]) / brickSize;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickCache::GetBrickExtent(const int index[3],
+                                        const int wholeExtent[6],
+                                        int brickExtent[6])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    int brickSize = std::max(this->BrickSize[i], 1);
+    brickExtent[2*i] = wholeExtent[2*i] + index[i] * brickSize;
+    brickExtent[2*i+1] = std::min(brickExtent[2*i] + brickSize - 1,
+                                  wholeExtent[2*i+1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickCache::IsBrickNeeded(const int brickExtent[6])
+{
+  if (!this->Internal->UseSlab)
+    {
+    return true;
+    }
+  // Pad the brick by the support of the cubic interpolation.
+  const int padding = 2;
+  double minDistance = VTK_DOUBLE_MAX;
+  double maxDistance = -VTK_DOUBLE_MAX;
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double distance = 0.;
+    for (int i = 0; i < 3; ++i)
+      {
+      double coordinate = ((corner >> i) & 1) ?
+        brickExtent[2*i+1] + padding : brickExtent[2*i] - padding;
+      distance += this->Internal->SlabNormal[i] *
+        (coordinate - this->Internal->SlabOrigin[i]);
+      }
+    minDistance = std::min(minDistance, distance);
+    maxDistance = std::max(maxDistance, distance);
+    }
+  return minDistance <= this->Internal->SlabMax &&
+         maxDistance >= this->Internal->SlabMin;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickCache::RequestUpdateExtent(
+  vtkInformation *vtkNotUsed(request),
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+
+  int outExt[6], wholeExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+
+  vtkInternal* internal = this->Internal;
+  if (internal->CurrentFetch > 0 &&
+      internal->CurrentFetch * 6 < internal->Fetches.size())
+    {
+    // Following pass of a request: fetch the next row of missing bricks.
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+                &internal->Fetches[internal->CurrentFetch * 6], 6);
+    return 1;
+    }
+
+  // First pass of a request: pin the cached bricks and list the missing ones.
+  internal->CurrentFetch = 0;
+  internal->Fetches.clear();
+  internal->PinnedBricks.clear();
+  internal->Key = GetBrickKey(this, inInfo);
+
+  internal->UseSlab = false;
+  if (this->SliceTransform)
+    {
+    vtkMatrix4x4* sliceToIJK = this->SliceTransform->GetMatrix();
+    double xAxis[3], yAxis[3], zAxis[3];
+    for (int i = 0; i < 3; ++i)
+      {
+      xAxis[i] = sliceToIJK->GetElement(i, 0);
+      yAxis[i] = sliceToIJK->GetElement(i, 1);
+      zAxis[i] = sliceToIJK->GetElement(i, 2);
+      internal->SlabOrigin[i] = sliceToIJK->GetElement(i, 3);
+      }
+    vtkMath::Cross(xAxis, yAxis, internal->SlabNormal);
+    // A degenerated slice intersects everything.
+    if (vtkMath::Normalize(internal->SlabNormal) > 0.)
+      {
+      double thickness = (this->NumberOfSlices - 1) *
+        vtkMath::Dot(internal->SlabNormal, zAxis);
+      internal->SlabMin = std::min(0., thickness);
+      internal->SlabMax = std::max(0., thickness);
+      internal->UseSlab = true;
+      }
+    }
+
+  if (!IsExtentEmpty(outExt) && !IsExtentEmpty(wholeExt))
+    {
+    BrickKey key = internal->Key;
+    int brickRange[6];
+    this->GetBrickRange(outExt, wholeExt, brickRange);
+    for (key.Index[2] = brickRange[4]; key.Index[2] <= brickRange[5]; ++key.Index[2])
+      {
+      for (key.Index[1] = brickRange[2]; key.Index[1] <= brickRange[3]; ++key.Index[1])
+        {
+        // Contiguous missing bricks of the row are fetched together.
+        bool extendFetch = false;
+        for (key.Index[0] = brickRange[0]; key.Index[0] <= brickRange[1]; ++key.Index[0])
+          {
+          int brickExt[6];
+          this->GetBrickExtent(key.Index, wholeExt, brickExt);
+          if (!this->IsBrickNeeded(brickExt))
+            {
+            extendFetch = false;
+            continue;
+            }
+          vtkImageData* brick = GetBrickStorage().Find(key);
+          if (brick)
+            {
+            internal->PinnedBricks[key] = brick;
+            extendFetch = false;
+            continue;
+            }
+          if (extendFetch)
+            {
+            internal->Fetches[internal->Fetches.size() - 5] = brickExt[1];
+            }
+          else
+            {
+            internal->Fetches.insert(internal->Fetches.end(), brickExt, brickExt + 6);
+            }
+          extendFetch = true;
+          }
+        }
+      }
+    }
+
+  if (!internal->Fetches.empty())
+    {
+    std::copy(internal->Fetches.begin(), internal->Fetches.begin() + 6,
+              this->FetchedExtent);
+    }
+  else if (IsExtentEmpty(this->FetchedExtent) ||
+           !IsExtentInside(this->FetchedExtent, wholeExt))
+    {
+    // Everything is cached, request as little as possible from the input.
+    this->FetchedExtent[0] = this->FetchedExtent[1] = wholeExt[0];
+    this->FetchedExtent[2] = this->FetchedExtent[3] = wholeExt[2];
+    this->FetchedExtent[4] = this->FetchedExtent[5] = wholeExt[4];
+    }
+  // else: everything is cached, request the same extent as last time so the
+  // input does not need to re-execute.
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+              this->FetchedExtent, 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickCache::RequestData(
+  vtkInformation *request,
+  vtkInformationVector **inputVector,
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData *outData = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  int outExt[6], wholeExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+
+  vtkInternal* internal = this->Internal;
+  if (internal->CurrentFetch * 6 < internal->Fetches.size())
+    {
+    // Cache and pin the bricks of the row fetched in this pass.
+    int fetchExt[6], brickRange[6];
+    std::copy(&internal->Fetches[internal->CurrentFetch * 6],
+              &internal->Fetches[internal->CurrentFetch * 6] + 6, fetchExt);
+    this->GetBrickRange(fetchExt, wholeExt, brickRange);
+    BrickKey key = internal->Key;
+    key.Index[1] = brickRange[2];
+    key.Index[2] = brickRange[4];
+    for (key.Index[0] = brickRange[0]; key.Index[0] <= brickRange[1]; ++key.Index[0])
+      {
+      int brickExt[6];
+      this->GetBrickExtent(key.Index, wholeExt, brickExt);
+      vtkSmartPointer<vtkImageData> brick = vtkSmartPointer<vtkImageData>::New();
+      brick->SetExtent(brickExt);
+      brick->SetScalarType(inData->GetScalarType());
+      brick->SetNumberOfScalarComponents(inData->GetNumberOfScalarComponents());
+      brick->AllocateScalars();
+      brick->CopyAndCastFrom(inData, brickExt);
+      GetBrickStorage().Insert(key, brick);
+      internal->PinnedBricks[key] = brick;
+      }
+    ++internal->CurrentFetch;
+    if (internal->CurrentFetch * 6 < internal->Fetches.size())
+      {
+      // Ask the pipeline for another pass to fetch the next row.
+      request->Set(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING(), 1);
+      return 1;
+      }
+    request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+    }
+  internal->CurrentFetch = 0;
+  internal->Fetches.clear();
+
+  outData->SetExtent(outExt);
+  outData->SetScalarType(inData->GetScalarType());
+  outData->SetNumberOfScalarComponents(inData->GetNumberOfScalarComponents());
+  outData->AllocateScalars();
+  if (IsExtentEmpty(outExt) || IsExtentEmpty(wholeExt))
+    {
+    internal->PinnedBricks.clear();
+    return 1;
+    }
+
+  BrickKey key = internal->Key;
+  int brickRange[6];
+  this->GetBrickRange(outExt, wholeExt, brickRange);
+  for (key.Index[2] = brickRange[4]; key.Index[2] <= brickRange[5]; ++key.Index[2])
+    {
+    for (key.Index[1] = brickRange[2]; key.Index[1] <= brickRange[3]; ++key.Index[1])
+      {
+      for (key.Index[0] = brickRange[0]; key.Index[0] <= brickRange[1]; ++key.Index[0])
+        {
+        int brickExt[6];
+        this->GetBrickExtent(key.Index, wholeExt, brickExt);
+        int copyExt[6];
+        for (int i = 0; i < 3; ++i)
+          {
+          copyExt[2*i] = std::max(brickExt[2*i], outExt[2*i]);
+          copyExt[2*i+1] = std::min(brickExt[2*i+1], outExt[2*i+1]);
+          }
+        if (IsExtentEmpty(copyExt))
+          {
+          continue;
+          }
+        std::map<BrickKey, vtkSmartPointer<vtkImageData> >::iterator brickIt =
+          internal->PinnedBricks.find(key);
+        if (brickIt == internal->PinnedBricks.end())
+          {
+          if (this->IsBrickNeeded(brickExt))
+            {
+            vtkErrorMacro("RequestData: brick " << key.Index[0] << ","
+                          << key.Index[1] << "," << key.Index[2]
+                          << " is missing.");
+            }
+          // Not intersected by the slice: never interpolated.
+          ClearExtent(outData, copyExt);
+          continue;
+          }
+        outData->CopyAndCastFrom(brickIt->second, copyExt);
+        }
+      }
+    }
+  internal->PinnedBricks.clear();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "BrickSize: " << this->BrickSize[0] << " "
+     << this->BrickSize[1] << " " << this->BrickSize[2] << "\n";
+  os << indent << "SliceTransform: " << this->SliceTransform << "\n";
+  os << indent << "NumberOfSlices: " << this->NumberOfSlices << "\n";
+  os << indent << "FetchedExtent: " << this->FetchedExtent[0];
+  for (int i = 1; i < 6; ++i)
+    {
+    os << " " << this->FetchedExtent[i];
+    }
+  os << "\n";
+  os << indent << "MemoryBudget: " << vtkImageBrickCache::GetMemoryBudget() << "kB\n";
+  os << indent << "MemorySize: " << vtkImageBrickCache::GetMemorySize() << "kB\n";
+}
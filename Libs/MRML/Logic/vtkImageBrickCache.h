@@ -0,0 +1,128 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageBrickCache_h
+#define __vtkImageBrickCache_h
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+
+#include "vtkMRMLLogicWin32Header.h"
+
+class vtkLinearTransform;
+
+/// \brief Pass-through filter that requests its input by bricks and keeps
+/// them in a memory-budgeted LRU cache.
+///
+/// The whole extent of the input is split into bricks of BrickSize voxels.
+/// When an output extent is requested, only the bricks intersecting it that
+/// are not already cached are requested from the input, one row of
+/// contiguous bricks per pipeline pass. The bricks are kept in a cache shared
+/// by all the vtkImageBrickCache instances, bounded by MemoryBudget: the least
+/// recently used bricks are discarded first. The bricks used by the request
+/// being executed are kept until the output is generated, even if they are
+/// discarded from the cache in the meantime.
+///
+/// If a SliceTransform is set, only the bricks intersected by the slice
+/// (the bricks needed to interpolate it) are requested, the rest of the output
+/// extent is set to 0. This keeps the number of bricks proportional to the
+/// slice area when the slice is oblique, in which case the update extent
+/// requested by the reslice filter is most of the volume.
+///
+/// This is useful when the input is a streaming capable source (e.g. a
+/// reader that supports update extents): a filter such as
+/// vtkImageResliceMask only requests the input extent that intersects the
+/// slice, and that part only needs to be loaded in memory. With an input
+/// that is already in memory (e.g. the image data of a volume node) it
+/// saves nothing and only adds a copy.
+/// Only the point scalars of the input are passed through.
+class VTK_MRML_LOGIC_EXPORT vtkImageBrickCache : public vtkImageAlgorithm
+{
+public:
+  static vtkImageBrickCache *New();
+  vtkTypeRevisionMacro(vtkImageBrickCache,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Size in voxels of the bricks the input is split into.
+  /// 64x64x64 by default.
+  vtkSetVector3Macro(BrickSize, int);
+  vtkGetVector3Macro(BrickSize, int);
+
+  ///
+  /// Transform from the slice index coordinates (the output extent of the
+  /// reslice filter, e.g. XYToIJK) to the input index coordinates.
+  /// Only the bricks intersected by the slab of NumberOfSlices slices are
+  /// fetched. No transform by default: all the bricks of the output extent
+  /// are fetched.
+  virtual void SetSliceTransform(vtkLinearTransform*);
+  vtkGetObjectMacro(SliceTransform, vtkLinearTransform);
+
+  ///
+  /// Number of slices of the slab, along the third axis of SliceTransform.
+  /// 1 by default.
+  vtkSetClampMacro(NumberOfSlices, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfSlices, int);
+
+  ///
+  /// Take the SliceTransform into account.
+  virtual unsigned long GetMTime();
+
+  ///
+  /// Memory (in kilobytes) that can be used by the bricks of all the
+  /// vtkImageBrickCache instances. 256MB by default.
+  static void SetMemoryBudget(unsigned long kilobytes);
+  static unsigned long GetMemoryBudget();
+
+  ///
+  /// Memory (in kilobytes) currently used by the cached bricks.
+  static unsigned long GetMemorySize();
+
+  ///
+  /// Remove all the bricks from the cache.
+  static void ClearCache();
+
+protected:
+  vtkImageBrickCache();
+  ~vtkImageBrickCache();
+
+  virtual int RequestUpdateExtent(vtkInformation *,
+                                  vtkInformationVector **,
+                                  vtkInformationVector *);
+  virtual int RequestData(vtkInformation *,
+                          vtkInformationVector **,
+                          vtkInformationVector *);
+
+  /// Compute the range of bricks intersecting extent.
+  void GetBrickRange(const int extent[6], const int wholeExtent[6],
+                     int brickRange[6]);
+  /// Compute the extent of the brick at index (clamped to the whole extent).
+  void GetBrickExtent(const int index[3], const int wholeExtent[6],
+                      int brickExtent[6]);
+  /// Return true if the brick extent is intersected by the slab computed from
+  /// SliceTransform in RequestUpdateExtent (or if there is no SliceTransform).
+  bool IsBrickNeeded(const int brickExtent[6]);
+
+  int BrickSize[3];
+  vtkLinearTransform* SliceTransform;
+  int NumberOfSlices;
+  /// Last extent requested from the input.
+  int FetchedExtent[6];
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageBrickCache(const vtkImageBrickCache&);  // Not implemented.
+  void operator=(const vtkImageBrickCache&);  // Not implemented.
+};
+
+#endif
@@ -16,6 +16,7 @@
 #include "vtkImageResliceMask.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkImageData.h>
 #include <vtkImageStencilData.h>
@@ -23,6 +24,8 @@
 #include <vtkInformationVector.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTransform.h>
 
@@ -34,7 +37,12 @@
 # define VTK_USE_UINT64 0
 
 // STD includes
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
 
 vtkCxxRevisionMacro(vtkImageResliceMask, "$Revision$");
 vtkStandardNewMacro(vtkImageResliceMask);
@@ -42,6 +50,122 @@ vtkCxxSetObjectMacro(vtkImageResliceMask, InformationInput, vtkImageData);
 vtkCxxSetObjectMacro(vtkImageResliceMask,ResliceAxes,vtkMatrix4x4);
 vtkCxxSetObjectMacro(vtkImageResliceMask,ResliceTransform,vtkAbstractTransform);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Identify a reslice result: the input data, its modified time when the
+// result was computed, and all the parameters the output values depend on.
+struct ResliceResultKey
+{
+  const void* Input;
+  unsigned long InputMTime;
+  std::vector<double> Parameters;
+
+  bool operator<(const ResliceResultKey& other)const
+    {
+    if (this->Input != other.Input)
+      {
+      return this->Input < other.Input;
+      }
+    if (this->InputMTime != other.InputMTime)
+      {
+      return this->InputMTime < other.InputMTime;
+      }
+    return this->Parameters < other.Parameters;
+    }
+};
+
+//----------------------------------------------------------------------------
+// Output and background mask scalars of a reslice.
+struct ResliceResult
+{
+  vtkSmartPointer<vtkDataArray> Scalars[2];
+
+  unsigned long GetActualMemorySize()const
+    {
+    return this->Scalars[0]->GetActualMemorySize() +
+      this->Scalars[1]->GetActualMemorySize();
+    }
+};
+
+//----------------------------------------------------------------------------
+// LRU cache of results shared by all the vtkImageResliceMask filters.
+// The most recently used results are at the front of the list.
+class ResliceResultStorage
+{
+public:
+  ResliceResultStorage()
+    : MemoryBudget(64 * 1024)
+    , MemorySize(0)
+    {
+    }
+
+  ResliceResult* Find(const ResliceResultKey& key)
+    {
+    ResultMapType::iterator it = this->Results.find(key);
+    if (it == this->Results.end())
+      {
+      return 0;
+      }
+    // Move the result to the front of the list
+    this->LRU.splice(this->LRU.begin(), this->LRU, it->second);
+    return &it->second->second;
+    }
+
+  void Insert(const ResliceResultKey& key, const ResliceResult& result)
+    {
+    ResultMapType::iterator it = this->Results.find(key);
+    if (it != this->Results.end())
+      {
+      this->MemorySize -= it->second->second.GetActualMemorySize();
+      this->LRU.erase(it->second);
+      this->Results.erase(it);
+      }
+    this->LRU.push_front(ResultType(key, result));
+    this->Results[key] = this->LRU.begin();
+    this->MemorySize += result.GetActualMemorySize();
+    this->Trim();
+    }
+
+  void Trim()
+    {
+    while (this->MemorySize > this->MemoryBudget && !this->LRU.empty())
+      {
+      ResultType& result = this->LRU.back();
+      this->MemorySize -= result.second.GetActualMemorySize();
+      this->Results.erase(result.first);
+      this->LRU.pop_back();
+      }
+    }
+
+  void Clear()
+    {
+    this->Results.clear();
+    this->LRU.clear();
+    this->MemorySize = 0;
+    }
+
+  unsigned long MemoryBudget;
+  unsigned long MemorySize;
+
+protected:
+  typedef std::pair<ResliceResultKey, ResliceResult> ResultType;
+  typedef std::list<ResultType> ResultListType;
+  typedef std::map<ResliceResultKey, ResultListType::iterator> ResultMapType;
+  ResultListType LRU;
+  ResultMapType Results;
+};
+
+//----------------------------------------------------------------------------
+ResliceResultStorage& GetResliceResultStorage()
+{
+  static ResliceResultStorage storage;
+  return storage;
+}
+
+} // end of anonymous namespace
+
 //--------------------------------------------------------------------------
 // The 'floor' function on x86 and mips is many times slower than these
 // and is used a lot in this code, optimize for different CPU architectures
@@ -154,6 +278,9 @@ vtkImageResliceMask::vtkImageResliceMask()
   // set to zero when we completely missed the input extent
   this->HitInputExtent = 1;
 
+  // don't share the results with the other reslice filters
+  this->ShareResults = 0;
+
   // There is an optional second input.
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(2);
@@ -243,6 +370,32 @@ void vtkImageResliceMask::PrintSelf(ostream& os, vtkIndent indent)
     this->BackgroundColor[2] << " " << this->BackgroundColor[3] << "\n";
   os << indent << "BackgroundLevel: " << this->BackgroundColor[0] << "\n";
   os << indent << "Stencil: " << this->GetStencil() << "\n";
+  os << indent << "ShareResults: " << (this->ShareResults ? "On\n":"Off\n");
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMask::SetResultCacheMemoryBudget(unsigned long kilobytes)
+{
+  GetResliceResultStorage().MemoryBudget = kilobytes;
+  GetResliceResultStorage().Trim();
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageResliceMask::GetResultCacheMemoryBudget()
+{
+  return GetResliceResultStorage().MemoryBudget;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageResliceMask::GetResultCacheMemorySize()
+{
+  return GetResliceResultStorage().MemorySize;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceMask::ClearResultCache()
+{
+  GetResliceResultStorage().Clear();
 }
 
 //----------------------------------------------------------------------------
@@ -1746,6 +1899,134 @@ void vtkGetResliceInterpFunc(vtkImageResliceMask *self,
 
 
 
+//----------------------------------------------------------------------------
+// Row kernels for vtkOptimizedExecute when there is neither a perspective
+// nor a nonlinear transform: the pixels of a row from idXmin to idXmax are
+// interpolated at inPoint1 + idX*xAxis.  The interpolation is inlined
+// instead of being called through a function pointer for each pixel, the
+// arithmetic is the same so the results are identical.
+
+// nearest neighbor without wrapping, out-of-bounds pixels are set to
+// the background color
+template <class F, class T>
+void vtkResliceNearestRow(T *&outPtr, const T *inPtr,
+                          const int inExt[6], const vtkIdType inInc[3],
+                          int numscalars, const F inPoint1[4],
+                          const F xAxis[4], int idXmin, int idXmax,
+                          int vtkNotUsed(mode), const T *background,
+                          unsigned char *&BackgroundMaskPtr, bool value)
+{
+  int inExtX = inExt[1] - inExt[0] + 1;
+  int inExtY = inExt[3] - inExt[2] + 1;
+  int inExtZ = inExt[5] - inExt[4] + 1;
+  unsigned char mask = (unsigned char)(255*value);
+
+  for (int idX = idXmin; idX <= idXmax; idX++)
+    {
+    F inPoint[3];
+    inPoint[0] = inPoint1[0] + idX*xAxis[0];
+    inPoint[1] = inPoint1[1] + idX*xAxis[1];
+    inPoint[2] = inPoint1[2] + idX*xAxis[2];
+
+    int inIdX = vtkResliceRound(inPoint[0]) - inExt[0];
+    int inIdY = vtkResliceRound(inPoint[1]) - inExt[2];
+    int inIdZ = vtkResliceRound(inPoint[2]) - inExt[4];
+
+    const T *tmpPtr = background;
+    if (inIdX >= 0 && inIdX < inExtX &&
+        inIdY >= 0 && inIdY < inExtY &&
+        inIdZ >= 0 && inIdZ < inExtZ)
+      {
+      tmpPtr = inPtr + (inIdX*inInc[0] + inIdY*inInc[1] + inIdZ*inInc[2]);
+      }
+
+    *BackgroundMaskPtr++ = mask;
+    int m = numscalars;
+    do
+      {
+      *outPtr++ = *tmpPtr++;
+      }
+    while (--m);
+    }
+}
+
+// trilinear, for all the border modes
+template <class F, class T>
+void vtkResliceTrilinearRow(T *&outPtr, const T *inPtr,
+                            const int inExt[6], const vtkIdType inInc[3],
+                            int numscalars, const F inPoint1[4],
+                            const F xAxis[4], int idXmin, int idXmax,
+                            int mode, const T *background,
+                            unsigned char *&BackgroundMaskPtr, bool value)
+{
+  for (int idX = idXmin; idX <= idXmax; idX++)
+    {
+    F inPoint[3];
+    inPoint[0] = inPoint1[0] + idX*xAxis[0];
+    inPoint[1] = inPoint1[1] + idX*xAxis[1];
+    inPoint[2] = inPoint1[2] + idX*xAxis[2];
+
+    vtkTrilinearInterpolation(outPtr, inPtr, inExt, inInc, numscalars,
+                              inPoint, mode, background,
+                              BackgroundMaskPtr, value);
+    }
+}
+
+// get the row kernel appropriate for the interpolation mode and the data
+// type, or null if the pixels must be interpolated one at a time
+template<class F>
+void vtkGetResliceRowFunc(vtkImageResliceMask *self,
+                          void (**interpolateRow)(void *&outPtr,
+                                                  const void *inPtr,
+                                                  const int inExt[6],
+                                                  const vtkIdType inInc[3],
+                                                  int numscalars,
+                                                  const F inPoint1[4],
+                                                  const F xAxis[4],
+                                                  int idXmin, int idXmax,
+                                                  int mode,
+                                                  const void *background,
+                                                  void *&backgroundmask,
+                                                  bool flag),
+                          int optimizeNearest, int optimizeLinear)
+{
+  int dataType = self->GetOutput()->GetScalarType();
+
+  *interpolateRow = 0;
+  if (optimizeNearest)
+    {
+    switch (dataType)
+      {
+      vtkTemplateAliasMacro(*((void (**)(VTK_TT *&outPtr, const VTK_TT *inPtr,
+                                    const int inExt[6],
+                                    const vtkIdType inInc[3],
+                                    int numscalars, const F inPoint1[4],
+                                    const F xAxis[4],
+                                    int idXmin, int idXmax, int mode,
+                                    const VTK_TT *background,
+                                    unsigned char *&backgroundmask,
+                                    bool flag))interpolateRow) = \
+                       &vtkResliceNearestRow);
+      }
+    }
+  else if (optimizeLinear)
+    {
+    switch (dataType)
+      {
+      vtkTemplateAliasMacro(*((void (**)(VTK_TT *&outPtr, const VTK_TT *inPtr,
+                                    const int inExt[6],
+                                    const vtkIdType inInc[3],
+                                    int numscalars, const F inPoint1[4],
+                                    const F xAxis[4],
+                                    int idXmin, int idXmax, int mode,
+                                    const VTK_TT *background,
+                                    unsigned char *&backgroundmask,
+                                    bool flag))interpolateRow) = \
+                       &vtkResliceTrilinearRow);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 // Some helper functions for 'RequestData'
 //----------------------------------------------------------------------------
@@ -2211,6 +2492,12 @@ void vtkOptimizedExecute(vtkImageResliceMask *self,
                      int numscalars, const F point[3],
                      int mode, const void *background, void *&outMask, bool flag);
   void (*setpixels)(void *&out, const void *in, int numscalars, int n, void *&outMask, bool flag);
+  void (*interpolateRow)(void *&outPtr, const void *inPtr,
+                         const int inExt[6], const vtkIdType inInc[3],
+                         int numscalars, const F inPoint1[4],
+                         const F xAxis[4], int idXmin, int idXmax,
+                         int mode, const void *background,
+                         void *&outMask, bool flag);
 
   int mode = VTK_RESLICE_BACKGROUND;
   int wrap = 0;
@@ -2244,6 +2531,13 @@ void vtkOptimizedExecute(vtkImageResliceMask *self,
     optimizeNearest = 1;
     }
 
+  int optimizeLinear = 0;
+  if (self->GetInterpolationMode() == VTK_RESLICE_LINEAR &&
+      !(newtrans || perspective))
+    {
+    optimizeLinear = 1;
+    }
+
   // find maximum input range
   inData->GetExtent(inExt);
 
@@ -2284,6 +2578,7 @@ void vtkOptimizedExecute(vtkImageResliceMask *self,
   // Set interpolation method
   vtkGetResliceInterpFunc(self, &interpolate);
   vtkGetSetPixelsFunc(self, &setpixels);
+  vtkGetResliceRowFunc(self, &interpolateRow, optimizeNearest, optimizeLinear);
 
   // get the stencil
   vtkImageStencilData *stencil = self->GetStencil();
@@ -2318,7 +2613,13 @@ void vtkOptimizedExecute(vtkImageResliceMask *self,
                                      outPtr, background, numscalars, 
                                      setpixels, iter, BackgroundMaskPtr, false))
         {
-        if (!optimizeNearest)
+        if (interpolateRow)
+          { // interpolate the whole row at once
+          interpolateRow(outPtr, inPtr, inExt, inInc, numscalars,
+                         inPoint1, xAxis, idXmin, idXmax, mode,
+                         background, BackgroundMaskPtr, true);
+          }
+        else
           {
           for (idX = idXmin; idX <= idXmax; idX++)
             {
@@ -2343,37 +2644,6 @@ void vtkOptimizedExecute(vtkImageResliceMask *self,
                         inPoint, mode, background, BackgroundMaskPtr, true);
             }
           }
-        else // optimize for nearest-neighbor interpolation
-          {
-          int inExtX = inExt[1] - inExt[0] + 1;
-          int inExtY = inExt[3] - inExt[2] + 1;
-          int inExtZ = inExt[5] - inExt[4] + 1;
-
-          for (int iidX = idXmin; iidX <= idXmax; iidX++)
-            {
-            void *inPtrTmp = background;
-
-            inPoint[0] = inPoint1[0] + iidX*xAxis[0];
-            inPoint[1] = inPoint1[1] + iidX*xAxis[1];
-            inPoint[2] = inPoint1[2] + iidX*xAxis[2];
-
-            int inIdX = vtkResliceRound(inPoint[0]) - inExt[0];
-            int inIdY = vtkResliceRound(inPoint[1]) - inExt[2];
-            int inIdZ = vtkResliceRound(inPoint[2]) - inExt[4];
-
-            if (inIdX >= 0 && inIdX < inExtX &&
-                inIdY >= 0 && inIdY < inExtY &&
-                inIdZ >= 0 && inIdZ < inExtZ)
-              {
-              inPtrTmp = (void *)((char *)inPtr + \
-                                  (inIdX*inInc[0] + 
-                                   inIdY*inInc[1] +
-                                   inIdZ*inInc[2])*scalarSize);
-              }
-
-            setpixels(outPtr, inPtrTmp, numscalars, 1, BackgroundMaskPtr, true);
-            }
-          }
         }
       outPtr = (void *)((char *)outPtr + outIncY*scalarSize);
       }
@@ -2557,6 +2827,71 @@ void vtkPermuteTrilinearSummation(T *&outPtr, const T *inPtr,
     }
 }
 
+//----------------------------------------------------------------------------
+// Row kernels for when the x traversal table is contiguous, i.e. when
+// each output pixel of the row is the next input pixel (e.g. a slice
+// parallel to the input rows at the input resolution).  Only iX[0] is
+// needed: rows are copied with memcpy and the interpolation loops run
+// over plain arrays so that the compiler can vectorize them.  The
+// arithmetic is the same as in vtkPermuteNearestSummation and
+// vtkPermuteTrilinearSummation, so the results are identical.
+template<class F, class T>
+void vtkPermuteNearestContiguousSummation(T *&outPtr, const T *inPtr,
+                                          int numscalars, int n,
+                                          const vtkIdType *iX, const F *,
+                                          const vtkIdType *iY, const F *,
+                                          const vtkIdType *iZ, const F *,
+                                          const int [3], unsigned char *&BackgroundMaskPtr,  bool value)
+{
+  memcpy(outPtr, inPtr + iX[0] + iY[0] + iZ[0], n*numscalars*sizeof(T));
+  outPtr += n*numscalars;
+  memset(BackgroundMaskPtr, (unsigned char)(255*value), n);
+  BackgroundMaskPtr += n;
+}
+
+// ditto for linear interpolation, the x coefficients must be 1 and 0
+// (useNearestNeighbor[0] is set)
+template<class F, class T>
+void vtkPermuteTrilinearContiguousSummation(T *&outPtr, const T *inPtr,
+                                            int numscalars, int n,
+                                            const vtkIdType *iX, const F *fX,
+                                            const vtkIdType *iY, const F *fY,
+                                            const vtkIdType *iZ, const F *fZ,
+                                            const int useNearestNeighbor[3], unsigned char *&BackgroundMaskPtr,  bool value)
+{
+  F fy = fY[1];
+  F rz = fZ[0];
+  F fz = fZ[1];
+
+  if (fy != 0)
+    { // bilinear or trilinear, no contiguous shortcut
+    vtkPermuteTrilinearSummation(outPtr, inPtr, numscalars, n,
+                                 iX, fX, iY, fY, iZ, fZ,
+                                 useNearestNeighbor, BackgroundMaskPtr, value);
+    return;
+    }
+
+  const T *inPtr0 = inPtr + iX[0] + iY[0] + iZ[0];
+  int m = n*numscalars;
+  if (fz == 0)
+    { // no interpolation needed at all
+    memcpy(outPtr, inPtr0, m*sizeof(T));
+    }
+  else
+    { // only need linear z interpolation
+    const T *inPtr1 = inPtr + iX[0] + iY[0] + iZ[1];
+    T *tmpPtr = outPtr;
+    for (int i = 0; i < m; i++)
+      {
+      F result = (rz*inPtr0[i] + fz*inPtr1[i]);
+      vtkResliceRound(result, tmpPtr[i]);
+      }
+    }
+  outPtr += m;
+  memset(BackgroundMaskPtr, (unsigned char)(255*value), n);
+  BackgroundMaskPtr += n;
+}
+
 //--------------------------------------------------------------------------
 // helper function for tricubic interpolation
 template<class F, class T>
@@ -2693,6 +3028,72 @@ void vtkGetResliceSummationFunc(vtkImageResliceMask *self,
     }
 }
 
+//----------------------------------------------------------------------------
+// get the row kernel to use when the x traversal table is contiguous,
+// or null if there is none for this interpolation mode
+template <class F>
+void vtkGetResliceContiguousSummationFunc(vtkImageResliceMask *self,
+                                void (**summation)(void *&out, const void *in,
+                                                   int numscalars, int n,
+                                                   const vtkIdType *iX, const F *fX,
+                                                   const vtkIdType *iY, const F *fY,
+                                                   const vtkIdType *iZ, const F *fZ,
+                                                   const int useNearest[3], void *&backgroundmask, bool flag),
+                                int interpolationMode)
+{
+  int scalarType = self->GetOutput()->GetScalarType();
+
+  switch (interpolationMode)
+    {
+    case VTK_RESLICE_NEAREST:
+      switch (scalarType)
+        {
+        vtkTemplateAliasMacro(*((void (**)(VTK_TT *&out, const VTK_TT *in,
+                                      int numscalars, int n,
+                                      const vtkIdType *iX, const F *fX,
+                                      const vtkIdType *iY, const F *fY,
+                                      const vtkIdType *iZ, const F *fZ,
+                                      const int useNearest[3], unsigned char *&backgroundmask, bool flag))summation) = \
+                         vtkPermuteNearestContiguousSummation);
+        default:
+          *summation = 0;
+        }
+      break;
+    case VTK_RESLICE_LINEAR:
+      switch (scalarType)
+        {
+        vtkTemplateAliasMacro(*((void (**)(VTK_TT *&out, const VTK_TT *in,
+                                      int numscalars, int n,
+                                      const vtkIdType *iX, const F *fX,
+                                      const vtkIdType *iY, const F *fY,
+                                      const vtkIdType *iZ, const F *fZ,
+                                      const int useNearest[3], unsigned char *&backgroundmask, bool flag))summation) = \
+                         vtkPermuteTrilinearContiguousSummation);
+        default:
+          *summation = 0;
+        }
+      break;
+    default:
+      *summation = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+// check whether consecutive output pixels along x, within the clipped
+// extent, map to consecutive input pixels in memory
+inline int vtkIsContiguousTraversal(const vtkIdType *traversal, int step,
+                                    int idXmin, int idXmax, int numscalars)
+{
+  for (int idX = idXmin; idX < idXmax; idX++)
+    {
+    if (traversal[(idX + 1)*step] - traversal[idX*step] != numscalars)
+      {
+      return 0;
+      }
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 template <class F>
 void vtkPermuteNearestTable(vtkImageResliceMask *self, const int outExt[6],
@@ -3120,6 +3521,28 @@ void vtkReslicePermuteExecute(vtkImageResliceMask *self,
   vtkGetResliceSummationFunc(self, &summation, interpolationMode);
   vtkGetSetPixelsFunc(self, &setpixels);
 
+  // use the row kernels when the output rows run along the input rows
+  // at the input resolution (the usual case for slice views)
+  if ((interpolationMode == VTK_RESLICE_NEAREST ||
+       (interpolationMode == VTK_RESLICE_LINEAR && useNearestNeighbor[0])) &&
+      vtkIsContiguousTraversal(traversal[0], step, clipExt[0], clipExt[1],
+                               numscalars))
+    {
+    void (*contiguousSummation)(void *&out, const void *in,
+                                int numscalars, int n,
+                                const vtkIdType *iX, const F *fX,
+                                const vtkIdType *iY, const F *fY,
+                                const vtkIdType *iZ, const F *fZ,
+                                const int useNearestNeighbor[3],
+                                void *&outMask, bool flag);
+    vtkGetResliceContiguousSummationFunc(self, &contiguousSummation,
+                                         interpolationMode);
+    if (contiguousSummation)
+      {
+      summation = contiguousSummation;
+      }
+    }
+
   // set color for area outside of input volume extent
   void *background;
   vtkAllocBackgroundPixel(self, &background, numscalars);
@@ -3353,6 +3776,96 @@ vtkMatrix4x4 *vtkImageResliceMask::GetIndexMatrix(vtkInformation *inInfo,
   return this->IndexMatrix;
 }
 
+//----------------------------------------------------------------------------
+// Reuse the result of another filter if ShareResults is on, otherwise
+// reslice (in ThreadedRequestData) and make the result available to the
+// other filters.
+int vtkImageResliceMask::RequestData(vtkInformation *request,
+                                     vtkInformationVector **inputVector,
+                                     vtkInformationVector *outputVector)
+{
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkDataArray *inScalars =
+    inData ? inData->GetPointData()->GetScalars() : 0;
+  if (!this->ShareResults || !inScalars || !this->IndexMatrix ||
+      this->OptimizedTransform || this->GetStencil())
+    {
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  ResliceResultKey key;
+  key.Input = inData;
+  key.InputMTime = std::max(inData->GetMTime(), inScalars->GetMTime());
+  std::vector<double>& parameters = key.Parameters;
+  for (int i = 0; i < 4; i++)
+    {
+    for (int j = 0; j < 4; j++)
+      {
+      parameters.push_back(this->IndexMatrix->GetElement(i, j));
+      }
+    }
+  int extent[6];
+  inData->GetExtent(extent);
+  parameters.insert(parameters.end(), extent, extent + 6);
+  parameters.push_back(inData->GetScalarType());
+  parameters.push_back(inData->GetNumberOfScalarComponents());
+  parameters.push_back(this->InterpolationMode);
+  parameters.push_back(this->Wrap);
+  parameters.push_back(this->Mirror);
+  parameters.push_back(this->Border);
+  parameters.push_back(this->Optimization);
+  parameters.insert(parameters.end(),
+                    this->BackgroundColor, this->BackgroundColor + 4);
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkInformation *outInfo = outputVector->GetInformationObject(port);
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+    parameters.insert(parameters.end(), extent, extent + 6);
+    }
+
+  ResliceResultStorage& storage = GetResliceResultStorage();
+  ResliceResult* sharedResult = storage.Find(key);
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkInformation *outInfo = outputVector->GetInformationObject(port);
+    vtkImageData *outData = vtkImageData::SafeDownCast(
+      outInfo->Get(vtkDataObject::DATA_OBJECT()));
+    if (sharedResult)
+      {
+      outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+      outData->SetExtent(extent);
+      outData->GetPointData()->SetScalars(sharedResult->Scalars[port]);
+      }
+    else if (outData->GetPointData()->GetScalars() &&
+             outData->GetPointData()->GetScalars()->GetReferenceCount() > 1)
+      {
+      // the scalars are shared, don't reslice into them
+      outData->GetPointData()->SetScalars(0);
+      }
+    }
+  if (sharedResult)
+    {
+    return 1;
+    }
+
+  int res = this->Superclass::RequestData(request, inputVector, outputVector);
+  ResliceResult result;
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkImageData *outData = vtkImageData::SafeDownCast(
+      outputVector->GetInformationObject(port)->Get(
+        vtkDataObject::DATA_OBJECT()));
+    result.Scalars[port] = outData->GetPointData()->GetScalars();
+    }
+  if (res && result.Scalars[0] && result.Scalars[1])
+    {
+    storage.Insert(key, result);
+    }
+  return res;
+}
+
 //----------------------------------------------------------------------------
 // This method is passed a input and output region, and executes the filter
 // algorithm to fill the output from the input.
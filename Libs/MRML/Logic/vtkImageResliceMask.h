@@ -293,6 +293,34 @@ public:
   vtkImageStencilData *GetStencil();
 
   vtkImageData *GetBackgroundMask();
+
+  /// 
+  /// Share the results with the other vtkImageResliceMask filters that have
+  /// ShareResults on (default: off). Before reslicing, the filter looks for
+  /// a result computed by any of them from the same input data with the same
+  /// index matrix (output voxel -> input voxel), output extent, interpolation
+  /// and border settings, and reuses its output and mask arrays instead of
+  /// reslicing again. This is typically useful for linked slice views that
+  /// show the same volume with the same geometry.
+  /// Results are not shared if a stencil or a nonlinear transform is used.
+  vtkSetMacro(ShareResults, int);
+  vtkGetMacro(ShareResults, int);
+  vtkBooleanMacro(ShareResults, int);
+
+  /// 
+  /// Memory (in kilobytes) that can be used by the shared results, the least
+  /// recently used results are discarded first. 64MB by default.
+  static void SetResultCacheMemoryBudget(unsigned long kilobytes);
+  static unsigned long GetResultCacheMemoryBudget();
+
+  /// 
+  /// Memory (in kilobytes) currently used by the shared results.
+  static unsigned long GetResultCacheMemorySize();
+
+  /// 
+  /// Remove all the shared results.
+  static void ClearResultCache();
+
 protected:
   vtkImageResliceMask();
   ~vtkImageResliceMask();
@@ -315,6 +343,7 @@ protected:
   int TransformInputSampling;
   int AutoCropOutput;
   int HitInputExtent;
+  int ShareResults;
 
   vtkMatrix4x4 *IndexMatrix;
   vtkAbstractTransform *OptimizedTransform;
@@ -326,6 +355,8 @@ protected:
                                  vtkInformationVector *);
   virtual int RequestUpdateExtent(vtkInformation *, vtkInformationVector **,
                                   vtkInformationVector *);
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *);
   virtual void ThreadedRequestData(vtkInformation *request,
                                    vtkInformationVector **inputVector,
                                    vtkInformationVector *outputVector,
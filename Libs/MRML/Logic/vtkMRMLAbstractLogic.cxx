@@ -17,6 +17,7 @@
 //#include "vtkMRMLApplicationLogic.h"
 
 // MRML includes
+#include "vtkEventBroker.h"
 #include "vtkMRMLNode.h"
 
 // VTK includes
@@ -478,11 +479,31 @@ void vtkMRMLAbstractLogic
       assert(node);
       this->OnMRMLSceneNodeRemoved(node);
       break;
+    case vtkEventBroker::CoalescedEvent:
+      assert(callData);
+      this->OnMRMLSceneEventsCoalesced(
+        *reinterpret_cast<vtkEventBroker::CoalescedCallList*>(callData));
+      break;
     default:
       break;
     }
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLAbstractLogic
+::OnMRMLSceneEventsCoalesced(const vtkEventBroker::CoalescedCallList& calls)
+{
+  // Process the calls in order, as if they had not been coalesced
+  int oldProcessingEvent = this->GetProcessingMRMLSceneEvent();
+  vtkEventBroker::CoalescedCallList::const_iterator it;
+  for (it = calls.begin(); it != calls.end(); ++it)
+    {
+    this->SetProcessingMRMLSceneEvent(it->EventID);
+    this->ProcessMRMLSceneEvents(this->GetMRMLScene(), it->EventID, it->CallData);
+    }
+  this->SetProcessingMRMLSceneEvent(oldProcessingEvent);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLAbstractLogic::UnobserveMRMLScene()
 {
@@ -19,6 +19,7 @@
 class vtkMRMLApplicationLogic;
 
 // MRML includes
+#include <vtkEventBroker.h>
 #include <vtkMRMLScene.h>
 #include <vtkObserverManager.h>
 
@@ -312,6 +313,16 @@ protected:
   /// \sa ProcessMRMLSceneEvents, SetMRMLSceneInternal
   /// \sa OnMRMLSceneNodeAdded, vtkMRMLScene::NodeAboutToBeRemoved
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* /*node*/){}
+  /// Called once at the end of a batch process with the scene events
+  /// coalesced for the logic (see
+  /// vtkObserverManager::SetObjectEventsCoalesced()), in the order they
+  /// first happened. The call data of the node added and removed events is
+  /// the node. Reimplement it to handle the batch in one pass. By default,
+  /// each call is processed by ProcessMRMLSceneEvents() as if it had not
+  /// been coalesced.
+  /// \sa ProcessMRMLSceneEvents, vtkEventBroker::CoalescedEvent
+  virtual void OnMRMLSceneEventsCoalesced(
+    const vtkEventBroker::CoalescedCallList& calls);
 
   /// Called after the corresponding MRML event is triggered.
   /// \sa ProcessMRMLNodesEvents
@@ -49,6 +49,7 @@
 
 // STD includes
 #include <cassert>
+#include <cstring>
 #include <sstream>
 
 // For LoadDefaultParameterSets
@@ -425,6 +426,37 @@ std::string vtkMRMLApplicationLogic::PercentEncode(std::string s)
   return result.str();
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+// Return true if the file exists or is the file of one of the nodes
+// waiting to be written.
+bool IsFileNameUsed(const char* fileName, vtkCollection* nodesToWrite)
+{
+  if (vtksys::SystemTools::FileExists(fileName, true))
+    {
+    return true;
+    }
+  if (!nodesToWrite)
+    {
+    return false;
+    }
+  for (int i = 0; i < nodesToWrite->GetNumberOfItems(); ++i)
+    {
+    vtkMRMLStorableNode* storableNode =
+      vtkMRMLStorableNode::SafeDownCast(nodesToWrite->GetItemAsObject(i));
+    vtkMRMLStorageNode* storageNode =
+      storableNode ? storableNode->GetStorageNode() : 0;
+    if (storageNode && storageNode->GetFileName() &&
+        strcmp(storageNode->GetFileName(), fileName) == 0)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+}
+
 //----------------------------------------------------------------------------
 bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *sdbDir, vtkImageData *screenShot)
 {
@@ -535,6 +567,8 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
   this->OriginalStorageNodeFileNames.clear();
 
   std::map<std::string, vtkMRMLNode *> storableNodes;
+  // nodes of the scene whose data is written once all the paths are set
+  vtkNew<vtkCollection> nodesToWrite;
 
   int numNodes = this->GetMRMLScene()->GetNumberOfNodes();
   for (int i = 0; i < numNodes; ++i)
@@ -551,7 +585,8 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
       // and store them in the map by ID to avoid duplicates for the scene views
       vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast(mrmlNode);
 
-      this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir);
+      this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir,
+                                                        nodesToWrite.GetPointer());
 
       storableNodes[std::string(storableNode->GetID())] = storableNode;
     }
@@ -577,7 +612,9 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
           // save only new storable nodes
           storableNode->SetAddToScene(1);
           storableNode->UpdateScene(this->GetMRMLScene());
-          this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir);
+          // written right away, while it is temporarily added to the scene
+          this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir,
+                                                            nodesToWrite.GetPointer(), false);
 
           storableNodes[std::string(storableNode->GetID())] = storableNode;
           storableNode->SetAddToScene(0);
@@ -585,6 +622,18 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
         }
       }
   }
+
+  // write the data of the scene nodes, concurrently if the scene allows it
+  if (!this->GetMRMLScene()->WriteDataInParallel(nodesToWrite.GetPointer()))
+    {
+    vtkErrorMacro("failed to write the data of some nodes to " << dataDir);
+    }
+  vtkDebugMacro("wrote the data of " << nodesToWrite->GetNumberOfItems() << " nodes");
+  if (this->GetDebug())
+    {
+    this->GetMRMLScene()->PrintWriteDataSummary(std::cout, vtkIndent());
+    }
+
   //
   // create a scene view, using the snapshot passed in if any
   //
@@ -694,7 +743,9 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
 
 //----------------------------------------------------------------------------
 void vtkMRMLApplicationLogic::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode *storableNode,
-                                                                          std::string &dataDir)
+                                                                          std::string &dataDir,
+                                                                          vtkCollection *nodesToWrite,
+                                                                          bool deferWrite)
 {
   if (!storableNode || !storableNode->GetSaveWithScene())
     {
@@ -751,28 +802,42 @@ void vtkMRMLApplicationLogic::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRM
     vtkDebugMacro("set data directory to "
       << dataDir.c_str() << ", storable node " << storableNode->GetID()
       << " file name is now: " << storageNode->GetFileName());
-    // deal with existing files by creating a numeric suffix
-    if (vtksys::SystemTools::FileExists(storageNode->GetFileName(), true))
+    // deal with existing files, and with the files of the nodes that are
+    // not written yet, by creating a numeric suffix
+    if (IsFileNameUsed(storageNode->GetFileName(), nodesToWrite))
       {
       vtkWarningMacro("file " << storageNode->GetFileName() << " already exists, renaming!");
 
-      uniqueFileName = this->CreateUniqueFileName(fileName);
+      std::string usedFileName(storageNode->GetFileName());
+      uniqueFileName = this->CreateUniqueFileName(usedFileName, nodesToWrite);
 
       vtkDebugMacro("found unique file name " << uniqueFileName.c_str());
       storageNode->SetFileName(uniqueFileName.c_str());
       }
 
-    storageNode->WriteData(storableNode);
-
+    if (nodesToWrite && deferWrite)
+      {
+      nodesToWrite->AddItem(storableNode);
+      }
+    else
+      {
+      storageNode->WriteData(storableNode);
+      }
     }
  }
   
 //----------------------------------------------------------------------------
-std::string vtkMRMLApplicationLogic::CreateUniqueFileName(std::string &filename)
+std::string vtkMRMLApplicationLogic::CreateUniqueFileName(std::string &filename,
+                                                          vtkCollection *reservedNodes)
 {
   std::string uniqueFileName;
-  std::string baseName = vtksys::SystemTools::GetFilenameWithoutExtension(filename);
+  std::string filePath = vtksys::SystemTools::GetFilenamePath(filename);
+  std::string baseName = vtksys::SystemTools::GetFilenameWithoutLastExtension(filename);
   std::string extension = vtksys::SystemTools::GetFilenameLastExtension(filename);
+  if (!filePath.empty())
+    {
+    baseName = filePath + "/" + baseName;
+    }
 
   bool uniqueName = false;
   int v = 1;
@@ -781,7 +846,7 @@ std::string vtkMRMLApplicationLogic::CreateUniqueFileName(std::string &filename)
     std::stringstream ss;
     ss << v;
     uniqueFileName = baseName + ss.str() + extension;
-    if (vtksys::SystemTools::FileExists(uniqueFileName.c_str()) == 0)
+    if (!IsFileNameUsed(uniqueFileName.c_str(), reservedNodes))
       {
       uniqueName = true;
       }
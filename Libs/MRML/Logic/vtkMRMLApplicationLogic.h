@@ -26,6 +26,7 @@
 
 #include "vtkMRMLLogicWin32Header.h"
 
+class vtkCollection;
 class vtkMRMLColorLogic;
 class vtkMRMLSliceNode;
 class vtkMRMLSliceLogic;
@@ -118,7 +119,11 @@ public:
                                       const std::vector<std::string>& directories);
 
   /// Creates a unique non-existant file name by adding an index after base file name.
-  static std::string CreateUniqueFileName(std::string &filename);
+  /// The directory of \a filename is kept. If \a reservedNodes is not null,
+  /// the file names of the storage nodes of its storable nodes are not used
+  /// either.
+  static std::string CreateUniqueFileName(std::string &filename,
+                                          vtkCollection *reservedNodes = 0);
 
   /// List of custom events fired by the class.
   enum Events{
@@ -158,8 +163,14 @@ protected:
   void SetSelectionNode(vtkMRMLSelectionNode* );
   void SetInteractionNode(vtkMRMLInteractionNode* );
 
+  /// Move the file of the storable node to dataDir and write its data.
+  /// If nodesToWrite is not null, the file names of its nodes are not reused
+  /// and, unless deferWrite is false, the node is added to it instead of
+  /// being written.
   void SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode *storableNode,
-                                                 std::string &dataDir);
+                                                 std::string &dataDir,
+                                                 vtkCollection *nodesToWrite = 0,
+                                                 bool deferWrite = true);
 
 
 
@@ -100,6 +100,8 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->Reslice->SetOutputOrigin( 0, 0, 0 );
   this->Reslice->SetOutputSpacing( 1, 1, 1 );
   this->Reslice->SetOutputDimensionality( 3 );
+  // linked views showing the same volume reuse the same reslice result
+  this->Reslice->ShareResultsOn();
   
   this->ResliceUVW->SetBackgroundColor(0, 0, 0, 0); // only first two are used
   this->ResliceUVW->AutoCropOutputOff();
@@ -107,6 +109,7 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->ResliceUVW->SetOutputOrigin( 0, 0, 0 );
   this->ResliceUVW->SetOutputSpacing( 1, 1, 1 );
   this->ResliceUVW->SetOutputDimensionality( 3 );
+  this->ResliceUVW->ShareResultsOn();
   
   // Only the transform matrix can change, not the transform itself
   this->Reslice->SetResliceTransform( this->XYToIJKTransform ); 
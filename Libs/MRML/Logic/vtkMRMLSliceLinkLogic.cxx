@@ -32,6 +32,7 @@
 
 // STD includes
 #include <cassert>
+#include <set>
 
 
 //----------------------------------------------------------------------------
@@ -103,6 +104,17 @@ void vtkMRMLSliceLinkLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
 
   this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer(), priorities.GetPointer());
 
+  // The modified events of the slice nodes are ignored during a batch
+  // process: the slice nodes added and removed by the batch are handled at
+  // once, before the end of the batch process.
+  if (newScene)
+    {
+    this->GetMRMLSceneObserverManager()->SetObjectEventsCoalesced(
+      newScene, true, vtkMRMLScene::NodeAddedEvent);
+    this->GetMRMLSceneObserverManager()->SetObjectEventsCoalesced(
+      newScene, true, vtkMRMLScene::NodeRemovedEvent);
+    }
+
   this->ProcessMRMLSceneEvents(newScene, vtkCommand::ModifiedEvent, 0);
 }
 
@@ -148,6 +160,44 @@ void vtkMRMLSliceLinkLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLinkLogic
+::OnMRMLSceneEventsCoalesced(const vtkEventBroker::CoalescedCallList& calls)
+{
+  // Each slice node the batch added or removed is handled once, from its
+  // state at the end of the batch: a node added then removed is never
+  // observed, a node removed then added back keeps its observation.
+  std::set<vtkMRMLNode*> handledNodes;
+  vtkEventBroker::CoalescedCallList::const_iterator callIt;
+  for (callIt = calls.begin(); callIt != calls.end(); ++callIt)
+    {
+    if (callIt->EventID != vtkMRMLScene::NodeAddedEvent &&
+        callIt->EventID != vtkMRMLScene::NodeRemovedEvent)
+      {
+      this->ProcessMRMLSceneEvents(this->GetMRMLScene(), callIt->EventID,
+                                   callIt->CallData);
+      continue;
+      }
+    vtkMRMLNode* node = reinterpret_cast<vtkMRMLNode*>(callIt->CallData);
+    if ((!node->IsA("vtkMRMLSliceCompositeNode") && !node->IsA("vtkMRMLSliceNode")) ||
+        !handledNodes.insert(node).second)
+      {
+      continue;
+      }
+    bool observed = vtkEventBroker::GetInstance()->GetObservationExist(
+      node, vtkCommand::ModifiedEvent, this, this->GetMRMLNodesCallbackCommand());
+    bool inScene = this->GetMRMLScene()->IsNodePresent(node) != 0;
+    if (inScene && !observed)
+      {
+      this->OnMRMLSceneNodeAdded(node);
+      }
+    else if (!inScene && observed)
+      {
+      this->OnMRMLSceneNodeRemoved(node);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLinkLogic::OnMRMLNodeModified(vtkMRMLNode* node)
 {
@@ -55,6 +55,11 @@ protected:
 
   virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+  /// Handle the slice nodes added and removed by a batch process at once,
+  /// from their state at the end of the batch: the nodes added and removed
+  /// again by the batch are skipped.
+  virtual void OnMRMLSceneEventsCoalesced(
+    const vtkEventBroker::CoalescedCallList& calls);
   virtual void OnMRMLNodeModified(vtkMRMLNode* node);
   virtual void OnMRMLSceneStartBatchProcess();
   virtual void OnMRMLSceneEndBatchProcess();
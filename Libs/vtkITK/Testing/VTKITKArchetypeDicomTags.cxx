@@ -0,0 +1,80 @@
+// vtkITK includes
+#include "vtkITKArchetypeImageSeriesReader.h"
+
+// VTK includes
+#include "vtkNew.h"
+
+// STD includes
+#include <iostream>
+
+int main( int, char** )
+{
+  vtkNew<vtkITKArchetypeImageSeriesReader> reader;
+
+  // Tag values are grouped regardless of their DICOM padding
+  int uid = reader->InsertSeriesInstanceUIDs("1.2.840.1");
+  if (reader->InsertSeriesInstanceUIDs("1.2.840.1 ") != uid ||
+      reader->ExistSeriesInstanceUID("1.2.840.1") != uid ||
+      reader->InsertSeriesInstanceUIDs("1.2.840.12") == uid ||
+      reader->GetNumberOfSeriesInstanceUIDs() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong series instance UID grouping"
+              << std::endl;
+    return 1;
+    }
+
+  // Many distinct slice locations
+  for (int i = 0; i < 10000; ++i)
+    {
+    if (reader->InsertSliceLocation(i * 0.5f) != i)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong slice location index"
+                << std::endl;
+      return 1;
+      }
+    }
+  if (reader->ExistSliceLocation(100.f) != 200 ||
+      reader->ExistSliceLocation(100.25f) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong slice location lookup"
+              << std::endl;
+    return 1;
+    }
+
+  // Gradient directions match up to the sign and the magnitude
+  float g1[3] = {1.f, 0.f, 0.f};
+  float g2[3] = {0.f, 0.707107f, 0.707107f};
+  float g3[3] = {-2.f, 0.00001f, 0.f};
+  float g4[3] = {0.f, 0.f, 0.f};
+  float g5[3] = {0.f, 0.f, 0.f};
+  int i1 = reader->InsertDiffusionGradientOrientation(g1);
+  int i2 = reader->InsertDiffusionGradientOrientation(g2);
+  int i3 = reader->InsertDiffusionGradientOrientation(g3);
+  int i4 = reader->InsertDiffusionGradientOrientation(g4);
+  int i5 = reader->InsertDiffusionGradientOrientation(g5);
+  if (i1 != 0 || i2 != 1 || i3 != i1 || i4 == i5 ||
+      reader->GetNumberOfDiffusionGradientOrientation() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong gradient grouping "
+              << i1 << " " << i2 << " " << i3 << " " << i4 << " " << i5
+              << std::endl;
+    return 1;
+    }
+
+  // Orientations: both direction cosines must match
+  float o1[6] = {1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+  float o2[6] = {2.f, 0.f, 0.f, 0.f, 3.f, 0.f};
+  float o3[6] = {1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+  float o4[6] = {-1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+  if (reader->InsertImageOrientationPatient(o1) != 0 ||
+      reader->InsertImageOrientationPatient(o2) != 0 ||
+      reader->InsertImageOrientationPatient(o3) != 1 ||
+      reader->InsertImageOrientationPatient(o4) != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong orientation grouping"
+              << std::endl;
+    return 1;
+    }
+
+  return 0;
+}
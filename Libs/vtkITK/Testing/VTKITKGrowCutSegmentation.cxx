@@ -0,0 +1,211 @@
+// vtkITK includes
+#include "vtkITKGrowCutSegmentationImageFilter.h"
+
+// ITK includes
+#include <itkGrowCutSegmentationImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+const int Dimension = 40;
+
+//----------------------------------------------------------------------------
+// Two noisy blobs on a noisy background. The noise avoids ties between
+// attacks, so that the results do not depend on the order of the updates.
+float Intensity(int x, int y, int z, unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  float noise = static_cast<float>((seed >> 16) & 0x7fff) / 32768.f;
+  int dx1 = x - 12, dy1 = y - 14, dz1 = z - 20;
+  int dx2 = x - 28, dy2 = y - 25, dz2 = z - 18;
+  float value = 10.f;
+  if (dx1 * dx1 + dy1 * dy1 + dz1 * dz1 < 64)
+    {
+    value = 100.f;
+    }
+  if (dx2 * dx2 + dy2 * dy2 + dz2 * dz2 < 49)
+    {
+    value = 60.f;
+    }
+  return value + 5.f * noise;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> NewImage(int scalarType)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(Dimension, Dimension, Dimension);
+  image->SetScalarType(scalarType);
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+  memset(image->GetScalarPointer(), 0,
+         Dimension * Dimension * Dimension * image->GetScalarSize());
+  return image;
+}
+
+//----------------------------------------------------------------------------
+void PaintSeed(vtkImageData* gestures, int x, int y, int z, short label)
+{
+  for (int k = -1; k <= 1; ++k)
+    {
+    *static_cast<short*>(gestures->GetScalarPointer(x + k, y, z)) = label;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CompareLabels(vtkImageData* image1, vtkImageData* image2, int line)
+{
+  if (memcmp(image1->GetScalarPointer(), image2->GetScalarPointer(),
+             Dimension * Dimension * Dimension * sizeof(short)) != 0)
+    {
+    std::cerr << "Line " << line << ": segmentations differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> Segment(vtkITKGrowCutSegmentationImageFilter* filter,
+                                      vtkImageData* intensities,
+                                      vtkImageData* gestures,
+                                      vtkImageData* prior)
+{
+  filter->SetInput(0, intensities);
+  filter->SetInput(1, gestures);
+  filter->SetInput(2, prior);
+  filter->SetObjectSize(8);
+  filter->SetContrastNoiseRatio(0.8);
+  filter->Update();
+  vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+  output->DeepCopy(filter->GetOutput());
+  return output;
+}
+
+//----------------------------------------------------------------------------
+// The active front gives the same result whatever the number of threads
+bool TestThreads(vtkImageData* intensities, vtkImageData* gestures)
+{
+  typedef itk::Image<float, 3> ImageType;
+  typedef itk::Image<short, 3> LabelImageType;
+  typedef itk::GrowCutSegmentationImageFilter<ImageType, LabelImageType> FilterType;
+
+  ImageType::RegionType region;
+  ImageType::SizeType size;
+  size.Fill(Dimension);
+  region.SetSize(size);
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->GetPixelContainer()->SetImportPointer(
+    static_cast<float*>(intensities->GetScalarPointer()), region.GetNumberOfPixels(), false);
+  LabelImageType::Pointer labels = LabelImageType::New();
+  labels->SetRegions(region);
+  labels->GetPixelContainer()->SetImportPointer(
+    static_cast<short*>(gestures->GetScalarPointer()), region.GetNumberOfPixels(), false);
+  FilterType::WeightImageType::Pointer strengths = FilterType::WeightImageType::New();
+  strengths->SetRegions(region);
+  strengths->Allocate();
+  itk::ImageRegionConstIterator<LabelImageType> label(labels, region);
+  itk::ImageRegionIterator<FilterType::WeightImageType> strength(strengths, region);
+  for (; !label.IsAtEnd(); ++label, ++strength)
+    {
+    strength.Set(label.Get() ? 0.8f : 0.f);
+    }
+
+  LabelImageType::Pointer outputs[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetLabelImage(labels);
+    filter->SetStrengthImage(strengths);
+    filter->SetObjectRadius(8);
+    filter->SetNumberOfThreads(i == 0 ? 1 : 4);
+    filter->Update();
+    outputs[i] = filter->GetOutput();
+    }
+  if (memcmp(outputs[0]->GetBufferPointer(), outputs[1]->GetBufferPointer(),
+             region.GetNumberOfPixels() * sizeof(short)) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": segmentations differ with 1 and 4 threads"
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int , char * [] )
+{
+  vtkSmartPointer<vtkImageData> intensities = NewImage(VTK_FLOAT);
+  unsigned int seed = 1;
+  float* intensity = static_cast<float*>(intensities->GetScalarPointer());
+  for (int z = 0; z < Dimension; ++z)
+    {
+    for (int y = 0; y < Dimension; ++y)
+      {
+      for (int x = 0; x < Dimension; ++x)
+        {
+        *(intensity++) = Intensity(x, y, z, seed);
+        }
+      }
+    }
+
+  vtkSmartPointer<vtkImageData> prior = NewImage(VTK_SHORT);
+  vtkSmartPointer<vtkImageData> gestures = NewImage(VTK_SHORT);
+  PaintSeed(gestures, 12, 14, 20, 1);
+  PaintSeed(gestures, 20, 20, 20, 2);
+
+  if (!TestThreads(intensities, gestures))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkITKGrowCutSegmentationImageFilter> incremental =
+    vtkSmartPointer<vtkITKGrowCutSegmentationImageFilter>::New();
+  incremental->IncrementalOn();
+  vtkSmartPointer<vtkImageData> output =
+    Segment(incremental, intensities, gestures, prior);
+
+  // Paint seeds on the previous result: the segmentation resumes from it
+  // and must match the segmentation of all the seeds from scratch.
+  vtkSmartPointer<vtkImageData> refinedGestures = vtkSmartPointer<vtkImageData>::New();
+  refinedGestures->DeepCopy(output);
+  PaintSeed(refinedGestures, 28, 25, 18, 3);
+  PaintSeed(gestures, 28, 25, 18, 3);
+  output = Segment(incremental, intensities, refinedGestures, prior);
+
+  vtkSmartPointer<vtkITKGrowCutSegmentationImageFilter> fromScratch =
+    vtkSmartPointer<vtkITKGrowCutSegmentationImageFilter>::New();
+  vtkSmartPointer<vtkImageData> expected =
+    Segment(fromScratch, intensities, gestures, prior);
+  if (!CompareLabels(output, expected, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Erasing seeds restarts from scratch
+  vtkSmartPointer<vtkImageData> erasedGestures = NewImage(VTK_SHORT);
+  PaintSeed(erasedGestures, 12, 14, 20, 1);
+  PaintSeed(erasedGestures, 28, 25, 18, 3);
+  output = Segment(incremental, intensities, erasedGestures, prior);
+  expected = Segment(fromScratch, intensities, erasedGestures, prior);
+  if (!CompareLabels(output, expected, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+// ITK includes
+#include "itkTimeSeriesDatabase.h"
+#include <itkImageFileWriter.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+typedef itk::TimeSeriesDatabase<short> DatabaseType;
+typedef DatabaseType::OutputImageType ImageType;
+
+//----------------------------------------------------------------------------
+short ExpectedValue(const ImageType::IndexType& index, unsigned int image)
+{
+  return static_cast<short>(index[0] + 40 * index[1] + 1200 * index[2] - 1000 * image);
+}
+
+//----------------------------------------------------------------------------
+bool CheckRegion(DatabaseType* database, unsigned int image,
+                 const ImageType::RegionType& region, int line)
+{
+  database->SetCurrentImage(image);
+  database->GetOutput()->SetRequestedRegion(region);
+  database->Update();
+  itk::ImageRegionIteratorWithIndex<ImageType> it(database->GetOutput(), region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != ExpectedValue(it.GetIndex(), image))
+      {
+      std::cerr << "Line " << line << ": wrong value " << it.Get() << " at "
+                << it.GetIndex() << " in image " << image << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckDatabase(const std::string& filename, bool useMemoryMapping, bool readAhead)
+{
+  DatabaseType::Pointer database = DatabaseType::New();
+  database->SetUseMemoryMapping(useMemoryMapping);
+  database->SetReadAhead(readAhead);
+  database->Connect(filename.c_str());
+  database->UpdateOutputInformation();
+  if (database->GetNumberOfVolumes() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of volumes "
+              << database->GetNumberOfVolumes() << std::endl;
+    return false;
+    }
+
+  // Scroll forward and backward through the images
+  ImageType::RegionType region = database->GetOutputRegion();
+  unsigned int images[7] = {0, 1, 2, 3, 2, 1, 0};
+  for (int i = 0; i < 7; ++i)
+    {
+    if (!CheckRegion(database, images[i], region, __LINE__))
+      {
+      return false;
+      }
+    }
+
+  // Move a slice through an image
+  ImageType::RegionType slice = region;
+  slice.SetSize(2, 1);
+  for (long z = 0; z < static_cast<long>(region.GetSize(2)); ++z)
+    {
+    slice.SetIndex(2, z);
+    if (!CheckRegion(database, 3, slice, __LINE__))
+      {
+      return false;
+      }
+    }
+
+  // A voxel through time
+  ImageType::IndexType voxel = {{17, 21, 5}};
+  DatabaseType::ArrayType timeSeries;
+  database->GetVoxelTimeSeries(voxel, timeSeries);
+  for (unsigned int image = 0; image < 4; ++image)
+    {
+    if (timeSeries[image] != ExpectedValue(voxel, image))
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong time series value "
+                << timeSeries[image] << " in image " << image << std::endl;
+      return false;
+      }
+    }
+
+  database->Disconnect();
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: VTKITKTimeSeriesDatabase <temporary directory>
+int main( int argc, char* argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: VTKITKTimeSeriesDatabase <temporary directory>" << std::endl;
+    return 1;
+    }
+  std::string directory = argv[1];
+
+  // A 4D series whose size is not a multiple of the block size
+  ImageType::RegionType region;
+  ImageType::SizeType size = {{40, 30, 20}};
+  region.SetSize(size);
+  std::string archetype;
+  for (unsigned int image = 0; image < 4; ++image)
+    {
+    ImageType::Pointer volume = ImageType::New();
+    volume->SetRegions(region);
+    volume->Allocate();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(volume, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      it.Set(ExpectedValue(it.GetIndex(), image));
+      }
+    std::ostringstream filename;
+    filename << directory << "/VTKITKTimeSeriesDatabase_" << image << ".nrrd";
+    itk::ImageFileWriter<ImageType>::Pointer writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetInput(volume);
+    writer->SetFileName(filename.str());
+    writer->Update();
+    if (image == 0)
+      {
+      archetype = filename.str();
+      }
+    }
+
+  // Small files so the database spans several of them
+  std::string database = directory + "/VTKITKTimeSeriesDatabase.tsd";
+  DatabaseType::CreateFromFileArchetype(database.c_str(), archetype.c_str(),
+                                        16 * 16 * 16 * 16 * sizeof(short));
+
+  for (int mapping = 0; mapping < 2; ++mapping)
+    {
+    for (int readAhead = 0; readAhead < 2; ++readAhead)
+      {
+      if (!CheckDatabase(database, mapping != 0, readAhead != 0))
+        {
+        std::cerr << "Failed with memory mapping " << mapping
+                  << " and read ahead " << readAhead << std::endl;
+        return 1;
+        }
+      }
+    }
+
+  return 0;
+}
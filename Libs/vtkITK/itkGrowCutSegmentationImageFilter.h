@@ -5,6 +5,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkSimpleDataObjectDecorator.h"
 #include "itkVectorContainer.h"
+#include "itkIterationReporter.h"
+#include "itkMultiThreader.h"
 //#include "itkCommand.h"
 
 //#include "itkGrowCutSegmentationUpdateFilter.h"
@@ -45,6 +47,15 @@ namespace itk
  *
  * This algorithm is implemented scalar images. Vector Images are not
  * supported.
+ *
+ * When run until convergence, each iteration only visits the neighbors of
+ * the pixels modified by the previous iteration (the active front). The
+ * neighbors are updated in parallel from the state of the previous
+ * iteration, the changes being applied once all the threads are done, so
+ * that the result does not depend on the number of threads. Given the
+ * converged labels and strengths of a previous run and a set of new seeds
+ * (SetSeedPoints), the filter resumes from that state instead of
+ * segmenting from scratch.
  *    
  *        
 **/
@@ -261,6 +272,22 @@ template<class TInputImage,
   itkGetConstMacro(SetMaxSaturationImage, bool);
   itkBooleanMacro(SetMaxSaturationImage);
 
+  /**Set/Get whether the ROI has already been set for the filter with
+  * SetROIStart and SetROIEnd. Default setting is off in which case the
+  * filter computes the ROI from the labeled pixels and the object radius.
+  **/
+  itkSetMacro(SetROI, bool);
+  itkGetConstMacro(SetROI, bool);
+  itkBooleanMacro(SetROI);
+
+  /** Set/Get the seeds the active front starts from. When set, the label
+   * and strength images are taken as the converged result of a previous
+   * run to which these seeds were added, and only the pixels the new seeds
+   * can reach are visited. By default the front starts from every labeled
+   * pixel. **/
+  itkSetObjectMacro(SeedPoints, NodeContainer);
+  itkGetObjectMacro(SeedPoints, NodeContainer);
+
  protected:
   
   GrowCutSegmentationImageFilter();
@@ -290,7 +317,37 @@ template<class TInputImage,
 
   void GrowCutSlowROI( TOutputImage *);
 
-  
+  typedef typename OutputImageType::OffsetType OffsetType;
+  typedef typename OutputImageType::OffsetValueType OffsetValueType;
+
+  /** Label and strength a pixel takes at the end of an iteration **/
+  struct CellUpdate
+  {
+    OffsetValueType Offset;
+    OutputPixelType Label;
+    WeightPixelType Strength;
+  };
+
+  /** Data shared by the threads updating the active front **/
+  struct ActiveFrontThreadStruct
+  {
+    Self *Filter;
+    const vcl_vector< OffsetValueType > *Cells;
+    vcl_vector< vcl_vector< CellUpdate > > *Updates;
+  };
+
+  /** Run the automaton until no pixel changes, only visiting the
+   * neighbors of the pixels that changed in the previous iteration **/
+  void GrowCutActiveFront( OutputImageType *output, IterationReporter &iterate );
+
+  /** Compute the new label and strength of the cells [begin, end[ from the
+   * current state, without modifying it **/
+  void UpdateCells( const vcl_vector< OffsetValueType > &cells,
+                    size_t begin, size_t end,
+                    vcl_vector< CellUpdate > &updates );
+
+  static ITK_THREAD_RETURN_TYPE UpdateCellsThreaderCallback( void *arg );
+
  private:
 
   GrowCutSegmentationImageFilter(const Self&); //purposely not implemented
@@ -305,6 +362,14 @@ template<class TInputImage,
   void ComputeLabelVolumes(TOutputImage *outputImage, vcl_vector< unsigned > &volumes, vcl_vector< unsigned > &phyVolumes);
 
   void MaskSegmentedImageByWeight(float upperThresh);
+
+  void ComputeRegionOfInterest( const OutputImageType *labelImage );
+
+  void ComputeBufferIndex( OffsetValueType offset, IndexType &index ) const;
+
+  bool IsOnROIBorder( const IndexType &index ) const;
+
+  WeightPixelType GetMaxDistance( OffsetValueType offset, const IndexType &index );
   
    
   WeightPixelType                            m_ConfThresh;
@@ -320,6 +385,7 @@ template<class TInputImage,
   bool                                       m_SetStateImage;
   bool                                       m_SetDistancesImage;
   bool                                       m_SetMaxSaturationImage;
+  bool                                       m_SetROI;
 
   unsigned int                               m_MaxIterations;
   unsigned int                               m_ObjectRadius;
@@ -331,6 +397,20 @@ template<class TInputImage,
   OutputIndexType                            m_roiStart;
   OutputIndexType                            m_roiEnd;
 
+  NodeContainerPointer                       m_SeedPoints;
+
+  // Active front state, in buffer offsets and buffer indices
+  const InputPixelType                      *m_InputBuffer;
+  OutputPixelType                           *m_LabelBuffer;
+  WeightPixelType                           *m_StrengthBuffer;
+  WeightPixelType                           *m_DistanceBuffer;
+  OutputSizeType                             m_BufferSize;
+  OffsetType                                 m_BufferStrides;
+  IndexType                                  m_ROILower;
+  IndexType                                  m_ROIUpper;
+  vcl_vector< OffsetType >                   m_NeighborIndexOffsets;
+  vcl_vector< OffsetValueType >              m_NeighborOffsets;
+
 };
 
 } // namespace itk
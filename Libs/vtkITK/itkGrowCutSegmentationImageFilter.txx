@@ -10,6 +10,7 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkConstantBoundaryCondition.h"
 #include "itkNumericTraits.h"
 #include "itkImageFileWriter.h"
@@ -52,6 +53,13 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
 
   m_SetMaxSaturationImage = false;
 
+  m_SetROI = false;
+
+  m_InputBuffer = 0;
+  m_LabelBuffer = 0;
+  m_StrengthBuffer = 0;
+  m_DistanceBuffer = 0;
+
   m_ConfThresh = 0.2;
   
   m_MaxIterations = 500;
@@ -510,251 +518,463 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
     return;
     }
 
-    
-  unsigned int ndims = static_cast< unsigned int>(output->GetImageDimension());
+  // Filter was configured to run until convergence. Only the pixels next
+  // to the ones modified by the previous iteration can change, so each
+  // iteration visits the neighbors of the active front only.
+  this->GrowCutActiveFront(output, iterate);
+
+  m_LabelImage = output;
   
+  this->MaskSegmentedImageByWeight(m_ConfThresh);
+}
+
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void 
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::GrowCutActiveFront( OutputImageType *output, IterationReporter &iterate )
+{
   typename InputImageType::Pointer inputImage = InputImageType::New();
   inputImage->Graft( this->ProcessObject::GetInput(0));
-  
-  typename OutputImageType::Pointer pixelStateImage = OutputImageType::New();
-  typename WeightImageType::Pointer maxDistancesImage = WeightImageType::New();
-  typename WeightImageType::Pointer maxSaturationImage = WeightImageType::New();
 
+  typename OutputImageType::Pointer labelImage = OutputImageType::New();
+  labelImage->Graft( this->ProcessObject::GetInput(1));
 
-  bool converged = false;
-  
-  // Initialize the state image
-  if( !m_SetStateImage)
+  typename WeightImageType::Pointer strengthImage = WeightImageType::New();
+  strengthImage->Graft( this->ProcessObject::GetInput(2));
+
+  const OutputImageRegionType bufferedRegion = output->GetBufferedRegion();
+  if( inputImage->GetBufferedRegion() != bufferedRegion )
     {
-      
-    pixelStateImage->CopyInformation( this->GetLabelImage() );
-    pixelStateImage->SetBufferedRegion( this->GetLabelImage()->GetBufferedRegion() );
-    pixelStateImage->Allocate();
-    pixelStateImage->FillBuffer(UNLABELED);      
-      
-    converged = this->InitializeStateImage(pixelStateImage);
+    itkExceptionMacro(<< "Input image and output image buffered regions differ");
     }
-  
 
-  // Initialize the max distance for each pixel in the image
-  if( !m_SetDistancesImage)
+  if( !m_SetROI )
     {
-  
-    maxDistancesImage->CopyInformation(this->GetStrengthImage());
-    maxDistancesImage->SetBufferedRegion( this->GetStrengthImage()->GetBufferedRegion() );
-    maxDistancesImage->Allocate();
-    maxDistancesImage->FillBuffer(UNLABELED);
-    this->InitializeDistancesImage(inputImage, maxDistancesImage);  
+    this->ComputeRegionOfInterest( labelImage );
     }
 
-  
-  if( !m_SetMaxSaturationImage )
+  // The automaton runs in the ROI only, the pixels outside are unlabeled
+  OutputSizeType roiSize;
+  bool emptyROI = false;
+  for (unsigned int d = 0; d < ImageDimension; d++)
     {
-    maxSaturationImage->CopyInformation( inputImage );
-    maxSaturationImage->SetBufferedRegion( inputImage->GetBufferedRegion() );  
-    maxSaturationImage->Allocate();
-    maxSaturationImage->FillBuffer( 0 );       
+    emptyROI = emptyROI || m_roiEnd[d] < m_roiStart[d];
+    roiSize[d] = emptyROI ? 0 : m_roiEnd[d] - m_roiStart[d] + 1;
     }
+  OutputImageRegionType roi( m_roiStart, roiSize );
 
-  /////////////////////////////////////////////////////////////////
+  output->FillBuffer( m_UnknownLabel );
 
-  // Filter was configured to run until convergence. We need to delegate a different instance of the filter to run on each iteration. 
-  // std::cout<<" Running filter until convergence .... "<<std::endl;
+  m_WeightImage = WeightImageType::New();
+  m_WeightImage->CopyInformation( output );
+  m_WeightImage->SetRegions( bufferedRegion );
+  m_WeightImage->Allocate();
+  m_WeightImage->FillBuffer( 0.0 );
 
-  typename GrowCutSegmentationImageFilter< TInputImage, TOutputImage, TWeightPixelType >::Pointer 
-    singleIteration = 
-    GrowCutSegmentationImageFilter< TInputImage, TOutputImage, TWeightPixelType>::New();
-  // set up the singleIteration Filter. 
-  singleIteration->RunOneIterationOn();
-  singleIteration->SetInputImage( this->GetInputImage());
-  singleIteration->SetLabelImage( this->GetLabelImage() );
-  singleIteration->SetStrengthImage (this->GetStrengthImage() );
+  if( emptyROI || !roi.Crop( bufferedRegion ) )
+    {
+    this->UpdateProgress(1.0);
+    return;
+    }
 
-  if(m_SetStateImage)
+  // The distance of each pixel to its neighbors is only computed when the
+  // pixel is attacked
+  typename WeightImageType::Pointer distancesImage = WeightImageType::New();
+  if( m_SetDistancesImage )
     {
-    singleIteration->SetStateImage( this->GetStateImage() );
+    distancesImage->Graft( this->ProcessObject::GetInput(4) );
     }
   else
     {
-    singleIteration->SetStateImage(pixelStateImage);
+    distancesImage->CopyInformation( output );
+    distancesImage->SetRegions( bufferedRegion );
+    distancesImage->Allocate();
+    distancesImage->FillBuffer( -1.0 );
     }
-  
-  if(m_SetDistancesImage)
+
+  m_InputBuffer = inputImage->GetBufferPointer();
+  m_LabelBuffer = output->GetBufferPointer();
+  m_StrengthBuffer = m_WeightImage->GetBufferPointer();
+  m_DistanceBuffer = distancesImage->GetBufferPointer();
+  m_BufferSize = bufferedRegion.GetSize();
+  OffsetValueType stride = 1;
+  for (unsigned int d = 0; d < ImageDimension; d++)
     {
-    singleIteration->SetDistancesImage( this->GetDistancesImage() );
+    m_BufferStrides[d] = stride;
+    stride *= m_BufferSize[d];
+    m_ROILower[d] = roi.GetIndex(d) - bufferedRegion.GetIndex(d);
+    m_ROIUpper[d] = m_ROILower[d] + static_cast< OffsetValueType >(roi.GetSize(d)) - 1;
     }
-  else
+
+  // All the pixels of the 3x3x3 neighborhood but the center
+  m_NeighborIndexOffsets.clear();
+  m_NeighborOffsets.clear();
+  unsigned int numberOfNeighbors = 1;
+  for (unsigned int d = 0; d < ImageDimension; d++)
     {
-    singleIteration->SetDistancesImage(maxDistancesImage);
+    numberOfNeighbors *= 3;
     }
-  if(m_SetMaxSaturationImage)
+  for (unsigned int n = 0; n < numberOfNeighbors; n++)
     {
-    singleIteration->SetMaxSaturationImage( this->GetMaxSaturationImage() );
+    OffsetType neighborOffset;
+    OffsetValueType linearOffset = 0;
+    bool center = true;
+    for (unsigned int d = 0, digits = n; d < ImageDimension; d++, digits /= 3)
+      {
+      neighborOffset[d] = static_cast< OffsetValueType >(digits % 3) - 1;
+      linearOffset += neighborOffset[d] * m_BufferStrides[d];
+      center = center && neighborOffset[d] == 0;
+      }
+    if(!center)
+      {
+      m_NeighborIndexOffsets.push_back( neighborOffset );
+      m_NeighborOffsets.push_back( linearOffset );
+      }
     }
-  else
+
+  // Copy the ROI of the labels and strengths. The initial front is made of
+  // the seed points if any, of all the labeled pixels otherwise.
+  vcl_vector< OffsetValueType > front;
+  unsigned long numberOfLabeled = 0;
+  ImageRegionConstIteratorWithIndex< OutputImageType > label( labelImage, roi );
+  ImageRegionConstIterator< WeightImageType > strength( strengthImage, roi );
+  for (label.GoToBegin(), strength.GoToBegin(); !label.IsAtEnd(); ++label, ++strength)
+    {
+    const OffsetValueType offset = output->ComputeOffset( label.GetIndex() );
+    m_LabelBuffer[offset] = label.Get();
+    m_StrengthBuffer[offset] = strength.Get();
+    if( strength.Get() > 0 )
+      {
+      ++numberOfLabeled;
+      if( !m_SeedPoints )
+        {
+        front.push_back( offset );
+        }
+      }
+    }
+  if( m_SeedPoints )
     {
-    singleIteration->SetMaxSaturationImage(maxSaturationImage);
+    for (typename NodeContainer::ConstIterator it = m_SeedPoints->Begin();
+         it != m_SeedPoints->End(); ++it)
+      {
+      if( roi.IsInside( it.Value() ) )
+        {
+        front.push_back( output->ComputeOffset( it.Value() ) );
+        }
+      }
     }
 
-  // std::cout<<" Setting other filter parameters ... "<<std::endl;
-  singleIteration->SetSeedStrength( this->GetSeedStrength());
-  singleIteration->SetMaxIterations( this->GetMaxIterations());
-  singleIteration->SetObjectRadius(this->GetObjectRadius() );
+  const unsigned long roiVolume = roi.GetNumberOfPixels();
+  vcl_vector< bool > isCandidate( bufferedRegion.GetNumberOfPixels(), false );
+  vcl_vector< OffsetValueType > candidates;
 
-  singleIteration->SetROIStart( this->GetROIStart() );
-  singleIteration->SetROIEnd( this->GetROIEnd() );
-  
-  singleIteration->GetOutput()->SetBufferedRegion( 
-    this->GetOutput()->GetBufferedRegion() );
-  
-  // Create Progress Accumulator for tracking the progress
-  //ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
-  //progress->SetMiniPipelineFilter( this );
-  //progress->RegisterInternalFilter( singleIterationFilter, 1.0f );
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  const unsigned int numberOfThreads =
+    static_cast< unsigned int >( this->GetMultiThreader()->GetNumberOfThreads() );
+  vcl_vector< vcl_vector< CellUpdate > > updates( numberOfThreads );
+
+  ActiveFrontThreadStruct str;
+  str.Filter = this;
+  str.Cells = &candidates;
+  str.Updates = &updates;
 
-  // run until convergence
-  
   unsigned int iter = 0;
-  //time_t startTime;
-  //time_t endTime;
-  time_t start;
-  time_t end;
+  while (iter < m_MaxIterations && !front.empty())
+    {
+    // Only the neighbors of the pixels modified at the previous iteration
+    // can be modified
+    candidates.clear();
+    for (size_t i = 0; i < front.size(); i++)
+      {
+      IndexType index;
+      this->ComputeBufferIndex( front[i], index );
+      const bool border = this->IsOnROIBorder( index );
+      for (size_t k = 0; k < m_NeighborOffsets.size(); k++)
+        {
+        if(border)
+          {
+          const IndexType neighborIndex = index + m_NeighborIndexOffsets[k];
+          bool inside = true;
+          for (unsigned int d = 0; d < ImageDimension; d++)
+            {
+            inside = inside && neighborIndex[d] >= m_ROILower[d] &&
+              neighborIndex[d] <= m_ROIUpper[d];
+            }
+          if(!inside)
+            {
+            continue;
+            }
+          }
+        const OffsetValueType neighbor = front[i] + m_NeighborOffsets[k];
+        if(!isCandidate[neighbor])
+          {
+          isCandidate[neighbor] = true;
+          candidates.push_back( neighbor );
+          }
+        }
+      }
+    for (size_t i = 0; i < candidates.size(); i++)
+      {
+      isCandidate[candidates[i]] = false;
+      }
 
-  unsigned int maxRadius = 0;
-  
-  unsigned totalROIVolume = 1;
+    // All the candidates are updated from the same state, the changes are
+    // applied once all the threads are done
+    for (unsigned int t = 0; t < numberOfThreads; t++)
+      {
+      updates[t].clear();
+      }
+    if(candidates.size() < 1024 || numberOfThreads == 1)
+      {
+      this->UpdateCells( candidates, 0, candidates.size(), updates[0] );
+      }
+    else
+      {
+      this->GetMultiThreader()->SetSingleMethod( Self::UpdateCellsThreaderCallback, &str );
+      this->GetMultiThreader()->SingleMethodExecute();
+      }
 
-  for (unsigned n = 0; n < ndims; n++)
+    front.clear();
+    for (unsigned int t = 0; t < numberOfThreads; t++)
+      {
+      for (size_t i = 0; i < updates[t].size(); i++)
+        {
+        const CellUpdate &update = updates[t][i];
+        numberOfLabeled += (m_StrengthBuffer[update.Offset] <= 0) ? 1 : 0;
+        m_LabelBuffer[update.Offset] = update.Label;
+        m_StrengthBuffer[update.Offset] = update.Strength;
+        front.push_back( update.Offset );
+        }
+      }
+
+    ++iter;
+    iterate.CompletedStep();
+    this->UpdateProgress( roiVolume ? numberOfLabeled / static_cast< float >(roiVolume) : 1.0 );
+    }
+
+  this->UpdateProgress(1.0);
+
+  m_InputBuffer = 0;
+  m_LabelBuffer = 0;
+  m_StrengthBuffer = 0;
+  m_DistanceBuffer = 0;
+}
+
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void 
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::UpdateCells( const vcl_vector< OffsetValueType > &cells,
+               size_t begin, size_t end,
+               vcl_vector< CellUpdate > &updates )
+{
+  for (size_t i = begin; i < end; i++)
     {
-    //prevUnlabeledPix *= (m_roiEnd[n]-m_roiStart[n]);
-    totalROIVolume *= (m_roiEnd[n]-m_roiStart[n]);
-      
-    if(n == 0)
+    const OffsetValueType offset = cells[i];
+    IndexType index;
+    this->ComputeBufferIndex( offset, index );
+    const bool border = this->IsOnROIBorder( index );
+
+    const WeightPixelType strength = m_StrengthBuffer[offset];
+    const WeightPixelType center = static_cast< WeightPixelType >(m_InputBuffer[offset]);
+    WeightPixelType winnerStrength = strength;
+    OutputPixelType winnerLabel = m_LabelBuffer[offset];
+    WeightPixelType maxDistance = -1.0;
+
+    for (size_t k = 0; k < m_NeighborOffsets.size(); k++)
       {
-      maxRadius = m_roiEnd[n]-m_roiStart[n];
+      if(border)
+        {
+        const IndexType neighborIndex = index + m_NeighborIndexOffsets[k];
+        bool inside = true;
+        for (unsigned int d = 0; d < ImageDimension; d++)
+          {
+          inside = inside && neighborIndex[d] >= m_ROILower[d] &&
+            neighborIndex[d] <= m_ROIUpper[d];
+          }
+        if(!inside)
+          {
+          continue;
+          }
+        }
+      const OffsetValueType neighbor = offset + m_NeighborOffsets[k];
+      const WeightPixelType neighborStrength = m_StrengthBuffer[neighbor];
+      // The attack is at most as strong as the attacker
+      if(neighborStrength <= winnerStrength)
+        {
+        continue;
+        }
+      if(maxDistance < 0)
+        {
+        maxDistance = this->GetMaxDistance( offset, index );
+        }
+      WeightPixelType attackWeight = center - static_cast< WeightPixelType >(m_InputBuffer[neighbor]);
+      attackWeight *= attackWeight;
+      attackWeight = (maxDistance > 0) ? (1.0 - attackWeight/maxDistance) : 1.0;
+      attackWeight *= neighborStrength;
+      if(attackWeight > winnerStrength)
+        {
+        winnerStrength = attackWeight;
+        winnerLabel = m_LabelBuffer[neighbor];
+        }
       }
-    else if(maxRadius < (m_roiEnd[n]-m_roiStart[n]))
+
+    if(winnerStrength > strength)
       {
-      maxRadius = m_roiEnd[n]-m_roiStart[n];
+      CellUpdate update;
+      update.Offset = offset;
+      update.Label = winnerLabel;
+      update.Strength = winnerStrength;
+      updates.push_back( update );
       }
     }
-  
-  maxRadius = static_cast< unsigned int>(vcl_ceil(maxRadius*0.5));
-  
-  // float threshSaturation = .96; //.999; // Determine the saturation according to the size of the object
-  // float threshUnchanged = 0.05;
-  // float threshUnlabeledLimit = 0;
-  
-  unsigned threshSaturation = 96; // .96*100
-  unsigned threshUnchanged = 5;
-  
-  time(&start);
+}
 
-  // set up the grow cut update filter here... 
-  
-  unsigned prevModifiedPix = 0;
-  while (iter < m_MaxIterations && !converged)
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+ITK_THREAD_RETURN_TYPE
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::UpdateCellsThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct* info = static_cast<MultiThreader::ThreadInfoStruct*>( arg );
+  ActiveFrontThreadStruct *str = static_cast<ActiveFrontThreadStruct*>( info->UserData );
+  const size_t threadId = static_cast<size_t>( info->ThreadID );
+  const size_t numberOfThreads = static_cast<size_t>( info->NumberOfThreads );
+  const size_t numberOfCells = str->Cells->size();
+
+  str->Filter->UpdateCells( *str->Cells,
+                            numberOfCells * threadId / numberOfThreads,
+                            numberOfCells * (threadId + 1) / numberOfThreads,
+                            (*str->Updates)[threadId] );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void 
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::ComputeRegionOfInterest( const OutputImageType *labelImage )
+{
+  const OutputImageRegionType region = labelImage->GetBufferedRegion();
+  bool foundLabels = false;
+
+  ImageRegionConstIteratorWithIndex< OutputImageType > label( labelImage, region );
+  for (label.GoToBegin(); !label.IsAtEnd(); ++label)
     {
-    //std::cout<<" running iteration ...... "<<iter<<std::endl;
-    singleIteration->Update();
-    //std::cout<<" DONE"<<std::endl;
-    iterate.CompletedStep();
+    if(label.Get() == m_UnknownLabel)
+      {
+      continue;
+      }
+    const OutputIndexType idx = label.GetIndex();
+    for (unsigned int d = 0; d < ImageDimension; d++)
+      {
+      if(!foundLabels || idx[d] < m_roiStart[d])
+        {
+        m_roiStart[d] = idx[d];
+        }
+      if(!foundLabels || idx[d] > m_roiEnd[d])
+        {
+        m_roiEnd[d] = idx[d];
+        }
+      }
+    foundLabels = true;
+    }
 
-    // Check for convergence
-    //pixelStateImage = singleIteration->GetStateImage();
-            
-    unsigned changeablePix = 
-      singleIteration->GetLabeled();//updateFilter->GetNumLabeledPixels();
-    unsigned currLocallySaturatedPix = 
-      singleIteration->GetLocallySaturated();//updateFilter->GetNumLocallySaturatedPixels();
-    unsigned currSaturatedPix = 
-      singleIteration->GetSaturated();//updateFilter->GetNumSaturatedPixels();
-
-    unsigned unlabeled = (changeablePix + currLocallySaturatedPix + currSaturatedPix <= totalROIVolume) ? 
-      (static_cast<unsigned > (totalROIVolume) -(currLocallySaturatedPix + 
-                                                 currSaturatedPix + changeablePix)) : 0;
-       
-    unsigned currModified = currLocallySaturatedPix + currSaturatedPix;
-     
-    unsigned relUnlabeled = (unlabeled*100)/totalROIVolume;
-    unsigned relSaturated = ((currSaturatedPix+currLocallySaturatedPix)*100)/totalROIVolume;    
+  if(!foundLabels)
+    {
+    // Empty ROI
+    m_roiStart = region.GetIndex();
+    m_roiEnd = region.GetIndex();
+    m_roiEnd[0] -= 1;
+    return;
+    }
 
-    // unsigned permodified = (currModified > prevModifiedPix) ? ((currModified-prevModifiedPix)*100)/(vcl_max(static_cast<unsigned int>(1), vcl_max(currModified, prevModifiedPix))) : ((prevModifiedPix - currModified)*100)/(vcl_max(static_cast<unsigned int>(1), vcl_max(currModified, prevModifiedPix)));
+  for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+    const OffsetValueType radius = static_cast< OffsetValueType >(m_ObjectRadius);
+    const OffsetValueType lower = region.GetIndex(d);
+    const OffsetValueType upper = lower + static_cast< OffsetValueType >(region.GetSize(d)) - 1;
+    m_roiStart[d] = vcl_max( m_roiStart[d] - radius, lower );
+    m_roiEnd[d] = vcl_min( m_roiEnd[d] + radius, upper );
+    }
+}
 
-    converged = (prevModifiedPix == currModified) || 
-      (relUnlabeled < threshUnchanged && relSaturated > threshSaturation);
-      
-    // if((iter % 10 == 0) || converged)
-    //   {
-      // std::cout<<" ITER "<<iter<<std::endl;
-      // std::cout<<" saturated Pixels "<<currSaturatedPix<<"( "<<
-      //   totalROIVolume<<") %"<<currSaturatedPix/(float)totalROIVolume<<std::endl;
-      // std::cout<<" locally saturated Pixels "<<currLocallySaturatedPix<<" %"<<
-      //   currLocallySaturatedPix/(float)totalROIVolume<<std::endl;
-      // std::cout<<"Number of Labeled Pixels "<<changeablePix<<" %"<<
-      //   changeablePix/(float)totalROIVolume<<std::endl;
-      // std::cout<<"Curr Saturated "<<relSaturated<<" %"<<std::endl;
-      // std::cout<<" Prev Modified "<<prevModifiedPix<<" Curr Modified "<<currModified<<std::endl;
-      // std::cout<<"Unlabeled pixels "<<unlabeled<<" %"<<
-      //   relUnlabeled<<" Per modified "<<permodified<<std::endl;
-      // if(converged)
-      //   std::cout<<" converged...."<<std::endl;
-      // }
-      
-    prevModifiedPix = currModified; 
-    ++iter;
-    m_WeightImage = singleIteration->GetUpdatedStrengthImage();
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void 
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::ComputeBufferIndex( OffsetValueType offset, IndexType &index ) const
+{
+  for (unsigned int d = ImageDimension - 1; d > 0; d--)
+    {
+    index[d] = offset / m_BufferStrides[d];
+    offset -= index[d] * m_BufferStrides[d];
+    }
+  index[0] = offset;
+}
 
-    if(!converged)
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+bool 
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::IsOnROIBorder( const IndexType &index ) const
+{
+  for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+    if(index[d] == m_ROILower[d] || index[d] == m_ROIUpper[d])
       {
-      // assign the old output as input
-      m_WeightImage->DisconnectPipeline();
-      //m_LabelImage->DisconnectPipeline();
-    
-      singleIteration->SetStrengthImage(m_WeightImage);
-      //singleIteration->SetLabelImage(m_LabelImage);
-      singleIteration->GetOutput()->
-        SetBufferedRegion(output->GetBufferedRegion() );
+      return true;
       }
+    }
+  return false;
+}
 
-    this->UpdateProgress((currSaturatedPix+currLocallySaturatedPix)/(float)totalROIVolume);
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+typename GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>::WeightPixelType
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::GetMaxDistance( OffsetValueType offset, const IndexType &index )
+{
+  if(m_DistanceBuffer[offset] >= 0)
+    {
+    return m_DistanceBuffer[offset];
     }
-  
-    
-  this->UpdateProgress(1.0);
-  m_WeightImage = singleIteration->GetUpdatedStrengthImage() ;
-  m_LabelImage = singleIteration->GetOutput();
-  
-  this->MaskSegmentedImageByWeight(m_ConfThresh);
-    
-  this->GraftOutput(m_LabelImage);
-  
-  time(&end);
 
-  vcl_vector< unsigned > labelVolumes;
-  vcl_vector< unsigned > physicalVolumes;
-  
-  this->ComputeLabelVolumes(m_LabelImage, labelVolumes, physicalVolumes);
-  
-  // std::cout<<"...................................................."<<std::endl;
-  // for (unsigned n = 0; n < labelVolumes.size(); n++)
-  //   {
-  //   std::cout<<" Object "<<n<<" volume "<<labelVolumes[n]<<" Physical Volume "<<
-  //     physicalVolumes[n]<<std::endl;
-  //   }
- 
-  /*
-  typedef ImageFileWriter < OutputImageType > WriterType;
-  typename WriterType::Pointer writer = WriterType::New();
-  
-  vcl_string outfilename = "segmented_img.mhd";
-  writer->SetFileName(outfilename.c_str());
-  writer->SetInput(m_LabelImage);
-  writer->Update();
-  */
-  // std::cout<<" Time taken for segmentation "<<iter<<
-  //   " : "<<difftime(end, start)<<" secs"<<std::endl;
-  
+  // Same as InitializeDistancesImage: the largest squared difference with
+  // the pixels of the neighborhood, the image being extended by its border
+  // values (zero flux Neumann boundary condition)
+  const WeightPixelType center = static_cast< WeightPixelType >(m_InputBuffer[offset]);
+  WeightPixelType maxDistance = 0.0;
+  OffsetType radiusOffset;
+  for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+    radiusOffset[d] = -static_cast< OffsetValueType >(m_Radius[d]);
+    }
+  while (true)
+    {
+    OffsetValueType neighbor = 0;
+    for (unsigned int d = 0; d < ImageDimension; d++)
+      {
+      OffsetValueType x = index[d] + radiusOffset[d];
+      x = vcl_max( vcl_min( x, static_cast< OffsetValueType >(m_BufferSize[d]) - 1 ),
+                   static_cast< OffsetValueType >(0) );
+      neighbor += x * m_BufferStrides[d];
+      }
+    WeightPixelType distance = static_cast< WeightPixelType >(m_InputBuffer[neighbor]) - center;
+    distance *= distance;
+    maxDistance = (distance > maxDistance) ? distance : maxDistance;
+
+    unsigned int d = 0;
+    for (; d < ImageDimension; d++)
+      {
+      if(++radiusOffset[d] <= static_cast< OffsetValueType >(m_Radius[d]))
+        {
+        break;
+        }
+      radiusOffset[d] = -static_cast< OffsetValueType >(m_Radius[d]);
+      }
+    if(d == ImageDimension)
+      {
+      break;
+      }
+    }
+
+  m_DistanceBuffer[offset] = maxDistance;
+  return maxDistance;
 }
 
 
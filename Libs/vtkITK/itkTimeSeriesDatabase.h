@@ -5,8 +5,13 @@
 #include <itkImage.h>
 #include <itkArray.h>
 #include <itkImageSource.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
+#include <itkMutexLock.h>
+#include <itkConditionVariable.h>
 #include <iostream>
 #include <fstream>
+#include <deque>
 #include <itkTimeSeriesDatabaseHelper.h>
 
 #define TimeSeriesBlockSize 16
@@ -101,6 +106,26 @@ public:
    */
   float GetCacheSizeInMiB ();
 
+  /** Read the blocks of the neighbouring images in a background thread
+   * When the CurrentImage changes, the blocks of the requested region in
+   * the next NumberOfReadAheadImages images along the scroll direction are
+   * loaded into the cache, as well as the blocks next to the requested
+   * region when the region moves.  On by default.
+   */
+  itkSetMacro ( ReadAhead, bool );
+  itkGetMacro ( ReadAhead, bool );
+  itkBooleanMacro ( ReadAhead );
+  itkSetMacro ( NumberOfReadAheadImages, unsigned int );
+  itkGetMacro ( NumberOfReadAheadImages, unsigned int );
+
+  /** Read the database files through memory mappings
+   * Fall back to stream reads when a file can not be mapped.
+   * Takes effect on the next Connect.  On by default.
+   */
+  itkSetMacro ( UseMemoryMapping, bool );
+  itkGetMacro ( UseMemoryMapping, bool );
+  itkBooleanMacro ( UseMemoryMapping );
+
 
 protected:
   TimeSeriesDatabase();
@@ -137,13 +162,49 @@ protected:
   std::vector<std::string> m_DatabaseFileNames;
   unsigned long m_BlocksPerFile;
 
+  /// Memory mappings of the database files, unmapped entries are read
+  /// through m_DatabaseFiles
+  typedef itk::TimeSeriesDatabaseHelper::counted_ptr<TimeSeriesDatabaseHelper::MappedFile> MappedFilePtr;
+  std::vector<MappedFilePtr> m_MappedFiles;
+  bool m_UseMemoryMapping;
+  /// Serializes the seek/read pairs on m_DatabaseFiles
+  SimpleFastMutexLock m_StreamLock;
+
   /// our cache
   struct CacheBlock 
   {
     TPixel data[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
   };
   TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
-  CacheBlock* GetCacheBlock ( unsigned long index );
+  mutable SimpleFastMutexLock m_CacheLock;
+  /// Copy the block at index into Block, reading it from disk on a cache miss.
+  /// Safe to call from several threads.
+  void GetCacheBlock ( unsigned long index, CacheBlock& Block );
+  /// Read the block at index from the database files
+  void ReadBlock ( unsigned long index, CacheBlock& Block );
+
+  /// Read ahead
+  bool m_ReadAhead;
+  unsigned int m_NumberOfReadAheadImages;
+  /// Image and region of the previous GenerateData, used to find the
+  /// scroll direction
+  int m_PreviousImage;
+  typename OutputImageType::RegionType m_PreviousRegion;
+  int m_ReadAheadDirection;
+  /// Block indices waiting to be read by the read ahead thread
+  std::deque<unsigned long> m_ReadAheadQueue;
+  SimpleMutexLock m_ReadAheadLock;
+  ConditionVariable::Pointer m_ReadAheadCondition;
+  MultiThreader::Pointer m_ReadAheadThreader;
+  int m_ReadAheadThreadID;
+  bool m_TerminateReadAhead;
+  /// Append the indices of the blocks overlapping Region in Image to Indices
+  void CalculateBlockIndices ( const typename OutputImageType::RegionType& Region, unsigned int Image,
+                               std::deque<unsigned long>& Indices );
+  /// Queue the blocks to read ahead of the region that was just generated
+  void ScheduleReadAhead ( const typename OutputImageType::RegionType& Region );
+  void StopReadAhead();
+  static ITK_THREAD_RETURN_TYPE ReadAheadThreaderCallback ( void* arg );
 };
 
 } // end namespace itk
@@ -11,6 +11,7 @@
 #include "itkArchetypeSeriesFileNames.h"
 #include <fstream>
 #include <vector>
+#include <cstring>
 
 namespace itk {
 
@@ -57,12 +58,19 @@ bool TimeSeriesDatabase<TPixel>::IsOpen () const
 template <class TPixel>
 void TimeSeriesDatabase<TPixel>::Disconnect ()
 {
-  for ( int idx = 0; idx < this->m_DatabaseFiles.size(); idx++ )
+  // The read ahead thread reads from the files
+  this->StopReadAhead();
+  for ( ::size_t idx = 0; idx < this->m_DatabaseFiles.size(); idx++ )
     {
     this->m_DatabaseFiles[idx]->close();
     }
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
+  this->m_CacheLock.Lock();
+  this->m_Cache.clear();
+  this->m_CacheLock.Unlock();
+  this->m_PreviousImage = -1;
 }
   
 template <class TPixel>
@@ -118,6 +126,7 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
   // Read the "Filenames:" line
   o >> dummy;
   this->m_DatabaseFiles.clear();
+  this->m_MappedFiles.clear();
   this->m_DatabaseFileNames.clear();
   // Read and open the files
   for ( int idx = 0; idx < NumberOfFiles; idx++ )
@@ -127,6 +136,19 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
     // std::cout << "Reading file " << idx << " " << Filename << std::endl;
     this->m_DatabaseFileNames.push_back ( Filename );
     this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( Filename.c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+    // Files that can not be mapped (e.g. not enough address space) are read
+    // through the stream
+    MappedFilePtr mapped;
+    if ( this->m_UseMemoryMapping )
+      {
+      mapped = MappedFilePtr ( new TimeSeriesDatabaseHelper::MappedFile );
+      if ( !mapped->Open ( Filename.c_str() ) )
+        {
+        itkDebugMacro ( << "Could not map " << Filename << ", using stream reads" );
+        mapped = MappedFilePtr();
+        }
+      }
+    this->m_MappedFiles.push_back ( mapped );
     }
   /*
   std::cout << "ImageSize: " << m_OutputRegion.GetSize() << endl;
@@ -181,20 +203,59 @@ template <class TPixel>
 
 
 template <class TPixel>
-typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index )
+void TimeSeriesDatabase<TPixel>::ReadBlock ( unsigned long index, CacheBlock& Block )
+{
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  unsigned int FileIdx = this->CalculateFileIndex ( index );
+  ::size_t position = static_cast< ::size_t > ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
+  ::size_t count = 0;
+  if ( FileIdx < this->m_MappedFiles.size() && this->m_MappedFiles[FileIdx].get() )
+    {
+    // Mapped files are read without locking, the page cache does the rest
+    const TimeSeriesDatabaseHelper::MappedFile* mapped = this->m_MappedFiles[FileIdx].get();
+    if ( position < mapped->GetSize() )
+      {
+      count = TSD_MIN ( BlockBytes, mapped->GetSize() - position );
+      memcpy ( Block.data, mapped->GetData() + position, count );
+      }
+    }
+  else if ( FileIdx < this->m_DatabaseFiles.size() )
+    {
+    // The seek and read must not be interleaved with another thread's
+    this->m_StreamLock.Lock();
+    std::fstream* stream = this->m_DatabaseFiles[FileIdx].get();
+    stream->clear();
+    stream->seekg ( position );
+    stream->read ( reinterpret_cast<char*> ( Block.data ), BlockBytes );
+    count = static_cast< ::size_t > ( TSD_MAX ( (std::streamsize)0, stream->gcount() ) );
+    this->m_StreamLock.Unlock();
+    }
+  if ( count < BlockBytes )
+    {
+    memset ( reinterpret_cast<char*> ( Block.data ) + count, 0, BlockBytes - count );
+    }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index, CacheBlock& Block )
 {
+  // The block is copied out under the lock: another thread may evict it
+  // as soon as the lock is released.
+  this->m_CacheLock.Lock();
   CacheBlock* Buffer = this->m_Cache.find ( index );
-  if ( Buffer == 0 ) {
-    // Fill it in
-    CacheBlock B;
-    int FileIdx = this->CalculateFileIndex ( index );
-    
-    this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
-    this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( B.data ), TimeSeriesVolumeBlockSize * sizeof ( TPixel ) );
-    this->m_Cache.insert ( index, B );
-    Buffer = this->m_Cache.find ( index );
-  }
-  return Buffer;
+  if ( Buffer )
+    {
+    Block = *Buffer;
+    this->m_CacheLock.Unlock();
+    return;
+    }
+  this->m_CacheLock.Unlock();
+
+  // Fill it in, without holding the cache lock
+  this->ReadBlock ( index, Block );
+  this->m_CacheLock.Lock();
+  this->m_Cache.insert ( index, Block );
+  this->m_CacheLock.Unlock();
 }
 
 
@@ -206,21 +267,173 @@ void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::
   Size<3> CurrentBlock;
   Size<3> Offset;
   for ( int i = 0; i < 3; i++ ) {
-    if ( idx[i] < 0 || idx[i] > this->m_OutputRegion.Size[i] ) {
-      throw 1;
+    if ( idx[i] < 0 || idx[i] >= (long) this->m_OutputRegion.GetSize ( i ) ) {
+      itkExceptionMacro ( "TimeSeriesDatabase::GetVoxelTimeSeries: index " << idx << " is outside of the image" );
     }
-    CurrentBlock[i] = reinterpret_cast<unsigned long> ( idx[i] / (double)TimeSeriesBlockSize );
+    CurrentBlock[i] = idx[i] / TimeSeriesBlockSize;
     Offset[i] = idx[i] % TimeSeriesBlockSize;
   }
   unsigned long offset = Offset[0] + Offset[1] * TimeSeriesBlockSize + Offset[2] * TimeSeriesBlockSizeP2;
-  array = ArrayType ( this->m_Dimensions[3] );
-  for ( int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
-    CacheBlock* cache = this->GetCacheBlock ( CurrentBlock, volume );
-    array[volume] = cache->data[offset];
+  array.SetSize ( this->m_Dimensions[3] );
+  CacheBlock Block;
+  for ( unsigned int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
+    this->GetCacheBlock ( this->CalculateIndex ( CurrentBlock, volume ), Block );
+    array[volume] = Block.data[offset];
   }
 }
 
 
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::CalculateBlockIndices ( const typename OutputImageType::RegionType& Region,
+                                                         unsigned int Image,
+                                                         std::deque<unsigned long>& Indices )
+{
+  Size<3> BlockStart, BlockEnd, CurrentBlock;
+  for ( unsigned int i = 0; i < 3; i++ ) {
+    BlockStart[i] = Region.GetIndex(i) / TimeSeriesBlockSize;
+    BlockEnd[i] = ( Region.GetIndex(i) + Region.GetSize(i) + TimeSeriesBlockSize - 1 ) / TimeSeriesBlockSize;
+  }
+  for ( CurrentBlock[2] = BlockStart[2]; CurrentBlock[2] < BlockEnd[2]; CurrentBlock[2]++ ) {
+    for ( CurrentBlock[1] = BlockStart[1]; CurrentBlock[1] < BlockEnd[1]; CurrentBlock[1]++ ) {
+      for ( CurrentBlock[0] = BlockStart[0]; CurrentBlock[0] < BlockEnd[0]; CurrentBlock[0]++ ) {
+        Indices.push_back ( this->CalculateIndex ( CurrentBlock, Image ) );
+      }
+    }
+  }
+}
+
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ScheduleReadAhead ( const typename OutputImageType::RegionType& Region )
+{
+  bool HasPrevious = this->m_PreviousImage >= 0;
+  int PreviousImage = this->m_PreviousImage;
+  typename OutputImageType::RegionType PreviousRegion = this->m_PreviousRegion;
+  this->m_PreviousImage = this->m_CurrentImage;
+  this->m_PreviousRegion = Region;
+  if ( !this->m_ReadAhead || !this->IsOpen() )
+    {
+    return;
+    }
+
+  // Keep scrolling in the same direction until the image goes the other way
+  if ( HasPrevious && (int) this->m_CurrentImage != PreviousImage )
+    {
+    this->m_ReadAheadDirection = (int) this->m_CurrentImage > PreviousImage ? 1 : -1;
+    }
+
+  std::deque<unsigned long> Indices;
+  // The blocks next to the region, when the region moves through the image
+  // (e.g. slice by slice)
+  if ( HasPrevious && Region.GetSize() == PreviousRegion.GetSize() )
+    {
+    for ( unsigned int i = 0; i < 3; i++ )
+      {
+      long delta = Region.GetIndex(i) - PreviousRegion.GetIndex(i);
+      if ( delta == 0 )
+        {
+        continue;
+        }
+      typename OutputImageType::RegionType NextRegion = Region;
+      NextRegion.SetIndex ( i, Region.GetIndex(i) + ( delta > 0 ? 1 : -1 ) * (long) Region.GetSize(i) );
+      if ( NextRegion.Crop ( this->m_OutputRegion ) )
+        {
+        this->CalculateBlockIndices ( NextRegion, this->m_CurrentImage, Indices );
+        }
+      }
+    }
+  // The same region in the next images
+  for ( unsigned int k = 1; k <= this->m_NumberOfReadAheadImages; k++ )
+    {
+    long Image = (long) this->m_CurrentImage + this->m_ReadAheadDirection * (long) k;
+    if ( Image < 0 || Image >= (long) this->m_Dimensions[3] )
+      {
+      break;
+      }
+    this->CalculateBlockIndices ( Region, Image, Indices );
+    }
+
+  // Do not read ahead more than half of the cache, so the blocks being
+  // displayed are not evicted by the blocks read ahead.
+  this->m_CacheLock.Lock();
+  ::size_t MaximumBlocks = this->m_Cache.get_maxsize() / 2;
+  this->m_CacheLock.Unlock();
+  if ( Indices.size() > MaximumBlocks )
+    {
+    Indices.resize ( MaximumBlocks );
+    }
+
+  // Requests for the previous region are obsolete
+  this->m_ReadAheadLock.Lock();
+  this->m_ReadAheadQueue.swap ( Indices );
+  if ( this->m_ReadAheadThreadID < 0 && !this->m_ReadAheadQueue.empty() )
+    {
+    this->m_ReadAheadThreadID = this->m_ReadAheadThreader->SpawnThread ( ReadAheadThreaderCallback, this );
+    }
+  this->m_ReadAheadCondition->Signal();
+  this->m_ReadAheadLock.Unlock();
+}
+
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::StopReadAhead()
+{
+  if ( this->m_ReadAheadThreadID < 0 )
+    {
+    return;
+    }
+  this->m_ReadAheadLock.Lock();
+  this->m_TerminateReadAhead = true;
+  this->m_ReadAheadQueue.clear();
+  this->m_ReadAheadCondition->Broadcast();
+  this->m_ReadAheadLock.Unlock();
+  // Waits for the thread to return
+  this->m_ReadAheadThreader->TerminateThread ( this->m_ReadAheadThreadID );
+  this->m_ReadAheadThreadID = -1;
+  this->m_TerminateReadAhead = false;
+}
+
+
+template <class TPixel>
+ITK_THREAD_RETURN_TYPE TimeSeriesDatabase<TPixel>::ReadAheadThreaderCallback ( void* arg )
+{
+  MultiThreader::ThreadInfoStruct* info = static_cast<MultiThreader::ThreadInfoStruct*> ( arg );
+  Self* self = static_cast<Self*> ( info->UserData );
+  CacheBlock Block;
+
+  self->m_ReadAheadLock.Lock();
+  while ( !self->m_TerminateReadAhead )
+    {
+    if ( self->m_ReadAheadQueue.empty() )
+      {
+      self->m_ReadAheadCondition->Wait ( &self->m_ReadAheadLock );
+      continue;
+      }
+    unsigned long index = self->m_ReadAheadQueue.front();
+    self->m_ReadAheadQueue.pop_front();
+    self->m_ReadAheadLock.Unlock();
+
+    self->m_CacheLock.Lock();
+    bool cached = self->m_Cache.contains ( index );
+    self->m_CacheLock.Unlock();
+    if ( !cached )
+      {
+      self->ReadBlock ( index, Block );
+      self->m_CacheLock.Lock();
+      if ( !self->m_Cache.contains ( index ) )
+        {
+        self->m_Cache.insert ( index, Block );
+        }
+      self->m_CacheLock.Unlock();
+      }
+
+    self->m_ReadAheadLock.Lock();
+    }
+  self->m_ReadAheadLock.Unlock();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
 template <class TPixel>
 void TimeSeriesDatabase<TPixel>::GenerateOutputInformation ( ) 
 {
@@ -261,7 +474,8 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
     }
 
   Size<3> CurrentBlock;
-  // Now, read our data, caching as we go, in future, make this thread safe
+  CacheBlock Buffer;
+  // Now, read our data, caching as we go
   Size<3> BlockSize = { {TimeSeriesBlockSize, TimeSeriesBlockSize, TimeSeriesBlockSize }};
   ImageRegion<3> BlockRegion;
   BlockRegion.SetSize ( BlockSize );
@@ -272,7 +486,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         typename OutputImageType::RegionType BR, IR;
         if ( print ) {  std::cout << "For Block Index: " << CurrentBlock << std::endl; }
         unsigned long index = this->CalculateIndex ( CurrentBlock, this->m_CurrentImage );
-        CacheBlock* Buffer = this->GetCacheBlock ( index );
+        this->GetCacheBlock ( index, Buffer );
         if ( this->CalculateIntersection ( CurrentBlock, Region, BR, IR ) ) {
           // Just iterate over whole block
           // Good we can use an iterator!
@@ -285,7 +499,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
           BlockRegion.SetIndex ( BlockIndex );
           ImageRegionIterator<OutputImageType> it ( output, IR );
           it.GoToBegin();
-          TPixel* ptr = Buffer->data;
+          TPixel* ptr = Buffer.data;
           while ( !it.IsAtEnd() ) {
             it.Set ( *ptr );
             ++it;
@@ -300,7 +514,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
             std::cout << "Count: " << Count << std::endl;
             std::cout << "Block Region: " << BR;
             std::cout << "Image Region: " << IR;
-            std::cout << "First voxel: " << Buffer->data[0] << std::endl;
+            std::cout << "First voxel: " << Buffer.data[0] << std::endl;
           }
           unsigned int bx, by, bz, x, y, z;
           for ( z = 0; z < Count[2]; z++ ) {
@@ -320,7 +534,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
                 }
                 */
 
-                output->SetPixel ( ImageIndex, Buffer->data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
+                output->SetPixel ( ImageIndex, Buffer.data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
                 }
               }
             }
@@ -328,7 +542,9 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         }
       }
     }
-  
+
+  // Get the neighbouring images ready while this one is displayed
+  this->ScheduleReadAhead ( Region );
   return;
 }
   
@@ -552,7 +768,9 @@ void TimeSeriesDatabase<TPixel>::CreateFromFileArchetype ( const char* TSDFilena
 template <class TPixel>
 float TimeSeriesDatabase<TPixel>::GetCacheSizeInMiB() 
 {
+  this->m_CacheLock.Lock();
   unsigned cachesize = this->m_Cache.get_maxsize();
+  this->m_CacheLock.Unlock();
   return (float) cachesize * sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
 }
 
@@ -561,8 +779,10 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 {
   // How many blocks is this?
   double BlockSizeInMiB = sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
-  unsigned long int blocks = (unsigned long int) ceil ( sz * BlockSizeInMiB );
+  unsigned long int blocks = (unsigned long int) ceil ( sz / BlockSizeInMiB );
+  this->m_CacheLock.Lock();
   this->m_Cache.set_maxsize ( blocks );
+  this->m_CacheLock.Unlock();
 }
 
 
@@ -570,12 +790,25 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::TimeSeriesDatabase () : m_Cache ( 1024 ){
   this->m_Dimensions.SetSize ( 4 );
+  this->m_Dimensions.Fill ( 0 );
   this->m_BlocksPerImage.SetSize ( 4 );
+  this->m_CurrentImage = 0;
+  this->m_BlocksPerFile = 1;
+  this->m_UseMemoryMapping = true;
+  this->m_ReadAhead = true;
+  this->m_NumberOfReadAheadImages = 2;
+  this->m_PreviousImage = -1;
+  this->m_ReadAheadDirection = 1;
+  this->m_ReadAheadCondition = ConditionVariable::New();
+  this->m_ReadAheadThreader = MultiThreader::New();
+  this->m_ReadAheadThreadID = -1;
+  this->m_TerminateReadAhead = false;
 }
   
 template <class TPixel>
 TimeSeriesDatabase<TPixel>::~TimeSeriesDatabase () {
   // m_Cache.statistics ( std::cout );
+  this->Disconnect();
 }
   
 
@@ -593,9 +826,18 @@ TimeSeriesDatabase<TPixel>
   os << indent << "OutputRegion: " << m_OutputRegion;
   os << indent << "OutputOrigin: " << m_OutputOrigin << "\n";
   os << indent << "OutputDirection: " << m_OutputDirection << "\n";
+  os << indent << "UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "ReadAhead: " << m_ReadAhead << "\n";
+  os << indent << "NumberOfReadAheadImages: " << m_NumberOfReadAheadImages << "\n";
   if ( this->IsOpen() ) {
     os << indent << "Database is open." << "\n";
     os << indent << "Blocks per file: " << this->m_BlocksPerFile << "\n";
+    ::size_t MappedFiles = 0;
+    for ( ::size_t idx = 0; idx < this->m_MappedFiles.size(); idx++ )
+      {
+      MappedFiles += this->m_MappedFiles[idx].get() ? 1 : 0;
+      }
+    os << indent << "Memory mapped files: " << MappedFiles << "\n";
     os << indent << "File names: " << "\n";
     for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
       {
@@ -605,7 +847,9 @@ TimeSeriesDatabase<TPixel>
     os << indent << "Database is closed." << "\n";
   }
   
+  this->m_CacheLock.Lock();
   this->m_Cache.statistics ( os );
+  this->m_CacheLock.Unlock();
 }
 
 
@@ -0,0 +1,141 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   vtkITK
+
+==========================================================================*/
+
+#include "itkTimeSeriesDatabaseHelper.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace itk {
+  namespace TimeSeriesDatabaseHelper {
+
+//----------------------------------------------------------------------------
+MappedFile::MappedFile()
+  : Data(0), Size(0), CopyOnWrite(false)
+#ifdef _WIN32
+  , FileHandle(INVALID_HANDLE_VALUE), MappingHandle(0)
+#else
+  , FileDescriptor(-1)
+#endif
+{
+}
+
+//----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool MappedFile::Open(const char* filename, bool copyOnWrite)
+{
+  this->Close();
+#ifdef _WIN32
+  this->FileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0,
+                                 OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+  if (this->FileHandle == INVALID_HANDLE_VALUE)
+    {
+    return false;
+    }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(this->FileHandle, &size) || size.QuadPart == 0 ||
+      static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1))
+    {
+    this->Close();
+    return false;
+    }
+  this->MappingHandle = CreateFileMappingA(this->FileHandle, 0,
+    copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+  if (this->MappingHandle == 0)
+    {
+    this->Close();
+    return false;
+    }
+  this->Data = static_cast<char*>(MapViewOfFile(this->MappingHandle,
+    copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+  if (this->Data == 0)
+    {
+    this->Close();
+    return false;
+    }
+  this->Size = static_cast<size_t>(size.QuadPart);
+#else
+  this->FileDescriptor = open(filename, O_RDONLY);
+  if (this->FileDescriptor < 0)
+    {
+    return false;
+    }
+  struct stat info;
+  if (fstat(this->FileDescriptor, &info) != 0 || info.st_size == 0 ||
+      static_cast<unsigned long long>(info.st_size) > static_cast<size_t>(-1))
+    {
+    this->Close();
+    return false;
+    }
+  // Private mappings do not write back to the file
+  void* data = mmap(0, static_cast<size_t>(info.st_size),
+                    copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+                    copyOnWrite ? MAP_PRIVATE : MAP_SHARED,
+                    this->FileDescriptor, 0);
+  if (data == MAP_FAILED)
+    {
+    this->Close();
+    return false;
+    }
+  this->Data = static_cast<char*>(data);
+  this->Size = static_cast<size_t>(info.st_size);
+#endif
+  this->CopyOnWrite = copyOnWrite;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+  if (this->Data)
+    {
+    UnmapViewOfFile(this->Data);
+    }
+  if (this->MappingHandle)
+    {
+    CloseHandle(this->MappingHandle);
+    }
+  if (this->FileHandle != INVALID_HANDLE_VALUE)
+    {
+    CloseHandle(this->FileHandle);
+    }
+  this->FileHandle = INVALID_HANDLE_VALUE;
+  this->MappingHandle = 0;
+#else
+  if (this->Data)
+    {
+    munmap(this->Data, this->Size);
+    }
+  if (this->FileDescriptor >= 0)
+    {
+    close(this->FileDescriptor);
+    }
+  this->FileDescriptor = -1;
+#endif
+  this->Data = 0;
+  this->Size = 0;
+  this->CopyOnWrite = false;
+}
+
+  }
+}
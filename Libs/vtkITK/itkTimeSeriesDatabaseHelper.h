@@ -7,6 +7,8 @@
 #include <cstdarg>
 #include <cassert>
 
+#include "vtkITKWin32Header.h"
+
 namespace itk {
   namespace TimeSeriesDatabaseHelper {
     /// Some useful classes
@@ -234,6 +236,16 @@ namespace itk {
         return &(ti->second.value);
       }
 
+      /// Is a key in the cache ?
+      ///
+      /// Unlike find(), the LRU order and the statistics are not
+      /// modified.
+      ///
+      bool contains(const key_type& key) const
+      {
+        return table.find(key) != table.end();
+      }
+
       /// Dumps the cache to output.
       ///
       /// Useful for debugging. Expects key/value types to have
@@ -356,6 +368,49 @@ namespace itk {
       } stats;
 #endif
     };
+
+    /// Memory mapping of a whole file.
+    ///
+    /// The file is never modified: the mapping is either read only or
+    /// copy-on-write, in which case written pages become private copies.
+    /// Open() fails when the platform does not support memory mapping
+    /// or when the file does not fit in the address space; the caller
+    /// is expected to fall back to regular stream reads.
+    class VTK_ITK_EXPORT MappedFile
+      {
+      public:
+        MappedFile();
+        ~MappedFile();
+
+        /// Map the file. Return true on success.
+        bool Open(const char* filename, bool copyOnWrite = false);
+        /// Unmap the file.
+        void Close();
+
+        bool IsOpen() const { return this->Data != 0; }
+        /// Pointer to the first byte of the file, 0 if not mapped.
+        const char* GetData() const { return this->Data; }
+        /// Writable pointer to the first byte of the file, 0 if the file
+        /// is not mapped copy-on-write.
+        char* GetCopyOnWriteData() const
+          { return this->CopyOnWrite ? this->Data : 0; }
+        /// Size of the file in bytes.
+        size_t GetSize() const { return this->Size; }
+
+      private:
+        MappedFile(const MappedFile&); /// Not implemented.
+        void operator=(const MappedFile&); /// Not implemented.
+
+        char* Data;
+        size_t Size;
+        bool CopyOnWrite;
+#ifdef _WIN32
+        void* FileHandle;
+        void* MappingHandle;
+#else
+        int FileDescriptor;
+#endif
+      };
   }
 }
 #endif
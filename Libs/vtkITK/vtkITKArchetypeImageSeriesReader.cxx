@@ -25,9 +25,14 @@
 #include <itkMetaDataDictionary.h>
 #include <itkMetaDataObjectBase.h>
 #include <itkMetaDataObject.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
 #include <itkTimeProbe.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <vector>
 
 // Commented out redefinition of ExceptionMacro
@@ -914,13 +919,499 @@ void vtkITKArchetypeImageSeriesReader::GroupFiles ( int idxSeriesInstanceUID,
   return;
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+// Size of the grid cells used to index the directions of vectors. The
+// normalized vectors of two directions whose dot product is larger than
+// 0.99999 are less than sqrt(2*(1-0.99999)) = 0.00447 apart: they are in
+// the same or in neighbor cells.
+const double DirectionCellSize = 0.005;
+
+//----------------------------------------------------------------------------
+// Remove the trailing spaces and null characters DICOM pads values with.
+std::string UnpaddedTagValue(const char* value)
+{
+  std::string unpadded(value);
+  std::string::size_type end = unpadded.find_last_not_of(std::string(" \0", 2));
+  unpadded.erase(end == std::string::npos ? 0 : end + 1);
+  return unpadded;
+}
+
+//----------------------------------------------------------------------------
+// Compute the grid cell of the direction of v (or -v if sign < 0).
+// Return false if v has no direction (null, infinite or NaN components),
+// such vectors never match any other.
+bool DirectionCell(const float* v, int sign, std::vector<int>& cell)
+{
+  double norm = sqrt(static_cast<double>(v[0])*v[0] +
+                     static_cast<double>(v[1])*v[1] +
+                     static_cast<double>(v[2])*v[2]);
+  if (!(norm > 0.) || !(norm < VTK_DOUBLE_MAX))
+    {
+    return false;
+    }
+  cell.resize(3);
+  for (int i = 0; i < 3; ++i)
+    {
+    cell[i] = static_cast<int>(floor(sign * v[i] / norm / DirectionCellSize));
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void AddDirection(std::map<std::vector<int>, std::vector<int> >& index,
+                  const float* v, int k)
+{
+  std::vector<int> cell;
+  if (DirectionCell(v, 1, cell))
+    {
+    index[cell].push_back(k);
+    }
+}
+
+//----------------------------------------------------------------------------
+// List by increasing index the vectors of the cells neighbor to the
+// direction of v (and of -v if bothSigns is true).
+void DirectionCandidates(const std::map<std::vector<int>, std::vector<int> >& index,
+                         const float* v, bool bothSigns,
+                         std::vector<int>& candidates)
+{
+  candidates.clear();
+  for (int sign = 1; sign >= (bothSigns ? -1 : 1); sign -= 2)
+    {
+    std::vector<int> center;
+    if (!DirectionCell(v, sign, center))
+      {
+      return;
+      }
+    std::vector<int> cell(3);
+    for (int i = -1; i <= 1; ++i)
+      {
+      for (int j = -1; j <= 1; ++j)
+        {
+        for (int k = -1; k <= 1; ++k)
+          {
+          cell[0] = center[0] + i;
+          cell[1] = center[1] + j;
+          cell[2] = center[2] + k;
+          std::map<std::vector<int>, std::vector<int> >::const_iterator it =
+            index.find(cell);
+          if (it != index.end())
+            {
+            candidates.insert(candidates.end(),
+                              it->second.begin(), it->second.end());
+            }
+          }
+        }
+      }
+    }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+}
+
+//----------------------------------------------------------------------------
+int FindString(const std::map<std::string, int>& index, const char* value)
+{
+  std::map<std::string, int>::const_iterator it =
+    index.find(UnpaddedTagValue(value));
+  return it != index.end() ? it->second : -1;
+}
+
+//----------------------------------------------------------------------------
+int InsertString(std::vector<std::string>& values,
+                 std::map<std::string, int>& index, const char* value)
+{
+  int k = FindString(index, value);
+  if ( k >= 0 )
+    {
+    return k;
+    }
+  values.push_back( std::string(value) );
+  k = static_cast<int>(values.size()) - 1;
+  index[UnpaddedTagValue(value)] = k;
+  return k;
+}
+
+//----------------------------------------------------------------------------
+// Tag values of a file, read by the header parsing threads.
+struct FileHeader
+{
+  FileHeader() : Read(false), IsImage(false) {}
+  bool Read;
+  /// DICOM tags
+  std::string SeriesInstanceUID;
+  std::string ContentTime;
+  std::string TriggerTime;
+  std::string EchoNumbers;
+  std::string DiffusionGradientOrientation;
+  std::string SliceLocation;
+  std::string ImageOrientationPatient;
+  std::string ImagePositionPatient;
+  /// Non DICOM files
+  bool IsImage;
+  float Origin[3];
+  float Orientation[6];
+  std::string IOType;
+};
+
+//----------------------------------------------------------------------------
+struct HeaderParsing
+{
+  const std::vector<std::string>* FileNames;
+  bool IsDicom;
+  std::vector<FileHeader> Headers;
+  /// Errors of the files that could not be read, in file order.
+  std::map<int, itk::ExceptionObject> Errors;
+  itk::SimpleFastMutexLock ErrorsLock;
+};
+
+//----------------------------------------------------------------------------
+void ReadFileHeader(HeaderParsing* parsing, itk::GDCMImageIO* gdcmIO, int f)
+{
+  typedef itk::Image<float,3> ImageType;
+  FileHeader& header = parsing->Headers[f];
+  const std::string& fileName = (*parsing->FileNames)[f];
+  if (!parsing->IsDicom)
+    {
+    itk::ImageFileReader<ImageType>::Pointer imageReader =
+      itk::ImageFileReader<ImageType>::New();
+    imageReader->SetFileName( fileName );
+    imageReader->UpdateOutputInformation();
+    ImageType::PointType origin = imageReader->GetOutput()->GetOrigin();
+    ImageType::DirectionType orientation = imageReader->GetOutput()->GetDirection();
+    for (int k = 0; k < 3; k++)
+      {
+      header.Origin[k] = origin[k];
+      header.Orientation[k] = orientation[0][k];
+      header.Orientation[k+3] = orientation[1][k];
+      }
+    header.IOType = imageReader->GetImageIO()->GetNameOfClass();
+    header.IsImage = true;
+    header.Read = true;
+    return;
+    }
+
+  gdcmIO->SetFileName( fileName );
+  gdcmIO->ReadImageInformation();
+  itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
+  itk::ExposeMetaData<std::string>( dict, "0020|000e", header.SeriesInstanceUID );
+  itk::ExposeMetaData<std::string>( dict, "0008|0033", header.ContentTime );
+  itk::ExposeMetaData<std::string>( dict, "0018|1060", header.TriggerTime );
+  itk::ExposeMetaData<std::string>( dict, "0018|0086", header.EchoNumbers );
+  itk::ExposeMetaData<std::string>( dict, "0010|9089", header.DiffusionGradientOrientation );
+  itk::ExposeMetaData<std::string>( dict, "0020|1041", header.SliceLocation );
+  itk::ExposeMetaData<std::string>( dict, "0020|0037", header.ImageOrientationPatient );
+  itk::ExposeMetaData<std::string>( dict, "0020|0032", header.ImagePositionPatient );
+  header.Read = true;
+}
+
+//----------------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE ReadFileHeadersThreaderCallback( void *arg )
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    reinterpret_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  HeaderParsing* parsing = reinterpret_cast<HeaderParsing*>(info->UserData);
+  itk::GDCMImageIO::Pointer gdcmIO = itk::GDCMImageIO::New();
+  int nFiles = static_cast<int>(parsing->Headers.size());
+  // Interleave the files between the threads: headers of a series are
+  // usually the same size.
+  for (int f = info->ThreadID; f < nFiles;
+       f += static_cast<int>(info->NumberOfThreads))
+    {
+    try
+      {
+      ReadFileHeader(parsing, gdcmIO, f);
+      }
+    catch (itk::ExceptionObject& exception)
+      {
+      parsing->ErrorsLock.Lock();
+      parsing->Errors[f] = exception;
+      parsing->ErrorsLock.Unlock();
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::ResetDicomTags(bool resetImagePositionPatient)
+{
+  this->SeriesInstanceUIDs.resize( 0 );
+  this->ContentTime.resize( 0 );
+  this->TriggerTime.resize( 0 );
+  this->EchoNumbers.resize( 0 );
+  this->DiffusionGradientOrientation.resize( 0 );
+  this->SliceLocation.resize( 0 );
+  this->ImageOrientationPatient.resize( 0 );
+
+  this->SeriesInstanceUIDsIndex.clear();
+  this->ContentTimeIndex.clear();
+  this->TriggerTimeIndex.clear();
+  this->EchoNumbersIndex.clear();
+  this->DiffusionGradientOrientationIndex.clear();
+  this->SliceLocationIndex.clear();
+  this->ImageOrientationPatientIndex.clear();
+
+  if (resetImagePositionPatient)
+    {
+    this->ImagePositionPatient.resize( 0 );
+    this->ImagePositionPatientIndex.clear();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistSeriesInstanceUID( const char* SeriesInstanceUID )
+{
+  return FindString(this->SeriesInstanceUIDsIndex, SeriesInstanceUID);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistContentTime( const char* contentTime )
+{
+  return FindString(this->ContentTimeIndex, contentTime);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistTriggerTime( const char* triggerTime )
+{
+  return FindString(this->TriggerTimeIndex, triggerTime);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistEchoNumbers( const char* echoNumbers )
+{
+  return FindString(this->EchoNumbersIndex, echoNumbers);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistDiffusionGradientOrientation( float* dgo )
+{
+  float a = 0;
+  for (int n = 0; n < 3; n++)
+    {
+    a += dgo[n]*dgo[n];
+    }
+
+  std::vector<int> candidates;
+  DirectionCandidates(this->DiffusionGradientOrientationIndex, dgo, true, candidates);
+  for (std::vector<int>::const_iterator it = candidates.begin();
+       it != candidates.end(); ++it)
+    {
+    int k = *it;
+    float b = 0;
+    float c = 0;
+    for (int n = 0; n < 3; n++)
+      {
+      b += this->DiffusionGradientOrientation[k][n] * this->DiffusionGradientOrientation[k][n];
+      c += this->DiffusionGradientOrientation[k][n] * dgo[n];
+      }
+    c = fabs(c)/sqrt(a*b);
+
+    if ( c > 0.99999 )
+      {
+      return k;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistSliceLocation( float sliceLocation )
+{
+  // NaN never equals any location
+  if (sliceLocation != sliceLocation)
+    {
+    return -1;
+    }
+  std::map<float, int>::const_iterator it =
+    this->SliceLocationIndex.find(sliceLocation);
+  return it != this->SliceLocationIndex.end() ? it->second : -1;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistImageOrientationPatient( float * directionCosine )
+{
+  /// input has to have six elements
+  float a = sqrt( directionCosine[0]*directionCosine[0] + directionCosine[1]*directionCosine[1] + directionCosine[2]*directionCosine[2] );
+  for (int k = 0; k < 3; k++)
+    {
+    directionCosine[k] /= a;
+    }
+  a = sqrt( directionCosine[3]*directionCosine[3] + directionCosine[4]*directionCosine[4] + directionCosine[5]*directionCosine[5] );
+  for (int k = 3; k < 6; k++)
+    {
+    directionCosine[k] /= a;
+    }
+
+  // The first direction cosine must match
+  std::vector<int> candidates;
+  DirectionCandidates(this->ImageOrientationPatientIndex, directionCosine, false, candidates);
+  for (std::vector<int>::const_iterator it = candidates.begin();
+       it != candidates.end(); ++it)
+    {
+    const std::vector<float>& aVec = this->ImageOrientationPatient[*it];
+    a = sqrt( aVec[0]*aVec[0] + aVec[1]*aVec[1] + aVec[2]*aVec[2] );
+    float b = (directionCosine[0]*aVec[0] + directionCosine[1]*aVec[1] + directionCosine[2]*aVec[2])/a;
+    if ( b < 0.99999 )
+      {
+      continue;
+      }
+
+    a = sqrt( aVec[3]*aVec[3] + aVec[4]*aVec[4] + aVec[5]*aVec[5] );
+    b = (directionCosine[3]*aVec[3] + directionCosine[4]*aVec[4] + directionCosine[5]*aVec[5])/a;
+    if ( b > 0.99999 )
+      {
+      return *it;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::ExistImagePositionPatient( float* ipp )
+{
+  float a = 0;
+  for (int n = 0; n < 3; n++)
+    {
+    a += ipp[n]*ipp[n];
+    }
+
+  std::vector<int> candidates;
+  DirectionCandidates(this->ImagePositionPatientIndex, ipp, true, candidates);
+  for (std::vector<int>::const_iterator it = candidates.begin();
+       it != candidates.end(); ++it)
+    {
+    int k = *it;
+    float b = 0;
+    float c = 0;
+    for (int n = 0; n < 3; n++)
+      {
+      b += this->ImagePositionPatient[k][n] * this->ImagePositionPatient[k][n];
+      c += this->ImagePositionPatient[k][n] * ipp[n];
+      }
+    c = fabs(c)/sqrt(a*b);
+    if ( c > 0.99999 )
+      {
+      return k;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertSeriesInstanceUIDs ( const char * aUID )
+{
+  return InsertString(this->SeriesInstanceUIDs, this->SeriesInstanceUIDsIndex, aUID);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertContentTime ( const char * aTime )
+{
+  return InsertString(this->ContentTime, this->ContentTimeIndex, aTime);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertTriggerTime ( const char * aTime )
+{
+  return InsertString(this->TriggerTime, this->TriggerTimeIndex, aTime);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertEchoNumbers ( const char * aEcho )
+{
+  return InsertString(this->EchoNumbers, this->EchoNumbersIndex, aEcho);
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertDiffusionGradientOrientation ( float *a )
+{
+  int k = ExistDiffusionGradientOrientation( a );
+  if ( k >= 0 )
+    {
+    return k;
+    }
+  std::vector< float > aVector(3);
+  float aMag = sqrt(a[0]*a[0]+a[1]*a[1]+a[2]*a[2]);
+  for (k = 0; k < 3; k++)
+    {
+    aVector[k] = a[k]/aMag;
+    }
+
+  this->DiffusionGradientOrientation.push_back( aVector );
+  k = this->DiffusionGradientOrientation.size()-1;
+  AddDirection(this->DiffusionGradientOrientationIndex, &aVector[0], k);
+  return k;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertSliceLocation ( float a )
+{
+  int k = ExistSliceLocation( a );
+  if ( k >= 0 )
+    {
+    return k;
+    }
+
+  this->SliceLocation.push_back( a );
+  k = this->SliceLocation.size()-1;
+  if (a == a)
+    {
+    this->SliceLocationIndex[a] = k;
+    }
+  return k;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertImageOrientationPatient ( float *a )
+{
+  int k = ExistImageOrientationPatient( a );
+  if ( k >= 0 )
+    {
+    return k;
+    }
+  std::vector< float > aVector(6);
+  float aMag = sqrt(a[0]*a[0]+a[1]*a[1]+a[2]*a[2]);
+  float bMag = sqrt(a[3]*a[3]+a[4]*a[4]+a[5]*a[5]);
+  for (k = 0; k < 3; k++)
+    {
+    aVector[k] = a[k]/aMag;
+    aVector[k+3] = a[k+3]/bMag;
+    }
+
+  this->ImageOrientationPatient.push_back( aVector );
+  k = this->ImageOrientationPatient.size()-1;
+  AddDirection(this->ImageOrientationPatientIndex, &aVector[0], k);
+  return k;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::InsertImagePositionPatient ( float *a )
+{
+  int k = ExistImagePositionPatient( a );
+  if ( k >= 0 )
+    {
+    return k;
+    }
+
+  std::vector< float > aVector(3);
+  for ( unsigned int i = 0; i < 3; i++ ) aVector[i] = a[i];
+  this->ImagePositionPatient.push_back( aVector );
+  k = this->ImagePositionPatient.size()-1;
+  AddDirection(this->ImagePositionPatientIndex, &aVector[0], k);
+  return k;
+}
+
+//----------------------------------------------------------------------------
 void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
 {
   itk::TimeProbe AnalyzeTime;
   AnalyzeTime.Start();
 
   int nFiles = this->AllFileNames.size();
-  typedef itk::Image<float,3> ImageType;
 
   this->IndexSeriesInstanceUIDs.resize( nFiles );
   this->IndexContentTime.resize( nFiles );
@@ -931,25 +1422,41 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
   this->IndexImageOrientationPatient.resize( nFiles );
   this->IndexImagePositionPatient.resize( nFiles );
 
-  this->SeriesInstanceUIDs.resize( 0 );
-  this->ContentTime.resize( 0 );
-  this->TriggerTime.resize( 0 );
-  this->EchoNumbers.resize( 0 );
-  this->DiffusionGradientOrientation.resize( 0 );
-  this->SliceLocation.resize( 0 );
-  this->ImageOrientationPatient.resize( 0 );
-  this->ImagePositionPatient.resize( 0 );
-
+  this->ResetDicomTags();
 
+  // Read the headers in parallel, the grouping is done afterward in the
+  // file order so that the discriminators are indexed as if the headers were
+  // read one after the other. GDCM 1 (ITK 3) shares global state (the
+  // dictionaries and the document parser) between the readers and is not
+  // thread-safe: the headers are read by a single thread.
   itk::GDCMImageIO::Pointer gdcmIO = itk::GDCMImageIO::New();
-  if ( !gdcmIO->CanReadFile(this->Archetype) )
+  HeaderParsing parsing;
+  parsing.FileNames = &this->AllFileNames;
+  parsing.IsDicom = gdcmIO->CanReadFile(this->Archetype);
+  parsing.Headers.resize( nFiles );
+  if (nFiles > 0)
+    {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+#if ITK_VERSION_MAJOR < 4
+    threader->SetNumberOfThreads(1);
+#else
+    threader->SetNumberOfThreads(
+      std::min(static_cast<int>(threader->GetNumberOfThreads()), nFiles));
+#endif
+    threader->SetSingleMethod(ReadFileHeadersThreaderCallback, &parsing);
+    threader->SingleMethodExecute();
+    }
+  // Report the error of the first file that could not be read
+  if (!parsing.Errors.empty())
+    {
+    throw parsing.Errors.begin()->second;
+    }
+
+  if ( !parsing.IsDicom )
   {
     for (int f = 0; f < nFiles; f++)
     {
-      itk::ImageFileReader<ImageType>::Pointer imageReader =
-        itk::ImageFileReader<ImageType>::New();
-      imageReader->SetFileName( this->AllFileNames[f] );
-      imageReader->UpdateOutputInformation();
+      const FileHeader& header = parsing.Headers[f];
 
       // insert series 
       int idx = InsertSeriesInstanceUIDs( "Non-Dicom Series" );
@@ -962,8 +1469,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexDiffusionGradientOrientation[f] = -1;
 
       // Slice Location
-      ImageType::PointType origin = imageReader->GetOutput()->GetOrigin();
-      std::string IOType = imageReader->GetImageIO()->GetNameOfClass();
+      const std::string& IOType = header.IOType;
       if( IOType.find("BPMImageIO") == std::string::npos ||
           IOType.find("JPEGImageIO") == std::string::npos ||
           IOType.find("PNGImageIO") == std::string::npos ||
@@ -975,17 +1481,15 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
       else
       {
-        idx = InsertSliceLocation( origin[2] );
+        idx = InsertSliceLocation( header.Origin[2] );
         this->IndexSliceLocation[f] = idx;    
       }
 
       // Orientation
-      ImageType::DirectionType orientation = imageReader->GetOutput()->GetDirection();
       float a[6];
-      for (int k = 0; k < 3; k++)
+      for (int k = 0; k < 6; k++)
       {
-        a[k] = orientation[0][k];
-        a[k+3] = orientation[1][k];
+        a[k] = header.Orientation[k];
       }
       idx = InsertImageOrientationPatient( a );
       this->IndexImageOrientationPatient[f] = idx;    
@@ -994,19 +1498,14 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
   }
 
   // if Archetype is a Dicom File
-  gdcmIO->SetFileName( this->Archetype );
   for (int f = 0; f < nFiles; f++)
   {
-    gdcmIO->SetFileName( this->AllFileNames[f] );
-    gdcmIO->ReadImageInformation();
-    itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
-    std::string tagValue;
+    const FileHeader& header = parsing.Headers[f];
 
     // series instance UID
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|000e", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.SeriesInstanceUID.length() > 0 )
     {
-      int idx = InsertSeriesInstanceUIDs( tagValue.c_str() );
+      int idx = InsertSeriesInstanceUIDs( header.SeriesInstanceUID.c_str() );
       this->IndexSeriesInstanceUIDs[f] = idx;
     }
     else
@@ -1015,10 +1514,9 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // content time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0008|0033", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.ContentTime.length() > 0 )
     {
-      int idx = InsertContentTime( tagValue.c_str() );
+      int idx = InsertContentTime( header.ContentTime.c_str() );
       this->IndexContentTime[f] = idx;
     }
     else
@@ -1027,10 +1525,9 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // trigger time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|1060", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.TriggerTime.length() > 0 )
     {
-      int idx = InsertTriggerTime( tagValue.c_str() );
+      int idx = InsertTriggerTime( header.TriggerTime.c_str() );
       this->IndexTriggerTime[f] = idx;
     }
     else
@@ -1039,10 +1536,9 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // echo numbers
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|0086", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.EchoNumbers.length() > 0 )
     {
-      int idx = InsertEchoNumbers( tagValue.c_str() );
+      int idx = InsertEchoNumbers( header.EchoNumbers.c_str() );
       this->IndexEchoNumbers[f] = idx;
     }
     else
@@ -1051,11 +1547,10 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
     
     // diffision gradient orientation
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0010|9089", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.DiffusionGradientOrientation.length() > 0 )
     {
       float a[3];
-      sscanf( tagValue.c_str(), "%f\\%f\\%f", a, a+1, a+2 );
+      sscanf( header.DiffusionGradientOrientation.c_str(), "%f\\%f\\%f", a, a+1, a+2 );
       int idx = InsertDiffusionGradientOrientation( a );
       this->IndexDiffusionGradientOrientation[f] = idx;
     }
@@ -1065,11 +1560,10 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // slice location
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|1041", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.SliceLocation.length() > 0 )
     {
       float a;
-      sscanf( tagValue.c_str(), "%f", &a );
+      sscanf( header.SliceLocation.c_str(), "%f", &a );
       int idx = InsertSliceLocation( a );
       this->IndexSliceLocation[f] = idx;
     }
@@ -1079,11 +1573,10 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // image orientation patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0037", tagValue );
-    if ( tagValue.length() > 0 )
+    if ( header.ImageOrientationPatient.length() > 0 )
     {
       float a[6];
-      sscanf( tagValue.c_str(), "%f\\%f\\%f\\%f\\%f\\%f", a, a+1, a+2, a+3, a+4, a+5 );
+      sscanf( header.ImageOrientationPatient.c_str(), "%f\\%f\\%f\\%f\\%f\\%f", a, a+1, a+2, a+3, a+4, a+5 );
       int idx = InsertImageOrientationPatient( a );
       this->IndexImageOrientationPatient[f] = idx;
     }
@@ -1092,11 +1585,10 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexImageOrientationPatient[f] = -1;
     }
     // image position patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0032", tagValue );
-    if( tagValue.length() > 0 )
+    if( header.ImagePositionPatient.length() > 0 )
     {
         float a[3];
-        sscanf( tagValue.c_str(), "%f\\%f\\%f", a, a+1, a+2 );
+        sscanf( header.ImagePositionPatient.c_str(), "%f\\%f\\%f", a, a+1, a+2 );
         int idx = InsertImagePositionPatient( a );
         this->IndexImagePositionPatient[f] = idx;
     }
@@ -1214,13 +1706,7 @@ void vtkITKArchetypeImageSeriesReader::ResetFileNames( )
 {
   this->FileNames.resize( 0 );
   this->AllFileNames.resize( 0 );
-  this->SeriesInstanceUIDs.resize( 0 );
-  this->ContentTime.resize( 0 );
-  this->TriggerTime.resize( 0 );
-  this->EchoNumbers.resize( 0 );
-  this->DiffusionGradientOrientation.resize( 0 );
-  this->SliceLocation.resize( 0 );
-  this->ImageOrientationPatient.resize( 0 );
+  this->ResetDicomTags(false);
 }
 
 int vtkITKArchetypeImageSeriesReader::AssembleVolumeContainingArchetype( )
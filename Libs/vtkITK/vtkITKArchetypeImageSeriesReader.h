@@ -27,6 +27,7 @@ class vtkMatrix4x4;
 #include "itkSpatialOrientation.h"
 
 // STD includes
+#include <map>
 #include <string>
 #include <vector>
 
@@ -410,153 +411,23 @@ public:
     }
 
   /// check the existance of given discriminator
-  int ExistSeriesInstanceUID( const char* SeriesInstanceUID )
-    {
-    for (unsigned int k = 0; k < GetNumberOfSeriesInstanceUIDs(); k++)
-      {
-      if ( this->SeriesInstanceUIDs[k].find(SeriesInstanceUID) != std::string::npos )
-        {
-        return k;
-        }
-      }
-    return -1;
-    }
-
-  int ExistContentTime( const char* contentTime )
-    {
-      for (unsigned int k = 0; k < GetNumberOfContentTime(); k++)
-        {
-        if ( this->ContentTime[k].find(contentTime) != std::string::npos )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
-
-  int ExistTriggerTime( const char* triggerTime )
-    {
-      for (unsigned int k = 0; k < GetNumberOfTriggerTime(); k++)
-        {
-        if ( this->TriggerTime[k].find(triggerTime) != std::string::npos )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
-
-  int ExistEchoNumbers( const char* echoNumbers )
-    {
-      for (unsigned int k = 0; k < GetNumberOfEchoNumbers(); k++)
-        {
-        if ( this->EchoNumbers[k].find(echoNumbers) != std::string::npos )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
+  /// Values are looked up in sorted lookup tables (std::map, see the *Index
+  /// members) instead of being compared with all the values previously inserted.
+  /// Tag strings match when they are equal once trailing spaces and null
+  /// characters (DICOM padding) are removed. Vectors match when their
+  /// directions are within the same tolerance as before (dot product of the
+  /// normalized vectors larger than 0.99999); the first inserted match is
+  /// returned.
+  int ExistSeriesInstanceUID( const char* SeriesInstanceUID );
+  int ExistContentTime( const char* contentTime );
+  int ExistTriggerTime( const char* triggerTime );
+  int ExistEchoNumbers( const char* echoNumbers );
+  int ExistDiffusionGradientOrientation( float* dgo );
+  int ExistSliceLocation( float sliceLocation );
+  /// directionCosine is normalized in place.
+  int ExistImageOrientationPatient( float * directionCosine );
+  int ExistImagePositionPatient( float* ipp );
 
-  int ExistDiffusionGradientOrientation( float* dgo )
-    {
-      float a = 0;
-      for (int n = 0; n < 3; n++)
-        {
-        a += dgo[n]*dgo[n];
-        }
-      
-      for (unsigned int k = 0; k < GetNumberOfDiffusionGradientOrientation(); k++)
-        {
-        float b = 0;
-        float c = 0;
-        for (int n = 0; n < 3; n++)
-          {
-          b += this->DiffusionGradientOrientation[k][n] * this->DiffusionGradientOrientation[k][n];
-          c += this->DiffusionGradientOrientation[k][n] * dgo[n];
-          }
-        c = fabs(c)/sqrt(a*b);
-        
-        if ( c > 0.99999 )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
-
-  int ExistSliceLocation( float sliceLocation )
-    {
-      for (unsigned int k = 0; k < GetNumberOfSliceLocation(); k++)
-        {
-        if ( this->SliceLocation[k] == sliceLocation )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
-
-  int ExistImageOrientationPatient( float * directionCosine )
-    {
-      /// input has to have six elements
-      float a = sqrt( directionCosine[0]*directionCosine[0] + directionCosine[1]*directionCosine[1] + directionCosine[2]*directionCosine[2] );
-      for (int k = 0; k < 3; k++)
-        {
-        directionCosine[k] /= a;
-        }
-      a = sqrt( directionCosine[3]*directionCosine[3] + directionCosine[4]*directionCosine[4] + directionCosine[5]*directionCosine[5] );
-      for (int k = 3; k < 6; k++)
-        {
-        directionCosine[k] /= a;
-        }
-      
-      for (unsigned int k = 0; k < GetNumberOfImageOrientationPatient(); k++)
-        {
-        std::vector<float> aVec = ImageOrientationPatient[k];
-        a = sqrt( aVec[0]*aVec[0] + aVec[1]*aVec[1] + aVec[2]*aVec[2] );
-        float b = (directionCosine[0]*aVec[0] + directionCosine[1]*aVec[1] + directionCosine[2]*aVec[2])/a;
-        if ( b < 0.99999 )
-          {
-          continue;
-          }
-
-        a = sqrt( aVec[3]*aVec[3] + aVec[4]*aVec[4] + aVec[5]*aVec[5] );
-        b = (directionCosine[3]*aVec[3] + directionCosine[4]*aVec[4] + directionCosine[5]*aVec[5])/a;
-        if ( b > 0.99999 )
-          {
-          return k;
-          } 
-        }
-      return -1;
-    }
-  
-  int ExistImagePositionPatient( float* ipp )
-    {
-      float a = 0;
-      for (int n = 0; n < 3; n++)
-        {
-        a += ipp[n]*ipp[n];
-        }
-
-      for (unsigned int k = 0; k < GetNumberOfImagePositionPatient(); k++)
-        {
-        float b = 0;
-        float c = 0;
-        for (int n = 0; n < 3; n++)
-          {
-          b += this->ImagePositionPatient[k][n] * this->ImagePositionPatient[k][n];
-          c += this->ImagePositionPatient[k][n] * ipp[n];
-          }
-        c = fabs(c)/sqrt(a*b);
-        if ( c > 0.99999 )
-          {
-          return k;
-          }
-        }
-      return -1;
-    }
-    
   /// methods to get N-th discriminator
   const char* GetNthSeriesInstanceUID( unsigned int n )
     {
@@ -647,122 +518,17 @@ public:
 
   /// insert unique item into array. Duplicate code for TCL wrapping. 
   /// TODO: need to clean up
-  int InsertSeriesInstanceUIDs ( const char * aUID )
-    {
-      int k = ExistSeriesInstanceUID( aUID );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      
-      std::string aVector(aUID);
-      this->SeriesInstanceUIDs.push_back( aVector );
-      return (this->SeriesInstanceUIDs.size()-1);
-    }
-
-  int InsertContentTime ( const char * aTime )
-    {
-      int k = ExistContentTime( aTime );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      
-      std::string aVector(aTime);
-      this->ContentTime.push_back( aVector );
-      return (this->ContentTime.size()-1);
-    }
-
-  int InsertTriggerTime ( const char * aTime )
-    {
-      int k = ExistTriggerTime( aTime );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      
-      std::string aVector(aTime);
-      this->TriggerTime.push_back( aVector );
-      return (this->TriggerTime.size()-1);
-    }
-
-  int InsertEchoNumbers ( const char * aEcho )
-    {
-      int k = ExistEchoNumbers( aEcho );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      
-      std::string aVector(aEcho);
-      this->EchoNumbers.push_back( aVector );
-      return (this->EchoNumbers.size()-1);
-    }
-  
-  int InsertDiffusionGradientOrientation ( float *a )
-    {
-      int k = ExistDiffusionGradientOrientation( a );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      std::vector< float > aVector(3);
-      float aMag = sqrt(a[0]*a[0]+a[1]*a[1]+a[2]*a[2]);
-      for (k = 0; k < 3; k++)
-        {
-        aVector[k] = a[k]/aMag;
-        }
-      
-      this->DiffusionGradientOrientation.push_back( aVector );
-      return (this->DiffusionGradientOrientation.size()-1);
-    }
-
-  int InsertSliceLocation ( float a )
-    {
-      int k = ExistSliceLocation( a );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-
-      this->SliceLocation.push_back( a );
-      return (this->SliceLocation.size()-1);
-    }
-
-  int InsertImageOrientationPatient ( float *a )
-    {
-      int k = ExistImageOrientationPatient( a );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      std::vector< float > aVector(6);
-      float aMag = sqrt(a[0]*a[0]+a[1]*a[1]+a[2]*a[2]);
-      float bMag = sqrt(a[3]*a[3]+a[4]*a[4]+a[5]*a[5]);
-      for (k = 0; k < 3; k++)
-        {
-        aVector[k] = a[k]/aMag;
-        aVector[k+3] = a[k+3]/bMag;
-        }
-
-      this->ImageOrientationPatient.push_back( aVector );
-      return (this->ImageOrientationPatient.size()-1);
-    }
-
-  int InsertImagePositionPatient ( float *a )
-    {
-      int k = ExistImagePositionPatient( a );
-      if ( k >= 0 )
-        {
-        return k;
-        }
-      
-      std::vector< float > aVector(3);
-      for ( unsigned int i = 0; i < 3; i++ ) aVector[i] = a[i]; 
-      this->ImagePositionPatient.push_back( aVector );
-      return (this->ImagePositionPatient.size()-1);
-    }
-
+  int InsertSeriesInstanceUIDs ( const char * aUID );
+  int InsertContentTime ( const char * aTime );
+  int InsertTriggerTime ( const char * aTime );
+  int InsertEchoNumbers ( const char * aEcho );
+  int InsertDiffusionGradientOrientation ( float *a );
+  int InsertSliceLocation ( float a );
+  int InsertImageOrientationPatient ( float *a );
+  int InsertImagePositionPatient ( float *a );
+
+  /// Read the headers of AllFileNames (in parallel) and group the files by
+  /// their discriminators.
   void AnalyzeDicomHeaders( );
 
   void AssembleNthVolume( int n );
@@ -871,6 +637,23 @@ protected:
   std::vector<long int> IndexImageOrientationPatient;
   std::vector<long int> IndexImagePositionPatient;
 
+  /// Lookup tables (std::map) of the above arrays used by the Exist methods.
+  /// Strings are indexed by their value without padding, directions by the
+  /// grid cell of their normalized vector.
+  typedef std::map<std::string, int> StringIndexType;
+  typedef std::map<std::vector<int>, std::vector<int> > DirectionIndexType;
+  StringIndexType SeriesInstanceUIDsIndex;
+  StringIndexType ContentTimeIndex;
+  StringIndexType TriggerTimeIndex;
+  StringIndexType EchoNumbersIndex;
+  DirectionIndexType DiffusionGradientOrientationIndex;
+  std::map<float, int> SliceLocationIndex;
+  DirectionIndexType ImageOrientationPatientIndex;
+  DirectionIndexType ImagePositionPatientIndex;
+
+  /// Clear the discriminator arrays and their lookup tables.
+  void ResetDicomTags( bool resetImagePositionPatient = true );
+
 private:
   vtkITKArchetypeImageSeriesReader(const vtkITKArchetypeImageSeriesReader&);  /// Not implemented.
   void operator=(const vtkITKArchetypeImageSeriesReader&);  /// Not implemented.
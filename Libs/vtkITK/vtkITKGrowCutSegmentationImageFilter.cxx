@@ -10,11 +10,16 @@
 #include <vtkImageCast.h>
 #include <vtkImageData.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkTypeTraits.h>
 
 // ITK includes
 #include <itkGrowCutSegmentationImageFilter.h>
 #include <itkImageRegionIteratorWithIndex.h>
-#include <itkRegionOfInterestImageFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
 
 //-----------------------------------------------------------------------------
 vtkCxxRevisionMacro(vtkITKGrowCutSegmentationImageFilter, "$Revision: 1.3 $");
@@ -59,7 +64,9 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
   OT *output, double &ObjectSize,
   double &contrastNoiseRatio,
   double &priorSegmentStrength,
-  itk::CStyleCommand::Pointer progressCommand)
+  itk::CStyleCommand::Pointer progressCommand,
+  vtkITKGrowCutSegmentationImageFilter *self, bool resume,
+  vtkImageData *labelsState, vtkImageData *strengthsState, int stateROI[6])
 {
   typedef itk::Image<IT1, 3> InImageType;
   typename InImageType::Pointer image = InImageType::New();
@@ -70,10 +77,6 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
 
   typename OutImageType::Pointer prevSegmentedImage = OutImageType::New();
 
-  typename OutImageType::Pointer outputImageROI = OutImageType::New();
-
-  typename OutImageType::Pointer outputImage = OutImageType::New();
-
   typedef itk::Image<float, 3> WeightImageType;
   typename WeightImageType::Pointer weightImage = WeightImageType::New();
 
@@ -86,6 +89,9 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
   inData->GetOrigin(origin);
   inData->GetSpacing(spacing);
 
+  const vtkIdType numberOfPixels =
+    static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+
   image->SetOrigin( origin );
   image->SetSpacing( spacing );
 
@@ -102,28 +108,7 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
   region.SetSize( size );
   image->SetRegions(region);
 
-  image->GetPixelContainer()->SetImportPointer(inPtr1, dims[0]*dims[1]*dims[2], false);
-
-  labelImage->SetOrigin( origin );
-  labelImage->SetSpacing( spacing );
-  labelImage->SetRegions( region );
-  labelImage->GetPixelContainer()->SetImportPointer(inPtr2, dims[0]*dims[1]*dims[2], false);
-
-  prevSegmentedImage->SetOrigin( origin );
-  prevSegmentedImage->SetSpacing( spacing );
-  prevSegmentedImage->SetRegions( region );
-  prevSegmentedImage->GetPixelContainer()->SetImportPointer(inPtr3, dims[0]*dims[1]*dims[2], false);
-
-  weightImage->CopyInformation(image);
-  weightImage->SetBufferedRegion( image->GetBufferedRegion() );
-  weightImage->Allocate();
-  weightImage->FillBuffer( 0 );
-
-  itk::ImageRegionIterator< WeightImageType > weight(weightImage, weightImage->GetBufferedRegion() );
-  itk::ImageRegionIteratorWithIndex< OutImageType > label(labelImage, labelImage->GetBufferedRegion() );
-
-  itk::ImageRegionConstIterator< OutImageType > plabel(prevSegmentedImage,
-    prevSegmentedImage->GetBufferedRegion() );
+  image->GetPixelContainer()->SetImportPointer(inPtr1, numberOfPixels, false);
 
   if(contrastNoiseRatio > 1.0)
     {
@@ -135,70 +120,174 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
     priorSegmentStrength /= 100.0;
     }
 
-
   typename OutImageType::IndexType roiStart;
   typename OutImageType::IndexType roiEnd;
 
-
   roiStart[0] = 0; roiStart[1] = 0; roiStart[2] = 0;
   roiEnd[0] = 0; roiEnd[1] = 0; roiEnd[2] = 0;
 
   unsigned int ndims = image->GetImageDimension();
 
-  bool foundLabel = false;
+  typename OutImageType::PixelType radius = static_cast< typename OutImageType::PixelType> (ObjectSize);
 
-  for(weight.GoToBegin(), label.GoToBegin(); !weight.IsAtEnd();
-      ++weight, ++label)
-  {
-    typename OutImageType::PixelType color = label.Get();
-    if(color == 0)
+  typedef itk::GrowCutSegmentationImageFilter<InImageType, OutImageType> FilterType;
+  typename FilterType::NodeContainerPointer seedPoints;
+
+  OT* stateLabels = 0;
+  float* stateStrengths = 0;
+  if (resume)
+    {
+    int stateExtent[6];
+    labelsState->GetExtent(stateExtent);
+    resume = labelsState->GetScalarType() == vtkTypeTraits<OT>::VTKTypeID() &&
+      memcmp(stateExtent, extent, sizeof(extent)) == 0;
+    }
+  if (resume)
+    {
+    // The gestures are the previous output with new seeds painted on
+    // unlabeled or grown pixels. Erasing pixels or relabeling seeds
+    // requires to start from scratch.
+    stateLabels = static_cast<OT*>(labelsState->GetScalarPointer());
+    stateStrengths = static_cast<float*>(strengthsState->GetScalarPointer());
+    seedPoints = FilterType::NodeContainer::New();
+    typename FilterType::IndexType idx;
+    vtkIdType i = 0;
+    for (idx[2] = extent[4]; resume && idx[2] <= extent[5]; ++idx[2])
       {
-       weight.Set(0.0);
+      for (idx[1] = extent[2]; resume && idx[1] <= extent[3]; ++idx[1])
+        {
+        for (idx[0] = extent[0]; idx[0] <= extent[1]; ++idx[0], ++i)
+          {
+          if (inPtr2[i] == stateLabels[i])
+            {
+            continue;
+            }
+          if (inPtr2[i] == 0 || stateStrengths[i] >= contrastNoiseRatio)
+            {
+            resume = false;
+            break;
+            }
+          seedPoints->InsertElement(seedPoints->Size(), idx);
+          }
+        }
       }
-    else
-      {
-      weight.Set( contrastNoiseRatio );
+    }
+  if (resume && seedPoints->Size() == 0)
+    {
+    memcpy(output, stateLabels, numberOfPixels * sizeof(OT));
+    return;
+    }
 
-      typename OutImageType::IndexType idx = label.GetIndex();
-      for (unsigned i = 0; i < ndims; i++)
+  bool foundLabel = false;
+
+  if (resume)
+    {
+    // Add the new seeds to the previous labels and strengths
+    for (unsigned int n = 0; n < seedPoints->Size(); n++)
+      {
+      const typename FilterType::IndexType& idx = seedPoints->ElementAt(n);
+      vtkIdType i = (idx[0] - extent[0]) +
+        dims[0] * ((idx[1] - extent[2]) + static_cast<vtkIdType>(dims[1]) * (idx[2] - extent[4]));
+      stateLabels[i] = inPtr2[i];
+      stateStrengths[i] = contrastNoiseRatio;
+      for (unsigned int d = 0; d < ndims; d++)
         {
-        if(!foundLabel)
+        if (!foundLabel || idx[d] < roiStart[d])
+          {
+          roiStart[d] = idx[d];
+          }
+        if (!foundLabel || idx[d] > roiEnd[d])
           {
-          roiStart[i] = idx[i];
-          roiEnd[i] = idx[i];
+          roiEnd[d] = idx[d];
           }
-        else
+        }
+      foundLabel = true;
+      }
+
+    labelImage->SetOrigin( origin );
+    labelImage->SetSpacing( spacing );
+    labelImage->SetRegions( region );
+    labelImage->GetPixelContainer()->SetImportPointer(stateLabels, numberOfPixels, false);
+
+    weightImage->SetOrigin( origin );
+    weightImage->SetSpacing( spacing );
+    weightImage->SetRegions( region );
+    weightImage->GetPixelContainer()->SetImportPointer(stateStrengths, numberOfPixels, false);
+    }
+  else
+    {
+    labelImage->SetOrigin( origin );
+    labelImage->SetSpacing( spacing );
+    labelImage->SetRegions( region );
+    labelImage->GetPixelContainer()->SetImportPointer(inPtr2, numberOfPixels, false);
+
+    prevSegmentedImage->SetOrigin( origin );
+    prevSegmentedImage->SetSpacing( spacing );
+    prevSegmentedImage->SetRegions( region );
+    prevSegmentedImage->GetPixelContainer()->SetImportPointer(inPtr3, numberOfPixels, false);
+
+    weightImage->CopyInformation(image);
+    weightImage->SetBufferedRegion( image->GetBufferedRegion() );
+    weightImage->Allocate();
+    weightImage->FillBuffer( 0 );
+
+    itk::ImageRegionIterator< WeightImageType > weight(weightImage, weightImage->GetBufferedRegion() );
+    itk::ImageRegionIteratorWithIndex< OutImageType > label(labelImage, labelImage->GetBufferedRegion() );
+
+    itk::ImageRegionConstIterator< OutImageType > plabel(prevSegmentedImage,
+      prevSegmentedImage->GetBufferedRegion() );
+
+    for(weight.GoToBegin(), label.GoToBegin(); !weight.IsAtEnd();
+        ++weight, ++label)
+    {
+      typename OutImageType::PixelType color = label.Get();
+      if(color == 0)
+        {
+         weight.Set(0.0);
+        }
+      else
+        {
+        weight.Set( contrastNoiseRatio );
+
+        typename OutImageType::IndexType idx = label.GetIndex();
+        for (unsigned i = 0; i < ndims; i++)
           {
-          if(idx[i] <= roiStart[i])
+          if(!foundLabel)
             {
             roiStart[i] = idx[i];
+            roiEnd[i] = idx[i];
             }
-          if(idx[i] >= roiEnd[i])
+          else
             {
-            roiEnd[i] = idx[i];
+            if(idx[i] <= roiStart[i])
+              {
+              roiStart[i] = idx[i];
+              }
+            if(idx[i] >= roiEnd[i])
+              {
+              roiEnd[i] = idx[i];
+              }
             }
           }
-        }
-    foundLabel = true;
+      foundLabel = true;
+      }
     }
-  }
 
 
-  for(weight.GoToBegin(), plabel.GoToBegin(), label.GoToBegin(); !weight.IsAtEnd();
-      ++weight, ++plabel, ++label)
-    {
-    typename OutImageType::PixelType color = plabel.Get();
-    if(color != 0 && weight.Get() == 0.0)
+    for(weight.GoToBegin(), plabel.GoToBegin(), label.GoToBegin(); !weight.IsAtEnd();
+        ++weight, ++plabel, ++label)
       {
-      weight.Set( priorSegmentStrength );
-      label.Set ( color );
+      typename OutImageType::PixelType color = plabel.Get();
+      if(color != 0 && weight.Get() == 0.0)
+        {
+        weight.Set( priorSegmentStrength );
+        label.Set ( color );
+        }
       }
     }
 
   std::cout << " ObjectSize (radius) " << ObjectSize << std::endl;
 
-  typename OutImageType::PixelType radius = static_cast< typename OutImageType::PixelType> (ObjectSize);
-
   for (unsigned i = 0; i < ndims; i++)
     {
     int diff = static_cast< int > (roiStart[i] - radius);
@@ -213,110 +302,105 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
     roiEnd[i] = (static_cast<unsigned int>(roiEnd[i] + radius) < size[i]) ?
 (roiEnd[i] + radius) : size[i]-1;
 
+    if (resume)
+      {
+      // The previous segmentation may reach the border of its ROI
+      roiStart[i] = std::min(roiStart[i],
+        static_cast<typename OutImageType::IndexValueType>(stateROI[2 * i]));
+      roiEnd[i] = std::max(roiEnd[i],
+        static_cast<typename OutImageType::IndexValueType>(stateROI[2 * i + 1]));
+      }
+
     std::cout << " roi[ " << roiStart[i]<<" "<<roiEnd[i] << "] " << std::endl;
     }
 
+  if (resume)
+    {
+    // The previous segmentation could not grow past its ROI: if the ROI
+    // is larger, restart from the labeled pixels of its faces too.
+    bool grown = false;
+    for (unsigned int d = 0; d < ndims; d++)
+      {
+      grown = grown || roiStart[d] < stateROI[2 * d] || roiEnd[d] > stateROI[2 * d + 1];
+      }
+    typename FilterType::IndexType idx;
+    for (idx[2] = stateROI[4]; grown && idx[2] <= stateROI[5]; ++idx[2])
+      {
+      for (idx[1] = stateROI[2]; idx[1] <= stateROI[3]; ++idx[1])
+        {
+        bool face = idx[2] == stateROI[4] || idx[2] == stateROI[5] ||
+          idx[1] == stateROI[2] || idx[1] == stateROI[3];
+        int step = face ? 1 : std::max(stateROI[1] - stateROI[0], 1);
+        for (idx[0] = stateROI[0]; idx[0] <= stateROI[1]; idx[0] += step)
+          {
+          vtkIdType i = (idx[0] - extent[0]) +
+            dims[0] * ((idx[1] - extent[2]) + static_cast<vtkIdType>(dims[1]) * (idx[2] - extent[4]));
+          if (stateStrengths[i] > 0)
+            {
+            seedPoints->InsertElement(seedPoints->Size(), idx);
+            }
+          }
+        }
+      }
+    }
 
-  typedef itk::GrowCutSegmentationImageFilter<InImageType, OutImageType> FilterType;
   typename FilterType::Pointer filter = FilterType::New();
 
   filter->AddObserver(itk::ProgressEvent(), progressCommand );
 
-  typename InImageType::IndexType istart;
-  typename InImageType::SizeType isize;
+  filter->SetInput( image );
+  filter->SetLabelImage( labelImage );
 
-  typename OutImageType::IndexType ostart;
-  typename OutImageType::SizeType osize;
+  filter->SetStrengthImage( weightImage );
 
-  typename WeightImageType::IndexType wstart;
-  typename WeightImageType::SizeType wsize;
+  filter->SetSeedStrength( contrastNoiseRatio );
+  filter->SetObjectRadius((unsigned int)ObjectSize);
 
-  for (unsigned n = 0; n < ndims; n++)
+  filter->SetROIStart( roiStart );
+  filter->SetROIEnd( roiEnd );
+  filter->SetROIOn();
+  if (resume)
     {
-    istart[n] = roiStart[n];
-    isize[n] = roiEnd[n]-roiStart[n];
-
-    std::cout << " istart " << istart[n] << " isize " << isize[n] << " " << std::endl;
-
-    ostart[n] = istart[n];
-    osize[n] = isize[n];
-
-    wstart[n] = istart[n];
-    wsize[n] = isize[n];
-
+    filter->SetSeedPoints( seedPoints );
     }
 
-  typename InImageType::RegionType iRegion;
-  iRegion.SetSize( isize );
-  iRegion.SetIndex( istart );
-
-  typedef itk::RegionOfInterestImageFilter< InImageType, InImageType > iFilterType;
-  typename iFilterType::Pointer fInput = iFilterType::New();
-  fInput->SetRegionOfInterest( iRegion );
-
-  fInput->SetInput( image );
-  fInput->Update();
-
-  typename OutImageType::RegionType oRegion;
-  oRegion.SetSize(osize);
-  oRegion.SetIndex(ostart);
-
-  typedef itk::RegionOfInterestImageFilter< OutImageType, OutImageType > oFilterType;
-  typename oFilterType::Pointer fOutput = oFilterType::New();
-  fOutput->SetRegionOfInterest( oRegion );
-
-  fOutput->SetInput( labelImage );
-  fOutput->Update();
-
-  typename WeightImageType::RegionType wRegion;
-  wRegion.SetSize(wsize);
-  wRegion.SetIndex(wstart);
-
-  typedef itk::RegionOfInterestImageFilter< WeightImageType, WeightImageType > wFilterType;
-  typename wFilterType::Pointer fWeight = wFilterType::New();
-  fWeight->SetRegionOfInterest( wRegion );
-
-  fWeight->SetInput( weightImage );
-  fWeight->Update();
-
-  typename InImageType::Pointer inImage = InImageType::New();
-  inImage = fInput->GetOutput();
-
-  typename OutImageType::Pointer labImage = OutImageType::New();
-  labImage = fOutput->GetOutput();
-
-  typename WeightImageType::Pointer wtImage = WeightImageType::New();
-  wtImage = fWeight->GetOutput();
-
-  filter->SetInput( inImage );
-  filter->SetLabelImage( labImage );
-
-  filter->SetStrengthImage( wtImage );
-
-  filter->SetSeedStrength( contrastNoiseRatio );
-  filter->SetObjectRadius((unsigned int)ObjectSize);
-
   filter->Update();
-  outputImageROI = filter->GetOutput();
 
   std::cout << "Done running filter " << std::endl;
 
-  // allocate outputImage first
-  outputImage->CopyInformation( labelImage );
-  outputImage->SetBufferedRegion( labelImage->GetBufferedRegion() );
-  outputImage->Allocate();
-  outputImage->FillBuffer(0);
+  typename OutImageType::Pointer outputImage = filter->GetOutput();
+  memcpy(output, outputImage->GetBufferPointer(), numberOfPixels * sizeof(OT));
 
-  itk::ImageRegionIterator< OutImageType > filterOut(outputImageROI, outputImageROI->GetBufferedRegion());
-  itk::ImageRegionIterator< OutImageType > out(outputImage, oRegion);
+  if (!self->Incremental)
+    {
+    return;
+    }
 
-  for (filterOut.GoToBegin(), out.GoToBegin(); !filterOut.IsAtEnd(); ++filterOut, ++out)
+  // Keep the labels and strengths to resume from when seeds are added.
+  // The pixels masked out of the output are unlabeled.
+  labelsState->SetExtent(extent);
+  labelsState->SetScalarType(vtkTypeTraits<OT>::VTKTypeID());
+  labelsState->SetNumberOfScalarComponents(1);
+  labelsState->AllocateScalars();
+  stateLabels = static_cast<OT*>(labelsState->GetScalarPointer());
+  memcpy(stateLabels, output, numberOfPixels * sizeof(OT));
+
+  strengthsState->SetExtent(extent);
+  strengthsState->SetScalarTypeToFloat();
+  strengthsState->SetNumberOfScalarComponents(1);
+  strengthsState->AllocateScalars();
+  stateStrengths = static_cast<float*>(strengthsState->GetScalarPointer());
+  const float* strengths = filter->GetUpdatedStrengthImage()->GetBufferPointer();
+  for (vtkIdType i = 0; i < numberOfPixels; ++i)
     {
-    out.Set(filterOut.Get());
+    stateStrengths[i] = (output[i] != 0) ? strengths[i] : 0.f;
     }
 
- memcpy(output, outputImage->GetBufferPointer(),
-         outputImage->GetBufferedRegion().GetNumberOfPixels()*sizeof(OT) );
+  for (unsigned int d = 0; d < ndims; d++)
+    {
+    stateROI[2 * d] = static_cast<int>(roiStart[d]);
+    stateROI[2 * d + 1] = static_cast<int>(roiEnd[d]);
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -325,6 +409,25 @@ vtkITKGrowCutSegmentationImageFilter::vtkITKGrowCutSegmentationImageFilter()
   this->ObjectSize = 20;
   this->ContrastNoiseRatio = 1.0;
   this->PriorSegmentConfidence = 0.003;
+  this->Incremental = 0;
+
+  this->StateLabels = vtkImageData::New();
+  this->StateStrengths = vtkImageData::New();
+  for (int i = 0; i < 6; ++i)
+    {
+    this->StateROI[i] = 0;
+    }
+  this->StateInput = 0;
+  this->StateInputTime = 0;
+  this->StateObjectSize = 0.;
+  this->StateContrastNoiseRatio = 0.;
+}
+
+//-----------------------------------------------------------------------------
+vtkITKGrowCutSegmentationImageFilter::~vtkITKGrowCutSegmentationImageFilter()
+{
+  this->StateLabels->Delete();
+  this->StateStrengths->Delete();
 }
 
 //-----------------------------------------------------------------------------
@@ -334,6 +437,10 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           vtkImageData *input2,
           vtkImageData *input3,
           vtkImageData *outData,
+          bool resume,
+          vtkImageData *labelsState,
+          vtkImageData *strengthsState,
+          int stateROI[6],
           IT1 *)
 {
   int outExt[6];
@@ -402,7 +509,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (short*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         imageCaster1->Delete();
         }
       else
@@ -418,7 +526,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (unsigned short*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         else if (input2->GetScalarType() == VTK_SHORT)
           {
@@ -427,7 +536,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (short*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         else if(input2->GetScalarType() == VTK_UNSIGNED_CHAR)
           {
@@ -436,7 +546,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (unsigned char*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         else if(input2->GetScalarType() == VTK_CHAR)
           {
@@ -445,7 +556,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (char*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         else if(input2->GetScalarType() == VTK_UNSIGNED_LONG)
           {
@@ -454,7 +566,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (unsigned long*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         else if(input2->GetScalarType() == VTK_LONG)
           {
@@ -463,7 +576,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
             (long*)(outPtr),
             self->ObjectSize, self->ContrastNoiseRatio,
             self->PriorSegmentConfidence,
-            progressCommand);
+            progressCommand, self, resume,
+            labelsState, strengthsState, stateROI);
           }
         }
       imageCaster->Delete();
@@ -494,7 +608,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
         (short*)(outPtr),
         self->ObjectSize, self->ContrastNoiseRatio,
         self->PriorSegmentConfidence,
-        progressCommand);
+        progressCommand, self, resume,
+        labelsState, strengthsState, stateROI);
 
       imageCaster1->Delete();
       imageCaster->Delete();
@@ -510,7 +625,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (unsigned short*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         }
       else if (input2->GetScalarType() == VTK_SHORT)
         {
@@ -519,7 +635,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (short*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         }
       else if(input2->GetScalarType() == VTK_UNSIGNED_CHAR)
         {
@@ -528,7 +645,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (unsigned char*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         }
       else if(input2->GetScalarType() == VTK_CHAR)
         {
@@ -537,7 +655,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (char*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         }
       else if(input2->GetScalarType() == VTK_UNSIGNED_LONG)
       {
@@ -546,7 +665,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
         (unsigned long*)(outPtr),
         self->ObjectSize, self->ContrastNoiseRatio,
         self->PriorSegmentConfidence,
-        progressCommand);
+        progressCommand, self, resume,
+        labelsState, strengthsState, stateROI);
       }
       else if(input2->GetScalarType() == VTK_LONG)
         {
@@ -555,7 +675,8 @@ void ExecuteGrowCut( vtkITKGrowCutSegmentationImageFilter *self,
           (long*)(outPtr),
           self->ObjectSize, self->ContrastNoiseRatio,
           self->PriorSegmentConfidence,
-          progressCommand);
+          progressCommand, self, resume,
+          labelsState, strengthsState, stateROI);
         }
       }
     }
@@ -571,12 +692,46 @@ void vtkITKGrowCutSegmentationImageFilter::ExecuteData(
 
   vtkImageData * out = vtkImageData::SafeDownCast(outData);
 
+  // Resume from the previous execution if the intensities and the
+  // parameters did not change
+  bool resume = this->Incremental &&
+    this->StateInput == input1 &&
+    this->StateInputTime == input1->GetMTime() &&
+    this->StateObjectSize == this->ObjectSize &&
+    this->StateContrastNoiseRatio == this->ContrastNoiseRatio &&
+    this->StateLabels->GetPointData()->GetScalars() != 0;
+
   switch(input1->GetScalarType() ) {
     vtkTemplateMacro( ExecuteGrowCut(this, input1, input2,
-             input3, out,
+             input3, out, resume,
+             this->StateLabels, this->StateStrengths, this->StateROI,
              static_cast< VTK_TT*>(0)));
     break;
   }
+
+  if (this->Incremental)
+    {
+    this->StateInput = input1;
+    this->StateInputTime = input1->GetMTime();
+    this->StateObjectSize = this->ObjectSize;
+    this->StateContrastNoiseRatio = this->ContrastNoiseRatio;
+    }
+  else
+    {
+    this->ReleaseState();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkITKGrowCutSegmentationImageFilter::ReleaseState()
+{
+  this->StateLabels->Initialize();
+  this->StateStrengths->Initialize();
+  for (int i = 0; i < 6; ++i)
+    {
+    this->StateROI[i] = 0;
+    }
+  this->StateInput = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -604,4 +759,5 @@ void vtkITKGrowCutSegmentationImageFilter::PrintSelf(ostream& os, vtkIndent inde
 
   os << indent << "Object Size : " << this->ObjectSize << std::endl;
   os << indent << "ContrastNoiseRatio : " << this->ContrastNoiseRatio << std::endl;
+  os << indent << "Incremental : " << this->Incremental << std::endl;
 }
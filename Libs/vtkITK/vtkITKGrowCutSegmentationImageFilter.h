@@ -21,6 +21,13 @@ class vtkImageData;
 ///
 /// GetOutput produces the output segmented image
 ///
+/// In incremental mode, the labels and strengths of the automaton are kept
+/// after each execution. When the gestures of the next execution are the
+/// previous output with new seeds painted on it, the segmentation resumes
+/// from that state instead of starting over, only updating the pixels the
+/// new seeds reach. Otherwise (erased or relabeled seeds, modified input
+/// image or parameters) the segmentation starts from scratch.
+///
 /// This filter is implemented only for scalar images gray scale images. 
 /// The current implementation supports n-class segmentation.
 class VTK_ITK_EXPORT vtkITKGrowCutSegmentationImageFilter : public vtkImageMultipleInputFilter 
@@ -43,15 +50,31 @@ public:
   vtkSetMacro(PriorSegmentConfidence, double);
   vtkGetMacro(PriorSegmentConfidence, double);
 
+  /// Resume from the previous execution when seeds are added.
+  /// Off by default.
+  vtkSetMacro(Incremental, int);
+  vtkGetMacro(Incremental, int);
+  vtkBooleanMacro(Incremental, int);
+
+  /// Automaton state after the last execution in incremental mode: the
+  /// output labels, their strengths and the ROI (IJK bounds) of the
+  /// segmentation
+  vtkGetObjectMacro(StateLabels, vtkImageData);
+  vtkGetObjectMacro(StateStrengths, vtkImageData);
+  vtkGetVector6Macro(StateROI, int);
+
+  /// Free the automaton state. The next execution starts from scratch.
+  void ReleaseState();
+
 public:
   double ObjectSize;
   double PriorSegmentConfidence;
   double ContrastNoiseRatio;
-
+  int Incremental;
 
 protected:
   vtkITKGrowCutSegmentationImageFilter();
-  ~vtkITKGrowCutSegmentationImageFilter(){}
+  ~vtkITKGrowCutSegmentationImageFilter();
 
   virtual void ExecuteData(vtkDataObject *outData);
 
@@ -64,6 +87,16 @@ protected:
   /// override to ExecuteInformation(vtkImageData**, vtkImageData**)
   virtual void ExecuteInformation();
 
+  vtkImageData* StateLabels;
+  vtkImageData* StateStrengths;
+  int StateROI[6];
+
+  /// Input and parameters the state was computed with
+  vtkImageData* StateInput;
+  unsigned long StateInputTime;
+  double StateObjectSize;
+  double StateContrastNoiseRatio;
+
 private:
   vtkITKGrowCutSegmentationImageFilter(const vtkITKGrowCutSegmentationImageFilter&);  // Not implemented.
   void operator=(const vtkITKGrowCutSegmentationImageFilter&);  // Not implemented.
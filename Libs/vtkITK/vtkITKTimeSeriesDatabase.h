@@ -64,6 +64,12 @@ public:
 
   int GetNumberOfVolumes() 
   { DelegateITKOutputMacro ( GetNumberOfVolumes ); }; 
+
+  /// Read the neighbouring time points in a background thread
+  void SetReadAhead ( int value )
+  { DelegateITKInputMacro ( SetReadAhead, value != 0 ); };
+  int GetReadAhead()
+  { DelegateITKOutputMacro ( GetReadAhead ); };
   
 protected:
   vtkITKTimeSeriesDatabase() 
@@ -0,0 +1,171 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// vtkTeem includes
+#include <vtkHyperStreamlineDTMRI.h>
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+const int Dimension = 48;
+
+//----------------------------------------------------------------------------
+// Fibers turning around the z axis, with a scalar volume
+void SetupTensorField(vtkImageData* tensorField)
+{
+  tensorField->SetDimensions(Dimension, Dimension, Dimension);
+  tensorField->SetOrigin(-30., -30., -20.);
+  tensorField->SetSpacing(1.25, 1.25, 1.5);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(Dimension * Dimension * Dimension);
+  vtkNew<vtkFloatArray> scalars;
+  scalars->SetNumberOfTuples(Dimension * Dimension * Dimension);
+  vtkIdType id = 0;
+  for (int z = 0; z < Dimension; ++z)
+    {
+    for (int y = 0; y < Dimension; ++y)
+      {
+      for (int x = 0; x < Dimension; ++x, ++id)
+        {
+        double point[3];
+        tensorField->GetPoint(id, point);
+        double r = sqrt(point[0] * point[0] + point[1] * point[1]) + 1.;
+        double e[3] = {-point[1] / r, point[0] / r, 0.1};
+        float tensor[9];
+        for (int i = 0; i < 3; ++i)
+          {
+          for (int j = 0; j < 3; ++j)
+            {
+            tensor[3 * i + j] = static_cast<float>(0.8 * e[i] * e[j] + (i == j ? 0.1 : 0.));
+            }
+          }
+        tensors->SetTupleValue(id, tensor);
+        scalars->SetValue(id, static_cast<float>(r));
+        }
+      }
+    }
+  tensorField->GetPointData()->SetTensors(tensors.GetPointer());
+  tensorField->GetPointData()->SetScalars(scalars.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+// Track from a grid of seeds, return the time spent
+double Track(vtkImageData* tensorField, int useImageInterpolation,
+             std::vector<vtkSmartPointer<vtkPolyData> >& tracts)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int z = -10; z <= 10; z += 5)
+    {
+    for (int y = -20; y <= 20; y += 4)
+      {
+      for (int x = -20; x <= 20; x += 4)
+        {
+        vtkNew<vtkHyperStreamlineDTMRI> streamline;
+        streamline->SetInput(tensorField);
+        streamline->SetStartPosition(x + 0.3, y + 0.1, z + 0.2);
+        streamline->SetUseImageInterpolation(useImageInterpolation);
+        streamline->OutputTensorsOn();
+        streamline->OneTrajectoryPerSeedPointOn();
+        streamline->Update();
+        vtkSmartPointer<vtkPolyData> tract = vtkSmartPointer<vtkPolyData>::New();
+        tract->DeepCopy(streamline->GetOutput());
+        tracts.push_back(tract);
+        }
+      }
+    }
+  timer->StopTimer();
+  return timer->GetElapsedTime();
+}
+
+//----------------------------------------------------------------------------
+bool CompareTracts(vtkPolyData* tract1, vtkPolyData* tract2, size_t index)
+{
+  const double tolerance = 1e-3;
+  if (tract1->GetNumberOfPoints() != tract2->GetNumberOfPoints())
+    {
+    std::cerr << "Tract " << index << ": " << tract1->GetNumberOfPoints()
+              << " points instead of " << tract2->GetNumberOfPoints() << std::endl;
+    return false;
+    }
+  vtkDataArray* scalars1 = tract1->GetPointData()->GetScalars();
+  vtkDataArray* scalars2 = tract2->GetPointData()->GetScalars();
+  for (vtkIdType i = 0; i < tract1->GetNumberOfPoints(); ++i)
+    {
+    double point1[3];
+    double point2[3];
+    tract1->GetPoint(i, point1);
+    tract2->GetPoint(i, point2);
+    if (fabs(point1[0] - point2[0]) > tolerance ||
+        fabs(point1[1] - point2[1]) > tolerance ||
+        fabs(point1[2] - point2[2]) > tolerance ||
+        fabs(scalars1->GetComponent(i, 0) - scalars2->GetComponent(i, 0)) > tolerance)
+      {
+      std::cerr << "Tract " << index << " differs at point " << i << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the tracking time with the generic cell interpolation and with
+// the image interpolation. Both must give the same tracts.
+int vtkHyperStreamlineDTMRIBenchmark(int , char * [] )
+{
+  vtkNew<vtkImageData> tensorField;
+  SetupTensorField(tensorField.GetPointer());
+
+  std::vector<vtkSmartPointer<vtkPolyData> > cellTracts;
+  double cellTime = Track(tensorField.GetPointer(), 0, cellTracts);
+  std::vector<vtkSmartPointer<vtkPolyData> > imageTracts;
+  double imageTime = Track(tensorField.GetPointer(), 1, imageTracts);
+
+  vtkIdType numberOfPoints = 0;
+  for (size_t i = 0; i < cellTracts.size(); ++i)
+    {
+    if (!CompareTracts(imageTracts[i], cellTracts[i], i))
+      {
+      return EXIT_FAILURE;
+      }
+    numberOfPoints += cellTracts[i]->GetNumberOfPoints();
+    }
+  if (numberOfPoints == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": no tract" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << cellTracts.size() << " tracts, " << numberOfPoints << " points: "
+            << cellTime << "s with cell interpolation, "
+            << imageTime << "s with image interpolation" << std::endl;
+
+  return EXIT_SUCCESS;
+}
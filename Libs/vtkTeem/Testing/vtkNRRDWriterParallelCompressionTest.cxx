@@ -0,0 +1,106 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// vtkTeem includes
+#include <vtkNRRDReader.h>
+#include <vtkNRRDWriter.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool WriteAndRead(vtkImageData* image, const std::string& fileName,
+                  int numberOfThreads)
+{
+  vtkNew<vtkNRRDWriter> writer;
+  writer->SetInput(image);
+  writer->SetFileName(fileName.c_str());
+  writer->SetUseCompression(1);
+  writer->SetNumberOfThreads(numberOfThreads);
+  writer->Write();
+  if (writer->GetWriteError())
+    {
+    std::cerr << "Failed to write " << fileName << " with "
+              << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  vtkImageData* readImage = reader->GetOutput();
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  vtkDataArray* readScalars = readImage ? readImage->GetPointData()->GetScalars() : 0;
+  if (!readScalars ||
+      readScalars->GetNumberOfTuples() != scalars->GetNumberOfTuples() ||
+      readScalars->GetDataType() != scalars->GetDataType() ||
+      memcmp(readScalars->GetVoidPointer(0), scalars->GetVoidPointer(0),
+             scalars->GetNumberOfTuples() * scalars->GetDataTypeSize()) != 0)
+    {
+    std::cerr << "Data read from " << fileName << " written with "
+              << numberOfThreads << " threads differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Usage: vtkNRRDWriterParallelCompressionTest <temporary directory>
+int vtkNRRDWriterParallelCompressionTest(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkNRRDWriterParallelCompressionTest <temporary directory>"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = argv[1];
+
+  // More than one compression block, the last one partial
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(130, 110, 50);
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+  short* scalars = static_cast<short*>(image->GetScalarPointer());
+  vtkIdType numberOfPoints = image->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    scalars[i] = static_cast<short>((i % 130) * (i / 14300) - (i / 130) % 110);
+    }
+
+  if (!WriteAndRead(image.GetPointer(),
+                    directory + "/vtkNRRDWriterParallelCompressionTest1.nrrd", 1) ||
+      !WriteAndRead(image.GetPointer(),
+                    directory + "/vtkNRRDWriterParallelCompressionTest4.nrrd", 4) ||
+      // Detached headers are compressed by teem
+      !WriteAndRead(image.GetPointer(),
+                    directory + "/vtkNRRDWriterParallelCompressionTest4.nhdr", 4))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// vtkTeem includes
+#include <vtkSeedTracts.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Tensors along x, slightly bent along y so the paths are not trivial
+void SetupTensorField(vtkImageData* tensorField)
+{
+  const int dim = 24;
+  tensorField->SetDimensions(dim, dim, dim);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(dim * dim * dim);
+  vtkIdType id = 0;
+  for (int z = 0; z < dim; ++z)
+    {
+    for (int y = 0; y < dim; ++y)
+      {
+      for (int x = 0; x < dim; ++x, ++id)
+        {
+        double bend = 0.3 * (y - dim / 2) / dim;
+        float tensor[9] = {1.f, static_cast<float>(bend), 0.f,
+                           static_cast<float>(bend), 0.2f, 0.f,
+                           0.f, 0.f, 0.1f};
+        tensors->SetTupleValue(id, tensor);
+        }
+      }
+    }
+  tensorField->GetPointData()->SetTensors(tensors.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+// A block of seeds in the middle of the field
+void SetupROI(vtkImageData* roi)
+{
+  roi->SetDimensions(24, 24, 24);
+  roi->SetScalarTypeToShort();
+  roi->AllocateScalars();
+  short* ptr = static_cast<short*>(roi->GetScalarPointer());
+  for (int z = 0; z < 24; ++z)
+    {
+    for (int y = 0; y < 24; ++y)
+      {
+      for (int x = 0; x < 24; ++x)
+        {
+        *(ptr++) = (x >= 10 && x < 14 && y >= 6 && y < 18 && z >= 8 && z < 16);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void SeedTracts(vtkSeedTracts* seedTracts, vtkImageData* tensorField,
+                vtkImageData* roi, int numberOfThreads)
+{
+  seedTracts->SetInputTensorField(tensorField);
+  seedTracts->SetInputROI(roi);
+  seedTracts->SetInputROIValue(1);
+  seedTracts->SetMinimumPathLength(5);
+  seedTracts->SetNumberOfThreads(numberOfThreads);
+  seedTracts->SeedStreamlinesInROI();
+}
+
+//----------------------------------------------------------------------------
+bool CompareStreamlines(vtkCollection* streamlines1, vtkCollection* streamlines2)
+{
+  if (streamlines1->GetNumberOfItems() == 0 ||
+      streamlines1->GetNumberOfItems() != streamlines2->GetNumberOfItems())
+    {
+    std::cerr << "Wrong number of streamlines: "
+              << streamlines1->GetNumberOfItems() << " and "
+              << streamlines2->GetNumberOfItems() << std::endl;
+    return false;
+    }
+  for (int i = 0; i < streamlines1->GetNumberOfItems(); ++i)
+    {
+    vtkPoints* points1 = vtkHyperStreamline::SafeDownCast(
+      streamlines1->GetItemAsObject(i))->GetOutput()->GetPoints();
+    vtkPoints* points2 = vtkHyperStreamline::SafeDownCast(
+      streamlines2->GetItemAsObject(i))->GetOutput()->GetPoints();
+    if (points1->GetNumberOfPoints() != points2->GetNumberOfPoints())
+      {
+      std::cerr << "Streamline " << i << " differs" << std::endl;
+      return false;
+      }
+    for (vtkIdType j = 0; j < points1->GetNumberOfPoints(); ++j)
+      {
+      double point1[3];
+      double point2[3];
+      points1->GetPoint(j, point1);
+      points2->GetPoint(j, point2);
+      if (point1[0] != point2[0] || point1[1] != point2[1] ||
+          point1[2] != point2[2])
+        {
+        std::cerr << "Streamline " << i << " differs at point " << j << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// The streamlines seeded in parallel are the streamlines seeded by a single
+// thread, in the same order.
+int vtkSeedTractsThreadsTest(int , char * [] )
+{
+  vtkNew<vtkImageData> tensorField;
+  SetupTensorField(tensorField.GetPointer());
+  vtkNew<vtkImageData> roi;
+  SetupROI(roi.GetPointer());
+
+  vtkNew<vtkSeedTracts> seedTracts;
+  SeedTracts(seedTracts.GetPointer(), tensorField.GetPointer(),
+             roi.GetPointer(), 1);
+  vtkNew<vtkSeedTracts> threadedSeedTracts;
+  SeedTracts(threadedSeedTracts.GetPointer(), tensorField.GetPointer(),
+             roi.GetPointer(), 4);
+
+  if (!CompareStreamlines(seedTracts->GetStreamlines(),
+                          threadedSeedTracts->GetStreamlines()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << seedTracts->GetSeedsPerSecond() << " seeds/s with 1 thread, "
+            << threadedSeedTracts->GetSeedsPerSecond() << " seeds/s with 4 threads"
+            << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 
 #include "vtkCellArray.h"
 #include "vtkFloatArray.h"
+#include "vtkImageData.h"
 #include "vtkMath.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
@@ -27,6 +28,184 @@
 //#include "vtkHyperPointandArray.cxx"
 #endif
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Locate points and interpolate tensors in a vtkImageData with index
+// arithmetic instead of the generic FindCell() and vtkCell weights.
+// Cells are voxels designated by the index of their first point.
+class ImageTensorField
+{
+public:
+  ImageTensorField()
+    : Tensors(0), TensorType(VTK_VOID), Scalars(0)
+    {
+    }
+
+  // Return false if the input can not use the direct interpolation
+  bool Initialize(vtkDataSet *input, vtkDataArray *tensors, vtkDataArray *scalars)
+    {
+    vtkImageData *image = vtkImageData::SafeDownCast(input);
+    if (!image || tensors->GetNumberOfComponents() != 9 ||
+        (tensors->GetDataType() != VTK_FLOAT &&
+         tensors->GetDataType() != VTK_DOUBLE))
+      {
+      return false;
+      }
+    int dims[3];
+    image->GetDimensions(dims);
+    double origin[3], spacing[3];
+    image->GetOrigin(origin);
+    image->GetSpacing(spacing);
+    int extent[6];
+    image->GetExtent(extent);
+    for (int i = 0; i < 3; i++)
+      {
+      // flat images have pixel cells, leave them to the generic code
+      if (dims[i] < 2 || spacing[i] == 0.0)
+        {
+        return false;
+        }
+      this->Dimensions[i] = dims[i];
+      this->Origin[i] = origin[i] + extent[2*i] * spacing[i];
+      this->Spacing[i] = spacing[i];
+      }
+    vtkIdType dx = dims[0];
+    vtkIdType dxy = dx * dims[1];
+    vtkIdType offsets[8] = {0, 1, dx, dx + 1, dxy, dxy + 1, dxy + dx, dxy + dx + 1};
+    for (int i = 0; i < 8; i++)
+      {
+      this->Offsets[i] = offsets[i];
+      }
+    this->Tensors = tensors->GetVoidPointer(0);
+    this->TensorType = tensors->GetDataType();
+    this->Scalars = scalars;
+    return true;
+    }
+
+  // Same as vtkImageData::FindCell(): -1 if x is out of the image
+  vtkIdType FindCell(const vtkFloatingPointType x[3], int ijk[3],
+                     vtkFloatingPointType pcoords[3]) const
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      double index = (x[i] - this->Origin[i]) / this->Spacing[i];
+      if (index < 0.0 || index > this->Dimensions[i] - 1)
+        {
+        return -1;
+        }
+      ijk[i] = static_cast<int>(index);
+      if (ijk[i] == this->Dimensions[i] - 1)
+        {
+        ijk[i]--;
+        }
+      pcoords[i] = index - ijk[i];
+      }
+    return this->CellId(ijk);
+    }
+
+  // Same as vtkVoxel::EvaluatePosition(): pcoords are extrapolated
+  // when x is out of the cell.
+  bool EvaluatePosition(const int ijk[3], const vtkFloatingPointType x[3],
+                        vtkFloatingPointType pcoords[3]) const
+    {
+    bool inside = true;
+    for (int i = 0; i < 3; i++)
+      {
+      pcoords[i] = (x[i] - this->Origin[i]) / this->Spacing[i] - ijk[i];
+      if (pcoords[i] < 0.0 || pcoords[i] > 1.0)
+        {
+        inside = false;
+        }
+      }
+    return inside;
+    }
+
+  vtkIdType CellId(const int ijk[3]) const
+    {
+    return ijk[0] + (this->Dimensions[0] - 1) *
+      (ijk[1] + static_cast<vtkIdType>(this->Dimensions[1] - 1) * ijk[2]);
+    }
+
+  void CellIndex(vtkIdType cellId, int ijk[3]) const
+    {
+    ijk[0] = cellId % (this->Dimensions[0] - 1);
+    cellId /= this->Dimensions[0] - 1;
+    ijk[1] = cellId % (this->Dimensions[1] - 1);
+    ijk[2] = cellId / (this->Dimensions[1] - 1);
+    }
+
+  // Trilinear interpolation of the tensor (and scalar if any) at pcoords
+  void Interpolate(const int ijk[3], const vtkFloatingPointType pcoords[3],
+                   vtkFloatingPointType *m[3], vtkFloatingPointType *scalar) const
+    {
+    vtkIdType pointId = ijk[0] + this->Dimensions[0] *
+      (ijk[1] + static_cast<vtkIdType>(this->Dimensions[1]) * ijk[2]);
+    vtkFloatingPointType w[8];
+    vtkFloatingPointType rm = 1.0 - pcoords[0];
+    vtkFloatingPointType sm = 1.0 - pcoords[1];
+    vtkFloatingPointType tm = 1.0 - pcoords[2];
+    w[0] = rm * sm * tm;
+    w[1] = pcoords[0] * sm * tm;
+    w[2] = rm * pcoords[1] * tm;
+    w[3] = pcoords[0] * pcoords[1] * tm;
+    w[4] = rm * sm * pcoords[2];
+    w[5] = pcoords[0] * sm * pcoords[2];
+    w[6] = rm * pcoords[1] * pcoords[2];
+    w[7] = pcoords[0] * pcoords[1] * pcoords[2];
+    if (this->TensorType == VTK_FLOAT)
+      {
+      this->InterpolateTensor(static_cast<const float*>(this->Tensors), pointId, w, m);
+      }
+    else
+      {
+      this->InterpolateTensor(static_cast<const double*>(this->Tensors), pointId, w, m);
+      }
+    if (this->Scalars && scalar)
+      {
+      *scalar = 0.0;
+      for (int k = 0; k < 8; k++)
+        {
+        *scalar += this->Scalars->GetComponent(pointId + this->Offsets[k], 0) * w[k];
+        }
+      }
+    }
+
+private:
+  template <class T>
+  void InterpolateTensor(const T *tensors, vtkIdType pointId,
+                         const vtkFloatingPointType w[8],
+                         vtkFloatingPointType *m[3]) const
+    {
+    for (int j = 0; j < 3; j++)
+      {
+      m[0][j] = m[1][j] = m[2][j] = 0.0;
+      }
+    for (int k = 0; k < 8; k++)
+      {
+      const T *tensor = tensors + 9 * (pointId + this->Offsets[k]);
+      for (int j = 0; j < 3; j++)
+        {
+        for (int i = 0; i < 3; i++)
+          {
+          m[i][j] += tensor[i+3*j] * w[k];
+          }
+        }
+      }
+    }
+
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  vtkIdType Offsets[8];
+  const void *Tensors;
+  int TensorType;
+  vtkDataArray *Scalars;
+};
+
+} // end of anonymous namespace
+
 vtkCxxRevisionMacro(vtkHyperStreamlineDTMRI, "$Revision: 1.32.2.1 $");
 vtkStandardNewMacro(vtkHyperStreamlineDTMRI);
 
@@ -59,6 +238,7 @@ vtkHyperStreamlineDTMRI::vtkHyperStreamlineDTMRI()
 
   this->OutputTensors = 0;
   this->OneTrajectoryPerSeedPoint = 0;
+  this->UseImageInterpolation = 1;
 }
 
 vtkHyperStreamlineDTMRI::~vtkHyperStreamlineDTMRI()
@@ -202,6 +382,12 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
     }
 
 
+  // Index arithmetic in image data instead of FindCell() and cell weights
+  ImageTensorField imageField;
+  bool useImageField = this->UseImageInterpolation &&
+    imageField.Initialize(input, inTensors, inScalars);
+  int cellIjk[3];
+
   tol2 = input->GetLength() / 1000.0;
   tol2 = tol2 * tol2;
   iv = this->IntegrationEigenvector;
@@ -226,8 +412,16 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
       {
       sPtr->X[i] = this->StartPosition[i];
       }
-    sPtr->CellId = input->FindCell(this->StartPosition, NULL, (-1), 0.0, 
-                                   sPtr->SubId, sPtr->P, w);
+    if (useImageField)
+      {
+      sPtr->SubId = 0;
+      sPtr->CellId = imageField.FindCell(this->StartPosition, cellIjk, sPtr->P);
+      }
+    else
+      {
+      sPtr->CellId = input->FindCell(this->StartPosition, NULL, (-1), 0.0, 
+                                     sPtr->SubId, sPtr->P, w);
+      }
     }
 
   else //VTK_START_FROM_LOCATION
@@ -242,14 +436,20 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
   this->Streamers[0].Direction = 1.0;
   sPtr = this->Streamers[0].GetTractographyPoint(0);
   sPtr->D = 0.0;
-  if ( sPtr->CellId >= 0 ) //starting point in dataset
+  if ( sPtr->CellId >= 0 && useImageField ) //starting point in image
+    {
+    imageField.CellIndex(sPtr->CellId, cellIjk);
+    // interpolate tensor and scalar
+    imageField.Interpolate(cellIjk, sPtr->P, m, &sPtr->S);
+    }
+  else if ( sPtr->CellId >= 0 ) //starting point in dataset
     {
     cell = input->GetCell(sPtr->CellId);
     cell->EvaluateLocation(sPtr->SubId, sPtr->P, xNext, w);
 
     inTensors->GetTuples(cell->PointIds, cellTensors);
 
-    // interpolate tensor, compute eigenfunctions
+    // interpolate tensor
     for (j=0; j<3; j++)
       {
       for (i=0; i<3; i++)
@@ -269,7 +469,21 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
           }
         }
       }
-    
+
+    if ( inScalars )
+      {
+      inScalars->GetTuples(cell->PointIds, cellScalars);
+      for (sPtr->S=0, i=0; i < cell->GetNumberOfPoints(); i++)
+        {
+        sPtr->S += cellScalars->GetTuple(i)[0] * w[i];
+        // for curvature coloring for debugging purposes:
+        //sPtr->S =0;
+        }
+      }
+    }
+
+  if ( sPtr->CellId >= 0 )
+    {
     // store tensor at start point
     for (j=0; j<3; j++) 
       {
@@ -279,21 +493,11 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         }
       }
 
+    // compute eigenfunctions
     //vtkMath::Jacobi(m, sPtr->W, sPtr->V);
     vtkDiffusionTensorMathematics::TeemEigenSolver(m,sPtr->W,sPtr->V);
     FixVectors(NULL, sPtr->V, iv, ix, iy);
 
-    if ( inScalars )
-      {
-      inScalars->GetTuples(cell->PointIds, cellScalars);
-      for (sPtr->S=0, i=0; i < cell->GetNumberOfPoints(); i++)
-        {
-        sPtr->S += cellScalars->GetTuple(i)[0] * w[i];
-        // for curvature coloring for debugging purposes:
-        //sPtr->S =0;
-        }
-      }
-
     if ( this->IntegrationDirection == VTK_INTEGRATE_BOTH_DIRECTIONS )
       {
       this->Streamers[1].Direction = -1.0;
@@ -319,11 +523,18 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
       }
 
     dir = this->Streamers[ptId].Direction;
-    cell = input->GetCell(sPtr->CellId);
-    cell->EvaluateLocation(sPtr->SubId, sPtr->P, xNext, w);
     step = this->IntegrationStepLength;
-    inTensors->GetTuples(cell->PointIds, cellTensors);
-    if ( inScalars ) {inScalars->GetTuples(cell->PointIds, cellScalars);}
+    if (useImageField)
+      {
+      imageField.CellIndex(sPtr->CellId, cellIjk);
+      }
+    else
+      {
+      cell = input->GetCell(sPtr->CellId);
+      cell->EvaluateLocation(sPtr->SubId, sPtr->P, xNext, w);
+      inTensors->GetTuples(cell->PointIds, cellTensors);
+      if ( inScalars ) {inScalars->GetTuples(cell->PointIds, cellScalars);}
+      }
 
 
     // This is the flag for integration to continue if FA, curvature
@@ -405,24 +616,33 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         }
 
       //compute updated position using updated step
-      cell->EvaluatePosition(xNext, closestPoint, subId, p, dist2, w);
-
-      //interpolate tensor
-      for (j=0; j<3; j++)
+      if (useImageField)
         {
-        for (i=0; i<3; i++)
-          {
-          m[i][j] = 0.0;
-          }
+        //interpolate tensor (extrapolated from the current cell)
+        imageField.EvaluatePosition(cellIjk, xNext, p);
+        imageField.Interpolate(cellIjk, p, m, NULL);
         }
-      for (k=0; k < cell->GetNumberOfPoints(); k++)
+      else
         {
-        tensor = cellTensors->GetTuple(k);
+        cell->EvaluatePosition(xNext, closestPoint, subId, p, dist2, w);
+
+        //interpolate tensor
         for (j=0; j<3; j++)
           {
           for (i=0; i<3; i++)
             {
-            m[i][j] += tensor[i+3*j] * w[k];
+            m[i][j] = 0.0;
+            }
+          }
+        for (k=0; k < cell->GetNumberOfPoints(); k++)
+          {
+          tensor = cellTensors->GetTuple(k);
+          for (j=0; j<3; j++)
+            {
+            for (i=0; i<3; i++)
+              {
+              m[i][j] += tensor[i+3*j] * w[k];
+              }
             }
           }
         }
@@ -439,7 +659,24 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
         }
       sNext = this->Streamers[ptId].InsertNextTractographyPoint();
 
-      if ( cell->EvaluatePosition(xNext, closestPoint, sNext->SubId, 
+      if (useImageField)
+        {
+        sNext->SubId = 0;
+        if ( imageField.EvaluatePosition(cellIjk, xNext, sNext->P) )
+          { //integration still in cell
+          sNext->CellId = sPtr->CellId;
+          }
+        else
+          { //integration has passed out of cell
+          sNext->CellId = imageField.FindCell(xNext, cellIjk, sNext->P);
+          step = this->IntegrationStepLength;
+          }
+        for (i=0; i<3; i++)
+          {
+          sNext->X[i] = xNext[i];
+          }
+        }
+      else if ( cell->EvaluatePosition(xNext, closestPoint, sNext->SubId, 
       sNext->P, dist2, w) )
         { //integration still in cell
         for (i=0; i<3; i++)
@@ -466,7 +703,11 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
           }
         }
 
-      if ( sNext->CellId >= 0 )
+      if ( sNext->CellId >= 0 && useImageField )
+        {
+        imageField.Interpolate(cellIjk, sNext->P, m, &sNext->S);
+        }
+      else if ( sNext->CellId >= 0 )
         {
         cell->EvaluateLocation(sNext->SubId, sNext->P, xNext, w);
         for (j=0; j<3; j++)
@@ -488,6 +729,21 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
             }
           }
 
+        if ( inScalars )
+          {
+          for (sNext->S=0.0, i=0; i < cell->GetNumberOfPoints(); i++)
+            {
+              // output interpolated scalar data
+              sNext->S += cellScalars->GetTuple(i)[0] * w[i];
+              // for curvature coloring for debugging purposes:
+              //sNext->S =K;
+
+            }
+          }
+        }
+
+      if ( sNext->CellId >= 0 )
+        {
         //vtkMath::Jacobi(m, sNext->W, sNext->V);
         vtkDiffusionTensorMathematics::TeemEigenSolver(m,sNext->W,sNext->V);
         FixVectors(sPtr->V, sNext->V, iv, ix, iy);
@@ -516,18 +772,6 @@ vtkPolyData *output = vtkPolyData::SafeDownCast(
           keepIntegrating=0;
           }
 
-        if ( inScalars )
-          {
-          for (sNext->S=0.0, i=0; i < cell->GetNumberOfPoints(); i++)
-            {
-              // output interpolated scalar data
-              sNext->S += cellScalars->GetTuple(i)[0] * w[i];
-              // for curvature coloring for debugging purposes:
-              //sNext->S =K;
-
-            }
-          }
-
         // output tensor at final position
         for (j=0; j<3; j++) 
             {
@@ -911,6 +1155,8 @@ void vtkHyperStreamlineDTMRI::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Radius of Curvature "
     << this->RadiusOfCurvature << "\n";
+  os << indent << "Use Image Interpolation "
+    << this->UseImageInterpolation << "\n";
 }
 
 
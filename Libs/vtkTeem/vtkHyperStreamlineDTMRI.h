@@ -100,6 +100,15 @@ public:
   vtkSetMacro(OneTrajectoryPerSeedPoint, int);
   vtkBooleanMacro(OneTrajectoryPerSeedPoint, int);
 
+  /// 
+  /// Whether to locate points and interpolate tensors with direct index
+  /// arithmetic when the input is a vtkImageData with float or double
+  /// tensors, instead of the generic FindCell() and cell weights.
+  /// The tracts are the same up to round-off. On by default.
+  vtkGetMacro(UseImageInterpolation, int);
+  vtkSetMacro(UseImageInterpolation, int);
+  vtkBooleanMacro(UseImageInterpolation, int);
+
 protected:
   vtkHyperStreamlineDTMRI();
   ~vtkHyperStreamlineDTMRI();
@@ -118,6 +127,8 @@ protected:
 
   int OneTrajectoryPerSeedPoint;
 
+  int UseImageInterpolation;
+
   vtkTractographyArray *Streamers;
 
 private:
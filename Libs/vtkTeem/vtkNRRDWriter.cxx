@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <map>
+#include <vector>
 
 #include "vtkNRRDWriter.h"
 
@@ -8,8 +12,108 @@
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
 
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
+
 class AttributeMapType: public std::map<std::string, std::string> {};
 
+namespace
+{
+
+/// Size of the blocks compressed concurrently
+const size_t GzipBlockSize = 1 << 20;
+/// The last 32KB of the previous block prime the compression of a block
+const size_t GzipDictionarySize = 1 << 15;
+
+//----------------------------------------------------------------------------
+struct GzipBlock
+{
+  const unsigned char *Input;
+  size_t InputSize;
+  size_t DictionarySize;
+  bool Last;
+  std::vector<unsigned char> Output;
+  uLong CRC;
+  bool Failed;
+};
+
+//----------------------------------------------------------------------------
+struct GzipBatch
+{
+  std::vector<GzipBlock> Blocks;
+  int NumberOfThreads;
+};
+
+//----------------------------------------------------------------------------
+// Raw deflate of a block. Blocks but the last end on a byte boundary
+// (sync flush) so that the compressed blocks can be concatenated.
+bool DeflateGzipBlock(GzipBlock& block)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                   8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+  if (block.DictionarySize > 0 &&
+      deflateSetDictionary(&stream, block.Input - block.DictionarySize,
+                           static_cast<uInt>(block.DictionarySize)) != Z_OK)
+    {
+    deflateEnd(&stream);
+    return false;
+    }
+  block.Output.resize(deflateBound(&stream, static_cast<uLong>(block.InputSize)) + 16);
+  stream.next_in = const_cast<Bytef*>(block.Input);
+  stream.avail_in = static_cast<uInt>(block.InputSize);
+  int flush = block.Last ? Z_FINISH : Z_SYNC_FLUSH;
+  int status = Z_OK;
+  size_t written = 0;
+  while (true)
+    {
+    stream.next_out = &block.Output[written];
+    stream.avail_out = static_cast<uInt>(block.Output.size() - written);
+    status = deflate(&stream, flush);
+    written = block.Output.size() - stream.avail_out;
+    if (status == Z_STREAM_ERROR ||
+        (block.Last ? status == Z_STREAM_END : stream.avail_out != 0))
+      {
+      break;
+      }
+    block.Output.resize(2 * block.Output.size());
+    }
+  deflateEnd(&stream);
+  block.Output.resize(written);
+  block.CRC = crc32(crc32(0L, Z_NULL, 0), block.Input,
+                    static_cast<uInt>(block.InputSize));
+  return status != Z_STREAM_ERROR;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE DeflateGzipBlocksThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  GzipBatch *batch = static_cast<GzipBatch*>(info->UserData);
+  for (size_t i = info->ThreadID; i < batch->Blocks.size();
+       i += batch->NumberOfThreads)
+    {
+    batch->Blocks[i].Failed = !DeflateGzipBlock(batch->Blocks[i]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void WriteLittleEndian32(std::ostream& stream, unsigned long value)
+{
+  for (int i = 0; i < 4; ++i)
+    {
+    stream.put(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+} // end of anonymous namespace
+
 vtkCxxRevisionMacro(vtkNRRDWriter, "$Revision: 1.28 $");
 vtkStandardNewMacro(vtkNRRDWriter);
 
@@ -22,6 +126,7 @@ vtkNRRDWriter::vtkNRRDWriter()
   this->IJKToRASMatrix = vtkMatrix4x4::New();
   this->MeasurementFrameMatrix = vtkMatrix4x4::New();
   this->UseCompression = 1;
+  this->NumberOfThreads = 1;
   this->DiffusionWeigthedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -348,6 +453,18 @@ void vtkNRRDWriter::WriteData()
   // set endianness as unknown of output
   nio->endian = airEndianUnknown;
 
+  // Large data of attached header files is compressed by blocks in
+  // parallel: teem only writes the header.
+  size_t dataSize = nrrdElementNumber(nrrd) * nrrdElementSize(nrrd);
+  bool parallelGzip = nio->encoding == nrrdEncodingGzip &&
+    this->NumberOfThreads > 1 && dataSize > GzipBlockSize &&
+    vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(
+      this->GetFileName())) == ".nrrd";
+  if (parallelGzip)
+    {
+    nio->skipData = AIR_TRUE;
+    }
+
   // Write the nrrd to file.
   if (nrrdSave(this->GetFileName(), nrrd, nio))
     {
@@ -356,16 +473,106 @@ void vtkNRRDWriter::WriteData()
                       << this->GetFileName() << ":\n" << err);
     this->WriteErrorOn();
     }
+  else if (parallelGzip && !this->WriteParallelGzipData(buffer, dataSize))
+    {
+    vtkErrorMacro("Write: Error writing compressed data to "
+                  << this->GetFileName());
+    this->WriteErrorOn();
+    }
   // Free the nrrd struct but don't touch nrrd->data
   nrrd = nrrdNix(nrrd);
   nio = nrrdIoStateNix(nio);
   return;
 }
 
+//----------------------------------------------------------------------------
+bool vtkNRRDWriter::WriteParallelGzipData(const void *data, size_t size)
+{
+  // The data follows the blank line that ends the header
+  char tail[2] = {0, 0};
+  std::ifstream header(this->GetFileName(), std::ios::in | std::ios::binary);
+  header.seekg(-2, std::ios::end);
+  header.read(tail, 2);
+  if (!header)
+    {
+    return false;
+    }
+  header.close();
+
+  std::ofstream file(this->GetFileName(),
+                     std::ios::out | std::ios::binary | std::ios::app);
+  if (!file)
+    {
+    return false;
+    }
+  if (tail[0] != '\n' || tail[1] != '\n')
+    {
+    file.put('\n');
+    }
+  // gzip member header: deflate, no flags, no time, unix
+  const char gzipHeader[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+  file.write(gzipHeader, 10);
+
+  const unsigned char *input = static_cast<const unsigned char*>(data);
+  size_t numberOfBlocks = (size + GzipBlockSize - 1) / GzipBlockSize;
+  // Bound the memory used by the compressed blocks waiting to be written
+  size_t batchSize = 4 * static_cast<size_t>(this->NumberOfThreads);
+  uLong crc = crc32(0L, Z_NULL, 0);
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  GzipBatch batch;
+  bool success = true;
+  for (size_t first = 0; success && first < numberOfBlocks; first += batchSize)
+    {
+    size_t last = std::min(first + batchSize, numberOfBlocks);
+    batch.Blocks.resize(last - first);
+    for (size_t i = first; i < last; ++i)
+      {
+      GzipBlock& block = batch.Blocks[i - first];
+      size_t offset = i * GzipBlockSize;
+      block.Input = input + offset;
+      block.InputSize = std::min(GzipBlockSize, size - offset);
+      block.DictionarySize = std::min(GzipDictionarySize, offset);
+      block.Last = (i == numberOfBlocks - 1);
+      block.Failed = false;
+      }
+    batch.NumberOfThreads =
+      std::min(this->NumberOfThreads, static_cast<int>(batch.Blocks.size()));
+    threader->SetNumberOfThreads(batch.NumberOfThreads);
+    threader->SetSingleMethod(DeflateGzipBlocksThread, &batch);
+    threader->SingleMethodExecute();
+
+    for (size_t i = 0; success && i < batch.Blocks.size(); ++i)
+      {
+      GzipBlock& block = batch.Blocks[i];
+      success = !block.Failed;
+      if (!block.Output.empty())
+        {
+        file.write(reinterpret_cast<const char*>(&block.Output[0]),
+                   block.Output.size());
+        }
+      crc = crc32_combine(crc, block.CRC, static_cast<z_off_t>(block.InputSize));
+      }
+    success = success && static_cast<bool>(file);
+    this->UpdateProgress(static_cast<double>(last) / numberOfBlocks);
+    }
+  threader->Delete();
+
+  // gzip member trailer: CRC-32 and size modulo 2^32 of the data
+  WriteLittleEndian32(file, crc);
+  WriteLittleEndian32(file, static_cast<unsigned long>(size & 0xffffffffUL));
+  file.close();
+  return success && !file.fail();
+}
+
+//----------------------------------------------------------------------------
 void vtkNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
 
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+
   os << indent << "RAS to IJK Matrix: ";
      this->IJKToRASMatrix->PrintSelf(os,indent);
   os << indent << "Measurement frame: ";
@@ -6,6 +6,7 @@
 
 #include "vtkMatrix4x4.h"
 #include "vtkDoubleArray.h"
+#include "vtkMultiThreader.h"
 #include "teem/nrrd.h"
 
 #include "vtkTeemConfigure.h"
@@ -52,6 +53,15 @@ public:
   vtkSetMacro(UseCompression,int);
   vtkGetMacro(UseCompression,int);
   vtkBooleanMacro(UseCompression,int);
+
+  /// Number of threads used to compress the data of attached header
+  /// (.nrrd) files. The data is split into blocks that are deflated
+  /// concurrently and concatenated into a single gzip stream, the same
+  /// way pigz does, so any gzip reader can decompress it.
+  /// With 1 thread the data is compressed by teem.
+  /// Default is 1.
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
   
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
@@ -90,6 +100,7 @@ protected:
   vtkMatrix4x4 *MeasurementFrameMatrix;
 
   int UseCompression;
+  int NumberOfThreads;
   int FileType;
   
   AttributeMapType *Attributes;
@@ -99,6 +110,9 @@ private:
   void operator=(const vtkNRRDWriter&);  /// Not implemented.
   void vtkImageDataInfoToNrrdInfo(vtkImageData *in, int &nrrdKind, size_t &numComp, int &vtkType, void **buffer);
   int VTKToNrrdPixelType( const int vtkPixelType );
+  /// Append the gzip compressed data to the header written in FileName.
+  /// Return false on error.
+  bool WriteParallelGzipData(const void *data, size_t size);
   int DiffusionWeigthedData;
 };
 
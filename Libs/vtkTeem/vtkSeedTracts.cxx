@@ -19,14 +19,75 @@
 #include <vtkCellArray.h>
 #include <vtkCommand.h>
 #include <vtkMath.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyDataWriter.h>
+#include <vtkSmartPointer.h>
 #include <vtkTimerLog.h>
 #include <vtkTransformPolyDataFilter.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct StreamlineBatch
+{
+  std::vector<vtkHyperStreamline*> Streamlines;
+  int NumberOfThreads;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE UpdateStreamlinesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  StreamlineBatch* batch = static_cast<StreamlineBatch*>(info->UserData);
+  // Each thread integrates the streamlines that share its tensor field copy
+  for (size_t i = info->ThreadID; i < batch->Streamlines.size();
+       i += batch->NumberOfThreads)
+    {
+    batch->Streamlines[i]->Update();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Test the nearest ROI voxel of each path point from firstPoint
+bool PathIntersectsROI(vtkPoints* path, vtkIdType firstPoint,
+                       vtkTransform* tensorScaledIJKToWorld,
+                       vtkTransform* worldToROI, vtkImageData* roi,
+                       int roiValue)
+{
+  double point[3], point2[3];
+  int pt[3];
+  for (vtkIdType ptidx = firstPoint; ptidx < path->GetNumberOfPoints(); ++ptidx)
+    {
+    path->GetPoint(ptidx, point);
+    // First transform to world space.
+    tensorScaledIJKToWorld->TransformPoint(point, point2);
+    // Now transform to ROI IJK space
+    worldToROI->TransformPoint(point2, point);
+    // Find that voxel number
+    pt[0] = (int) floor(point[0] + 0.5);
+    pt[1] = (int) floor(point[1] + 0.5);
+    pt[2] = (int) floor(point[2] + 0.5);
+    short *tmp = (short *) roi->GetScalarPointer(pt);
+    if (tmp != NULL && *tmp == roiValue)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSeedTracts);
@@ -74,6 +135,9 @@ vtkSeedTracts::vtkSeedTracts()
   this->FilePrefix = NULL;
   this->UseStartingThreshold = 0;
   this->StartingThreshold = 0;
+
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->SeedsPerSecond = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -467,8 +531,6 @@ void vtkSeedTracts::SeedStreamlinesInROI()
   double point[3], point2[3];
 
   short *inPtr;
-  vtkHyperStreamlineDTMRI *newStreamline;
-  int idx;
 
 
   // test we have input
@@ -495,15 +557,6 @@ void vtkSeedTracts::SeedStreamlinesInROI()
       return;      
     }
 
-  vtkNew<vtkTransform> transform;
-  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
-  transform->Inverse();
-
-  vtkNew<vtkTransformPolyDataFilter> transformer;
-  transformer->SetTransform(transform.GetPointer());
-
-  vtkNew<vtkPolyDataWriter> writer;
-
   // make sure we are creating objects with points
   this->UseVtkHyperStreamlinePoints();
  
@@ -513,8 +566,8 @@ void vtkSeedTracts::SeedStreamlinesInROI()
   this->InputTensorField->GetWholeExtent(extent);
   this->InputTensorField->GetSpacing(spacing);
 
-  // currently this filter is not multithreaded, though in the future 
-  // it could be (especially if it inherits from an image filter class)
+  // The seeds are collected first, then the streamlines are integrated
+  // in parallel by IntegrateStreamlines()
   this->InputROI->GetWholeExtent(inExt);
 
   // find the region to loop over
@@ -551,32 +604,16 @@ void vtkSeedTracts::SeedStreamlinesInROI()
   m[0] = m0; m[1] = m1; m[2] = m2; 
   v[0] = v0; v[1] = v1; v[2] = v2;
 
-  // filename index
-  idx=0;
-
-  int gridIncXYZ = gridIncX*gridIncY*gridIncZ;
-  int numLabelVoxels = 0;
-  if (gridIncXYZ)
-    {
-    numLabelVoxels = maxX*maxY*maxZ/gridIncXYZ;
-    }
-  int labelVoxelCount = 0;
-  int progressCount = 0;
-  int progressCountMax = 100;
-  double progress;
+  vtkNew<vtkPoints> seeds;
 
   for (idxZ = 0; idxZ <= maxZ; idxZ+=gridIncZ)
     {
-      // just output (fractional or integer) current slice number
-      std::cout << idxZ << " / " << maxZ << endl;
-
       //for (idxY = 0; !this->AbortExecute && idxY <= maxY; idxY++)
       for (idxY = 0; idxY <= maxY; idxY+=gridIncY)
         {
           
           for (idxX = 0; idxX <= maxX; idxX+=gridIncX)
             {
-              labelVoxelCount++;
               // get the pointer to the nearest voxel at this location
               int pt[3];
               pt[0]= (int) floor(idxX + 0.5);
@@ -656,73 +693,7 @@ void vtkSeedTracts::SeedStreamlinesInROI()
                         }
                       } // end if (UseStartingThreshold)
 
-                      // Report progress
-                      if (numLabelVoxels && progressCount == progressCountMax)
-                        {
-                        progressCount = 0;
-                        progress = (labelVoxelCount+0.0)/numLabelVoxels;
-                        this->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
-                        }
-                      else
-                        {
-                        progressCount++;
-                        }
-                      // Now create a streamline 
-                      newStreamline=(vtkHyperStreamlineDTMRI *) 
-                        this->CreateHyperStreamline();
-                      
-                      // Set its input information.
-                      newStreamline->SetInput(this->InputTensorField);
-                      newStreamline->SetStartPosition(point[0],point[1],point[2]);
-                      //newStreamline->DebugOn();
-
-                      // Ask it to output tensors and to only do one trajectory per start point
-                      newStreamline->OutputTensorsOn();
-                      newStreamline->OneTrajectoryPerSeedPointOn();
-
-                      // Force it to execute
-                      newStreamline->Update();
-
-                      // See if we like it enough to add to the collection
-                      // This relies on the fact that the step length is in units of
-                      // length (unlike fractions of a cell in vtkHyperStreamline).
-                      double length = 
-                        (newStreamline->GetOutput()->GetNumberOfPoints() - 1) * 
-                        newStreamline->GetIntegrationStepLength();
- 
-                      if (length > this->MinimumPathLength)
-                        {
-                        if (this->FileDirectoryName) 
-                          // write streamline to disk
-                          {
-                          if (this->FilePrefix == NULL)
-                            {
-                            this->SetFilePrefix("line");
-                            }
-                          // transform model
-                          transformer->SetInput(newStreamline->GetOutput());
-                          
-                          // Save the model to disk
-                          writer->SetInput(transformer->GetOutput());
-                          writer->SetFileType(2);
-
-                          std::stringstream fileNameStr;
-                          fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << idx << ".vtk";
-                          writer->SetFileName(fileNameStr.str().c_str());
-                          writer->Write();
-                          newStreamline->Delete();
-                          }
-                        else
-                          {
-                          // keep the streamline in memory
-                          this->Streamlines->AddItem((vtkObject *) newStreamline);
-                          }
-                        idx++;
-                        }
-                      else
-                        {
-                        newStreamline->Delete();
-                        }
+                      seeds->InsertNextPoint(point);
                     }
                 }
 
@@ -732,6 +703,7 @@ void vtkSeedTracts::SeedStreamlinesInROI()
 
     }
 
+  this->IntegrateStreamlines(seeds.GetPointer(), SelectByLength);
 }
 
 
@@ -942,11 +914,6 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
 
   //unsigned long target;
   short *inPtr;
-  vtkHyperStreamlineDTMRI *newStreamline;
-
-  // time
-  vtkTimerLog *timer = vtkTimerLog::New();
-  timer->StartTimer();
 
   // test we have input
   if (this->InputROI == NULL)
@@ -978,26 +945,8 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
       return;      
     }
 
-  vtkNew<vtkTransform> transform;
-  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
-  transform->Inverse();
-
-  vtkNew<vtkTransformPolyDataFilter> transformer;
-  transformer->SetTransform(transform.GetPointer());
-
-  vtkNew<vtkPolyDataWriter> writer;
-
-  // Create transformation matrices to go backwards from streamline points to ROI space
-  // This is used to access ROI2.
-  vtkTransform *WorldToROI2 = vtkTransform::New();
-  WorldToROI2->SetMatrix(this->ROI2ToWorld->GetMatrix());
-  WorldToROI2->Inverse();
-  vtkTransform *TensorScaledIJKToWorld = vtkTransform::New();
-  TensorScaledIJKToWorld->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
-  TensorScaledIJKToWorld->Inverse();
-
-  // currently this filter is not multithreaded, though in the future 
-  // it could be (especially if it inherits from an image filter class)
+  // The seeds are collected first, then the streamlines are integrated
+  // in parallel by IntegrateStreamlines()
   this->InputROI->GetWholeExtent(inExt);
   this->InputROI->GetContinuousIncrements(inExt, inIncX, inIncY, inIncZ);
 
@@ -1009,16 +958,14 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
   //cout << "Dims: " << maxX << " " << maxY << " " << maxZ << endl;
   //cout << "Incr: " << inIncX << " " << inIncY << " " << inIncZ << endl;
 
-  // for progress notification
-  //target = (unsigned long)((maxZ+1)*(maxY+1)/50.0);
-  //target++;
-
   // start point in input integer field
   inPtr = (short *) this->InputROI->GetScalarPointerForExtent(inExt);
 
   // testing for seeding at a certain resolution.
   int increment = 1;
 
+  vtkNew<vtkPoints> seeds;
+
   for (idxZ = 0; idxZ <= maxZ; idxZ++)
     {
       //for (idxY = 0; !this->AbortExecute && idxY <= maxY; idxY++)
@@ -1046,106 +993,7 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
                   // make sure it is within the bounds of the tensor dataset
                   if (this->PointWithinTensorData(point,point2))
                     {
-                      // Now create a streamline.
-                      newStreamline=(vtkHyperStreamlineDTMRI *) this->CreateHyperStreamline();
-
-                      // Set its input information.
-                      newStreamline->SetInput(this->InputTensorField);
-                      newStreamline->SetStartPosition(point[0],point[1],point[2]);
-                      
-                      // Force it to update to access the path points
-                      newStreamline->Update();
-                      
-                      // for each point on the path, test
-                      // the nearest voxel for path/ROI intersection.
-                      vtkPoints * hs0
-                        = newStreamline->GetOutput()->GetCell(0)->GetPoints();
-
-                      int numPts=hs0->GetNumberOfPoints();
-                      int ptidx=0;
-                      int pt[3];
-                      int intersects = 0;
-                      while (ptidx < numPts)
-                        {
-                          hs0->GetPoint(ptidx,point);
-                          // First transform to world space.
-                          TensorScaledIJKToWorld->TransformPoint(point,point2);
-                          // Now transform to ROI2 IJK space
-                          WorldToROI2->TransformPoint(point2,point);
-                          // Find that voxel number
-                          pt[0]= (int) floor(point[0]+0.5);
-                          pt[1]= (int) floor(point[1]+0.5);
-                          pt[2]= (int) floor(point[2]+0.5);
-                          short *tmp = (short *) this->InputROI2->GetScalarPointer(pt);
-                          if (tmp != NULL)
-                            {
-                              if (*tmp == this->InputROI2Value) {
-                                intersects = 1;
-                              }
-                            }
-                          ptidx++;
-                        }
-
-                      vtkPoints * hs1
-                        = newStreamline->GetOutput()->GetCell(1)->GetPoints();
-                      numPts=hs1->GetNumberOfPoints();
-                      // Skip the first point in the second line since it
-                      // is a duplicate of the initial point.
-                      ptidx=1;
-                      while (ptidx < numPts)
-                        {
-                          hs1->GetPoint(ptidx,point);
-                          // First transform to world space.
-                          TensorScaledIJKToWorld->TransformPoint(point,point2);
-                          // Now transform to ROI IJK space
-                          WorldToROI2->TransformPoint(point2,point);
-                          // Find that voxel number
-                          pt[0]= (int) floor(point[0]+0.5);
-                          pt[1]= (int) floor(point[1]+0.5);
-                          pt[2]= (int) floor(point[2]+0.5);
-                          short *tmp = (short *) this->InputROI2->GetScalarPointer(pt);
-                          if (tmp != NULL)
-                            {
-                              if (*tmp == this->InputROI2Value) {
-                                intersects = 1;
-                              }
-                            }
-                          ptidx++;
-                        }                          
-
-                      // if it intersects with some ROI, then 
-                      // display it, otherwise delete it.
-                      if (intersects) 
-                        {
-                        if (this->FileDirectoryName) 
-                          {
-                          if (this->FilePrefix == NULL)
-                            {
-                            this->SetFilePrefix("line");
-                            }
-                          // transform model
-                          transformer->SetInput(newStreamline->GetOutput());
-                          
-                          // Save the model to disk
-                          writer->SetInput(transformer->GetOutput());
-                          writer->SetFileType(2);
-                          
-                          std::stringstream fileNameStr;
-                          fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << this->Streamlines->GetNumberOfItems()-1 << ".vtk";
-                          writer->SetFileName(fileNameStr.str().c_str());
-                          writer->Write();
-                          }
-                        else
-                          {
-                          this->Streamlines->AddItem((vtkObject *)newStreamline);
-                          newStreamline->Delete();
-                          }
-                        }
-                      else 
-                        {
-                          newStreamline->Delete();
-                        }
-
+                    seeds->InsertNextPoint(point);
                     } // end if inside tensor field
 
                 } // end if in ROI
@@ -1161,9 +1009,173 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
       inPtr += inIncZ;
     }
 
+  this->IntegrateStreamlines(seeds.GetPointer(), SelectByROI2Intersection);
+}
+
+// Integrate the streamlines of the seeds by batches. Within a batch, the
+// threads interleave the seeds and each one probes its own copy of the
+// tensor field. The streamlines of the batch are then selected in seed
+// order, so that the result does not depend on the number of threads.
+//----------------------------------------------------------------------------
+void vtkSeedTracts::IntegrateStreamlines(vtkPoints *seeds, int selection)
+{
+  vtkIdType numberOfSeeds = seeds->GetNumberOfPoints();
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  // Create transformation matrix to place actors in scene
+  // This is used to transform the models before writing them to disk
+  vtkNew<vtkTransform> transform;
+  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
+  transform->Inverse();
+
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetTransform(transform.GetPointer());
+
+  vtkNew<vtkPolyDataWriter> writer;
+
+  // Create transformation matrices to go backwards from streamline points to ROI space
+  // This is used to access ROI2.
+  vtkNew<vtkTransform> worldToROI2;
+  worldToROI2->SetMatrix(this->ROI2ToWorld->GetMatrix());
+  worldToROI2->Inverse();
+
+  // vtkImageData::FindCell() and GetCell() are not thread safe, give each
+  // thread a shallow copy of the tensor field
+  int numberOfThreads = static_cast<int>(
+    std::min(static_cast<vtkIdType>(this->NumberOfThreads),
+             std::max(numberOfSeeds, static_cast<vtkIdType>(1))));
+  std::vector<vtkSmartPointer<vtkImageData> > tensorFields;
+  if (numberOfThreads == 1)
+    {
+    tensorFields.push_back(this->InputTensorField);
+    }
+  else
+    {
+    this->InputTensorField->Update();
+    for (int i = 0; i < numberOfThreads; ++i)
+      {
+      vtkSmartPointer<vtkImageData> tensorField = vtkSmartPointer<vtkImageData>::New();
+      tensorField->ShallowCopy(this->InputTensorField);
+      tensorFields.push_back(tensorField);
+      }
+    }
+
+  // Bound the memory used by the streamlines waiting to be selected
+  vtkIdType batchSize = 64 * numberOfThreads;
+  vtkNew<vtkMultiThreader> threader;
+  StreamlineBatch batch;
+  // filename index
+  int idx = 0;
+  double point[3];
+  for (vtkIdType first = 0; first < numberOfSeeds; first += batchSize)
+    {
+    vtkIdType last = std::min(first + batchSize, numberOfSeeds);
+    batch.Streamlines.resize(last - first);
+    batch.NumberOfThreads =
+      static_cast<int>(std::min(static_cast<vtkIdType>(numberOfThreads), last - first));
+    for (vtkIdType i = first; i < last; ++i)
+      {
+      // Now create a streamline 
+      vtkHyperStreamline *newStreamline = this->CreateHyperStreamline();
+
+      // Set its input information.
+      newStreamline->SetInput(tensorFields[(i - first) % batch.NumberOfThreads]);
+      seeds->GetPoint(i, point);
+      newStreamline->SetStartPosition(point[0],point[1],point[2]);
+
+      // Ask it to output tensors and to only do one trajectory per start point
+      vtkHyperStreamlineDTMRI *streamlineDTMRI =
+        vtkHyperStreamlineDTMRI::SafeDownCast(newStreamline);
+      if (selection == SelectByLength && streamlineDTMRI)
+        {
+        streamlineDTMRI->OutputTensorsOn();
+        streamlineDTMRI->OneTrajectoryPerSeedPointOn();
+        }
+      batch.Streamlines[i - first] = newStreamline;
+      }
+
+    // Force them to execute
+    threader->SetNumberOfThreads(batch.NumberOfThreads);
+    threader->SetSingleMethod(UpdateStreamlinesThread, &batch);
+    threader->SingleMethodExecute();
+
+    for (size_t i = 0; i < batch.Streamlines.size(); ++i)
+      {
+      vtkHyperStreamline *newStreamline = batch.Streamlines[i];
+      vtkPolyData *path = newStreamline->GetOutput();
+      bool selected = false;
+      if (selection == SelectByLength)
+        {
+        // See if we like it enough to add to the collection
+        // This relies on the fact that the step length is in units of
+        // length (unlike fractions of a cell in vtkHyperStreamline).
+        double length = (path->GetNumberOfPoints() - 1) *
+          newStreamline->GetIntegrationStepLength();
+        selected = (length > this->MinimumPathLength);
+        }
+      else
+        {
+        // for each point on the path, test
+        // the nearest voxel for path/ROI intersection.
+        // Skip the first point in the second line since it
+        // is a duplicate of the initial point.
+        selected =
+          (path->GetNumberOfCells() > 0 &&
+           PathIntersectsROI(path->GetCell(0)->GetPoints(), 0,
+                             transform.GetPointer(), worldToROI2.GetPointer(),
+                             this->InputROI2, this->InputROI2Value)) ||
+          (path->GetNumberOfCells() > 1 &&
+           PathIntersectsROI(path->GetCell(1)->GetPoints(), 1,
+                             transform.GetPointer(), worldToROI2.GetPointer(),
+                             this->InputROI2, this->InputROI2Value));
+        }
+
+      if (!selected)
+        {
+        newStreamline->Delete();
+        continue;
+        }
+      if (this->FileDirectoryName) 
+        // write streamline to disk
+        {
+        if (this->FilePrefix == NULL)
+          {
+          this->SetFilePrefix("line");
+          }
+        // transform model
+        transformer->SetInput(path);
+
+        // Save the model to disk
+        writer->SetInput(transformer->GetOutput());
+        writer->SetFileType(2);
+
+        std::stringstream fileNameStr;
+        fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << idx << ".vtk";
+        writer->SetFileName(fileNameStr.str().c_str());
+        writer->Write();
+        newStreamline->Delete();
+        }
+      else
+        {
+        // keep the streamline in memory
+        this->Streamlines->AddItem((vtkObject *) newStreamline);
+        }
+      idx++;
+      }
+
+    // Report progress
+    double progress = static_cast<double>(last) / numberOfSeeds;
+    this->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
+    }
+
   timer->StopTimer();
-  std::cout << "Tractography in ROI time: " << timer->GetElapsedTime() << endl;
-  timer->Delete();
+  double time = timer->GetElapsedTime();
+  this->SeedsPerSecond = (time > 0.) ? numberOfSeeds / time : 0.;
+  std::cout << "Tractography in ROI time: " << time << " s for "
+            << numberOfSeeds << " seeds (" << this->SeedsPerSecond
+            << " seeds/s with " << numberOfThreads << " threads)" << endl;
 }
 
 //----------------------------------------------------------------------------
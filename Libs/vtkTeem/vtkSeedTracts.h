@@ -23,6 +23,7 @@
 #include "vtkImageData.h"
 #include "vtkTransform.h"
 #include "vtkCollection.h"
+#include "vtkMultiThreader.h"
 #include "vtkShortArray.h"
 
 #include "vtkHyperStreamline.h"
@@ -30,6 +31,8 @@
 #include "vtkHyperStreamlineTeem.h"
 #include "vtkPreciseHyperStreamlinePoints.h"
 
+class vtkPoints;
+
 #define USE_VTK_HYPERSTREAMLINE 0
 #define USE_VTK_HYPERSTREAMLINE_POINTS 1
 #define USE_VTK_PRECISE_HYPERSTREAMLINE_POINTS 2
@@ -248,6 +251,16 @@ public:
   vtkGetMacro(UseStartingThreshold,int)
   vtkBooleanMacro(UseStartingThreshold,int)
 
+  /// Number of threads integrating the streamlines seeded in ROIs.
+  /// The streamlines are kept (or written) in the order of their seeds
+  /// whatever the number of threads.
+  /// Default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+  /// Number of seeds integrated per second by the last seeding in ROIs.
+  vtkGetMacro(SeedsPerSecond,double);
+
   /// 
   /// A file directory name for lines
   vtkSetStringMacro(FileDirectoryName);
@@ -264,6 +277,18 @@ protected:
 
   vtkHyperStreamline *CreateHyperStreamline();
 
+  /// How IntegrateStreamlines() selects the streamlines to keep
+  enum
+  {
+    SelectByLength = 0,
+    SelectByROI2Intersection
+  };
+
+  /// Integrate a streamline from each seed (in scaled IJK of the tensor
+  /// field) with NumberOfThreads threads. The selected streamlines are
+  /// added to Streamlines, or written to FileDirectoryName, in seed order.
+  void IntegrateStreamlines(vtkPoints *seeds, int selection);
+
   vtkCollection *Streamlines;
 
   vtkTransform *ROIToWorld;
@@ -298,6 +323,9 @@ protected:
 
   int UseStartingThreshold;
 
+  int NumberOfThreads;
+  double SeedsPerSecond;
+
   /// Here we have a representative accessible object 
   /// of each type, so that the user can modify it.
   /// We copy its settings to each new created streamline.
@@ -15,12 +15,15 @@ Version:   $Revision: 1.3 $
 // VTK includes
 #include <vtkCleanPolyData.h>
 #include <vtkCommand.h>
-#include <vtkExtractPolyDataGeometry.h>
+#include <vtkDoubleArray.h>
 #include <vtkExtractSelectedPolyDataIds.h>
 #include <vtkIdTypeArray.h>
 #include <vtkInformation.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlanes.h>
+#include <vtkPolyData.h>
 #include <vtkSelection.h>
 #include <vtkSelectionNode.h>
 
@@ -36,6 +39,7 @@ Version:   $Revision: 1.3 $
 #include <vtkMRMLScene.h>
 #include <vtkMRMLAnnotationNode.h>
 #include <vtkMRMLAnnotationROINode.h>
+#include <vtkMRMLTransformNode.h>
 
 // STD includes
 #include <algorithm>
@@ -43,6 +47,57 @@ Version:   $Revision: 1.3 $
 #include <math.h>
 #include <vector>
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// World bounds of the ROI box. Return false if they can not be used to cull
+// the fibers: the ROI is inside out or has a non linear transform.
+bool GetROIBounds(vtkMRMLAnnotationROINode* roi, double bounds[6])
+{
+  if (roi->GetInsideOut())
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> transformToWorld;
+  vtkMRMLTransformNode* transformNode = roi->GetParentTransformNode();
+  if (transformNode &&
+      !transformNode->GetMatrixTransformToWorld(transformToWorld.GetPointer()))
+    {
+    return false;
+    }
+  double center[3];
+  double radius[3];
+  roi->GetXYZ(center);
+  roi->GetRadiusXYZ(radius);
+  bounds[0] = bounds[2] = bounds[4] = VTK_DOUBLE_MAX;
+  bounds[1] = bounds[3] = bounds[5] = -VTK_DOUBLE_MAX;
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double point[4] = {center[0] + ((corner & 1) ? radius[0] : -radius[0]),
+                       center[1] + ((corner & 2) ? radius[1] : -radius[1]),
+                       center[2] + ((corner & 4) ? radius[2] : -radius[2]),
+                       1.};
+    transformToWorld->MultiplyPoint(point, point);
+    for (int i = 0; i < 3; ++i)
+      {
+      bounds[2*i] = std::min(bounds[2*i], point[i]);
+      bounds[2*i+1] = std::max(bounds[2*i+1], point[i]);
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool BoundsOverlap(const double bounds1[6], const double bounds2[6])
+{
+  return bounds1[0] <= bounds2[1] && bounds2[0] <= bounds1[1] &&
+         bounds1[2] <= bounds2[3] && bounds2[2] <= bounds1[3] &&
+         bounds1[4] <= bounds2[5] && bounds2[4] <= bounds1[5];
+}
+
+} // end of anonymous namespace
+
 //------------------------------------------------------------------------------
 vtkCxxSetReferenceStringMacro(vtkMRMLFiberBundleNode, AnnotationNodeID);
 
@@ -60,12 +115,15 @@ vtkMRMLFiberBundleNode::vtkMRMLFiberBundleNode()
   this->CleanPolyDataPostSubsampling = 0;
   this->CleanPolyDataPostROISelection = 0;
   this->SubsamplingRatio = 0;
+  this->LevelOfDetail = 1.;
   this->SelectWithAnnotationNode = 0;
   this->SelectionWithAnnotationNodeMode = vtkMRMLFiberBundleNode::PositiveAnnotationNodeSelection;
   this->AnnotationNode = 0;
   this->AnnotationNodeID = 0;
-  this->ExtractPolyDataGeometry = 0;
+  this->ExtractROISelectedPolyDataIds = 0;
   this->Planes = 0;
+  this->FiberBounds = 0;
+  this->FiberBoundsTime = 0;
   this->SelectWithAnnotationNode = 0;
   this->EnableShuffleIDs = 1;
 
@@ -172,6 +230,7 @@ void vtkMRMLFiberBundleNode::PrintSelf(ostream& os, vtkIndent indent)
   
   Superclass::PrintSelf(os,indent);
 
+  os << indent << "LevelOfDetail: " << this->LevelOfDetail << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -390,6 +449,7 @@ vtkMRMLFiberBundleDisplayNode* vtkMRMLFiberBundleNode::AddGlyphDisplayNode()
 void vtkMRMLFiberBundleNode::SetAndObservePolyData(vtkPolyData* polyData)
 {
   this->ExtractSelectedPolyDataIds->SetInput(0, polyData);
+  this->ExtractROISelectedPolyDataIds->SetInput(0, polyData);
   this->Superclass::SetAndObservePolyData(polyData);
 
   if (polyData)
@@ -454,6 +514,70 @@ void vtkMRMLFiberBundleNode::SetSubsamplingRatio (float _arg)
     }
   }
 
+//----------------------------------------------------------------------------
+void vtkMRMLFiberBundleNode::SetLevelOfDetail(const char* viewNodeID, double viewLevelOfDetail)
+{
+  if (!viewNodeID)
+    {
+    vtkErrorMacro("SetLevelOfDetail: invalid view node ID");
+    return;
+    }
+  viewLevelOfDetail = std::max(0.01, std::min(1., viewLevelOfDetail));
+  if (viewLevelOfDetail == 1.)
+    {
+    this->ViewLevelOfDetails.erase(viewNodeID);
+    }
+  else
+    {
+    this->ViewLevelOfDetails[viewNodeID] = viewLevelOfDetail;
+    }
+
+  double levelOfDetail = 1.;
+  std::map<std::string, double>::const_iterator it;
+  for (it = this->ViewLevelOfDetails.begin(); it != this->ViewLevelOfDetails.end(); ++it)
+    {
+    levelOfDetail = std::min(levelOfDetail, it->second);
+    }
+  if (this->LevelOfDetail == levelOfDetail)
+    {
+    return;
+    }
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting LevelOfDetail to " << levelOfDetail);
+  this->LevelOfDetail = levelOfDetail;
+  // Not a property of the node, do not call Modified()
+  vtkMRMLFiberBundleTubeDisplayNode* tubeDisplayNode =
+    vtkMRMLFiberBundleTubeDisplayNode::SafeDownCast(this->GetTubeDisplayNode());
+  if (tubeDisplayNode)
+    {
+    tubeDisplayNode->SetLevelOfDetail(levelOfDetail);
+    }
+  this->UpdateSubsampling();
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLFiberBundleNode::GetLevelOfDetail(const char* viewNodeID)
+{
+  std::map<std::string, double>::const_iterator it =
+    viewNodeID ? this->ViewLevelOfDetails.find(viewNodeID) : this->ViewLevelOfDetails.end();
+  return it != this->ViewLevelOfDetails.end() ? it->second : 1.;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMRMLFiberBundleNode::GetNumberOfFibersToShow()
+{
+  vtkPolyData* polyData = this->GetPolyData();
+  if (!polyData)
+    {
+    return 0;
+    }
+  vtkIdType numberOfFibers = std::min(
+    vtkIdType(floor(polyData->GetNumberOfLines() * this->SubsamplingRatio)),
+    this->ShuffledIds->GetNumberOfTuples());
+  vtkIdType numberOfFibersToShow = vtkIdType(floor(numberOfFibers * this->LevelOfDetail));
+  // always show a fiber of a subsampled bundle
+  return (numberOfFibers > 0 && numberOfFibersToShow == 0) ? 1 : numberOfFibersToShow;
+}
+
 
 //----------------------------------------------------------------------------
 void vtkMRMLFiberBundleNode::SetSelectWithAnnotationNode(int _arg)
@@ -463,6 +587,10 @@ void vtkMRMLFiberBundleNode::SetSelectWithAnnotationNode(int _arg)
   if (this->SelectWithAnnotationNode != _arg)
     {
     this->SelectWithAnnotationNode = _arg;
+    if (this->SelectWithAnnotationNode)
+      {
+      this->SelectFibersInROI();
+      }
     this->SetPolyDataToDisplayNodes();
     this->Modified();
     }
@@ -476,14 +604,10 @@ void vtkMRMLFiberBundleNode::SetSelectionWithAnnotationNodeMode(int _arg)
     { 
     this->SelectionWithAnnotationNodeMode = _arg;
 
-    if (_arg == vtkMRMLFiberBundleNode::PositiveAnnotationNodeSelection)
-    {
-      this->ExtractPolyDataGeometry->ExtractInsideOn();
-      this->ExtractPolyDataGeometry->ExtractBoundaryCellsOn();
-    } else if (_arg == vtkMRMLFiberBundleNode::NegativeAnnotationNodeSelection) {
-      this->ExtractPolyDataGeometry->ExtractInsideOff();
-      this->ExtractPolyDataGeometry->ExtractBoundaryCellsOff();
-    }
+    if (this->SelectWithAnnotationNode)
+      {
+      this->SelectFibersInROI();
+      }
 
     this->Modified();
     // \tbd really needed ?
@@ -577,7 +701,7 @@ void vtkMRMLFiberBundleNode::UpdateSubsampling()
     vtkSelectionNode* node = sel->GetNode(0);
 
     vtkIdTypeArray* arr = vtkIdTypeArray::SafeDownCast(node->GetSelectionList());
-    vtkIdType numberOfCellsToKeep = vtkIdType(floor(this->GetPolyData()->GetNumberOfLines() * this->SubsamplingRatio));
+    vtkIdType numberOfCellsToKeep = this->GetNumberOfFibersToShow();
 
     arr->Initialize();
     arr->SetNumberOfTuples(numberOfCellsToKeep);
@@ -593,6 +717,10 @@ void vtkMRMLFiberBundleNode::UpdateSubsampling()
     node->Modified();
     sel->Modified();
     }
+  if (this->SelectWithAnnotationNode)
+    {
+    this->SelectFibersInROI();
+    }
 
   /*
   vtkMRMLFiberBundleDisplayNode *node = this->GetLineDisplayNode();
@@ -632,13 +760,24 @@ void vtkMRMLFiberBundleNode::PrepareROISelection()
   this->AnnotationNode = NULL;
   this->AnnotationNodeID = NULL;
 
-  this->ExtractPolyDataGeometry = vtkExtractPolyDataGeometry::New();
+  vtkSelection* sel = vtkSelection::New();
+  vtkSelectionNode* node = vtkSelectionNode::New();
+  vtkIdTypeArray* arr = vtkIdTypeArray::New();
+
+  this->ExtractROISelectedPolyDataIds = vtkExtractSelectedPolyDataIds::New();
   this->Planes = vtkPlanes::New();
+  this->FiberBounds = vtkDoubleArray::New();
+  this->FiberBounds->SetNumberOfComponents(6);
 
-  this->ExtractPolyDataGeometry->ExtractInsideOn();
-  this->ExtractPolyDataGeometry->ExtractBoundaryCellsOn();
-  this->ExtractPolyDataGeometry->SetInputConnection(
-    this->CleanPolyDataPostSubsampling->GetOutputPort());
+  sel->AddNode(node);
+  node->GetProperties()->Set(vtkSelectionNode::CONTENT_TYPE(), vtkSelectionNode::INDICES);
+  node->GetProperties()->Set(vtkSelectionNode::FIELD_TYPE(), vtkSelectionNode::CELL);
+  node->SetSelectionList(arr);
+  this->ExtractROISelectedPolyDataIds->SetInput(1, sel);
+
+  arr->Delete();
+  node->Delete();
+  sel->Delete();
 
   this->SelectionWithAnnotationNodeMode = vtkMRMLFiberBundleNode::PositiveAnnotationNodeSelection;
 
@@ -649,7 +788,7 @@ void vtkMRMLFiberBundleNode::PrepareROISelection()
   this->CleanPolyDataPostROISelection->PointMergingOff();
 
   this->CleanPolyDataPostROISelection->SetInputConnection(
-    this->ExtractPolyDataGeometry->GetOutputPort());
+    this->ExtractROISelectedPolyDataIds->GetOutputPort());
 
   this->SelectWithAnnotationNode = 0;
 }
@@ -657,16 +796,101 @@ void vtkMRMLFiberBundleNode::PrepareROISelection()
 //----------------------------------------------------------------------------
 void vtkMRMLFiberBundleNode::UpdateROISelection()
 {
-  vtkMRMLAnnotationROINode* AnnotationROI =
+  if (this->GetSelectWithAnnotationNode())
+    {
+    this->SelectFibersInROI();
+    this->InvokeEvent(vtkMRMLModelNode::PolyDataModifiedEvent, this);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLFiberBundleNode::SelectFibersInROI()
+{
+  vtkSelection* sel = vtkSelection::SafeDownCast(this->ExtractROISelectedPolyDataIds->GetInput(1));
+  vtkSelectionNode* node = sel->GetNode(0);
+  vtkIdTypeArray* arr = vtkIdTypeArray::SafeDownCast(node->GetSelectionList());
+  arr->Initialize();
+
+  vtkMRMLAnnotationROINode* annotationROI =
     vtkMRMLAnnotationROINode::SafeDownCast(this->AnnotationNode);
-  if (AnnotationROI)
+  vtkPolyData* polyData = this->GetPolyData();
+  if (annotationROI && polyData)
     {
-    AnnotationROI->GetTransformedPlanes(this->Planes);
-    this->ExtractPolyDataGeometry->SetImplicitFunction(this->Planes);
+    annotationROI->GetTransformedPlanes(this->Planes);
+    this->UpdateFiberBounds();
+
+    // Only the fibers that overlap the ROI bounds can have points inside
+    double roiBounds[6];
+    bool cull = GetROIBounds(annotationROI, roiBounds);
+    bool positive =
+      (this->SelectionWithAnnotationNodeMode == vtkMRMLFiberBundleNode::PositiveAnnotationNodeSelection);
+
+    // Keep the displayed (subsampled) fibers with a point inside the ROI
+    // in positive mode, with all their points outside in negative mode.
+    vtkIdType numberOfFibers = this->GetNumberOfFibersToShow();
+    vtkIdType npts;
+    vtkIdType* pts;
+    double point[3];
+    for (vtkIdType i = 0; i < numberOfFibers; ++i)
+      {
+      vtkIdType fiberId = this->ShuffledIds->GetValue(i);
+      bool keep = !positive;
+      if (!cull || BoundsOverlap(this->FiberBounds->GetPointer(6 * fiberId), roiBounds))
+        {
+        polyData->GetCellPoints(fiberId, npts, pts);
+        for (vtkIdType j = 0; j < npts; ++j)
+          {
+          polyData->GetPoint(pts[j], point);
+          double value = this->Planes->EvaluateFunction(point);
+          if (positive ? value < 0. : value <= 0.)
+            {
+            keep = positive;
+            break;
+            }
+          }
+        }
+      if (keep)
+        {
+        arr->InsertNextValue(fiberId);
+        }
+      }
     }
-  if (this->GetSelectWithAnnotationNode())
+
+  arr->Modified();
+  node->Modified();
+  sel->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLFiberBundleNode::UpdateFiberBounds()
+{
+  vtkPolyData* polyData = this->GetPolyData();
+  if (!polyData || polyData->GetMTime() == this->FiberBoundsTime)
     {
-    this->InvokeEvent(vtkMRMLModelNode::PolyDataModifiedEvent, this);
+    return;
+    }
+  this->FiberBoundsTime = polyData->GetMTime();
+
+  vtkIdType numberOfFibers = polyData->GetNumberOfLines();
+  this->FiberBounds->SetNumberOfTuples(numberOfFibers);
+  vtkIdType npts;
+  vtkIdType* pts;
+  double point[3];
+  for (vtkIdType fiberId = 0; fiberId < numberOfFibers; ++fiberId)
+    {
+    double* bounds = this->FiberBounds->GetPointer(6 * fiberId);
+    bounds[0] = bounds[2] = bounds[4] = VTK_DOUBLE_MAX;
+    bounds[1] = bounds[3] = bounds[5] = -VTK_DOUBLE_MAX;
+    polyData->GetCellPoints(fiberId, npts, pts);
+    for (vtkIdType j = 0; j < npts; ++j)
+      {
+      polyData->GetPoint(pts[j], point);
+      for (int k = 0; k < 3; ++k)
+        {
+        bounds[2*k] = std::min(bounds[2*k], point[k]);
+        bounds[2*k+1] = std::max(bounds[2*k+1], point[k]);
+        }
+      }
     }
 }
 
@@ -676,8 +900,9 @@ void vtkMRMLFiberBundleNode::CleanROISelection()
 {
   this->SetAndObserveAnnotationNodeID(NULL);
   this->CleanPolyDataPostROISelection->Delete();
-  this->ExtractPolyDataGeometry->Delete();
+  this->ExtractROISelectedPolyDataIds->Delete();
   this->Planes->Delete();
+  this->FiberBounds->Delete();
 }
 
 
@@ -28,11 +28,15 @@
 // Tractography includes
 #include "vtkSlicerTractographyDisplayModuleMRMLExport.h"
 
+// STD includes
+#include <map>
+#include <string>
+
 class vtkMRMLFiberBundleDisplayNode;
 class vtkExtractSelectedPolyDataIds;
 class vtkMRMLAnnotationNode;
 class vtkIdTypeArray;
-class vtkExtractPolyDataGeometry;
+class vtkDoubleArray;
 class vtkPlanes;
 class vtkCleanPolyData;
 
@@ -104,6 +108,21 @@ public:
 
   //vtkSetClampMacro(SubsamplingRatio, float, 0, 1);
 
+  /// Fraction of the subsampled fibers that are actually displayed: the
+  /// lowest of the levels of detail requested by the views. 1 by default.
+  vtkGetMacro(LevelOfDetail, double);
+
+  /// Level of detail requested by the view \a viewNodeID. The displayable
+  /// managers lower it while their view is interacted to keep its frame
+  /// time within budget, and set it back to 1 on the still renders.
+  /// The views share the fiber geometry, it is displayed at the lowest
+  /// requested level of detail. It is not saved with the scene.
+  virtual void SetLevelOfDetail(const char* viewNodeID, double levelOfDetail);
+  double GetLevelOfDetail(const char* viewNodeID);
+
+  /// Number of fibers shown given the subsampling ratio and level of detail
+  vtkIdType GetNumberOfFibersToShow();
+
   ///
   /// Get annotation MRML object.
   vtkMRMLAnnotationNode* GetAnnotationNode ( );
@@ -226,6 +245,8 @@ protected:
   vtkCleanPolyData* CleanPolyDataPostSubsampling;
   vtkCleanPolyData* CleanPolyDataPostROISelection;
   float SubsamplingRatio;
+  double LevelOfDetail;
+  std::map<std::string, double> ViewLevelOfDetails;
 
   virtual void PrepareSubsampling();
   virtual void UpdateSubsampling();
@@ -238,12 +259,21 @@ protected:
 
   vtkMRMLAnnotationNode *AnnotationNode;
   char *AnnotationNodeID;
-  vtkExtractPolyDataGeometry *ExtractPolyDataGeometry;
+  vtkExtractSelectedPolyDataIds* ExtractROISelectedPolyDataIds;
   vtkPlanes *Planes;
 
+  /// Bounding box of each fiber of the polydata, so that only the fibers
+  /// that overlap the ROI have their points tested
+  vtkDoubleArray* FiberBounds;
+  unsigned long FiberBoundsTime;
+  virtual void UpdateFiberBounds();
+
   virtual void PrepareROISelection();
   virtual void UpdateROISelection();
   virtual void CleanROISelection();
+  /// Fill the ROI selection with the ids of the displayed fibers selected
+  /// by the annotation node
+  virtual void SelectFibersInROI();
 
   virtual void SetAnnotationNodeID(const char* id);
 
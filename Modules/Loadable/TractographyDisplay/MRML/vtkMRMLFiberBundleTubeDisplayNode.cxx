@@ -29,6 +29,7 @@ Version:   $Revision: 1.3 $
 #include <vtkTubeFilter.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -45,6 +46,7 @@ vtkMRMLFiberBundleTubeDisplayNode::vtkMRMLFiberBundleTubeDisplayNode()
   this->TubeFilter = vtkTubeFilter::New();
   this->TubeNumberOfSides = 6;
   this->TubeRadius = 0.5;
+  this->LevelOfDetail = 1.;
 
   this->TubeFilter->SetNumberOfSides(this->GetTubeNumberOfSides());
   this->TubeFilter->SetRadius(this->GetTubeRadius());
@@ -141,6 +143,26 @@ void vtkMRMLFiberBundleTubeDisplayNode::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
   os << indent << "TubeNumberOfSides:             " << this->TubeNumberOfSides << "\n";
   os << indent << "TubeRadius:             " << this->TubeRadius << "\n";
+  os << indent << "LevelOfDetail:             " << this->LevelOfDetail << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLFiberBundleTubeDisplayNode::SetLevelOfDetail(double levelOfDetail)
+{
+  if (this->LevelOfDetail == levelOfDetail)
+    {
+    return;
+    }
+  this->LevelOfDetail = levelOfDetail;
+  // Not a property of the node, only update the tubes
+  this->TubeFilter->SetNumberOfSides(this->GetDisplayedTubeNumberOfSides());
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLFiberBundleTubeDisplayNode::GetDisplayedTubeNumberOfSides()
+{
+  int numberOfSides = static_cast<int>(this->TubeNumberOfSides * this->LevelOfDetail + 0.5);
+  return std::min(this->TubeNumberOfSides, std::max(3, numberOfSides));
 }
 
 //----------------------------------------------------------------------------
@@ -173,7 +195,7 @@ void vtkMRMLFiberBundleTubeDisplayNode::UpdatePolyDataPipeline()
   vtkMRMLDiffusionTensorDisplayPropertiesNode * DiffusionTensorDisplayPropertiesNode =
     this->GetDiffusionTensorDisplayPropertiesNode( );
 
-  this->TubeFilter->SetNumberOfSides(this->GetTubeNumberOfSides());
+  this->TubeFilter->SetNumberOfSides(this->GetDisplayedTubeNumberOfSides());
   this->TubeFilter->SetRadius(this->GetTubeRadius());
 
   // set line coloring
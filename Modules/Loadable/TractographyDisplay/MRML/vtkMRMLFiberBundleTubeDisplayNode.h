@@ -77,6 +77,16 @@ class VTK_SLICER_TRACTOGRAPHYDISPLAY_MODULE_MRML_EXPORT vtkMRMLFiberBundleTubeDi
   vtkSetMacro ( TubeNumberOfSides , int );
   vtkGetMacro ( TubeNumberOfSides , int );
 
+  ///
+  /// Fraction of the tube sides used to build the tubes, set by the fiber
+  /// bundle node from its level of detail. Not saved with the scene.
+  vtkGetMacro ( LevelOfDetail , double );
+  virtual void SetLevelOfDetail ( double );
+
+  ///
+  /// Number of sides of the displayed tubes given the level of detail
+  int GetDisplayedTubeNumberOfSides ( );
+
 
  protected:
   vtkMRMLFiberBundleTubeDisplayNode ( );
@@ -92,6 +102,7 @@ class VTK_SLICER_TRACTOGRAPHYDISPLAY_MODULE_MRML_EXPORT vtkMRMLFiberBundleTubeDi
 
   int    TubeNumberOfSides;
   double TubeRadius;
+  double LevelOfDetail;
 
   /// dispaly pipeline
   vtkTubeFilter *TubeFilter;
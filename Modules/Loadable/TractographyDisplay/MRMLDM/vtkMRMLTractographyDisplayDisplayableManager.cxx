@@ -46,6 +46,10 @@
 #include "vtkPolyData.h"
 #include "vtkPointData.h"
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+
 // ITKSys includes
 //#include <itksys/SystemTools.hxx>
 //#include <itksys/Directory.hxx>
@@ -60,6 +64,9 @@ vtkCxxRevisionMacro (vtkMRMLTractographyDisplayDisplayableManager, "$Revision: 1
 vtkMRMLTractographyDisplayDisplayableManager::vtkMRMLTractographyDisplayDisplayableManager()
 {
   this->EnableFiberEdit = 0;
+  this->FrameTimeBudget = 0.1;
+  this->LevelOfDetail = 1.;
+  this->SkipNextFrameTime = false;
   this->SelectedFiberBundleNode = 0;
 
   this->RemoveInteractorStyleObservableEvent(vtkCommand::LeftButtonPressEvent);
@@ -78,6 +85,15 @@ vtkMRMLTractographyDisplayDisplayableManager::vtkMRMLTractographyDisplayDisplaya
 //---------------------------------------------------------------------------
 vtkMRMLTractographyDisplayDisplayableManager::~vtkMRMLTractographyDisplayDisplayableManager()
 {
+  if (this->GetRenderer())
+    {
+    this->GetRenderer()->RemoveObservers(vtkCommand::EndEvent, this->GetWidgetsCallbackCommand());
+    }
+  // Do not keep the fiber bundles at the level of detail of a deleted view
+  if (this->LevelOfDetail != 1.)
+    {
+    this->SetFiberBundlesLevelOfDetail(1.);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -92,6 +108,98 @@ int vtkMRMLTractographyDisplayDisplayableManager::ActiveInteractionModes()
   return vtkMRMLInteractionNode::ViewTransform;
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLTractographyDisplayDisplayableManager::AdditionalInitializeStep()
+{
+  // Measure the frame times for the level of detail
+  this->GetRenderer()->AddObserver(vtkCommand::EndEvent, this->GetWidgetsCallbackCommand());
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLTractographyDisplayDisplayableManager
+::ProcessWidgetsEvents(vtkObject *caller, unsigned long event, void *callData)
+{
+  if (caller == this->GetRenderer() && event == vtkCommand::EndEvent)
+    {
+    this->UpdateLevelOfDetail();
+    return;
+    }
+  this->Superclass::ProcessWidgetsEvents(caller, event, callData);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLTractographyDisplayDisplayableManager::UpdateLevelOfDetail()
+{
+  // Full detail on the still renders
+  double levelOfDetail = 1.;
+  if (this->FrameTimeBudget > 0. && this->IsInteractiveRender())
+    {
+    if (this->SkipNextFrameTime)
+      {
+      // This frame rebuilt the fiber geometry for the new level of detail
+      this->SkipNextFrameTime = false;
+      return;
+      }
+    double frameTime = this->GetRenderer()->GetLastRenderTimeInSeconds();
+    levelOfDetail = this->LevelOfDetail;
+    if (frameTime > this->FrameTimeBudget)
+      {
+      levelOfDetail *= std::max(0.5, this->FrameTimeBudget / frameTime);
+      }
+    else if (frameTime < 0.5 * this->FrameTimeBudget)
+      {
+      levelOfDetail *= 2.;
+      }
+    // Coarse steps so the geometry is not rebuilt for small variations
+    levelOfDetail = std::max(0.01, std::min(1., floor(levelOfDetail * 64.) / 64.));
+    }
+  this->SkipNextFrameTime = false;
+  if (levelOfDetail == this->LevelOfDetail)
+    {
+    return;
+    }
+  if (this->SetFiberBundlesLevelOfDetail(levelOfDetail))
+    {
+    this->SkipNextFrameTime = true;
+    this->RequestRender();
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLTractographyDisplayDisplayableManager
+::SetFiberBundlesLevelOfDetail(double levelOfDetail)
+{
+  this->LevelOfDetail = levelOfDetail;
+  if (!this->GetMRMLScene() || !this->GetMRMLViewNode())
+    {
+    return false;
+    }
+  const char* viewNodeID = this->GetMRMLViewNode()->GetID();
+  bool modified = false;
+  std::vector<vtkMRMLNode*> nodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLFiberBundleNode", nodes);
+  for (std::vector<vtkMRMLNode*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    {
+    vtkMRMLFiberBundleNode* fiberBundleNode = vtkMRMLFiberBundleNode::SafeDownCast(*it);
+    double displayedLevelOfDetail = fiberBundleNode->GetLevelOfDetail();
+    fiberBundleNode->SetLevelOfDetail(viewNodeID, levelOfDetail);
+    modified = modified ||
+      fiberBundleNode->GetLevelOfDetail() != displayedLevelOfDetail;
+    }
+  return modified;
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLTractographyDisplayDisplayableManager::IsInteractiveRender()
+{
+  // The interactor styles raise the desired update rate of the render
+  // window while the view is interacted
+  vtkRenderWindowInteractor* interactor = this->GetInteractor();
+  vtkRenderWindow* renderWindow = this->GetRenderer()->GetRenderWindow();
+  return interactor && renderWindow &&
+    renderWindow->GetDesiredUpdateRate() > interactor->GetStillUpdateRate();
+}
+
 
 //---------------------------------------------------------------------------
 void vtkMRMLTractographyDisplayDisplayableManager::OnInteractorStyleEvent(int eventid)
@@ -262,7 +370,7 @@ vtkMRMLTractographyDisplayDisplayableManager::GetPickedFiber(vtkMRMLFiberBundleD
 
   if (tubeDisplayNode)
     {
-    int numSides = tubeDisplayNode->GetTubeNumberOfSides();
+    int numSides = tubeDisplayNode->GetDisplayedTubeNumberOfSides();
     cellID = pickedCell/numSides;
     }
   else if (lineDisplayNode)
@@ -413,6 +521,12 @@ void vtkMRMLTractographyDisplayDisplayableManager::SetMRMLSceneInternal(vtkMRMLS
       }
     }
 
+  // The level of detail requested by the view is for the previous scene
+  if (this->LevelOfDetail != 1.)
+    {
+    this->SetFiberBundlesLevelOfDetail(1.);
+    }
+
   Superclass::SetMRMLSceneInternal(newScene);
 }
 
@@ -44,6 +44,20 @@ public:
   vtkGetMacro(EnableFiberEdit, int);
   vtkSetMacro(EnableFiberEdit, int);
 
+  /// Time in seconds allowed to render an interactive frame of the view.
+  /// When a frame rendered while the view is interacted takes longer, the
+  /// level of detail the view requests for the fiber bundles (number of
+  /// fibers and tube sides displayed) is lowered. It is raised back when
+  /// frames take less than half of the budget, and set back to full detail
+  /// on the still renders. 0 disables the level of detail.
+  /// 0.1 by default (10 frames per second).
+  /// \sa vtkMRMLFiberBundleNode::SetLevelOfDetail()
+  vtkGetMacro(FrameTimeBudget, double);
+  vtkSetMacro(FrameTimeBudget, double);
+
+  /// Level of detail currently requested by the view for the fiber bundles
+  vtkGetMacro(LevelOfDetail, double);
+
 protected:
   vtkMRMLTractographyDisplayDisplayableManager();
   ~vtkMRMLTractographyDisplayDisplayableManager();
@@ -52,6 +66,18 @@ protected:
 
   virtual int ActiveInteractionModes();
 
+  virtual void AdditionalInitializeStep();
+  virtual void ProcessWidgetsEvents(vtkObject *caller, unsigned long event, void *callData);
+
+  /// Adapt the level of detail of the fiber bundles to the last frame time
+  void UpdateLevelOfDetail();
+  /// Request the level of detail for the view from all the fiber bundles.
+  /// Return true if the displayed level of detail of a bundle changed.
+  bool SetFiberBundlesLevelOfDetail(double levelOfDetail);
+  /// Return true if the last frame was rendered while the view was
+  /// interacted
+  bool IsInteractiveRender();
+
   virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
   virtual void ProcessMRMLNodesEvents(vtkObject *caller, unsigned long event, void *callData);
 
@@ -67,6 +93,9 @@ protected:
 protected:
   
   int EnableFiberEdit;
+  double FrameTimeBudget;
+  double LevelOfDetail;
+  bool SkipNextFrameTime;
   vtkMRMLFiberBundleNode* SelectedFiberBundleNode;
   std::map <vtkIdType, std::vector<double> > SelectedCells;
 };
@@ -0,0 +1,201 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include <vtkMRMLAnnotationROINode.h>
+#include <vtkMRMLFiberBundleNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkExtractPolyDataGeometry.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlanes.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+const int NumberOfFibers = 500;
+const int NumberOfPointsPerFiber = 20;
+
+//----------------------------------------------------------------------------
+// Random walks starting in a 100mm cube
+void SetupFibers(vtkPolyData* polyData)
+{
+  vtkMath::RandomSeed(42);
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> lines;
+  for (int i = 0; i < NumberOfFibers; ++i)
+    {
+    double point[3] = {vtkMath::Random(-50., 50.),
+                       vtkMath::Random(-50., 50.),
+                       vtkMath::Random(-50., 50.)};
+    lines->InsertNextCell(NumberOfPointsPerFiber);
+    for (int j = 0; j < NumberOfPointsPerFiber; ++j)
+      {
+      lines->InsertCellPoint(points->InsertNextPoint(point));
+      for (int k = 0; k < 3; ++k)
+        {
+        point[k] += vtkMath::Random(-2., 2.);
+        }
+      }
+    }
+  polyData->SetPoints(points.GetPointer());
+  polyData->SetLines(lines.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+// Select the fibers with vtkExtractPolyDataGeometry, as the fiber bundle node
+// did before it indexed the fiber bounds
+void ExtractFibersInROI(vtkPolyData* polyData, vtkMRMLAnnotationROINode* roi,
+                        bool positive, vtkPolyData* selectedFibers)
+{
+  vtkNew<vtkPlanes> planes;
+  roi->GetTransformedPlanes(planes.GetPointer());
+  vtkNew<vtkExtractPolyDataGeometry> extractPolyDataGeometry;
+  extractPolyDataGeometry->SetInput(polyData);
+  extractPolyDataGeometry->SetImplicitFunction(planes.GetPointer());
+  extractPolyDataGeometry->SetExtractInside(positive ? 1 : 0);
+  extractPolyDataGeometry->SetExtractBoundaryCells(positive ? 1 : 0);
+  extractPolyDataGeometry->Update();
+  selectedFibers->DeepCopy(extractPolyDataGeometry->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+// Return true if the fibers have the same points in the same order
+bool CompareFibers(vtkPolyData* fibers1, vtkPolyData* fibers2)
+{
+  if (fibers1->GetNumberOfLines() != fibers2->GetNumberOfLines())
+    {
+    return false;
+    }
+  vtkCellArray* lines1 = fibers1->GetLines();
+  vtkCellArray* lines2 = fibers2->GetLines();
+  vtkIdType npts1, npts2;
+  vtkIdType *pts1, *pts2;
+  lines1->InitTraversal();
+  lines2->InitTraversal();
+  while (lines1->GetNextCell(npts1, pts1))
+    {
+    if (!lines2->GetNextCell(npts2, pts2) || npts1 != npts2)
+      {
+      return false;
+      }
+    for (vtkIdType j = 0; j < npts1; ++j)
+      {
+      double point1[3];
+      double point2[3];
+      fibers1->GetPoint(pts1[j], point1);
+      fibers2->GetPoint(pts2[j], point2);
+      if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the fibers selected with the indexed fiber bounds against the
+// fibers vtkExtractPolyDataGeometry selects, in positive and negative modes.
+int vtkMRMLFiberBundleNodeROISelectionTest(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkPolyData> polyData;
+  SetupFibers(polyData.GetPointer());
+
+  vtkNew<vtkMRMLAnnotationROINode> roi;
+  scene->AddNode(roi.GetPointer());
+  roi->SetXYZ(10., -5., 0.);
+  roi->SetRadiusXYZ(15., 20., 10.);
+
+  vtkNew<vtkMRMLFiberBundleNode> fiberBundle;
+  scene->AddNode(fiberBundle.GetPointer());
+  fiberBundle->SetEnableShuffleIDs(0);
+  fiberBundle->SetSubsamplingRatio(1.);
+  fiberBundle->SetAndObservePolyData(polyData.GetPointer());
+  fiberBundle->SetAndObserveAnnotationNodeID(roi->GetID());
+  fiberBundle->SetSelectWithAnnotationNode(1);
+
+  for (int positive = 0; positive < 2; ++positive)
+    {
+    if (positive)
+      {
+      fiberBundle->SetSelectionWithAnnotationNodeModeToPositive();
+      }
+    else
+      {
+      fiberBundle->SetSelectionWithAnnotationNodeModeToNegative();
+      }
+    vtkPolyData* filtered = fiberBundle->GetFilteredPolyData();
+    filtered->Update();
+    vtkNew<vtkPolyData> expected;
+    ExtractFibersInROI(polyData.GetPointer(), roi.GetPointer(), positive != 0,
+                       expected.GetPointer());
+    if (!CompareFibers(filtered, expected.GetPointer()) ||
+        expected->GetNumberOfLines() == 0 ||
+        expected->GetNumberOfLines() == NumberOfFibers)
+      {
+      std::cerr << "Line " << __LINE__ << ": " << filtered->GetNumberOfLines()
+                << " fibers selected in " << (positive ? "positive" : "negative")
+                << " mode instead of the " << expected->GetNumberOfLines()
+                << " fibers of vtkExtractPolyDataGeometry" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A lower level of detail shows fewer fibers. The bundle is displayed at
+  // the lowest level of detail requested by the views.
+  fiberBundle->SetSelectWithAnnotationNode(0);
+  fiberBundle->SetLevelOfDetail("vtkMRMLViewNode1", 0.25);
+  fiberBundle->SetLevelOfDetail("vtkMRMLViewNode2", 0.5);
+  vtkPolyData* filtered = fiberBundle->GetFilteredPolyData();
+  filtered->Update();
+  if (fiberBundle->GetLevelOfDetail() != 0.25 ||
+      filtered->GetNumberOfLines() != NumberOfFibers / 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << filtered->GetNumberOfLines()
+              << " fibers shown at level of detail 0.25" << std::endl;
+    return EXIT_FAILURE;
+    }
+  fiberBundle->SetLevelOfDetail("vtkMRMLViewNode1", 1.);
+  filtered->Update();
+  if (fiberBundle->GetLevelOfDetail() != 0.5 ||
+      fiberBundle->GetLevelOfDetail("vtkMRMLViewNode1") != 1. ||
+      filtered->GetNumberOfLines() != NumberOfFibers / 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << filtered->GetNumberOfLines()
+              << " fibers shown at level of detail 0.5" << std::endl;
+    return EXIT_FAILURE;
+    }
+  fiberBundle->SetLevelOfDetail("vtkMRMLViewNode2", 1.);
+  filtered->Update();
+  if (fiberBundle->GetLevelOfDetail() != 1. ||
+      filtered->GetNumberOfLines() != NumberOfFibers)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << filtered->GetNumberOfLines()
+              << " fibers shown at full detail" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// TractographyDisplay includes
+#include <vtkMRMLFiberBundleNode.h>
+#include <vtkMRMLFiberBundleTubeDisplayNode.h>
+#include <vtkMRMLTractographyDisplayDisplayableManager.h>
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLDisplayableManagerGroup.h>
+#include <vtkMRMLModelDisplayableManager.h>
+
+// MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
+
+// MRML includes
+#include <vtkMRMLScene.h>
+#include <vtkMRMLViewNode.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+const int NumberOfFibers = 500;
+const int NumberOfPointsPerFiber = 20;
+
+//----------------------------------------------------------------------------
+// Random walks starting in a 100mm cube
+void SetupFibers(vtkPolyData* polyData)
+{
+  vtkMath::RandomSeed(42);
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> lines;
+  for (int i = 0; i < NumberOfFibers; ++i)
+    {
+    double point[3] = {vtkMath::Random(-50., 50.),
+                       vtkMath::Random(-50., 50.),
+                       vtkMath::Random(-50., 50.)};
+    lines->InsertNextCell(NumberOfPointsPerFiber);
+    for (int j = 0; j < NumberOfPointsPerFiber; ++j)
+      {
+      lines->InsertCellPoint(points->InsertNextPoint(point));
+      for (int k = 0; k < 3; ++k)
+        {
+        point[k] += vtkMath::Random(-2., 2.);
+        }
+      }
+    }
+  polyData->SetPoints(points.GetPointer());
+  polyData->SetLines(lines.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+// Render until the displayable manager measured a frame: the frame that
+// follows a change of level of detail rebuilds the fibers and is skipped.
+void RenderMeasuredFrame(vtkRenderWindow* renderWindow)
+{
+  renderWindow->Render();
+  renderWindow->Render();
+}
+
+//----------------------------------------------------------------------------
+bool CheckLevelOfDetail(vtkMRMLFiberBundleNode* fiberBundleNode,
+                        vtkMRMLFiberBundleTubeDisplayNode* tubeDisplayNode,
+                        bool fullDetail, const char* step)
+{
+  vtkIdType numberOfFibers = fiberBundleNode->GetNumberOfFibersToShow();
+  int numberOfSides = tubeDisplayNode->GetDisplayedTubeNumberOfSides();
+  if ((numberOfFibers == NumberOfFibers) != fullDetail ||
+      (numberOfSides == tubeDisplayNode->GetTubeNumberOfSides()) != fullDetail)
+    {
+    std::cerr << step << ": " << numberOfFibers << " fibers and "
+              << numberOfSides << " tube sides shown with a level of detail of "
+              << fiberBundleNode->GetLevelOfDetail() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Render interactive frames over and under the frame time budget and check
+// that the number of fibers and of tube sides shown follow.
+int vtkMRMLTractographyDisplayDisplayableManagerLevelOfDetailTest(int , char * [] )
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+  renderWindow->SetSize(300, 300);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderWindow->SetInteractor(renderWindowInteractor.GetPointer());
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLViewNode> viewNode;
+  scene->AddNode(viewNode.GetPointer());
+
+  vtkNew<vtkMRMLDisplayableManagerGroup> displayableManagerGroup;
+  displayableManagerGroup->SetRenderer(renderer.GetPointer());
+  displayableManagerGroup->SetMRMLDisplayableNode(viewNode.GetPointer());
+
+  vtkNew<vtkMRMLModelDisplayableManager> modelDisplayableManager;
+  modelDisplayableManager->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  displayableManagerGroup->AddDisplayableManager(modelDisplayableManager.GetPointer());
+  vtkNew<vtkMRMLTractographyDisplayDisplayableManager> tractographyDisplayableManager;
+  tractographyDisplayableManager->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  displayableManagerGroup->AddDisplayableManager(tractographyDisplayableManager.GetPointer());
+  displayableManagerGroup->GetInteractor()->Initialize();
+
+  if (tractographyDisplayableManager->GetFrameTimeBudget() <= 0.)
+    {
+    std::cerr << "The level of detail is disabled by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkPolyData> fibers;
+  SetupFibers(fibers.GetPointer());
+  vtkNew<vtkMRMLFiberBundleNode> fiberBundleNode;
+  fiberBundleNode->SetAndObservePolyData(fibers.GetPointer());
+  scene->AddNode(fiberBundleNode.GetPointer());
+  vtkNew<vtkMRMLFiberBundleTubeDisplayNode> tubeDisplayNode;
+  scene->AddNode(tubeDisplayNode.GetPointer());
+  fiberBundleNode->AddAndObserveDisplayNodeID(tubeDisplayNode->GetID());
+  renderer->ResetCamera();
+
+  // The interactor styles raise the desired update rate while interacting
+  renderWindow->SetDesiredUpdateRate(renderWindowInteractor->GetDesiredUpdateRate());
+  tractographyDisplayableManager->SetFrameTimeBudget(1000.);
+  RenderMeasuredFrame(renderWindow.GetPointer());
+  if (!CheckLevelOfDetail(fiberBundleNode.GetPointer(), tubeDisplayNode.GetPointer(),
+                          true, "Interactive render within budget"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Over budget: fewer fibers and tube sides
+  tractographyDisplayableManager->SetFrameTimeBudget(1e-9);
+  RenderMeasuredFrame(renderWindow.GetPointer());
+  RenderMeasuredFrame(renderWindow.GetPointer());
+  if (!CheckLevelOfDetail(fiberBundleNode.GetPointer(), tubeDisplayNode.GetPointer(),
+                          false, "Interactive render over budget"))
+    {
+    return EXIT_FAILURE;
+    }
+  double lowLevelOfDetail = fiberBundleNode->GetLevelOfDetail();
+  vtkIdType lowNumberOfFibers = fiberBundleNode->GetNumberOfFibersToShow();
+
+  // Well under budget: the detail comes back on the interactive renders
+  tractographyDisplayableManager->SetFrameTimeBudget(1000.);
+  RenderMeasuredFrame(renderWindow.GetPointer());
+  if (fiberBundleNode->GetLevelOfDetail() <= lowLevelOfDetail ||
+      fiberBundleNode->GetNumberOfFibersToShow() <= lowNumberOfFibers)
+    {
+    std::cerr << "Interactive render under budget: the level of detail stays at "
+              << fiberBundleNode->GetLevelOfDetail() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < 10; ++i)
+    {
+    RenderMeasuredFrame(renderWindow.GetPointer());
+    }
+  if (!CheckLevelOfDetail(fiberBundleNode.GetPointer(), tubeDisplayNode.GetPointer(),
+                          true, "Interactive renders under budget"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Over budget again, then the still render after the interaction
+  tractographyDisplayableManager->SetFrameTimeBudget(1e-9);
+  RenderMeasuredFrame(renderWindow.GetPointer());
+  if (!CheckLevelOfDetail(fiberBundleNode.GetPointer(), tubeDisplayNode.GetPointer(),
+                          false, "Interactive render over budget"))
+    {
+    return EXIT_FAILURE;
+    }
+  renderWindow->SetDesiredUpdateRate(renderWindowInteractor->GetStillUpdateRate());
+  renderWindow->Render();
+  if (!CheckLevelOfDetail(fiberBundleNode.GetPointer(), tubeDisplayNode.GetPointer(),
+                          true, "Still render"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  modelDisplayableManager->SetMRMLApplicationLogic(0);
+  tractographyDisplayableManager->SetMRMLApplicationLogic(0);
+  return EXIT_SUCCESS;
+}
@@ -89,6 +89,7 @@ int vtkMRMLVolumeRenderingDisplayableManager::DefaultGPUMemorySize = 256;
 vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManager()
 {
   this->MapperRaycast = NULL;
+  this->MapperRaycastMinIP = NULL;
   this->MapperTexture = NULL;
   this->MapperGPURaycast = NULL;
   this->MapperGPURaycastII = NULL;
@@ -149,6 +150,7 @@ vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableMana
 
   //delete instances
   vtkSetMRMLNodeMacro(this->MapperRaycast, NULL);
+  vtkSetMRMLNodeMacro(this->MapperRaycastMinIP, NULL);
   vtkSetMRMLNodeMacro(this->MapperTexture, NULL);
   vtkSetMRMLNodeMacro(this->MapperGPURaycast, NULL);
   vtkSetMRMLNodeMacro(this->MapperGPURaycastII, NULL);
@@ -197,6 +199,8 @@ void vtkMRMLVolumeRenderingDisplayableManager::SetGUICallbackCommand(vtkCommand*
   //cpu ray casting
   this->MapperRaycast->AddObserver(vtkCommand::VolumeMapperComputeGradientsProgressEvent, callback);
   this->MapperRaycast->AddObserver(vtkCommand::ProgressEvent,callback);
+  this->MapperRaycastMinIP->AddObserver(vtkCommand::VolumeMapperComputeGradientsProgressEvent, callback);
+  this->MapperRaycastMinIP->AddObserver(vtkCommand::ProgressEvent,callback);
 
   //hook up the gpu mapper
   this->MapperGPURaycast->AddObserver(vtkCommand::VolumeMapperComputeGradientsProgressEvent, callback);
@@ -220,10 +224,14 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
   //mapperEventsWithProgress->InsertNextValue(vtkCommand::ProgressEvent);
 
   // CPU mapper
-  vtkNew<vtkFixedPointVolumeRayCastMapper> newMapperRaycast;
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> newMapperRaycast;
   vtkSetAndObserveMRMLNodeEventsMacro(this->MapperRaycast,
                                       newMapperRaycast.GetPointer(),
                                       mapperEventsWithProgress.GetPointer());
+  vtkNew<vtkFixedPointVolumeRayCastMapper> newMapperRaycastMinIP;
+  vtkSetAndObserveMRMLNodeEventsMacro(this->MapperRaycastMinIP,
+                                      newMapperRaycastMinIP.GetPointer(),
+                                      mapperEventsWithProgress.GetPointer());
   // 3D Texture
   vtkNew<vtkSlicerVolumeTextureMapper3D> newMapperTexture;
   vtkSetAndObserveMRMLNodeEventsMacro(this->MapperTexture,
@@ -520,19 +528,43 @@ void vtkMRMLVolumeRenderingDisplayableManager
   this->UpdateClipping(mapper, vspNode);
 }
 
+//---------------------------------------------------------------------------
+namespace
+{
+// vtkSlicerFixedPointVolumeRayCastMapper is a fork of
+// vtkFixedPointVolumeRayCastMapper: they share the sampling API but no
+// class.
+template <class T>
+void SetCPURaycastSampleDistances(T* mapper, bool highDef, double sampleDistance)
+{
+  mapper->SetAutoAdjustSampleDistances( highDef ? 0 : 1);
+  mapper->SetSampleDistance(sampleDistance);
+  mapper->SetInteractiveSampleDistance(sampleDistance);
+  mapper->SetImageSampleDistance(highDef ? 0.5 : 1.);
+}
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager
 ::UpdateCPURaycastMapper(
-  vtkFixedPointVolumeRayCastMapper* mapper,
+  vtkVolumeMapper* mapper,
   vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode)
 {
   this->UpdateMapper(mapper, vspNode);
   const bool highDef = vspNode->GetPerformanceControl() ==
     vtkMRMLVolumeRenderingDisplayNode::MaximumQuality;
-  mapper->SetAutoAdjustSampleDistances( highDef ? 0 : 1);
-  mapper->SetSampleDistance(this->GetSampleDistance(vspNode));
-  mapper->SetInteractiveSampleDistance(this->GetSampleDistance(vspNode));
-  mapper->SetImageSampleDistance(highDef ? 0.5 : 1.);
+  if (vtkSlicerFixedPointVolumeRayCastMapper::SafeDownCast(mapper))
+    {
+    SetCPURaycastSampleDistances(
+      vtkSlicerFixedPointVolumeRayCastMapper::SafeDownCast(mapper),
+      highDef, this->GetSampleDistance(vspNode));
+    }
+  else
+    {
+    SetCPURaycastSampleDistances(
+      vtkFixedPointVolumeRayCastMapper::SafeDownCast(mapper),
+      highDef, this->GetSampleDistance(vspNode));
+    }
 
   switch(vspNode->GetRaycastTechnique())
     {
@@ -654,7 +686,8 @@ int vtkMRMLVolumeRenderingDisplayableManager
                                               ->GetFgVolumeNode())->GetImageData());
     }
   int supported = 0;
-  if (volumeMapper->IsA("vtkFixedPointVolumeRayCastMapper"))
+  if (volumeMapper->IsA("vtkSlicerFixedPointVolumeRayCastMapper") ||
+      volumeMapper->IsA("vtkFixedPointVolumeRayCastMapper"))
     {
     supported = 1;
     }
@@ -692,6 +725,12 @@ vtkVolumeMapper* vtkMRMLVolumeRenderingDisplayableManager
     }
   if (vspNode->IsA("vtkMRMLCPURayCastVolumeRenderingDisplayNode"))
     {
+    if (vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode)
+          ->GetRaycastTechnique() ==
+        vtkMRMLVolumeRenderingDisplayNode::MinimumIntensityProjection)
+      {
+      return this->MapperRaycastMinIP;
+      }
     return this->MapperRaycast;
     }
   else if (vspNode->IsA("vtkMRMLNCIRayCastVolumeRenderingDisplayNode"))
@@ -807,7 +846,7 @@ bool vtkMRMLVolumeRenderingDisplayableManager::UpdateMapper(
   vtkVolumeMapper* volumeMapper = this->GetVolumeMapper(vspNode);
   if (vspNode->IsA("vtkMRMLCPURayCastVolumeRenderingDisplayNode"))
     {
-    this->UpdateCPURaycastMapper(vtkFixedPointVolumeRayCastMapper::SafeDownCast(volumeMapper),
+    this->UpdateCPURaycastMapper(volumeMapper,
                                  vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode));
     }
   else if (vspNode->IsA("vtkMRMLNCIRayCastVolumeRenderingDisplayNode"))
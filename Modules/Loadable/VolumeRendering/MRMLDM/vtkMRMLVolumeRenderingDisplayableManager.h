@@ -33,6 +33,7 @@ class vtkMRMLNCIMultiVolumeRayCastVolumeRenderingDisplayNode;
 class vtkMRMLVolumeNode;
 class vtkMRMLVolumeRenderingDisplayNode;
 class vtkMRMLVolumeRenderingScenarioNode;
+class vtkSlicerFixedPointVolumeRayCastMapper;
 class vtkSlicerVolumeRenderingLogic;
 class vtkSlicerVolumeTextureMapper3D;
 class vtkSlicerGPURayCastVolumeMapper;
@@ -104,7 +105,7 @@ public:
 
   void UpdateMapper(vtkVolumeMapper* mapper,
                     vtkMRMLVolumeRenderingDisplayNode* vspNode);
-  void UpdateCPURaycastMapper(vtkFixedPointVolumeRayCastMapper* mapper,
+  void UpdateCPURaycastMapper(vtkVolumeMapper* mapper,
                               vtkMRMLCPURayCastVolumeRenderingDisplayNode* vspNode);
   void UpdateNCIRaycastMapper(vtkSlicerGPURayCastVolumeMapper* mapper,
                               vtkMRMLNCIRayCastVolumeRenderingDisplayNode* vspNode);
@@ -194,7 +195,12 @@ protected:
 
   // Description:
   // The software accelerated software mapper
-  vtkFixedPointVolumeRayCastMapper *MapperRaycast;
+  vtkSlicerFixedPointVolumeRayCastMapper *MapperRaycast;
+
+  // Description:
+  // The software mapper used for minimum intensity projections, that
+  // MapperRaycast doesn't support
+  vtkFixedPointVolumeRayCastMapper *MapperRaycastMinIP;
 
   // Description:
   // The gpu ray cast mapper.
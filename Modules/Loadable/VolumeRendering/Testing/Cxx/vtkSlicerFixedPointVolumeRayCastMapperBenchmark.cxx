@@ -0,0 +1,194 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// Volume Rendering includes
+#include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+
+// VTK includes
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkTimerLog.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+#include <vtkWindowToImageFilter.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+const int NumberOfFrames = 10;
+
+//----------------------------------------------------------------------------
+// A mostly empty volume: a ball and a few small blobs in a zero background
+void SetupImageData(vtkImageData* imageData)
+{
+  const int dim = 128;
+  imageData->SetDimensions(dim, dim, dim);
+  imageData->SetScalarTypeToUnsignedChar();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+  unsigned char* ptr = reinterpret_cast<unsigned char*>(
+    imageData->GetScalarPointer(0,0,0));
+  const int centers[4][4] = {{70, 60, 64, 24}, {20, 20, 30, 6},
+                             {100, 30, 100, 8}, {30, 100, 90, 5}};
+  for (int z = 0; z < dim; ++z)
+    {
+    for (int y = 0; y < dim; ++y)
+      {
+      for (int x = 0; x < dim; ++x)
+        {
+        unsigned char value = 0;
+        for (int i = 0; i < 4; ++i)
+          {
+          int dx = x - centers[i][0];
+          int dy = y - centers[i][1];
+          int dz = z - centers[i][2];
+          int r = centers[i][3];
+          if (dx * dx + dy * dy + dz * dz < r * r)
+            {
+            value = static_cast<unsigned char>(100 + (x + y + z) % 156);
+            }
+          }
+        *(ptr++) = value;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Render a fixed camera path from the start camera and return the mean frame
+// time
+double RenderFrames(vtkRenderWindow* renderWindow, vtkRenderer* renderer,
+                    vtkCamera* startCamera, vtkImageData* lastFrame)
+{
+  renderer->GetActiveCamera()->DeepCopy(startCamera);
+  renderer->ResetCameraClippingRange();
+  renderWindow->Render();
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int frame = 0; frame < NumberOfFrames; ++frame)
+    {
+    renderer->GetActiveCamera()->Azimuth(360. / NumberOfFrames);
+    renderWindow->Render();
+    }
+  timer->StopTimer();
+
+  vtkNew<vtkWindowToImageFilter> windowToImage;
+  windowToImage->SetInput(renderWindow);
+  windowToImage->Update();
+  lastFrame->DeepCopy(windowToImage->GetOutput());
+
+  return timer->GetElapsedTime() / NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+bool CompareFrames(vtkImageData* frame1, vtkImageData* frame2)
+{
+  vtkDataArray* scalars1 = frame1->GetPointData()->GetScalars();
+  vtkDataArray* scalars2 = frame2->GetPointData()->GetScalars();
+  return scalars1->GetNumberOfTuples() == scalars2->GetNumberOfTuples() &&
+    scalars1->GetNumberOfComponents() == scalars2->GetNumberOfComponents() &&
+    memcmp(scalars1->GetVoidPointer(0), scalars2->GetVoidPointer(0),
+           scalars1->GetNumberOfTuples() * scalars1->GetNumberOfComponents() *
+           scalars1->GetDataTypeSize()) == 0;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the frame times of the ray caster with and without empty space
+// skipping and dynamic scan line scheduling. Both must render the same
+// images.
+int vtkSlicerFixedPointVolumeRayCastMapperBenchmark(int , char * [] )
+{
+  vtkNew<vtkImageData> imageData;
+  SetupImageData(imageData.GetPointer());
+
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(90., 0.);
+  opacity->AddPoint(255., 0.3);
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., 0., 0., 0.);
+  color->AddRGBPoint(255., 1., 0.9, 0.8);
+
+  vtkNew<vtkVolumeProperty> volumeProperty;
+  volumeProperty->SetScalarOpacity(opacity.GetPointer());
+  volumeProperty->SetColor(color.GetPointer());
+  volumeProperty->SetInterpolationTypeToLinear();
+
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> mapper;
+  mapper->SetInput(imageData.GetPointer());
+  mapper->SetAutoAdjustSampleDistances(0);
+  mapper->SetImageSampleDistance(1.);
+  mapper->SetSampleDistance(0.5);
+
+  vtkNew<vtkVolume> volume;
+  volume->SetMapper(mapper.GetPointer());
+  volume->SetProperty(volumeProperty.GetPointer());
+
+  vtkNew<vtkRenderer> renderer;
+  renderer->AddVolume(volume.GetPointer());
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->SetSize(400, 400);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+
+  // All the runs render the same views
+  renderer->ResetCamera();
+  vtkNew<vtkCamera> startCamera;
+  startCamera->DeepCopy(renderer->GetActiveCamera());
+
+  for (int shade = 0; shade < 2; ++shade)
+    {
+    volumeProperty->SetShade(shade);
+
+    mapper->SetEmptySpaceSkipping(0);
+    mapper->SetDynamicScheduling(0);
+    vtkNew<vtkImageData> referenceFrame;
+    double referenceTime = RenderFrames(renderWindow.GetPointer(),
+      renderer.GetPointer(), startCamera.GetPointer(),
+      referenceFrame.GetPointer());
+
+    mapper->SetEmptySpaceSkipping(1);
+    mapper->SetDynamicScheduling(1);
+    vtkNew<vtkImageData> frame;
+    double time = RenderFrames(renderWindow.GetPointer(),
+      renderer.GetPointer(), startCamera.GetPointer(), frame.GetPointer());
+
+    std::cout << (shade ? "Shaded" : "Unshaded") << " composite with "
+              << mapper->GetNumberOfThreads() << " threads: "
+              << referenceTime << "s per frame with the fixed row split, "
+              << time << "s per frame with empty space skipping and dynamic "
+              << "scheduling" << std::endl;
+
+    if (!CompareFrames(referenceFrame.GetPointer(), frame.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << ": rendered images differ with shade "
+                << shade << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -672,6 +672,7 @@
 
 #define VTKKWRCHelper_InitializeVariables()                                                     \
   int i, j;                                                                                     \
+  int progressRow = 0;                                                                          \
   unsigned short *imagePtr;                                                                     \
                                                                                                 \
   int imageInUseSize[2];                                                                        \
@@ -805,10 +806,6 @@
   unsigned int dDHinc = dim[0]*dirOffset + dirOffset;
 
 #define VTKKWRCHelper_OuterInitialization()                             \
-    if ( j%threadCount != threadID )                                    \
-      {                                                                 \
-      continue;                                                         \
-      }                                                                 \
      if ( !threadID )                                                   \
       {                                                                 \
       if ( renWin->CheckAbortStatus() )                                 \
@@ -971,7 +968,9 @@
 
 #define VTKKWRCHelper_InitializationAndLoopStartNN()            \
   VTKKWRCHelper_InitializeVariables();                          \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -981,7 +980,9 @@
 #define VTKKWRCHelper_InitializationAndLoopStartGONN()          \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesGO();                        \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -991,7 +992,9 @@
 #define VTKKWRCHelper_InitializationAndLoopStartShadeNN()       \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesShade();                     \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1002,7 +1005,9 @@
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeVariablesGO();                        \
   VTKKWRCHelper_InitializeVariablesShade();                     \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1012,7 +1017,9 @@
 #define VTKKWRCHelper_InitializationAndLoopStartTrilin()        \
   VTKKWRCHelper_InitializeVariables();                          \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1024,7 +1031,9 @@
   VTKKWRCHelper_InitializeVariablesGO();                        \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesGO();                  \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1036,7 +1045,9 @@
   VTKKWRCHelper_InitializeVariablesShade();                     \
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesShade();               \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1050,7 +1061,9 @@
   VTKKWRCHelper_InitializeTrilinVariables();                    \
   VTKKWRCHelper_InitializeTrilinVariablesShade();               \
   VTKKWRCHelper_InitializeTrilinVariablesGO();                  \
-  for ( j = 0; j < imageInUseSize[1]; j++ )                     \
+  for ( j = mapper->GetNextRowToCast( threadID, threadCount, -1 );      \
+        j < imageInUseSize[1];                                          \
+        j = mapper->GetNextRowToCast( threadID, threadCount, j ) )      \
     {                                                           \
     VTKKWRCHelper_OuterInitialization();                        \
     for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i++ )      \
@@ -1060,11 +1073,12 @@
 #define VTKKWRCHelper_IncrementAndLoopEnd()                                     \
       imagePtr+=4;                                                              \
       }                                                                         \
-    if ( j%32 == 0 && threadID==0 )                                                           \
+    if ( threadID == 0 && j >= progressRow )                                    \
       {                                                                         \
       float fargs[1];                                                           \
       fargs[0] = static_cast<float>(j)/static_cast<float>(imageInUseSize[1]-1); \
       mapper->InvokeEvent( vtkCommand::ProgressEvent, fargs );                  \
+      progressRow = j + 32;                                                     \
       }                                                                         \
     }
 
@@ -1114,6 +1128,10 @@
                                                                 \
   if ( !mmvalid )                                               \
     {                                                           \
+    if ( k + 1 < numSteps )                                     \
+      {                                                         \
+      k += mapper->SkipEmptySpace( pos, dir, numSteps-k-2 );    \
+      }                                                         \
     continue;                                                   \
     }
 
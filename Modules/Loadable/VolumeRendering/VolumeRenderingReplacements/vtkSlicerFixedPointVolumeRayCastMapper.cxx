@@ -21,6 +21,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkFiniteDifferenceGradientEstimator.h"
 #include "vtkImageData.h"
 #include "vtkCommand.h"
+#include "vtkCriticalSection.h"
 #include "vtkSphericalDirectionEncoder.h"
 #include "vtkSlicerFixedPointVolumeRayCastCompositeGOHelper.h"
 #include "vtkSlicerFixedPointVolumeRayCastCompositeGOShadeHelper.h"
@@ -40,6 +41,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkVolumeProperty.h"
 #include "vtkSlicerFixedPointRayCastImage.h"
 
+#include <cstring>
 
 vtkCxxRevisionMacro(vtkSlicerFixedPointVolumeRayCastMapper, "$Revision: 1.20.4.1 $");
 vtkStandardNewMacro(vtkSlicerFixedPointVolumeRayCastMapper);
@@ -432,6 +434,10 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->RowBounds              = NULL;
     this->OldRowBounds           = NULL;
 
+    this->DynamicScheduling      = 1;
+    this->NextRowToCast          = 0;
+    this->NextRowToCastLock      = vtkCriticalSection::New();
+
     this->RenderTimeTable        = NULL;
     this->RenderVolumeTable      = NULL;
     this->RenderRendererTable    = NULL;
@@ -506,6 +512,18 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->MinMaxVolumeSize[3] = 0;
     this->SavedMinMaxInput = NULL;
 
+    // The octree summarizes the flags of the min/max volume so that large
+    // empty regions can be skipped at once
+    this->EmptySpaceSkipping = 1;
+    for ( i = 0; i < VTKKW_FPMM_OCTREE_LEVELS; i++ )
+    {
+        this->MinMaxOctree[i] = NULL;
+        this->MinMaxOctreeSize[i][0] = 0;
+        this->MinMaxOctreeSize[i][1] = 0;
+        this->MinMaxOctreeSize[i][2] = 0;
+    }
+    this->NumberOfMinMaxOctreeLevels = 0;
+
     this->Volume = NULL;
     //SLICERADD
     this->ManualInteractive=0;
@@ -571,6 +589,8 @@ vtkSlicerFixedPointVolumeRayCastMapper::~vtkSlicerFixedPointVolumeRayCastMapper(
     delete [] this->RowBounds;
     delete [] this->OldRowBounds;
 
+    this->NextRowToCastLock->Delete();
+
     int i;
     if ( this->GradientNormal )
     {
@@ -620,6 +640,10 @@ vtkSlicerFixedPointVolumeRayCastMapper::~vtkSlicerFixedPointVolumeRayCastMapper(
 
     // Delete storage used by min/max volume
     delete [] this->MinMaxVolume;
+    for ( i = 0; i < VTKKW_FPMM_OCTREE_LEVELS; i++ )
+    {
+        delete [] this->MinMaxOctree[i];
+    }
 }
 
 float vtkSlicerFixedPointVolumeRayCastMapper::ComputeRequiredImageSampleDistance( float desiredTime,
@@ -1075,10 +1099,181 @@ void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxVolume( vtkVolume *vol
         }
     }
 
+    delete [] minNonZeroScalarIndex;
+    delete [] minNonZeroGradientMagnitudeIndex;
+
+    this->UpdateMinMaxOctree();
+
     this->SavedMinMaxFlagTime.Modified();
 
 }
 
+// Build the octree levels from the flags of the first component of the
+// min/max volume (the one used by the space leaping of the composite
+// helpers). Each cell of a level is the union of the 2x2x2 cells below it.
+void vtkSlicerFixedPointVolumeRayCastMapper::UpdateMinMaxOctree()
+{
+    int i, j, k, level;
+    int srcSize[3];
+    int size[3];
+
+    srcSize[0] = this->MinMaxVolumeSize[0];
+    srcSize[1] = this->MinMaxVolumeSize[1];
+    srcSize[2] = this->MinMaxVolumeSize[2];
+
+    for ( level = 0; level < VTKKW_FPMM_OCTREE_LEVELS; level++ )
+    {
+        // Stop once the whole volume fits in a single cell
+        if ( srcSize[0] <= 1 && srcSize[1] <= 1 && srcSize[2] <= 1 )
+        {
+            break;
+        }
+
+        for ( i = 0; i < 3; i++ )
+        {
+            size[i] = (srcSize[i] + 1) / 2;
+        }
+
+        if ( this->MinMaxOctreeSize[level][0] != size[0] ||
+            this->MinMaxOctreeSize[level][1] != size[1] ||
+            this->MinMaxOctreeSize[level][2] != size[2] )
+        {
+            delete [] this->MinMaxOctree[level];
+            this->MinMaxOctree[level] = new unsigned char [size[0]*size[1]*size[2]];
+            this->MinMaxOctreeSize[level][0] = size[0];
+            this->MinMaxOctreeSize[level][1] = size[1];
+            this->MinMaxOctreeSize[level][2] = size[2];
+        }
+
+        unsigned char *cells = this->MinMaxOctree[level];
+        memset( cells, 0, size[0]*size[1]*size[2] );
+
+        unsigned short *minMaxPtr = this->MinMaxVolume;
+        unsigned char  *srcPtr    = (level) ? (this->MinMaxOctree[level-1]) : (NULL);
+        for ( k = 0; k < srcSize[2]; k++ )
+        {
+            for ( j = 0; j < srcSize[1]; j++ )
+            {
+                unsigned char *rowPtr = cells + (k/2)*size[0]*size[1] + (j/2)*size[0];
+                for ( i = 0; i < srcSize[0]; i++ )
+                {
+                    int flag;
+                    if ( level )
+                    {
+                        flag = *(srcPtr++);
+                    }
+                    else
+                    {
+                        flag = ((*(minMaxPtr + 2))&0x00ff);
+                        minMaxPtr += 3*this->MinMaxVolumeSize[3];
+                    }
+                    if ( flag )
+                    {
+                        rowPtr[i/2] = 1;
+                    }
+                }
+            }
+        }
+
+        srcSize[0] = size[0];
+        srcSize[1] = size[1];
+        srcSize[2] = size[2];
+    }
+
+    this->NumberOfMinMaxOctreeLevels = level;
+
+    // Release the levels that are not needed by this volume anymore
+    for ( ; level < VTKKW_FPMM_OCTREE_LEVELS; level++ )
+    {
+        delete [] this->MinMaxOctree[level];
+        this->MinMaxOctree[level] = NULL;
+        this->MinMaxOctreeSize[level][0] = 0;
+        this->MinMaxOctreeSize[level][1] = 0;
+        this->MinMaxOctreeSize[level][2] = 0;
+    }
+}
+
+// The ray is in an empty block of the min/max volume. Find the largest
+// empty octree cell around it, and compute how many more steps along
+// the ray stay in this cell. The samples at these steps are all in empty
+// blocks, so the position can be moved directly to the last one of them.
+unsigned int vtkSlicerFixedPointVolumeRayCastMapper::SkipEmptySpace( unsigned int pos[3],
+                                                                    unsigned int dir[3],
+                                                                    unsigned int maxSteps )
+{
+    if ( !this->EmptySpaceSkipping || maxSteps == 0 )
+    {
+        return 0;
+    }
+
+    int level = 0;
+    while ( level < this->NumberOfMinMaxOctreeLevels &&
+        !this->CheckMinMaxOctreeFlag( pos, level ) )
+    {
+        level++;
+    }
+
+    // level 0 here is the min/max block itself
+    unsigned int shift = VTKKW_FPMM_SHIFT + level;
+    unsigned int cellSize = 1u << shift;
+
+    unsigned int steps = maxSteps;
+    int i;
+    for ( i = 0; i < 3; i++ )
+    {
+        unsigned int increment = dir[i]&0x7fffffff;
+        if ( !increment )
+        {
+            continue;
+        }
+        unsigned int cellStart = (pos[i] >> shift) << shift;
+        unsigned int stepsInCell;
+        if ( dir[i]&0x80000000 )
+        {
+            stepsInCell = (cellStart + (cellSize - 1) - pos[i]) / increment;
+        }
+        else
+        {
+            stepsInCell = (pos[i] - cellStart) / increment;
+        }
+        if ( stepsInCell < steps )
+        {
+            steps = stepsInCell;
+        }
+    }
+
+    for ( i = 0; i < 3; i++ )
+    {
+        if ( dir[i]&0x80000000 )
+        {
+            pos[i] += steps*(dir[i]&0x7fffffff);
+        }
+        else
+        {
+            pos[i] -= steps*dir[i];
+        }
+    }
+
+    return steps;
+}
+
+// Scan lines are either interleaved across the threads, or taken from a
+// shared counter so that the threads keep busy until the image is done
+int vtkSlicerFixedPointVolumeRayCastMapper::GetNextRowToCast( int threadID,
+                                                             int threadCount,
+                                                             int lastRow )
+{
+    if ( !this->DynamicScheduling )
+    {
+        return (lastRow < 0) ? (threadID) : (lastRow + threadCount);
+    }
+
+    this->NextRowToCastLock->Lock();
+    int row = this->NextRowToCast++;
+    this->NextRowToCastLock->Unlock();
+    return row;
+}
+
 void vtkSlicerFixedPointVolumeRayCastMapper::UpdateCroppingRegions()
 {
     this->ConvertCroppingRegionPlanesToVoxels();
@@ -1264,6 +1459,7 @@ void vtkSlicerFixedPointVolumeRayCastMapper::RenderSubVolume()
 {
     // Set the number of threads to use for ray casting,
     // then set the execution method and do it.
+    this->NextRowToCast = 0;
     this->Threader->SetSingleMethod( SlicerFixedPointVolumeRayCastMapper_CastRays,
         (void *)this);
     this->Threader->SingleMethodExecute();
@@ -3116,6 +3312,12 @@ void vtkSlicerFixedPointVolumeRayCastMapper::PrintSelf(ostream& os, vtkIndent in
         << this->AutoAdjustSampleDistances << endl;
     os << indent << "Intermix Intersecting Geometry: "
         << (this->IntermixIntersectingGeometry ? "On\n" : "Off\n");
+    os << indent << "Empty Space Skipping: "
+        << (this->EmptySpaceSkipping ? "On\n" : "Off\n");
+    os << indent << "Number Of Min Max Octree Levels: "
+        << this->NumberOfMinMaxOctreeLevels << endl;
+    os << indent << "Dynamic Scheduling: "
+        << (this->DynamicScheduling ? "On\n" : "Off\n");
 
     os << indent << "ShadingRequired: " << this->ShadingRequired << endl;
     os << indent << "GradientOpacityRequired: " << this->GradientOpacityRequired
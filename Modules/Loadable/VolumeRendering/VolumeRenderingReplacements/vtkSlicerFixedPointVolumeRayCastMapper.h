@@ -19,7 +19,7 @@
 // composite or MIP rendering, and can be intermixed with geometric data.
 // Space leaping is used to speed up the rendering process. In addition,
 // calculation are performed in 15 bit fixed point precision. This mapper
-// is threaded, and will interleave scan lines across processors.
+// is threaded, and hands out scan lines to the processors on demand.
 //
 // This mapper is a good replacement for vtkVolumeRayCastMapper EXCEPT:
 //   - it does not do isosurface ray casting
@@ -45,7 +45,8 @@
 // third unsigned short which is both the maximum gradient opacity in
 // the neighborhood (an unsigned char) and the flag that is filled
 // in for the current lookup tables to indicate whether this region
-// can be skipped.
+// can be skipped. The flags are further summarized in an octree so that
+// rays can leap over large empty regions in a single step.
 
 // .SECTION see also
 // vtkVolumeMapper
@@ -59,9 +60,11 @@
 
 #define VTKKW_FP_SHIFT       15
 #define VTKKW_FPMM_SHIFT     17
+#define VTKKW_FPMM_OCTREE_LEVELS 6
 #define VTKKW_FP_MASK        0x7fff
 #define VTKKW_FP_SCALE       32767.0
 
+class vtkCriticalSection;
 class vtkMatrix4x4;
 class vtkMultiThreader;
 class vtkPlaneCollection;
@@ -158,6 +161,24 @@ public:
   void SetNumberOfThreads( int num );
   int GetNumberOfThreads();
 
+  // Description:
+  // If EmptySpaceSkipping is on (the default), rays leap over the regions
+  // of the min/max octree that have no opacity for the current transfer
+  // functions instead of stepping through them sample by sample.
+  vtkSetClampMacro( EmptySpaceSkipping, int, 0, 1 );
+  vtkGetMacro( EmptySpaceSkipping, int );
+  vtkBooleanMacro( EmptySpaceSkipping, int );
+
+  // Description:
+  // If DynamicScheduling is on (the default), the threads take the next
+  // scan line that has not been cast yet each time they finish one, so that
+  // a thread assigned to empty rows does not idle while others cast the
+  // expensive ones. Otherwise the scan lines are interleaved across the
+  // threads in a fixed order.
+  vtkSetClampMacro( DynamicScheduling, int, 0, 1 );
+  vtkGetMacro( DynamicScheduling, int );
+  vtkBooleanMacro( DynamicScheduling, int );
+
   // Description:
   // If IntermixIntersectingGeometry is turned on, the zbuffer will be
   // captured and used to limit the traversal of the rays.
@@ -192,6 +213,22 @@ public:
   void ShiftVectorDown( unsigned int in[3], unsigned int out[3] );
   int CheckMinMaxVolumeFlag( unsigned int pos[3], int c );
   int CheckMIPMinMaxVolumeFlag( unsigned int pos[3], int c, unsigned short maxIdx );
+  int CheckMinMaxOctreeFlag( unsigned int pos[3], int level );
+
+  // Description:
+  // WARNING: INTERNAL METHOD - NOT INTENDED FOR GENERAL USE
+  // Called when the ray at position pos enters an empty min/max block.
+  // Advance pos by the number of steps (at most maxSteps) that remain in
+  // the largest empty octree cell containing it and return that number.
+  unsigned int SkipEmptySpace( unsigned int pos[3], unsigned int dir[3],
+                               unsigned int maxSteps );
+
+  // Description:
+  // WARNING: INTERNAL METHOD - NOT INTENDED FOR GENERAL USE
+  // Return the next scan line for the thread to cast after lastRow (-1 for
+  // the first one). A value past the last row of the image means that
+  // there is nothing left to cast.
+  int GetNextRowToCast( int threadID, int threadCount, int lastRow );
 
   void LookupColorUC( unsigned short *colorTable,
                       unsigned short *scalarOpacityTable,
@@ -323,6 +360,11 @@ protected:
   int             *RowBounds;
   int             *OldRowBounds;
 
+  // Scan line scheduling across the ray casting threads
+  int                 DynamicScheduling;
+  int                 NextRowToCast;
+  vtkCriticalSection *NextRowToCastLock;
+
   float           *RenderTimeTable;
   vtkVolume      **RenderVolumeTable;
   vtkRenderer    **RenderRendererTable;
@@ -442,6 +484,17 @@ protected:
   void            FillInMaxGradientMagnitudes( int fullDim[3],
                                                int smallDim[3] );
 
+  // Octree over the flags of the first component of the min/max volume.
+  // Each level halves the resolution of the level below, level 0 being
+  // 2x2x2 groups of min/max volume elements. A cell is non-zero if any of
+  // the elements it covers may have opacity.
+  int             EmptySpaceSkipping;
+  unsigned char  *MinMaxOctree[VTKKW_FPMM_OCTREE_LEVELS];
+  int             MinMaxOctreeSize[VTKKW_FPMM_OCTREE_LEVELS][3];
+  int             NumberOfMinMaxOctreeLevels;
+
+  void            UpdateMinMaxOctree();
+
 private:
   vtkSlicerFixedPointVolumeRayCastMapper(const vtkSlicerFixedPointVolumeRayCastMapper&);  // Not implemented.
   void operator=(const vtkSlicerFixedPointVolumeRayCastMapper&);  // Not implemented.
@@ -545,6 +598,17 @@ inline int vtkSlicerFixedPointVolumeRayCastMapper::CheckMinMaxVolumeFlag( unsign
   return ((*(this->MinMaxVolume + 3*offset + 2))&0x00ff);
 }
 
+inline int vtkSlicerFixedPointVolumeRayCastMapper::CheckMinMaxOctreeFlag( unsigned int pos[3], int level )
+{
+  const int *size = this->MinMaxOctreeSize[level];
+  unsigned int shift = VTKKW_FPMM_SHIFT + level + 1;
+
+  return *(this->MinMaxOctree[level] +
+           (pos[2]>>shift)*size[0]*size[1] +
+           (pos[1]>>shift)*size[0] +
+           (pos[0]>>shift));
+}
+
 inline int vtkSlicerFixedPointVolumeRayCastMapper::CheckMIPMinMaxVolumeFlag( unsigned int mmpos[3], int c,
                                                                        unsigned short maxIdx )
 {
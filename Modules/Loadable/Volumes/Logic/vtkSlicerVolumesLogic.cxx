@@ -514,7 +514,9 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
 
   vtkNew<vtkSlicerErrorSink> errorSink;
 
-  // Run through the factory list and test each factory until success
+  // Run through the factory list and test each factory until success.
+  // The file header is checked first so the image data is only read
+  // with the storage node of the matching factory.
   for (NodeSetFactoryRegistry::const_iterator fit = volumeRegistry.begin();
        fit != volumeRegistry.end(); ++fit)
     {
@@ -531,10 +533,19 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
 
       this->InitializeStorageNode(nodeSet.StorageNode, filename, fileList);
 
-      vtkDebugMacro("Attempt to read file as a volume of type "
-                    << nodeSet.Node->GetNodeTagName() << " using "
-                    << nodeSet.Node->GetClassName() << " [filename = " << filename << "]");
-      bool success = nodeSet.StorageNode->ReadData(nodeSet.Node);
+      bool success = false;
+      if (nodeSet.StorageNode->CanReadFile(nodeSet.Node))
+        {
+        vtkDebugMacro("Attempt to read file as a volume of type "
+                      << nodeSet.Node->GetNodeTagName() << " using "
+                      << nodeSet.Node->GetClassName() << " [filename = " << filename << "]");
+        success = nodeSet.StorageNode->ReadData(nodeSet.Node);
+        }
+      else
+        {
+        vtkDebugMacro("File header does not match a volume of type "
+                      << nodeSet.Node->GetNodeTagName() << " [filename = " << filename << "]");
+        }
 
       // disconnect the observers
       nodeSet.StorageNode->RemoveObservers(vtkCommand::ErrorEvent, errorSink.GetPointer());
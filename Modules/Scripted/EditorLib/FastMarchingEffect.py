@@ -74,6 +74,10 @@ class FastMarchingEffectOptions(Effect.EffectOptions):
     self.widgets.append(self.marcher)
     self.marcher.connect('valueChanged(double)',self.onMarcherChanged)
 
+    # polls the march running in the background
+    self.timer = qt.QTimer()
+    self.timer.connect('timeout()', self.onMarchTimer)
+
     HelpButton(self.frame, "To use FastMarching effect, first mark the areas that belong to the structure of interest to initialize the algorithm. Define the expected volume of the structure you are trying to segment, and hit March.\nAfter computation is complete, use the Marcher slider to go over the segmentation history.")
 
     self.march.connect('clicked()', self.onMarch)
@@ -85,6 +89,8 @@ class FastMarchingEffectOptions(Effect.EffectOptions):
 
   def destroy(self):
     super(FastMarchingEffectOptions,self).destroy()
+    self.timer.stop()
+    self.logic.stopMarching()
 
   # note: this method needs to be implemented exactly as-is
   # in each leaf subclass so that "self" in the observer
@@ -112,18 +118,36 @@ class FastMarchingEffectOptions(Effect.EffectOptions):
       slicer.util.showStatusMessage('Running FastMarching...', 2000)
       self.logic.undoRedo = self.undoRedo
       npoints = self.logic.fastMarching(self.percentMax.value)
-      slicer.util.showStatusMessage('FastMarching finished', 2000)
       if npoints:
+        # the slider follows the march until it is over
+        self.march.enabled = False
+        self.marcher.enabled = False
         self.marcher.minimum = 0
         self.marcher.maximum = npoints
-        self.marcher.value = npoints
         self.marcher.singleStep = 1
-        self.marcher.enabled = True
+        self.timer.start(200)
     except IndexError:
       print('No tools available!')
       pass
 
+  def onMarchTimer(self):
+    if self.logic.isMarching():
+      self.marcher.value = self.logic.marchingProgress() * self.marcher.maximum
+      self.logic.updateLabel(1)
+      return
+    self.timer.stop()
+    self.march.enabled = True
+    self.marcher.enabled = True
+    if self.marcher.value == self.marcher.maximum:
+      self.logic.updateLabel(1)
+    else:
+      self.marcher.value = self.marcher.maximum
+    slicer.util.showStatusMessage('FastMarching finished', 2000)
+
   def onMarcherChanged(self,value):
+    if self.logic.isMarching():
+      # the march shows everything it has reached so far
+      return
     self.logic.updateLabel(value/self.marcher.maximum)
 
   def percentMaxChanged(self, val):
@@ -192,6 +216,7 @@ class FastMarchingEffectLogic(Effect.EffectLogic):
 
   def __init__(self,sliceLogic):
     super(FastMarchingEffectLogic,self).__init__(sliceLogic)
+    self.fm = None
 
   def fastMarching(self,percentMax):
 
@@ -248,31 +273,39 @@ class FastMarchingEffectLogic(Effect.EffectLogic):
     if nSeeds == 0:
       return 0
 
+    # the first update initializes the filter
     self.fm.Modified()
     self.fm.Update()
 
-    # TODO: need to call show() twice for data to be updated
-    self.fm.show(1)
-    self.fm.Modified()
-    self.fm.Update()
+    self.undoRedo.saveState()
 
-    self.fm.show(1)
+    # the second one starts the march in a separate thread,
+    # updateLabel shows the points reached so far
+    self.fm.setEvolveInBackground(1)
     self.fm.Modified()
     self.fm.Update()
+    print('FastMarching march started')
 
-    self.undoRedo.saveState()
+    return npoints
 
-    self.editUtil.getLabelImage().DeepCopy(self.fm.GetOutput())
-    self.editUtil.markVolumeNodeAsModified(self.sliceLogic.GetLabelLayer().GetVolumeNode())
-    # print('FastMarching output image: '+str(output))
-    print('FastMarching march update completed')
+  def isMarching(self):
+    return self.fm is not None and self.fm.isEvolving()
 
-    return npoints
+  def marchingProgress(self):
+    if not self.fm:
+      return 0
+    return self.fm.evolutionProgress()
+
+  def stopMarching(self):
+    if self.fm:
+      self.fm.stopEvolution()
 
   def updateLabel(self,value):
     if not self.fm:
       return
-    self.fm.show(value)
+    # the label map is copied only when show() painted new points
+    if not self.fm.show(value):
+      return
     self.fm.Modified()
     self.fm.Update()
 
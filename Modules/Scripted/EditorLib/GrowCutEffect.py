@@ -59,6 +59,7 @@ class GrowCutEffectOptions(Effect.EffectOptions):
 
   def destroy(self):
     super(GrowCutEffectOptions,self).destroy()
+    self.logic.releaseState()
 
   # note: this method needs to be implemented exactly as-is
   # in each leaf subclass so that "self" in the observer
@@ -123,9 +124,15 @@ class GrowCutEffectLogic(Effect.EffectLogic):
 
   def __init__(self,sliceLogic):
     super(GrowCutEffectLogic,self).__init__(sliceLogic)
+    # the filter is kept so that the seeds painted on the previous result
+    # resume the segmentation instead of starting over
+    self.growCutFilter = None
 
   def growCut(self):
-    growCutFilter = vtkITK.vtkITKGrowCutSegmentationImageFilter()
+    if not self.growCutFilter:
+      self.growCutFilter = vtkITK.vtkITKGrowCutSegmentationImageFilter()
+      self.growCutFilter.IncrementalOn()
+    growCutFilter = self.growCutFilter
     background = self.getScopedBackground()
     gestureInput = self.getScopedLabelInput()
     growCutOutput = self.getScopedLabelOutput()
@@ -170,6 +177,13 @@ class GrowCutEffectLogic(Effect.EffectLogic):
 
     self.applyScopedLabel()
 
+  def releaseState(self):
+    """Free the automaton state kept to resume the segmentation
+    (copies of the whole label volume), e.g. when the effect is deactivated
+    """
+    if self.growCutFilter:
+      self.growCutFilter.ReleaseState()
+
 #
 # The GrowCutEffect class definition 
 #
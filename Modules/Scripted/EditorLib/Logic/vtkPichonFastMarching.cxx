@@ -21,11 +21,36 @@
 #include "vtkPichonFastMarching.h"
 #include "vtkPointData.h"
 #include "vtkDataArray.h"
+#include "vtkMutexLock.h"
+
+#include <string.h>
+#include <sstream>
 
 
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
+// number of children of a leaf in the minheap. A wider heap would be
+// shallower, but it would pop equal arrival times in another order and
+// the adaptive PDFs make the segmentation depend on that order.
+#define HEAP_ARITY 2
+
+// number of steps between two publications of the known points
+// when evolving in the background
+#define GRANULARITY_PUBLISH 1000
+
+// number of errors of a background evolution kept for endEvolution()
+#define MAX_EVOLUTION_ERRORS 10
+
+// errors of the methods the evolution thread runs: vtkErrorMacro would
+// display them from that thread
+#define vtkPichonFastMarchingErrorMacro(x)      \
+  {                                             \
+  std::ostringstream evolutionMsg;              \
+  evolutionMsg << x;                            \
+  this->evolutionError( evolutionMsg.str() );   \
+  }
+
 // used to compute the median
 int compareInt(const void *a, const void *b)
 {
@@ -82,10 +107,10 @@ float vtkPichonFastMarching::speed( int index )
   if( (s<1.0/(INF/1e6)) || finite(s)==0 )
     {
       if(finite(s)==0)
-    vtkErrorMacro( "Error in vtkPichonFastMarching::speed(...): finite(s)==0 " << s );
+    vtkPichonFastMarchingErrorMacro( "Error in vtkPichonFastMarching::speed(...): finite(s)==0 " << s );
       /*
       else
-    vtkErrorMacro( "(s<1.0/(INF/1e6)) " << s );
+    vtkPichonFastMarchingErrorMacro( "(s<1.0/(INF/1e6)) " << s );
       */
       s=(float)(1.0/(INF/1e6));
     }
@@ -117,14 +142,13 @@ void vtkPichonFastMarching::setSeed( int index )
   // add all FAR 26-neighbors to TRIAL
   for(int n=1;n<=26;n++)
     {
-      FMleaf f;
-      f.nodeIndex=index + shiftNeighbor(n);
-      if( node[ f.nodeIndex ].status==fmsFAR )
+      int indexN=index + shiftNeighbor(n);
+      if( node[ indexN ].status==fmsFAR )
     {
-      node[f.nodeIndex].status=fmsTRIAL;
-      node[f.nodeIndex].T = (float) ( distanceNeighbor(n) / speed(f.nodeIndex) );
+      node[indexN].status=fmsTRIAL;
+      node[indexN].T = (float) ( distanceNeighbor(n) / speed(indexN) );
       
-      insert( f ); // insert in minheap
+      insert( indexN ); // insert in minheap
     }
     }
 }
@@ -174,6 +198,8 @@ void vtkPichonFastMarching::initNewExpansion( void )
   if(somethingReallyWrong)
     return;
 
+  stopEvolution();
+
   pdfIntensityIn->reset();
   pdfInhomoIn->reset();
 
@@ -250,12 +276,26 @@ int vtkPichonFastMarching::nKnownPoints(void)
 {
   if(somethingReallyWrong)
     return 0;
-  return knownPoints.size();
+  return nShownPoints();
+}
+
+int vtkPichonFastMarching::nShownPoints(void)
+{
+  evolutionLock->Lock();
+  int n = evolving ? nPublishedPoints : (int)knownPoints.size();
+  evolutionLock->Unlock();
+  return n;
+}
+
+void *vtkPichonFastMarchingEvolve(vtkMultiThreader::ThreadInfo *info)
+{
+  vtkPichonFastMarching *self = static_cast<vtkPichonFastMarching *>(info->UserData);
+  self->evolve();
+  return NULL;
 }
 
 void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
                 vtkImageData *vtkNotUsed(inData), short *inPtr,
-                vtkImageData *vtkNotUsed(outData), short *outPtr, 
                 int vtkNotUsed(outExt)[6])
 {
   if(self->somethingReallyWrong)
@@ -263,8 +303,12 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
   int n=0;
   int k;
 
+  // the background evolution owns the nodes until it is over,
+  // meanwhile we only output what show() has painted
+  if( self->isEvolving() )
+    return;
+
   self->setInData( (short *)inPtr );
-  self->setOutData( (short *)outPtr );
 
   if( !self->initialized )
     {      
@@ -361,7 +405,7 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
           if( self->node[indexN].status==fmsTRIAL )
             {
             self->node[indexN].T=(float)INF;
-            self->downTree( self->node[indexN].leafIndex );
+            self->updateTree( self->node[indexN].leafIndex, (float)INF );
             }
           }
         }
@@ -382,13 +426,10 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
 
         if( (hasKnownNeighbor) && (self->node[index].status!=fmsOUT) )
           {
-          FMleaf f;
-
           self->node[index].T=self->computeT(index);
           self->node[index].status=fmsTRIAL;        
-          f.nodeIndex=index;
 
-          self->insert( f );
+          self->insert( index );
           }
         }
 
@@ -419,54 +460,184 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
   self->pdfIntensityIn->setUpdateRate(self->nPointsEvolution/100);
   self->pdfInhomoIn->setUpdateRate(self->nPointsEvolution/100);
 
-  for(n=0;n<self->nPointsEvolution;n++)
+  self->nEvolvedPoints=0;
+  self->evolutionStuck=false;
+
+  if( self->evolveInBackground )
     {
-    if( (n*GRANULARITY_PROGRESS) % self->nPointsEvolution == 0 )
-      self->UpdateProgress(float(n)/float(self->nPointsEvolution));
+    // show() reads the known points while they are added,
+    // they must not be reallocated in the meantime
+    self->knownPoints.reserve( self->knownPoints.size()+self->nPointsEvolution );
 
-    float T=self->step();
+    self->evolutionLock->Lock();
+    self->nPublishedPoints=(int)self->knownPoints.size();
+    self->evolving=true;
+    self->abortEvolution=false;
+    self->evolutionLock->Unlock();
+
+    self->bufferErrors=true;
+
+    self->evolutionThreadID = self->evolutionThreader->SpawnThread(
+      (vtkThreadFunctionType) &vtkPichonFastMarchingEvolve,
+      static_cast<void *>(self));
+    return;
+    }
+
+  self->evolve();
+  self->endEvolution();
+}
+
+void vtkPichonFastMarching::evolve( void )
+{
+  int n;
+  for(n=0;n<nPointsEvolution;n++)
+    {
+    if( evolveInBackground )
+      {
+      if( n % GRANULARITY_PUBLISH == 0 )
+        {
+        evolutionLock->Lock();
+        nPublishedPoints=(int)knownPoints.size();
+        nEvolvedPoints=n;
+        bool abort=abortEvolution;
+        evolutionLock->Unlock();
+        if( abort )
+          break;
+        }
+      }
+    else if( (n*GRANULARITY_PROGRESS) % nPointsEvolution == 0 )
+      UpdateProgress(float(n)/float(nPointsEvolution));
+
+    float T=step();
 
     // all the statistics should be gathered from a band 3 pixels from the interface
-    self->pdfIntensityIn->setMemory((int)(5*self->tree.size()));
-    self->pdfInhomoIn->setMemory((int)(5*self->tree.size()));
+    pdfIntensityIn->setMemory((int)(5*tree.size()));
+    pdfInhomoIn->setMemory((int)(5*tree.size()));
 
     if( T==INF )
       {
-      self->vtkErrorWrapper( "FastMarching: nowhere else to go. End of evolution." );
+      // reported by endEvolution(), in the calling thread
+      evolutionStuck=true;
       break;
       }
     }
 
   // check minHeap still OK
-  self->minHeapIsSorted();
+  minHeapIsSorted();
+
+  evolutionLock->Lock();
+  nPublishedPoints=(int)knownPoints.size();
+  nEvolvedPoints=n;
+  evolving=false;
+  evolutionLock->Unlock();
+}
 
-  self->firstPassThroughShow = true;
+void vtkPichonFastMarching::endEvolution( void )
+{
+  // the evolution thread is over, report its errors here
+  bufferErrors=false;
+  for(size_t k=0;k<evolutionErrors.size();k++)
+    vtkErrorMacro( << evolutionErrors[k] );
+  if( nDroppedEvolutionErrors>0 )
+    vtkErrorMacro( "FastMarching: " << nDroppedEvolutionErrors
+                   << " more errors during the evolution." );
+  evolutionErrors.clear();
+  nDroppedEvolutionErrors=0;
+
+  if( evolutionStuck )
+    vtkErrorMacro( "FastMarching: nowhere else to go. End of evolution." );
+
+  firstPassThroughShow = true;
 
   // we've done that,
   // make sure this is reset to 0 so that nothing happen if Update is called
-  self->nPointsEvolution=0;
+  nPointsEvolution=0;
 }
 
-void vtkPichonFastMarching::show(float r)
+void vtkPichonFastMarching::evolutionError( const std::string& message )
 {
-  if(somethingReallyWrong)
+  if( !bufferErrors )
+    {
+    vtkErrorMacro( << message );
     return;
+    }
+  if( (int)evolutionErrors.size()<MAX_EVOLUTION_ERRORS )
+    evolutionErrors.push_back( message );
+  else
+    nDroppedEvolutionErrors++;
+}
+
+void vtkPichonFastMarching::setEvolveInBackground(int background)
+{
+  evolveInBackground = (background!=0);
+}
+
+int vtkPichonFastMarching::isEvolving(void)
+{
+  if( evolutionThreadID<0 )
+    return 0;
+
+  evolutionLock->Lock();
+  bool stillEvolving=evolving;
+  evolutionLock->Unlock();
+  if( stillEvolving )
+    return 1;
+
+  // the thread is done: wait for it and wrap up here
+  evolutionThreader->TerminateThread( evolutionThreadID );
+  evolutionThreadID=-1;
+  endEvolution();
+  return 0;
+}
+
+float vtkPichonFastMarching::evolutionProgress(void)
+{
+  evolutionLock->Lock();
+  float progress = nPointsEvolution>0 ?
+    float(nEvolvedPoints)/float(nPointsEvolution) : (float)1.0;
+  evolutionLock->Unlock();
+  return progress;
+}
+
+void vtkPichonFastMarching::stopEvolution(void)
+{
+  if( evolutionThreadID<0 )
+    return;
+
+  evolutionLock->Lock();
+  abortEvolution=true;
+  evolutionLock->Unlock();
+
+  // TerminateThread does not kill the thread, it waits for it
+  evolutionThreader->TerminateThread( evolutionThreadID );
+  evolutionThreadID=-1;
+  endEvolution();
+}
+
+int vtkPichonFastMarching::show(float r)
+{
+  if(somethingReallyWrong)
+    return 0;
 
   //assert( (r>=0) && (r<=1.0) );
   if(!( (r>=0) && (r<=1.0) ))
     {
       vtkErrorMacro("Error in vtkPichonFastMarching::show(...): !( (r>=0) && (r<=1.0) )");
-      return;
+      return 0;
     }
 
   if( nEvolutions<0 )
-    return;
+    return 0;
 
-  if( knownPoints.size()<1 )
-    return;
+  // while evolving in the background, only use the published points
+  int nPoints = nShownPoints();
+  if( nPoints<1 )
+    return 0;
 
   int oldIndex = nPointsBeforeLeakEvolution;
-  int newIndex = (int)((knownPoints.size()-1)*r);
+  int newIndex = (int)((nPoints-1)*r);
+  if( newIndex == oldIndex )
+    return 0;
 
   if( newIndex > oldIndex )
     for(int index=(oldIndex+1);index<=newIndex;index++)
@@ -485,6 +656,7 @@ void vtkPichonFastMarching::show(float r)
 
   nPointsBeforeLeakEvolution=newIndex;
   firstPassThroughShow=false;
+  return 1;
 }
 
 void vtkPichonFastMarching::setActiveLabel(int _label)
@@ -531,9 +703,12 @@ void vtkPichonFastMarching::ExecuteData(vtkDataObject *)
       return;
     }
 
-  vtkPichonFastMarchingExecute(this, inData, (short *)inPtr, 
-             outData, (short *)(outPtr), outExt);
+  vtkPichonFastMarchingExecute(this, inData, (short *)inPtr, outExt);
 
+  // show() paints into our own buffer, which stays valid while the
+  // pipeline reallocates the output
+  if( outdata!=NULL )
+    memcpy( outPtr, outdata, dimXYZ*sizeof(short) );
 }
 
 void vtkPichonFastMarching::setNPointsEvolution( int n )
@@ -550,6 +725,7 @@ void vtkPichonFastMarching::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "dimZ: " << this->dimZ << "\n";
   os << indent << "dimXY: " << this->dimXY << "\n";
   os << indent << "label: " << this->label << "\n";
+  os << indent << "evolveInBackground: " << this->evolveInBackground << "\n";
 }
 
 bool vtkPichonFastMarching::emptyTree(void)
@@ -557,11 +733,14 @@ bool vtkPichonFastMarching::emptyTree(void)
   return (tree.size()==0);
 }
 
-void vtkPichonFastMarching::insert(const FMleaf leaf) {
+void vtkPichonFastMarching::insert(int nodeIndex) {
 
   // insert element at the back
+  FMleaf leaf;
+  leaf.T=node[ nodeIndex ].T;
+  leaf.nodeIndex=nodeIndex;
   tree.push_back( leaf );
-  node[ leaf.nodeIndex ].leafIndex=(int)(tree.size()-1);
+  node[ nodeIndex ].leafIndex=(int)(tree.size()-1);
 
   // trickle the element up until everything 
   // is sorted again
@@ -573,27 +752,33 @@ bool vtkPichonFastMarching::minHeapIsSorted( void )
   int N=(int)tree.size();
   int k;
 
-  for(k=(N-1);k>=1;k--)
+  for(k=(N-1);k>=0;k--)
     {
-      if(node[tree[k].nodeIndex].leafIndex!=k)
+      if((int)node[tree[k].nodeIndex].leafIndex!=k)
     {
-      vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+      vtkPichonFastMarchingErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
              << "tree[" << k << "] : pb leafIndex/nodeIndex (size=" 
              << (unsigned int)tree.size() << ")" );
+    }
+      if(tree[k].T!=node[tree[k].nodeIndex].T)
+    {
+      vtkPichonFastMarchingErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+             << "tree[" << k << "] : pb T=" << tree[k].T
+             << " instead of " << node[tree[k].nodeIndex].T );
     }
     }
   for(k=(N-1);k>=1;k--)
     {
-      if( finite( node[tree[k].nodeIndex].T)==0 )
-    vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
-               << "NaN or Inf value in minHeap : " << node[tree[k].nodeIndex].T );
+      if( finite( tree[k].T )==0 )
+    vtkPichonFastMarchingErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+               << "NaN or Inf value in minHeap : " << tree[k].T );
 
-      if( node[tree[k].nodeIndex].T<node[ (int)(tree[(k-1)/2].nodeIndex) ].T )
+      if( tree[k].T<tree[(k-1)/HEAP_ARITY].T )
     {
-      vtkErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
+      vtkPichonFastMarchingErrorMacro( "Error in vtkPichonFastMarching::minHeapIsSorted(): "
              << "minHeapIsSorted is false! : size=" << (unsigned int)tree.size() << "at leafIndex=" << k 
-             << " node[tree[k].nodeIndex].T=" << node[tree[k].nodeIndex].T
-             << "<node[ (int)(tree[(k-1)/2].nodeIndex) ].T=" << node[ (int)(tree[(k-1)/2].nodeIndex) ].T);
+             << " tree[k].T=" << tree[k].T
+             << "<tree[(k-1)/HEAP_ARITY].T=" << tree[(k-1)/HEAP_ARITY].T);
 
       return false;
     }
@@ -604,101 +789,93 @@ bool vtkPichonFastMarching::minHeapIsSorted( void )
 void vtkPichonFastMarching::downTree(int index) {
   /*
    * This routine sweeps downward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is smaller than that of the parent. Note that this only
+   * moving the smallest child up as long as its value
+   * is smaller than that of the leaf, which then fills
+   * the hole left at the bottom. Note that this only
    * guarantees the heap property if the value at the
    * starting index is greater than all its parents.
    */
-  int LeftChild = 2 * index + 1;
-  int RightChild = 2 * index + 2;
-  
-  while (LeftChild < (int)tree.size())
-    {
-      /*
-       * Terminate the process when the current leaf has no
-       * children. If no swap occurs at a higher leaf, this
-       * condition is forced.
-       */
+  int size = (int)tree.size();
+  FMleaf leaf = tree[index];
+  int firstChild = HEAP_ARITY * index + 1;
 
+  /*
+   * Terminate the process when the current leaf has no
+   * children.
+   */
+  while (firstChild < size)
+    {
       /* 
-       * Find the child with the smallest value. The node has at least
-       * one child, and so has at least a left child.
+       * Find the child with the smallest value. The children
+       * of a leaf are contiguous in the tree.
        */
-      int MinChild = LeftChild;
+      int lastChild = firstChild + HEAP_ARITY;
+      if (lastChild > size)
+        lastChild = size;
+
+      int minChild = firstChild;
+      for (int child = firstChild + 1; child < lastChild; child++)
+        if (tree[child].T < tree[minChild].T)
+          minChild = child;
 
       /*
-       * If the node has a right child, and if the right child
-       * has smaller crossing time than the left child, then the 
-       * right child is the MinChild.
-       */
-      if (RightChild < (int)tree.size()) {
-    
-    if (node[tree[LeftChild].nodeIndex].T>
-        node[tree[RightChild].nodeIndex].T) 
-      MinChild = RightChild;
-      }
-    
-      /*
-       * If the MinChild has smaller T than the current leaf,
-       * swap them, and move the current leaf to the MinChild.
+       * If the current leaf has a lower value than its
+       * MinChild, the job is done, force a stop.
        */
-      if (node[tree[MinChild].nodeIndex].T<
-      node[tree[index].nodeIndex].T)
-    {
-      FMleaf tmp=tree[index];
-      tree[index]=tree[MinChild];
-      tree[MinChild]=tmp;
+      if (!(tree[minChild].T < leaf.T))
+        break;
 
+      tree[index] = tree[minChild];
       // make sure pointers remain correct
-      node[ tree[MinChild].nodeIndex ].leafIndex = MinChild;
       node[ tree[index].nodeIndex ].leafIndex = index;
-      
-      index = MinChild;
-     
-      LeftChild = 2 * index + 1;
-      RightChild =  LeftChild + 1;
-    }
-      else
-    /*
-     * If the current leaf has a lower value than its
-     * MinChild, the job is done, force a stop.
-     */
-    break;
+
+      index = minChild;
+      firstChild = HEAP_ARITY * index + 1;
     } 
+
+  tree[index] = leaf;
+  node[ leaf.nodeIndex ].leafIndex = index;
 }
 
 void vtkPichonFastMarching::upTree(int index) {
   /*
    * This routine sweeps upward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is less than that of the parent. Note that this only
+   * moving the parent down as long as its value is
+   * greater than that of the leaf. Note that this only
    * guarantees the heap property if the value at the
    * starting leaf is less than all its children.
    */
-  while( index>0 )
-    {
-      int upIndex = (int) (index-1)/2;
+  FMleaf leaf = tree[index];
 
-      if( node[tree[index].nodeIndex].T < 
-      node[tree[upIndex].nodeIndex].T )
+  while( index>0 )
     {
-      // then swap the 2 nodes
+      int upIndex = (index-1)/HEAP_ARITY;
 
-      FMleaf tmp=tree[index];
-      tree[index]=tree[upIndex];
-      tree[upIndex]=tmp;
+      if( !(leaf.T < tree[upIndex].T) )
+        // then there is nothing left to do
+        // force stop
+        break;
 
+      tree[index] = tree[upIndex];
       // make sure pointers remain correct
-      node[ tree[upIndex].nodeIndex ].leafIndex = upIndex;
       node[ tree[index].nodeIndex ].leafIndex = index;
-    
+
       index = upIndex;
     }
-      else
-    // then there is nothing left to do
-    // force stop
-    break;
-    }
+
+  tree[index] = leaf;
+  node[ leaf.nodeIndex ].leafIndex = index;
+}
+
+void vtkPichonFastMarching::updateTree(int index, float T) {
+  // the caller has already changed the T of the node
+  float oldT = tree[index].T;
+  tree[index].T = T;
+
+  if( T<oldT )
+    upTree( index );
+  else
+    downTree( index );
 }
 
 FMleaf vtkPichonFastMarching::removeSmallest( void ) {
@@ -709,16 +886,17 @@ FMleaf vtkPichonFastMarching::removeSmallest( void ) {
   /*
    * Now move the bottom, rightmost, leaf to the root.
    */
-  tree[0]=tree[ tree.size()-1 ];
-
-  // make sure pointers remain correct
-  node[ tree[0].nodeIndex ].leafIndex = 0;
-
+  FMleaf last=tree[ tree.size()-1 ];
   tree.pop_back();
 
-  // trickle the element down until everything 
-  // is sorted again
-  downTree( 0 );
+  if( tree.size()>0 )
+    {
+      tree[0]=last;
+
+      // trickle the element down until everything 
+      // is sorted again
+      downTree( 0 );
+    }
 
   return f;
 }
@@ -730,6 +908,20 @@ vtkPichonFastMarching::vtkPichonFastMarching()
 { 
   initialized=false; 
   somethingReallyWrong=true;
+  outdata=NULL;
+
+  nPointsEvolution=0;
+  evolveInBackground=false;
+  evolutionThreader=vtkMultiThreader::New();
+  evolutionThreadID=-1;
+  evolutionLock=vtkMutexLock::New();
+  evolving=false;
+  abortEvolution=false;
+  nPublishedPoints=0;
+  nEvolvedPoints=0;
+  evolutionStuck=false;
+  bufferErrors=false;
+  nDroppedEvolutionErrors=0;
 }
 
 void vtkPichonFastMarching::init(int _dimX, int _dimY, int _dimZ, double _depth, double _dx, double _dy, double _dz)
@@ -756,6 +948,13 @@ void vtkPichonFastMarching::init(int _dimX, int _dimY, int _dimZ, double _depth,
   this->dimXY=dimX*dimY;
   this->dimXYZ=dimX*dimY*dimZ;
 
+  // leafIndex is packed on 29 bits in the nodes
+  if( dimXYZ>=(1<<29) )
+    {
+      vtkErrorMacro("Error in void vtkPichonFastMarching::init(), the volume has too many voxels: " << dimXYZ);
+      return;
+    }
+
   arrayShiftNeighbor[0] = 0; // neighbor 0 is the node itself
   arrayDistanceNeighbor[0] = 0.0;
 
@@ -840,6 +1039,15 @@ void vtkPichonFastMarching::init(int _dimX, int _dimY, int _dimZ, double _depth,
       return;
     }
 
+  delete [] outdata;
+  outdata = new short[ dimX*dimY*dimZ ];
+  if(!(outdata!=NULL))
+    {
+      vtkErrorMacro("Error in void vtkPichonFastMarching::init(), not enough memory for allocation of 'outdata'");
+      return;
+    }
+  memset( outdata, 0, dimX*dimY*dimZ*sizeof(short) );
+
   pdfIntensityIn = new vtkPichonFastMarchingPDF( (int) _depth );
   if(!(pdfIntensityIn!=NULL))
     {
@@ -867,14 +1075,16 @@ void vtkPichonFastMarching::setInData(short* data)
   indata=data;
 }
 
-void vtkPichonFastMarching::setOutData(short* data)
-{
-  outdata=data;
-}
-
 vtkPichonFastMarching::~vtkPichonFastMarching()
 {
-  /* all the delete are done by unInit() */
+  stopEvolution();
+  evolutionThreader->Delete();
+  evolutionLock->Delete();
+
+  // the output buffer is also released when unInit() is never called
+  delete [] outdata;
+
+  /* all the other delete are done by unInit() */
 }
 
 inline int vtkPichonFastMarching::shiftNeighbor(int n)
@@ -929,22 +1139,15 @@ float vtkPichonFastMarching::step( void )
   /* find point in fmsTRIAL with smallest T, remove it from fmsTRIAL and put
      it in fmsKNOWN */
 
-  static int emptyTreeCnt;
+  // a bounded front ends this way, evolve() reports it
   if( emptyTree() )
-    {
-      if(emptyTreeCnt == 0)
-        {
-        vtkErrorMacro( "vtkPichonFastMarching::step empty tree!" << endl );
-        }
-      emptyTreeCnt++;
-      return (float)INF;
-    }
+    return (float)INF;
 
   min=removeSmallest();
   
   if( node[min.nodeIndex].T>=INF )
     {
-      vtkErrorMacro( " node[min.nodeIndex].T>=INF " << endl );      
+      vtkPichonFastMarchingErrorMacro( " node[min.nodeIndex].T>=INF " );
 
       // this would happen if the only points left were artificially put back
       // by the user playing with the slider
@@ -979,28 +1182,17 @@ float vtkPichonFastMarching::step( void )
        */
       if( node[indexN].status==fmsFAR )
     {
-      FMleaf f;
       node[indexN].T=computeT(indexN);
-      f.nodeIndex=indexN;
 
-      insert( f );
+      insert( indexN );
 
       node[indexN].status=fmsTRIAL;
     }
       else if( node[indexN].status==fmsTRIAL )
     {
-      float t1,  t2;
-      t1 = node[indexN].T;
-
       node[indexN].T=computeT(indexN);
 
-      t2 = node[indexN].T;
-
-      if( t2<t1 )
-          upTree( node[indexN].leafIndex );
-      else
-          downTree( node[indexN].leafIndex );
-
+      updateTree( node[indexN].leafIndex, node[indexN].T );
     }
     }
 
@@ -1114,7 +1306,7 @@ float vtkPichonFastMarching::computeT(int index )
     //    assert( Tij<INF );
     if(!( Tij<INF ))
       {
-    vtkErrorMacro("Error in vtkPichonFastMarching::computeT(...): !( Tij<INF )");
+    vtkPichonFastMarchingErrorMacro("Error in vtkPichonFastMarching::computeT(...): !( Tij<INF )");
     return (float)INF;
       }
  
@@ -1271,9 +1463,13 @@ void vtkPichonFastMarching::unInit( void )
   if(somethingReallyWrong)
     return;
 
+  stopEvolution();
+
   delete [] node;
   delete [] inhomo;
   delete [] median;
+  delete [] outdata;
+  outdata = NULL;
 
   // these are VTK objects, they should be destroyed by VTK's
   // garbage collector
@@ -15,9 +15,12 @@
 // VTK includes
 #include <vtkImageData.h>
 #include <vtkImageToImageFilter.h>
+#include <vtkMultiThreader.h>
+class vtkMutexLock;
 
 // STD includes
 #include <vector>
+#include <string>
 #include <algorithm>
 
 #define MAJOR_VERSION 3
@@ -41,13 +44,18 @@
 typedef enum fmstatus { fmsDONE, fmsKNOWN, fmsTRIAL, fmsFAR, fmsOUT } FMstatus;
 #define MASK_BIT 256
 
+/// status and position in the minheap share a word so that a node
+/// fits in 8 bytes; the volume must have less than 2^29 voxels
 struct FMnode {
-  FMstatus status;
   float T;
-  int leafIndex;
+  unsigned int leafIndex : 29;
+  unsigned int status : 3;
 };
 
+/// the arrival time is copied in the leaf so that sorting the minheap
+/// does not have to look up the nodes all over the volume
 struct FMleaf {
+  float T;
   int nodeIndex;
 };
 
@@ -83,7 +91,6 @@ public:
   void setNPointsEvolution( int n );
 
   void setInData(short* data);
-  void setOutData(short* data);
 
   void setRAStoIJKmatrix(float m11, float m12, float m13, float m14,
              float m21, float m22, float m23, float m24,
@@ -94,7 +101,24 @@ public:
   int addSeedIJK( int, int, int );
   int addSeedsFromImage(vtkImageData*);
 
-  void show(float r);
+  /// Paint the points known at the fraction r of the evolution into the
+  /// output. Return 1 if the output changed, 0 otherwise.
+  int show(float r);
+
+  /// Run the evolution of the next Update() in a separate thread.
+  /// Update() then returns right away: poll isEvolving() and call show()
+  /// and Update() to display the points known so far.
+  void setEvolveInBackground(int background);
+
+  /// Return 1 while a background evolution is running.
+  /// Once it is over, wait for the thread and report its errors.
+  int isEvolving(void);
+
+  /// Fraction of the requested points that have been evolved
+  float evolutionProgress(void);
+
+  /// Stop the background evolution, keeping the points known so far.
+  void stopEvolution(void);
 
   char * cxxVersionString(void);
   int cxxMajorVersion(void);
@@ -109,9 +133,10 @@ protected:
 
   friend void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
                      vtkImageData *inData, short *inPtr,
-                     vtkImageData *outData, short *outPtr, 
                      int outExt[6]);
-                     
+
+  friend void *vtkPichonFastMarchingEvolve(vtkMultiThreader::ThreadInfo *info);
+
 private:
   //pb wrap  vtkPichonFastMarching()(const vtkPichonFastMarching&);
   //pb wrap  void operator=(const vtkPichonFastMarching&);
@@ -141,7 +166,7 @@ private:
   int *inhomo; /// inhomogeneity 
   int *median; /// medican intensity
 
-  short* outdata; /// output
+  short* outdata; /// output painted by show(), copied by ExecuteData
   short* indata;  /// input
 
   /// size of the indata (=size outdata, node, inhomo)
@@ -193,12 +218,31 @@ private:
 
   bool firstPassThroughShow;
 
+  /// background evolution
+  bool evolveInBackground;
+  vtkMultiThreader *evolutionThreader;
+  int evolutionThreadID; /// -1 when there is no thread to wait for
+  bool evolutionStuck; /// the front could not go anywhere else
+  /// errors of the background evolution, reported by endEvolution()
+  bool bufferErrors; /// true from the spawn of the thread until it is joined
+  std::vector<std::string> evolutionErrors;
+  int nDroppedEvolutionErrors;
+  vtkMutexLock *evolutionLock; /// protects the 4 members below
+  bool evolving;
+  bool abortEvolution;
+  int nPublishedPoints; /// known points show() can use while evolving
+  int nEvolvedPoints;
+
+  /// report an error now, or from endEvolution() if the evolution thread runs
+  void evolutionError( const std::string& message );
+
   /// minheap methods
   bool emptyTree(void);
-  void insert(const FMleaf leaf);
+  void insert(int nodeIndex);
   FMleaf removeSmallest( void );
   void downTree(int index);
   void upTree(int index);
+  void updateTree(int index, float T);
 
   int indexFather(int index );
 
@@ -220,6 +264,13 @@ private:
   /* perform one step of fast marching
      return the leaf which has just been added to fmsKNOWN */
   float step( void );
+
+  /// run the steps of the current evolution
+  void evolve( void );
+  /// called in the calling thread once the evolution is over
+  void endEvolution( void );
+  /// number of known points show() can use
+  int nShownPoints( void );
 };
 
 #endif
@@ -0,0 +1,100 @@
+import math
+import time
+import unittest
+import vtk
+import slicer
+
+class FastMarchingHeap(unittest.TestCase):
+  """
+  March from a seed in the middle of a uniform cube. With the same speed
+  everywhere, the minheap must make the front reach the voxels in the
+  order of their distance to the seed: the result is a ball.
+  """
+  dimension = 24
+  cube = (4, 20)
+  seed = (12, 12, 12)
+  nPoints = 500
+
+  def setUp(self):
+    pass
+
+  def runTest(self):
+    self.test_FastMarchingHeap()
+
+  def image(self, value):
+    """Short image of the test dimension filled by value(i,j,k)."""
+    image = vtk.vtkImageData()
+    image.SetDimensions(self.dimension, self.dimension, self.dimension)
+    image.SetScalarTypeToShort()
+    image.AllocateScalars()
+    scalars = image.GetPointData().GetScalars()
+    index = 0
+    for k in range(self.dimension):
+      for j in range(self.dimension):
+        for i in range(self.dimension):
+          scalars.SetTuple1(index, value(i, j, k))
+          index += 1
+    return image
+
+  def inCube(self, i, j, k):
+    return (self.cube[0] <= i < self.cube[1] and
+            self.cube[0] <= j < self.cube[1] and
+            self.cube[0] <= k < self.cube[1])
+
+  def march(self, background):
+    """Return the voxels reached by the march, as a list of labels."""
+    volume = self.image(lambda i, j, k: 200 if self.inCube(i, j, k) else 0)
+    seeds = self.image(lambda i, j, k: 1 if (i, j, k) == self.seed else 0)
+
+    fm = slicer.vtkPichonFastMarching()
+    fm.init(self.dimension, self.dimension, self.dimension, 200, 1, 1, 1)
+    fm.SetInput(volume)
+    fm.setNPointsEvolution(self.nPoints)
+    fm.setActiveLabel(1)
+    self.assertEqual(fm.addSeedsFromImage(seeds), 1)
+
+    # the first update initializes the filter, the second one marches
+    fm.Modified()
+    fm.Update()
+    fm.setEvolveInBackground(background)
+    fm.Modified()
+    fm.Update()
+    while fm.isEvolving():
+      time.sleep(0.01)
+
+    # the seed and one point per step
+    self.assertEqual(fm.nKnownPoints(), self.nPoints + 1)
+
+    fm.show(1.0)
+    fm.Modified()
+    fm.Update()
+    scalars = fm.GetOutput().GetPointData().GetScalars()
+    labels = [int(scalars.GetTuple1(index))
+              for index in range(scalars.GetNumberOfTuples())]
+    self.assertEqual(labels.count(1), self.nPoints + 1)
+    return labels
+
+  def test_FastMarchingHeap(self):
+    labels = self.march(0)
+
+    # compare with the reference ball: no voxel outside is closer to the
+    # seed than a voxel inside, up to the error of the first order scheme
+    maxInside = 0.
+    minOutside = float(self.dimension)
+    index = 0
+    for k in range(self.dimension):
+      for j in range(self.dimension):
+        for i in range(self.dimension):
+          distance = math.sqrt((i - self.seed[0]) ** 2 +
+                               (j - self.seed[1]) ** 2 +
+                               (k - self.seed[2]) ** 2)
+          if labels[index]:
+            maxInside = max(maxInside, distance)
+          elif self.inCube(i, j, k):
+            minOutside = min(minOutside, distance)
+          index += 1
+    print('Reached voxels up to %g, missed one at %g' % (maxInside, minOutside))
+    self.assertLessEqual(maxInside, minOutside + 1.0)
+
+    # marching in the background pops the same voxels
+    self.assertEqual(self.march(1), labels)
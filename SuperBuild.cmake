@@ -185,6 +185,7 @@ foreach(ep_cmake_arg
   BUILD_SHARED_LIBS
   WITH_COVERAGE
   #WITH_MEMCHECK
+  Slicer_BUILD_BENCHMARKS
   Slicer_BUILD_CLI
   Slicer_BUILD_CLI_SUPPORT
   Slicer_BUILD_DICOM_SUPPORT